@@ -0,0 +1,44 @@
+# Locate the LZ4 compression library
+# This module defines
+# LZ4_LIBRARY
+# LZ4_FOUND, if false, do not try to link to lz4
+# LZ4_INCLUDE_DIR, where to find the headers
+#
+# $LZ4_DIR is an environment variable that would
+# correspond to the ./configure --prefix=$LZ4_DIR
+# used in building lz4.
+
+FIND_PATH(LZ4_INCLUDE_DIR lz4frame.h
+    $ENV{LZ4_DIR}/include
+    $ENV{LZ4_DIR}
+    ~/Library/Frameworks
+    /Library/Frameworks
+    /usr/local/include
+    /usr/include
+    /sw/include # Fink
+    /opt/local/include # DarwinPorts
+    /opt/csw/include # Blastwave
+    /opt/include
+    /usr/freeware/include
+)
+
+FIND_LIBRARY(LZ4_LIBRARY
+    NAMES lz4 liblz4
+    PATHS
+    $ENV{LZ4_DIR}/lib
+    $ENV{LZ4_DIR}
+    ~/Library/Frameworks
+    /Library/Frameworks
+    /usr/local/lib
+    /usr/lib
+    /sw/lib
+    /opt/local/lib
+    /opt/csw/lib
+    /opt/lib
+    /usr/freeware/lib64
+)
+
+SET(LZ4_FOUND "NO")
+IF(LZ4_LIBRARY AND LZ4_INCLUDE_DIR)
+    SET(LZ4_FOUND "YES")
+ENDIF(LZ4_LIBRARY AND LZ4_INCLUDE_DIR)
@@ -415,6 +415,11 @@ int main( int argc, char **argv )
     arguments.getApplicationUsage()->addCommandLineOption("-e level minX minY maxX maxY","Read down to <level> across the extents minX, minY to maxY, maxY.  Note, for geocentric datase X and Y are longitude and latitude respectively.");
     arguments.getApplicationUsage()->addCommandLineOption("-c directory","Shorthand for --file-cache directory.");
     arguments.getApplicationUsage()->addCommandLineOption("--file-cache directory","Set directory as to place cache download files.");
+    arguments.getApplicationUsage()->addCommandLineOption("--max-size megabytes","Limit the size of the file cache, least recently used files are removed once exceeded.");
+    arguments.getApplicationUsage()->addCommandLineOption("--hashed-names","Store cached files under hashed file names rather than mirroring the server paths.");
+    arguments.getApplicationUsage()->addCommandLineOption("--compress","Compress cached files, for formats that support it.");
+    arguments.getApplicationUsage()->addCommandLineOption("--compressor <name>","Compress cached files with the named compressor, such as zlib, lz4 or zstd.");
+    arguments.getApplicationUsage()->addCommandLineOption("--stats","Report the file cache statistics on exit.");
 
     // if user request help write it out to cout.
     if (arguments.read("-h") || arguments.read("--help"))
@@ -443,7 +448,24 @@ int main( int argc, char **argv )
         return 1;
     }
 
-    ldv.setFileCache(new osgDB::FileCache(fileCachePath));
+    osg::ref_ptr<osgDB::FileCache> fileCache = new osgDB::FileCache(fileCachePath);
+
+    double maxSize = 0.0;
+    while(arguments.read("--max-size",maxSize))
+    {
+        fileCache->setMaximumCacheSize(static_cast<unsigned long long>(maxSize*1024.0*1024.0));
+    }
+
+    while(arguments.read("--hashed-names")) { fileCache->setUseHashedFileNames(true); }
+    while(arguments.read("--compress")) { fileCache->setCompressCachedFiles(true); }
+
+    std::string compressor;
+    while(arguments.read("--compressor",compressor)) { fileCache->setCompressCachedFiles(true); fileCache->setCacheCompressor(compressor); }
+
+    bool reportStats = false;
+    while(arguments.read("--stats")) { reportStats = true; }
+
+    ldv.setFileCache(fileCache.get());
 
     unsigned int maxLevels = 0;
     while(arguments.read("-l",maxLevels))
@@ -489,6 +511,11 @@ int main( int argc, char **argv )
         std::cout<<"osgfilecache exited in response to signal : "<<s_SigValue<<std::endl;
     }
 
+    if (reportStats)
+    {
+        fileCache->reportStatistics(std::cout);
+    }
+
     return 0;
 }
 
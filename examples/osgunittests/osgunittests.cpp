@@ -573,6 +573,7 @@ int main( int argc, char** argv )
     arguments.getApplicationUsage()->addCommandLineOption("matrix","Display qualified tests.");
     arguments.getApplicationUsage()->addCommandLineOption("performance","Display qualified tests.");
     arguments.getApplicationUsage()->addCommandLineOption("read-threads <numthreads>","Run multi-thread reading test.");
+    arguments.getApplicationUsage()->addCommandLineOption("compressors [filename]","Compare .osgb compressors on the given scene, or on a generated one.");
 
 
     if (arguments.argc()<=1)
@@ -611,6 +612,23 @@ int main( int argc, char** argv )
     bool performanceTest = false;
     while (arguments.read("p") || arguments.read("performance")) performanceTest = true;
 
+    bool compressorTest = false;
+    std::string compressorTestFile;
+    int compressorsPos = arguments.find("compressors");
+    if (compressorsPos>0)
+    {
+        compressorTest = true;
+        if (compressorsPos+1<arguments.argc() && !arguments.isOption(compressorsPos+1))
+        {
+            compressorTestFile = arguments[compressorsPos+1];
+            arguments.remove(compressorsPos, 2);
+        }
+        else
+        {
+            arguments.remove(compressorsPos);
+        }
+    }
+
     // if user request help write it out to cout.
     if (arguments.read("-h") || arguments.read("--help"))
     {
@@ -681,6 +699,13 @@ int main( int argc, char** argv )
         runPerformanceTests();
     }
 
+    if (compressorTest)
+    {
+        std::cout<<"**** compressor tests  ******"<<std::endl;
+
+        runCompressorTests(compressorTestFile);
+    }
+
     if (numReadThreads>0)
     {
         runMultiThreadReadTests(numReadThreads, arguments);
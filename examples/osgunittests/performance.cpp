@@ -25,6 +25,27 @@
 #include <osg/ref_ptr>
 #include <osg/MatrixTransform>
 #include <osg/Group>
+#include <osg/State>
+#include <osg/Geometry>
+#include <osg/Geode>
+#include <osg/Program>
+
+#include <OpenThreads/Thread>
+
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+#include <osgDB/ObjectWrapper>
+#include <osgDB/DXTCImageProcessor>
+#include <osgDB/FileCache>
+#include <osgDB/ImageBufferPool>
+#include <osgDB/Archive>
+#include <osgDB/fstream>
+#include <osgDB/WriteFile>
+
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 struct Benchmark
 {
@@ -170,6 +191,460 @@ public:
     void apply(osg::Transform&) { }
 };
 
+/** StateAttribute that makes no OpenGL calls, so State's bookkeeping can be timed without a graphics context.*/
+class NullAttribute : public osg::StateAttribute
+{
+public:
+    NullAttribute(unsigned int member=0): _member(member) {}
+    NullAttribute(const NullAttribute& rhs, const osg::CopyOp& copyop=osg::CopyOp::SHALLOW_COPY): osg::StateAttribute(rhs, copyop), _member(rhs._member) {}
+
+    META_StateAttribute(osgunittests, NullAttribute, CLIPPLANE)
+
+    virtual unsigned int getMember() const { return _member; }
+
+    virtual int compare(const osg::StateAttribute& sa) const
+    {
+        COMPARE_StateAttribute_Types(NullAttribute, sa)
+        COMPARE_StateAttribute_Parameter(_member)
+        return 0;
+    }
+
+    virtual void apply(osg::State&) const {}
+
+protected:
+    unsigned int _member;
+};
+
+/** Push a parent StateSet then apply each of the leaf StateSets in turn, mimicking the draw traversal of a RenderBin.*/
+struct StateSetBenchmark
+{
+    StateSetBenchmark(unsigned int numModes, unsigned int numAttributes, unsigned int numLeaves)
+    {
+        _state = new osg::State;
+        _parent = new osg::StateSet;
+
+        for(unsigned int m=0; m<numModes; ++m)
+        {
+            // invalidate the modes so State doesn't call glEnable/glDisable.
+            _state->setModeValidity(GL_CLIP_PLANE0+m, false);
+            if (m%2==0) _parent->setMode(GL_CLIP_PLANE0+m, osg::StateAttribute::ON);
+        }
+
+        for(unsigned int a=0; a<numAttributes; a+=2)
+        {
+            _parent->setAttribute(new NullAttribute(a));
+        }
+
+        for(unsigned int l=0; l<numLeaves; ++l)
+        {
+            osg::ref_ptr<osg::StateSet> leaf = new osg::StateSet;
+            leaf->setMode(GL_CLIP_PLANE0+(l%numModes), osg::StateAttribute::OFF);
+            leaf->setMode(GL_CLIP_PLANE0+((l+1)%numModes), osg::StateAttribute::ON);
+            leaf->setAttribute(new NullAttribute(l%numAttributes));
+            _leaves.push_back(leaf);
+        }
+    }
+
+    void run()
+    {
+        _state->pushStateSet(_parent.get());
+        for(unsigned int l=0; l<_leaves.size(); ++l)
+        {
+            _state->apply(_leaves[l].get());
+        }
+        _state->popStateSet();
+        _state->apply();
+    }
+
+    osg::ref_ptr<osg::State>                    _state;
+    osg::ref_ptr<osg::StateSet>                 _parent;
+    std::vector< osg::ref_ptr<osg::StateSet> >  _leaves;
+};
+
+static void reportCheck(const std::string& name, bool passed)
+{
+    std::cout<<name<<"\t"<<(passed ? "passed" : "FAILED")<<std::endl;
+}
+
+/** Decode a pixel of a DXT5 compressed image level.*/
+static void decodeDXT5Pixel(const unsigned char* data, int width, int x, int y, int rgba[4])
+{
+    const unsigned char* block = data + ((y/4)*((width+3)/4) + x/4)*16;
+    int i = (y%4)*4 + x%4;
+
+    int a0 = block[0], a1 = block[1];
+    unsigned long long alphaBits = 0;
+    for(int b=0; b<6; ++b) alphaBits |= static_cast<unsigned long long>(block[2+b])<<(8*b);
+    int ai = static_cast<int>((alphaBits>>(3*i))&7);
+    if (ai==0) rgba[3] = a0;
+    else if (ai==1) rgba[3] = a1;
+    else if (a0>a1) rgba[3] = ((8-ai)*a0 + (ai-1)*a1)/7;
+    else if (ai<6) rgba[3] = ((6-ai)*a0 + (ai-1)*a1)/5;
+    else rgba[3] = (ai==6) ? 0 : 255;
+
+    int colours[4][3];
+    for(int c=0; c<2; ++c)
+    {
+        int packed = block[8+c*2] | (block[9+c*2]<<8);
+        int r5 = (packed>>11)&31, g6 = (packed>>5)&63, b5 = packed&31;
+        colours[c][0] = (r5<<3)|(r5>>2);
+        colours[c][1] = (g6<<2)|(g6>>4);
+        colours[c][2] = (b5<<3)|(b5>>2);
+    }
+    for(int k=0; k<3; ++k)
+    {
+        colours[2][k] = (2*colours[0][k] + colours[1][k])/3;
+        colours[3][k] = (colours[0][k] + 2*colours[1][k])/3;
+    }
+    unsigned int colourBits = block[12] | (block[13]<<8) | (block[14]<<16) | (static_cast<unsigned int>(block[15])<<24);
+    int ci = (colourBits>>(2*i))&3;
+    for(int k=0; k<3; ++k) rgba[k] = colours[ci][k];
+}
+
+static osg::Image* compressDXT5(osgDB::ImageProcessor& processor, const osg::Image& original)
+{
+    osg::Image* image = new osg::Image(original, osg::CopyOp::DEEP_COPY_ALL);
+    processor.compress(*image, osg::Texture::USE_S3TC_DXT5_COMPRESSION, true, false, osgDB::ImageProcessor::USE_CPU, osgDB::ImageProcessor::NORMAL);
+    return image;
+}
+
+/** Compress a smooth RGBA image to DXT5 and check the decoded result stays close to the original.*/
+static void runDXTCompressionTests(Benchmark& benchmark)
+{
+    const int size = 256;
+    osg::ref_ptr<osg::Image> original = new osg::Image;
+    original->allocateImage(size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+    for(int y=0; y<size; ++y)
+    {
+        for(int x=0; x<size; ++x)
+        {
+            unsigned char* pixel = original->data(x, y);
+            pixel[0] = static_cast<unsigned char>(x);
+            pixel[1] = static_cast<unsigned char>(y);
+            pixel[2] = static_cast<unsigned char>(128.0f+127.0f*sinf(float(x+y)*0.05f));
+            pixel[3] = static_cast<unsigned char>((x*y)/size);
+        }
+    }
+
+    osg::ref_ptr<osgDB::DXTCImageProcessor> processor = new osgDB::DXTCImageProcessor;
+    osg::ref_ptr<osg::Image> image;
+    RUN(benchmark, image = compressDXT5(*processor, *original), 10)
+
+    bool compressed = image->getPixelFormat()==GL_COMPRESSED_RGBA_S3TC_DXT5_EXT && image->getNumMipmapLevels()==9;
+    reportCheck("DXT5 compression with mipmaps", compressed);
+    if (!compressed) return;
+
+    int maxError = 0;
+    double totalError = 0.0;
+    for(int y=0; y<size; ++y)
+    {
+        for(int x=0; x<size; ++x)
+        {
+            int rgba[4];
+            decodeDXT5Pixel(image->data(), size, x, y, rgba);
+            const unsigned char* pixel = original->data(x, y);
+            for(int k=0; k<4; ++k)
+            {
+                int error = abs(rgba[k]-pixel[k]);
+                maxError = osg::maximum(maxError, error);
+                totalError += error;
+            }
+        }
+    }
+    double meanError = totalError/double(size*size*4);
+    std::cout<<"DXT5 round trip mean error "<<meanError<<", max error "<<maxError<<std::endl;
+    reportCheck("DXT5 round trip error", meanError<3.0 && maxError<24);
+
+    // compressed images of local files are cached under their path relative to the root of the file system.
+    osg::ref_ptr<osgDB::FileCache> fileCache = new osgDB::FileCache("/tmp/cache");
+    reportCheck("FileCache name of a local file", fileCache->createCacheFileName("/data/terrain.png.normal.dds")=="/tmp/cache/data/terrain.png.normal.dds");
+}
+
+static bool sameImage(const osg::Image* lhs, const osg::Image* rhs)
+{
+    return lhs && rhs &&
+           lhs->s()==rhs->s() && lhs->t()==rhs->t() &&
+           lhs->getPixelFormat()==rhs->getPixelFormat() &&
+           lhs->getInternalTextureFormat()==rhs->getInternalTextureFormat() &&
+           lhs->getDataType()==rhs->getDataType() &&
+           lhs->getTotalSizeInBytes()==rhs->getTotalSizeInBytes() &&
+           memcmp(lhs->data(), rhs->data(), lhs->getTotalSizeInBytes())==0;
+}
+
+/** Decode the same file repeatedly into a pool that fills up after the first image and check every
+  * image matches the one decoded without a pool, including those allocated once the pool is full.*/
+static void runPooledDecodeTest(const std::string& name, const osg::Image& original, const std::string& fileName)
+{
+    if (!osgDB::writeImageFile(original, fileName))
+    {
+        std::cout<<name<<"\tskipped, could not write "<<fileName<<std::endl;
+        return;
+    }
+
+    osg::ref_ptr<osg::Image> unpooled = osgDB::readRefImageFile(fileName);
+
+    osg::ref_ptr<osgDB::ImageBufferPool> pool = new osgDB::ImageBufferPool(1);
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options;
+    osgDB::ImageBufferPool::setImageBufferPool(options.get(), pool.get());
+
+    // disable the object cache so every read decodes the file again.
+    options->setObjectCacheHint(osgDB::Options::CACHE_NONE);
+
+    std::vector< osg::ref_ptr<osg::Image> > images;
+    for(unsigned int i=0; i<3; ++i)
+    {
+        images.push_back(osgDB::readRefImageFile(fileName, options.get()));
+    }
+
+    bool passed = unpooled.valid() && pool->getNumImages()==1;
+    for(unsigned int i=0; i<images.size(); ++i)
+    {
+        passed = passed && sameImage(images[i].get(), unpooled.get());
+    }
+
+    // once released the pooled image is recycled by the next read.
+    images.clear();
+    osg::ref_ptr<osg::Image> recycled = osgDB::readRefImageFile(fileName, options.get());
+    passed = passed && sameImage(recycled.get(), unpooled.get()) && pool->getNumImagesReused()==1;
+
+    reportCheck(name, passed);
+
+    remove(fileName.c_str());
+}
+
+static void runPooledDecodeTests()
+{
+    const int size = 64;
+    osg::ref_ptr<osg::Image> rgb = new osg::Image;
+    rgb->allocateImage(size, size, 1, GL_RGB, GL_UNSIGNED_BYTE);
+    osg::ref_ptr<osg::Image> luminanceAlpha = new osg::Image;
+    luminanceAlpha->allocateImage(size, size, 1, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE);
+    for(int y=0; y<size; ++y)
+    {
+        for(int x=0; x<size; ++x)
+        {
+            unsigned char* pixel = rgb->data(x, y);
+            pixel[0] = static_cast<unsigned char>(x*4);
+            pixel[1] = static_cast<unsigned char>(y*4);
+            pixel[2] = static_cast<unsigned char>((x+y)*2);
+
+            pixel = luminanceAlpha->data(x, y);
+            pixel[0] = static_cast<unsigned char>(x*4);
+            pixel[1] = static_cast<unsigned char>(255-y*4);
+        }
+    }
+
+    runPooledDecodeTest("JPEG pooled decode with a full pool", *rgb, "osgunittests_pooled.jpg");
+    runPooledDecodeTest("PNG pooled decode with a full pool", *rgb, "osgunittests_pooled.png");
+    runPooledDecodeTest("PNG pooled decode of luminance alpha", *luminanceAlpha, "osgunittests_pooled_la.png");
+}
+
+typedef osg::Program::PerContextProgram::UniformBlockMember UniformBlockMember;
+
+static UniformBlockMember createUniformBlockMember(const osg::Uniform& uniform, GLint offset, GLint arrayStride, GLint matrixStride)
+{
+    UniformBlockMember member;
+    member.nameID = uniform.getNameID();
+    member.type = uniform.getType();
+    member.size = uniform.getNumElements();
+    member.offset = offset;
+    member.arrayStride = arrayStride;
+    member.matrixStride = matrixStride;
+    return member;
+}
+
+static float readFloat(const std::vector<unsigned char>& data, unsigned int offset)
+{
+    float value;
+    memcpy(&value, &data[offset], sizeof(float));
+    return value;
+}
+
+/** Pack uniforms into a std140 block and check each value lands where the shader reads the value glUniform would set,
+  * then check the buffers of automatic blocks are trimmed once their uniforms are deleted or they are least recently used.*/
+static void runUniformBlockTests()
+{
+    // layout(std140) uniform Block { float f; vec3 v; mat3 m3; mat4 m4; vec2 a[3]; int i; };
+    osg::ref_ptr<osg::Uniform> f = new osg::Uniform("f", 1.5f);
+    osg::ref_ptr<osg::Uniform> v = new osg::Uniform("v", osg::Vec3(2.0f, 3.0f, 4.0f));
+    osg::Matrix3 matrix3(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f);
+    osg::ref_ptr<osg::Uniform> m3 = new osg::Uniform("m3", matrix3);
+    osg::Matrixf matrix4 = osg::Matrixf::rotate(0.5f, osg::Vec3(0.0f, 0.0f, 1.0f))*osg::Matrixf::translate(10.0f, 20.0f, 30.0f);
+    osg::ref_ptr<osg::Uniform> m4 = new osg::Uniform("m4", matrix4);
+    osg::ref_ptr<osg::Uniform> a = new osg::Uniform(osg::Uniform::FLOAT_VEC2, "a", 3);
+    for(unsigned int e=0; e<3; ++e) a->setElement(e, osg::Vec2(float(e), float(e*10)));
+    osg::ref_ptr<osg::Uniform> i = new osg::Uniform("i", 42);
+
+    std::vector<unsigned char> data(208, 0);
+    unsigned char* ptr = &data[0];
+    unsigned int size = static_cast<unsigned int>(data.size());
+
+    bool passed = true;
+    passed = passed && osg::Program::PerContextProgram::packUniformBlockMember(createUniformBlockMember(*f, 0, 0, 0), *f, ptr, size)==4;
+    passed = passed && osg::Program::PerContextProgram::packUniformBlockMember(createUniformBlockMember(*v, 16, 0, 0), *v, ptr, size)==28;
+    passed = passed && osg::Program::PerContextProgram::packUniformBlockMember(createUniformBlockMember(*m3, 32, 0, 16), *m3, ptr, size)==76;
+    passed = passed && osg::Program::PerContextProgram::packUniformBlockMember(createUniformBlockMember(*m4, 80, 0, 16), *m4, ptr, size)==144;
+    passed = passed && osg::Program::PerContextProgram::packUniformBlockMember(createUniformBlockMember(*a, 144, 16, 0), *a, ptr, size)==184;
+    passed = passed && osg::Program::PerContextProgram::packUniformBlockMember(createUniformBlockMember(*i, 192, 0, 0), *i, ptr, size)==196;
+
+    // glUniformMatrix*fv is passed the matrices without transposing, so column c row r of the GLSL matrix is matrix(c,r).
+    passed = passed && readFloat(data, 0)==1.5f;
+    for(unsigned int r=0; r<3; ++r) passed = passed && readFloat(data, 16+r*4)==v->getFloatArray()->at(r);
+    for(unsigned int c=0; c<3; ++c)
+        for(unsigned int r=0; r<3; ++r) passed = passed && readFloat(data, 32+c*16+r*4)==matrix3(c,r);
+    for(unsigned int c=0; c<4; ++c)
+        for(unsigned int r=0; r<4; ++r) passed = passed && readFloat(data, 80+c*16+r*4)==matrix4(c,r);
+    for(unsigned int e=0; e<3; ++e) passed = passed && readFloat(data, 144+e*16)==float(e) && readFloat(data, 144+e*16+4)==float(e*10);
+    int intValue = 0;
+    memcpy(&intValue, &data[192], sizeof(int));
+    passed = passed && intValue==42;
+
+    // the padding of the std140 layout is left untouched and mismatched types aren't packed.
+    passed = passed && readFloat(data, 28)==0.0f && readFloat(data, 44)==0.0f && readFloat(data, 152)==0.0f;
+    passed = passed && osg::Program::PerContextProgram::packUniformBlockMember(createUniformBlockMember(*f, 0, 0, 0), *i, ptr, size)==0;
+
+    reportCheck("Uniform block packing matches glUniform", passed);
+
+    typedef osg::Program::PerContextProgram::AutomaticUniformBlock AutomaticUniformBlock;
+    typedef osg::Program::PerContextProgram::UniformBlockBuffer UniformBlockBuffer;
+
+    AutomaticUniformBlock block;
+    osg::ref_ptr<osg::Uniform> deleted = new osg::Uniform("f", 2.5f);
+    osg::Uniform* uniforms[3] = { f.get(), deleted.get(), v.get() };
+    for(unsigned int b=0; b<3; ++b)
+    {
+        osg::ref_ptr<UniformBlockBuffer> buffer = new UniformBlockBuffer;
+        buffer->packedUniforms.push_back(osg::Program::PerContextProgram::UniformModifiedCountList::value_type(uniforms[b], 0));
+        buffer->lastUsed = ++block.useCount;
+        block.buffers[std::vector<const osg::Uniform*>(1, uniforms[b])] = buffer;
+    }
+    block.lastBound = block.buffers.begin()->second.get();
+
+    deleted = 0;
+    block.trimBuffers(3);
+    passed = block.buffers.size()==2 && block.buffers.count(std::vector<const osg::Uniform*>(1, f.get()))==1;
+
+    block.trimBuffers(2);
+    passed = passed && block.buffers.size()==1 && block.buffers.count(std::vector<const osg::Uniform*>(1, v.get()))==1;
+    passed = passed && (block.lastBound==0 || block.lastBound==block.buffers.begin()->second.get());
+
+    reportCheck("Uniform block buffers trimmed", passed);
+}
+
+static unsigned int getNumVertices(const osg::Node* node)
+{
+    const osg::Group* group = node ? node->asGroup() : 0;
+    const osg::Geometry* geometry = (group && group->getNumChildren()>0) ? group->getChild(0)->asGeometry() : 0;
+    return (geometry && geometry->getVertexArray()) ? geometry->getVertexArray()->getNumElements() : 0;
+}
+
+/** Read every entry of an archive, returning the number that matched the node written for it.*/
+static unsigned int readArchiveEntries(osgDB::Archive* archive, unsigned int numEntries)
+{
+    unsigned int numMatched = 0;
+    for(unsigned int i=0; i<numEntries; ++i)
+    {
+        std::ostringstream name;
+        name<<"tile_"<<i<<".osgb";
+        osg::ref_ptr<osg::Node> node = archive->readNode(name.str()).takeNode();
+        if (node.valid() && node->getName()==name.str() && getNumVertices(node.get())==100+i) ++numMatched;
+    }
+    return numMatched;
+}
+
+class ArchiveReadThread : public OpenThreads::Thread
+{
+public:
+
+    ArchiveReadThread(osgDB::Archive* archive, unsigned int numEntries):
+        _archive(archive),
+        _numEntries(numEntries),
+        _numMatched(0) {}
+
+    virtual void run() { _numMatched = readArchiveEntries(_archive, _numEntries); }
+
+    osgDB::Archive* _archive;
+    unsigned int    _numEntries;
+    unsigned int    _numMatched;
+};
+
+/** Write an archive, then compare reading its entries with positional reads, as archives opened from a file do,
+  * against the seek and read of archives opened from a stream, and check concurrent positional reads.*/
+static void runArchiveReadTests(Benchmark& benchmark)
+{
+    const std::string fileName = "osgunittests_archive.osga";
+    const unsigned int numEntries = 64;
+
+    {
+        osg::ref_ptr<osgDB::Archive> archive = osgDB::openArchive(fileName, osgDB::Archive::CREATE);
+        if (!archive)
+        {
+            std::cout<<"OSGA archive reads\tskipped, could not create "<<fileName<<std::endl;
+            return;
+        }
+
+        for(unsigned int i=0; i<numEntries; ++i)
+        {
+            std::ostringstream name;
+            name<<"tile_"<<i<<".osgb";
+
+            osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(100+i);
+            for(unsigned int v=0; v<vertices->size(); ++v) (*vertices)[v].set(float(v), float(i), 0.0f);
+            osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+            geometry->setVertexArray(vertices.get());
+            geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
+
+            osg::ref_ptr<osg::Group> group = new osg::Group;
+            group->setName(name.str());
+            group->addChild(geometry.get());
+            archive->writeNode(*group, name.str());
+        }
+        archive->close();
+    }
+
+    osg::ref_ptr<osgDB::Archive> positionalArchive = osgDB::openArchive(fileName, osgDB::Archive::READ);
+
+    osg::ref_ptr<osgDB::Archive> streamArchive;
+    osgDB::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension("osga");
+    if (rw) streamArchive = rw->openArchive(fin, 0).takeArchive();
+
+    bool passed = positionalArchive.valid() && streamArchive.valid();
+    if (passed)
+    {
+        unsigned int numPositional = 0, numStream = 0;
+        RUN(benchmark, numPositional = readArchiveEntries(positionalArchive.get(), numEntries), 10)
+        RUN(benchmark, numStream = readArchiveEntries(streamArchive.get(), numEntries), 10)
+
+        passed = numPositional==numEntries && numStream==numEntries &&
+                 !positionalArchive->fileExists("missing.osgb") && !streamArchive->fileExists("missing.osgb");
+    }
+    reportCheck("OSGA positional and stream reads match", passed);
+
+    if (positionalArchive.valid())
+    {
+        std::vector<ArchiveReadThread*> threads;
+        for(unsigned int t=0; t<4; ++t)
+        {
+            threads.push_back(new ArchiveReadThread(positionalArchive.get(), numEntries));
+            threads.back()->start();
+        }
+
+        bool concurrent = true;
+        for(unsigned int t=0; t<threads.size(); ++t)
+        {
+            threads[t]->join();
+            concurrent = concurrent && threads[t]->_numMatched==numEntries;
+            delete threads[t];
+        }
+        reportCheck("OSGA concurrent positional reads", concurrent);
+    }
+
+    positionalArchive = 0;
+    streamArchive = 0;
+    fin.close();
+    remove(fileName.c_str());
+}
 
 void runPerformanceTests()
 {
@@ -219,5 +694,110 @@ void runPerformanceTests()
     CustomNodeVisitor cnv;
     RUN(benchmark, { osg::MatrixTransform* mtl = dynamic_cast<osg::MatrixTransform*>(m); if (mtl) cnv.apply(*mtl); }, 1000)
     RUN(benchmark, { m->accept(cnv); }, 10000)
-    
+
+    StateSetBenchmark smallStateSets(8, 8, 100);
+    RUN(benchmark, smallStateSets.run(), 1000)
+
+    StateSetBenchmark largeStateSets(64, 64, 100);
+    RUN(benchmark, largeStateSets.run(), 1000)
+
+    runDXTCompressionTests(benchmark);
+
+    runPooledDecodeTests();
+
+    runUniformBlockTests();
+
+    runArchiveReadTests(benchmark);
+}
+
+static osg::Node* createCompressorTestScene()
+{
+    // a grid of terrain tiles with per vertex normals and texture coordinates, similar to paged database tiles.
+    const unsigned int numTiles = 16;
+    const unsigned int numVertices = 33;
+    osg::Geode* geode = new osg::Geode;
+    for(unsigned int tile=0; tile<numTiles*numTiles; ++tile)
+    {
+        osg::Geometry* geometry = new osg::Geometry;
+        osg::Vec3Array* vertices = new osg::Vec3Array;
+        osg::Vec3Array* normals = new osg::Vec3Array;
+        osg::Vec2Array* texcoords = new osg::Vec2Array;
+        for(unsigned int r=0; r<numVertices; ++r)
+        {
+            for(unsigned int c=0; c<numVertices; ++c)
+            {
+                float x = float((tile%numTiles)*(numVertices-1)+c);
+                float y = float((tile/numTiles)*(numVertices-1)+r);
+                float z = 10.0f*sinf(x*0.05f)*cosf(y*0.07f) + float(rand()%100)*0.01f;
+                vertices->push_back(osg::Vec3(x, y, z));
+                normals->push_back(osg::Vec3(0.0f, 0.0f, 1.0f));
+                texcoords->push_back(osg::Vec2(float(c)/float(numVertices-1), float(r)/float(numVertices-1)));
+            }
+        }
+
+        osg::DrawElementsUShort* elements = new osg::DrawElementsUShort(GL_TRIANGLES);
+        for(unsigned int r=0; r<numVertices-1; ++r)
+        {
+            for(unsigned int c=0; c<numVertices-1; ++c)
+            {
+                unsigned short i = r*numVertices+c;
+                elements->push_back(i); elements->push_back(i+1); elements->push_back(i+numVertices);
+                elements->push_back(i+1); elements->push_back(i+numVertices+1); elements->push_back(i+numVertices);
+            }
+        }
+
+        geometry->setVertexArray(vertices);
+        geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+        geometry->setTexCoordArray(0, texcoords);
+        geometry->addPrimitiveSet(elements);
+        geode->addDrawable(geometry);
+    }
+    return geode;
+}
+
+void runCompressorTests(const std::string& filename)
+{
+    osg::ref_ptr<osg::Node> node = filename.empty() ? createCompressorTestScene() : osgDB::readRefNodeFile(filename).get();
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+    if (!node || !rw)
+    {
+        std::cout<<"Unable to run compressor tests, no scene or no .osgb plugin"<<std::endl;
+        return;
+    }
+
+    struct Setting { const char* compressor; const char* options; };
+    const Setting settings[] =
+    {
+        { "", "" },
+        { "zlib", "" }, { "zlib", "CompressionLevel=1" }, { "zlib", "CompressionLevel=9" },
+        { "lz4", "" }, { "lz4", "CompressionLevel=9" },
+        { "zstd", "CompressionLevel=1" }, { "zstd", "" }, { "zstd", "CompressionLevel=19" }
+    };
+
+    osg::Timer timer;
+    std::cout<<"compressor\tsettings\tsize (bytes)\twrite (ms)\tread (ms)"<<std::endl;
+    for(unsigned int i=0; i<sizeof(settings)/sizeof(Setting); ++i)
+    {
+        std::string compressor = settings[i].compressor;
+        if (!compressor.empty() && !osgDB::Registry::instance()->getObjectWrapperManager()->findCompressor(compressor))
+        {
+            std::cout<<compressor<<"\tnot available"<<std::endl;
+            continue;
+        }
+
+        std::string optionString = settings[i].options;
+        if (!compressor.empty()) optionString += std::string(" Compressor=") + compressor;
+        osg::ref_ptr<osgDB::Options> options = new osgDB::Options(optionString);
+
+        std::stringstream stream;
+        osg::Timer_t startTick = timer.tick();
+        rw->writeNode(*node, stream, options.get());
+        osg::Timer_t writeTick = timer.tick();
+        osgDB::ReaderWriter::ReadResult result = rw->readNode(stream, options.get());
+        osg::Timer_t readTick = timer.tick();
+
+        std::cout<<(compressor.empty() ? "none" : compressor.c_str())<<"\t"<<(*settings[i].options ? settings[i].options : "-")<<"\t"
+                 <<stream.str().size()<<"\t"<<timer.delta_m(startTick, writeTick)<<"\t"<<timer.delta_m(writeTick, readTick)
+                 <<(result.validNode() ? "" : "\tread failed")<<std::endl;
+    }
 }
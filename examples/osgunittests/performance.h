@@ -23,4 +23,10 @@
 
 extern void runPerformanceTests();
 
+#include <string>
+
+/** Compare the size and the write and read times of .osgb files written with each available compressor,
+  * using the scene in filename or a generated terrain when filename is empty.*/
+extern void runCompressorTests(const std::string& filename);
+
 #endif
@@ -0,0 +1,345 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/BoundUpdateQueue>
+#include <osg/Drawable>
+#include <osg/Group>
+#include <osg/Notify>
+#include <osg/Timer>
+#include <osg/ApplicationUsage>
+
+#include <OpenThreads/Atomic>
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace osg;
+
+static osg::ApplicationUsageProxy BoundUpdateQueue_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_BOUND_UPDATE_THREADS <value>","Number of threads used to recompute the bounds batched by a BoundUpdateQueue.");
+
+// the queue collecting dirtied nodes, 0 when no queue is between begin() and end().
+static OpenThreads::AtomicPtr s_collectingQueue;
+
+static unsigned int getDefaultNumBoundUpdateThreads()
+{
+    static int s_numThreads = -1;
+    if (s_numThreads<0)
+    {
+        const char* str = getenv("OSG_BOUND_UPDATE_THREADS");
+        s_numThreads = str ? std::max(1, atoi(str)) : 1;
+    }
+    return static_cast<unsigned int>(s_numThreads);
+}
+
+static inline void computeNodeBound(Node* node)
+{
+    // Drawable hides Node::getBound() to compute its bounding box alongside the sphere.
+    Drawable* drawable = node->asDrawable();
+    if (drawable) drawable->getBoundingBox();
+    else node->getBound();
+}
+
+namespace osg
+{
+
+/** Recomputes the bounds of a range of nodes in a level on one of the BoundUpdateQueue's threads.*/
+class ComputeBoundsOperation : public osg::Operation
+{
+    public:
+
+        ComputeBoundsOperation(Node* const* begin, Node* const* end, RefBlockCount* block):
+            osg::Operation("ComputeBoundsOperation", false),
+            _begin(begin),
+            _end(end),
+            _block(block) {}
+
+        virtual void operator () (osg::Object*)
+        {
+            for(Node* const* itr = _begin; itr != _end; ++itr)
+            {
+                computeNodeBound(*itr);
+            }
+            _block->completed();
+        }
+
+    protected:
+
+        Node* const*                _begin;
+        Node* const*                _end;
+        ref_ptr<RefBlockCount>      _block;
+};
+
+}
+
+BoundUpdateQueue::BoundUpdateQueue():
+    _collecting(false),
+    _beginThread(0),
+    _numDirtyBoundCalls(0),
+    _numThreads(getDefaultNumBoundUpdateThreads()),
+    _minimumParallelLevelSize(256)
+{
+}
+
+BoundUpdateQueue::~BoundUpdateQueue()
+{
+    if (_collecting) end();
+}
+
+BoundUpdateQueue* BoundUpdateQueue::getCurrent()
+{
+    BoundUpdateQueue* queue = static_cast<BoundUpdateQueue*>(s_collectingQueue.get());
+    return (queue && queue->participates(OpenThreads::Thread::CurrentThread())) ? queue : 0;
+}
+
+bool BoundUpdateQueue::participates(OpenThreads::Thread* thread) const
+{
+    // the begin thread is set before the queue is made current, so only the added threads need the lock.
+    if (thread==_beginThread) return _collecting;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _collecting && std::find(_threads.begin(), _threads.end(), thread)!=_threads.end();
+}
+
+void BoundUpdateQueue::begin()
+{
+    if (_collecting) return;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _beginThread = OpenThreads::Thread::CurrentThread();
+        _numDirtyBoundCalls = 0;
+        _collecting = true;
+    }
+
+    if (!s_collectingQueue.assign(this, 0))
+    {
+        OSG_NOTICE<<"Warning: BoundUpdateQueue::begin() another BoundUpdateQueue is already collecting, bounds will be dirtied immediately."<<std::endl;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _collecting = false;
+    }
+}
+
+void BoundUpdateQueue::addThread(OpenThreads::Thread* thread)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    if (std::find(_threads.begin(), _threads.end(), thread)==_threads.end()) _threads.push_back(thread);
+}
+
+void BoundUpdateQueue::removeThread(OpenThreads::Thread* thread)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    Threads::iterator itr = std::find(_threads.begin(), _threads.end(), thread);
+    if (itr!=_threads.end()) _threads.erase(itr);
+}
+
+void BoundUpdateQueue::add(Node* node)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _dirtyNodes.push_back(node);
+    ++_numDirtyBoundCalls;
+}
+
+void BoundUpdateQueue::setNumThreads(unsigned int numThreads)
+{
+    if (numThreads==0) numThreads = 1;
+    if (_numThreads==numThreads) return;
+
+    _numThreads = numThreads;
+
+    // threads are recreated on demand at the new count.
+    _operationThreads.clear();
+    _operationQueue = 0;
+}
+
+void BoundUpdateQueue::end()
+{
+    if (!_collecting) return;
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    s_collectingQueue.assign(0, this);
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _collecting = false;
+    }
+
+    _statistics = Statistics();
+    _statistics.numDirtyBoundCalls = _numDirtyBoundCalls;
+
+    if (!_dirtyNodes.empty())
+    {
+        computeLevels();
+
+        _statistics.numLevels = static_cast<unsigned int>(_levels.size());
+
+        // recompute from the recorded nodes up, a node whose dirty children are on the same or a later level computes
+        // them on demand, which computeBounds() keeps out of the parallel ranges.
+        for(Levels::iterator itr = _levels.begin(); itr != _levels.end(); ++itr)
+        {
+            computeBounds(*itr);
+        }
+
+        // release the references on the dirtied nodes, keeping the containers' capacity for the next frame
+        _dirtyNodes.clear();
+        for(Levels::iterator itr = _levels.begin(); itr != _levels.end(); ++itr)
+        {
+            itr->clear();
+        }
+    }
+
+    _statistics.updateTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+}
+
+void BoundUpdateQueue::computeLevels()
+{
+    // a node may have been recorded more than once if its bound was recomputed in between, so clear the flags of all the
+    // recorded nodes and then claim each node the first time it's seen by setting its flag again.
+    for(DirtyNodes::iterator itr = _dirtyNodes.begin(); itr != _dirtyNodes.end(); ++itr)
+    {
+        (*itr)->_boundingSphereComputed = false;
+    }
+
+    _levels.resize(1);
+    for(DirtyNodes::iterator itr = _dirtyNodes.begin(); itr != _dirtyNodes.end(); ++itr)
+    {
+        if (!(*itr)->_boundingSphereComputed)
+        {
+            (*itr)->_boundingSphereComputed = true;
+            _levels[0].push_back(itr->get());
+        }
+    }
+
+    for(std::vector<Node*>::iterator itr = _levels[0].begin(); itr != _levels[0].end(); ++itr)
+    {
+        (*itr)->_boundingSphereComputed = false;
+    }
+
+    // dirty the ancestors of the recorded nodes a level at a time, each level holding the parents first reached from the
+    // level below. As with Node::dirtyBound() the walk stops at parents that are already dirty, as they are either recorded
+    // or reached already, or were dirtied outside of the batch along with their ancestors.
+    for(unsigned int l=0; !_levels[l].empty(); ++l)
+    {
+        if (_levels.size()==l+1) _levels.push_back(std::vector<Node*>());
+
+        std::vector<Node*>& parentLevel = _levels[l+1];
+        for(std::vector<Node*>::iterator itr = _levels[l].begin(); itr != _levels[l].end(); ++itr)
+        {
+            const Node::ParentList& parents = (*itr)->getParents();
+            for(Node::ParentList::const_iterator pitr = parents.begin(); pitr != parents.end(); ++pitr)
+            {
+                if ((*pitr)->_boundingSphereComputed)
+                {
+                    (*pitr)->_boundingSphereComputed = false;
+                    parentLevel.push_back(*pitr);
+                }
+            }
+        }
+    }
+
+    _levels.pop_back();
+
+    for(Levels::iterator itr = _levels.begin(); itr != _levels.end(); ++itr)
+    {
+        _statistics.numNodesDirtied += static_cast<unsigned int>(itr->size());
+    }
+}
+
+bool BoundUpdateQueue::childrenComputed(const Node* node)
+{
+    const Group* group = node->asGroup();
+    if (!group) return true;
+
+    for(unsigned int i=0; i<group->getNumChildren(); ++i)
+    {
+        if (!group->getChild(i)->_boundingSphereComputed) return false;
+    }
+    return true;
+}
+
+void BoundUpdateQueue::computeBounds(std::vector<Node*>& level)
+{
+    // nodes already recomputed since being dirtied, by a getBound() call during the update, need no work.
+    std::vector<Node*>::iterator last = level.begin();
+    for(std::vector<Node*>::iterator itr = level.begin(); itr != level.end(); ++itr)
+    {
+        if (!(*itr)->_boundingSphereComputed) *(last++) = *itr;
+    }
+    level.erase(last, level.end());
+
+    _statistics.numBoundsComputed += static_cast<unsigned int>(level.size());
+
+    if (_numThreads<2 || level.size()<_minimumParallelLevelSize)
+    {
+        for(std::vector<Node*>::iterator itr = level.begin(); itr != level.end(); ++itr)
+        {
+            computeNodeBound(*itr);
+        }
+        return;
+    }
+
+    // a child dirtied outside of the batch, such as a newly merged subgraph, is computed lazily by its parents' computeBound(),
+    // which isn't safe to do concurrently when the child is shared, so leave the parents of such children to this thread.
+    std::vector<Node*>::iterator parallelEnd = std::stable_partition(level.begin(), level.end(), &BoundUpdateQueue::childrenComputed);
+
+    unsigned int numParallel = static_cast<unsigned int>(parallelEnd - level.begin());
+    if (numParallel>=_minimumParallelLevelSize)
+    {
+        if (!_operationQueue)
+        {
+            _operationQueue = new OperationQueue;
+            for(unsigned int i=1; i<_numThreads; ++i)
+            {
+                ref_ptr<OperationThread> thread = new OperationThread;
+                thread->setOperationQueue(_operationQueue.get());
+                thread->startThread();
+                _operationThreads.push_back(thread);
+            }
+        }
+
+        // split the level into contiguous ranges, one per thread, the first range being computed on this thread.
+        unsigned int numRanges = _numThreads;
+        unsigned int rangeSize = (numParallel+numRanges-1)/numRanges;
+        numRanges = (numParallel+rangeSize-1)/rangeSize;
+
+        Node* const* first = &level.front();
+        Node* const* parallelLast = first + numParallel;
+
+        ref_ptr<RefBlockCount> block = new RefBlockCount(numRanges-1);
+        block->reset();
+        for(unsigned int r=1; r<numRanges; ++r)
+        {
+            Node* const* begin = first + r*rangeSize;
+            Node* const* end = std::min(begin + rangeSize, parallelLast);
+            _operationQueue->add(new ComputeBoundsOperation(begin, end, block.get()));
+        }
+
+        for(Node* const* itr = first; itr != first + rangeSize; ++itr)
+        {
+            computeNodeBound(*itr);
+        }
+
+        block->block();
+    }
+    else
+    {
+        parallelEnd = level.begin();
+    }
+
+    for(std::vector<Node*>::iterator itr = parallelEnd; itr != level.end(); ++itr)
+    {
+        computeNodeBound(*itr);
+    }
+}
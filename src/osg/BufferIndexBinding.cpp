@@ -67,7 +67,7 @@ void BufferIndexBinding::apply(State& state) const
             return;
         if (glObject->isDirty()) glObject->compileBuffer();
         glObject->_extensions->glBindBufferRange(_target, _index,
-                                                 glObject->getGLObjectID(), _offset, _size);
+                                                 glObject->getGLObjectID(), glObject->getBaseOffset()+_offset, _size);
     }
 }
 
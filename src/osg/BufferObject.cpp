@@ -14,6 +14,8 @@
 #include <stdio.h>
 #include <math.h>
 #include <float.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <osg/BufferObject>
 #include <osg/Notify>
@@ -25,6 +27,7 @@
 #include <osg/PrimitiveSet>
 #include <osg/Array>
 #include <osg/ContextData>
+#include <osg/ApplicationUsage>
 
 #include <OpenThreads/ScopedLock>
 #include <OpenThreads/Mutex>
@@ -56,6 +59,11 @@ GLBufferObject::GLBufferObject(unsigned int contextID, BufferObject* bufferObjec
     _profile(0,0,0),
     _allocatedSize(0),
     _dirty(true),
+    _baseOffset(0),
+    _segmentSize(0),
+    _currentSegment(0),
+    _mappedPointer(0),
+    _streamingFailed(false),
     _bufferObject(0),
     _set(0),
     _previous(0),
@@ -63,6 +71,8 @@ GLBufferObject::GLBufferObject(unsigned int contextID, BufferObject* bufferObjec
     _frameLastUsed(0),
     _extensions(0)
 {
+    for(unsigned int i=0; i<NUM_STREAMING_SEGMENTS; ++i) _segmentFences[i] = 0;
+
     assign(bufferObject);
 
     _extensions = GLExtensions::Get(contextID, true);
@@ -92,6 +102,9 @@ void GLBufferObject::setBufferObject(BufferObject* bufferObject)
 
 void GLBufferObject::assign(BufferObject* bufferObject)
 {
+    // immutable storage can't be resized for the new BufferObject so start again with a fresh buffer.
+    if (_segmentSize>0) releaseStreamingStorage(true);
+
     _bufferObject = bufferObject;
 
     if (_bufferObject)
@@ -205,6 +218,18 @@ void GLBufferObject::compileBuffer()
 
     }
 
+    if (useStreaming())
+    {
+        compileStreamingBuffer(newTotalSize);
+        return;
+    }
+    else if (_segmentSize>0)
+    {
+        // no longer streaming so replace the immutable storage with a buffer that glBufferData can be used on.
+        releaseStreamingStorage(true);
+        _extensions->glBindBuffer(_profile._target, _glObjectID);
+    }
+
     if (_allocatedSize != _profile._size)
     {
         _allocatedSize = _profile._size;
@@ -242,9 +267,165 @@ void GLBufferObject::compileBuffer()
     }
 }
 
+bool GLBufferObject::useStreaming() const
+{
+    if (_streamingFailed || !_extensions->isBufferStorageSupported || !_extensions->glFenceSync || !_extensions->glClientWaitSync) return false;
+
+    switch(_profile._target)
+    {
+        case(GL_ARRAY_BUFFER_ARB):
+        case(GL_ELEMENT_ARRAY_BUFFER_ARB):
+        case(GL_UNIFORM_BUFFER):
+            break;
+        default:
+            return false;
+    }
+
+    GLBufferObjectManager* manager = _set ? _set->getParent() : 0;
+    if (manager && !manager->getStreamingEnabled()) return false;
+
+    if (_bufferObject->getStreaming()) return true;
+
+    for(unsigned int i=0; i<_bufferObject->getNumBufferData(); ++i)
+    {
+        const BufferData* bd = _bufferObject->getBufferData(i);
+        if (bd && bd->getDataVariance()==Object::DYNAMIC) return true;
+    }
+
+    return false;
+}
+
+void GLBufferObject::compileStreamingBuffer(unsigned int totalSize)
+{
+    // align the segments so that their offsets are suitable for glBindBufferRange on uniform buffers.
+    unsigned int segmentSize = computeBufferAlignment(osg::maximum(totalSize, 1u), 256);
+
+    if (!_mappedPointer || segmentSize>_segmentSize)
+    {
+        releaseStreamingStorage(_segmentSize>0);
+
+        _segmentSize = segmentSize;
+        _allocatedSize = _segmentSize*NUM_STREAMING_SEGMENTS;
+
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        _extensions->glBindBuffer(_profile._target, _glObjectID);
+        _extensions->glBufferStorage(_profile._target, _allocatedSize, NULL, flags);
+        _mappedPointer = _extensions->glMapBufferRange(_profile._target, 0, _allocatedSize, flags);
+
+        if (!_mappedPointer)
+        {
+            OSG_NOTICE<<"Warning: GLBufferObject::compileStreamingBuffer() unable to map buffer, falling back to glBufferSubData uploads."<<std::endl;
+
+            _streamingFailed = true;
+            releaseStreamingStorage(true);
+
+            _dirty = true;
+            compileBuffer();
+            return;
+        }
+
+        _currentSegment = 0;
+    }
+    else
+    {
+        // all the draws reading the current segment have been issued, so fence it and move on to the next one.
+        _segmentFences[_currentSegment] = _extensions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        _currentSegment = (_currentSegment+1) % NUM_STREAMING_SEGMENTS;
+
+        GLsync& fence = _segmentFences[_currentSegment];
+        if (fence)
+        {
+            GLenum result = _extensions->glClientWaitSync(fence, 0, 0);
+            if (result==GL_TIMEOUT_EXPIRED)
+            {
+                GLBufferObjectManager* manager = _set ? _set->getParent() : 0;
+                if (manager) ++(manager->getNumberStreamingWaits());
+
+                do
+                {
+                    result = _extensions->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+                } while(result==GL_TIMEOUT_EXPIRED);
+            }
+
+            _extensions->glDeleteSync(fence);
+            fence = 0;
+        }
+
+        _extensions->glBindBuffer(_profile._target, _glObjectID);
+    }
+
+    _baseOffset = static_cast<GLsizeiptr>(_currentSegment)*_segmentSize;
+
+    // the segment holds the data from NUM_STREAMING_SEGMENTS updates ago so all the entries have to be written.
+    unsigned char* segment = reinterpret_cast<unsigned char*>(_mappedPointer) + _baseOffset;
+    for(BufferEntries::iterator itr = _bufferEntries.begin();
+        itr != _bufferEntries.end();
+        ++itr)
+    {
+        BufferEntry& entry = *itr;
+        if (!entry.dataSource) continue;
+
+        entry.numRead = 0;
+        entry.modifiedCount = entry.dataSource->getModifiedCount();
+
+        const osg::Image* image = entry.dataSource->asImage();
+        if (image && !(image->isDataContiguous()))
+        {
+            unsigned int offset = entry.offset;
+            for(osg::Image::DataIterator img_itr(image); img_itr.valid(); ++img_itr)
+            {
+                memcpy(segment + offset, img_itr.data(), img_itr.size());
+                offset += img_itr.size();
+            }
+        }
+        else if (entry.dataSource->getDataPointer())
+        {
+            memcpy(segment + entry.offset, entry.dataSource->getDataPointer(), entry.dataSize);
+        }
+    }
+
+    GLBufferObjectManager* manager = _set ? _set->getParent() : 0;
+    if (manager) manager->getNumberBytesStreamed() += totalSize;
+}
+
+void GLBufferObject::releaseStreamingStorage(bool regenerateBuffer)
+{
+    if (_mappedPointer)
+    {
+        _extensions->glBindBuffer(_profile._target, _glObjectID);
+        _extensions->glUnmapBuffer(_profile._target);
+        _extensions->glBindBuffer(_profile._target, 0);
+        _mappedPointer = 0;
+    }
+
+    for(unsigned int i=0; i<NUM_STREAMING_SEGMENTS; ++i)
+    {
+        if (_segmentFences[i])
+        {
+            _extensions->glDeleteSync(_segmentFences[i]);
+            _segmentFences[i] = 0;
+        }
+    }
+
+    if (regenerateBuffer && _glObjectID!=0)
+    {
+        _extensions->glDeleteBuffers(1, &_glObjectID);
+        _glObjectID = 0;
+        _extensions->glGenBuffers(1, &_glObjectID);
+    }
+
+    _segmentSize = 0;
+    _currentSegment = 0;
+    _baseOffset = 0;
+    _allocatedSize = 0;
+}
+
 void GLBufferObject::deleteGLObject()
 {
     OSG_INFO<<"GLBufferObject::deleteGLObject() "<<_glObjectID<<std::endl;
+
+    if (_segmentSize>0) releaseStreamingStorage(false);
+
     if (_glObjectID!=0)
     {
         _extensions->glDeleteBuffers(1, &_glObjectID);
@@ -850,6 +1031,7 @@ unsigned int GLBufferObjectSet::computeNumGLBufferObjectsInList() const
     return num;
 }
 
+static osg::ApplicationUsageProxy GLBufferObjectManager_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_STREAMING_BUFFER_OBJECTS <mode>","ON | OFF - upload dynamic buffer objects through persistently mapped ring buffers when supported.");
 
 GLBufferObjectManager::GLBufferObjectManager(unsigned int contextID):
     GraphicsObjectManager("GLBufferObjectManager", contextID),
@@ -864,8 +1046,16 @@ GLBufferObjectManager::GLBufferObjectManager(unsigned int contextID):
     _numGenerated(0),
     _generateTime(0.0),
     _numApplied(0),
-    _applyTime(0.0)
+    _applyTime(0.0),
+    _streamingEnabled(true),
+    _numBytesStreamed(0),
+    _numStreamingWaits(0)
 {
+    const char* str = getenv("OSG_STREAMING_BUFFER_OBJECTS");
+    if (str)
+    {
+        _streamingEnabled = !(strcmp(str,"OFF")==0 || strcmp(str,"off")==0 || strcmp(str,"Off")==0);
+    }
 }
 
 GLBufferObjectManager::~GLBufferObjectManager()
@@ -999,6 +1189,7 @@ void GLBufferObjectManager::reportStats(std::ostream& out)
     out<<"   total _numGenerated="<<_numGenerated<<", _generateTime="<<_generateTime<<", averagePerFrame="<<_generateTime/numFrames*1000.0<<"ms"<<std::endl;
     out<<"   total _numDeleted="<<_numDeleted<<", _deleteTime="<<_deleteTime<<", averagePerFrame="<<_deleteTime/numFrames*1000.0<<"ms"<<std::endl;
     out<<"   total _numApplied="<<_numApplied<<", _applyTime="<<_applyTime<<", averagePerFrame="<<_applyTime/numFrames*1000.0<<"ms"<<std::endl;
+    out<<"   total _numBytesStreamed="<<_numBytesStreamed<<", averagePerFrame="<<double(_numBytesStreamed)/numFrames<<" bytes, _numStreamingWaits="<<_numStreamingWaits<<std::endl;
     out<<"   getMaxGLBufferObjectPoolSize()="<<getMaxGLBufferObjectPoolSize()<<" current/max size = "<<double(_currGLBufferObjectPoolSize)/double(getMaxGLBufferObjectPoolSize())<<std::endl;;
 
     recomputeStats(out);
@@ -1016,6 +1207,9 @@ void GLBufferObjectManager::resetStats()
 
     _numApplied = 0;
     _applyTime = 0;
+
+    _numBytesStreamed = 0;
+    _numStreamingWaits = 0;
 }
 
 void GLBufferObjectManager::recomputeStats(std::ostream& out) const
@@ -1052,13 +1246,15 @@ void GLBufferObjectManager::recomputeStats(std::ostream& out) const
 // BufferObject
 //
 BufferObject::BufferObject():
-    _copyDataAndReleaseGLBufferObject(false)
+    _copyDataAndReleaseGLBufferObject(false),
+    _streaming(false)
 {
 }
 
 BufferObject::BufferObject(const BufferObject& bo,const CopyOp& copyop):
     Object(bo,copyop),
-    _copyDataAndReleaseGLBufferObject(bo._copyDataAndReleaseGLBufferObject)
+    _copyDataAndReleaseGLBufferObject(bo._copyDataAndReleaseGLBufferObject),
+    _streaming(bo._streaming)
 {
 }
 
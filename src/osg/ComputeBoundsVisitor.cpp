@@ -15,9 +15,23 @@
 #include <osg/Transform>
 #include <osg/Drawable>
 #include <osg/Geode>
+#include <osg/SpatialIndexGroup>
 
 using namespace osg;
 
+namespace
+{
+
+/** Skips all the cells, leaving only the children that aren't indexed to be traversed.*/
+class SkipCellCallback : public SpatialIndexGroup::CellCallback
+{
+    public:
+
+        virtual bool enter(const BoundingBox&) { return false; }
+};
+
+}
+
 ComputeBoundsVisitor::ComputeBoundsVisitor(TraversalMode traversalMode):
     osg::NodeVisitor(traversalMode)
 {
@@ -62,6 +76,31 @@ void ComputeBoundsVisitor::apply(osg::Transform& transform)
     popMatrix();
 }
 
+void ComputeBoundsVisitor::apply(osg::SpatialIndexGroup& group)
+{
+    // when all the indexed children lie within the bounding box computed so far they can't extend it. Otherwise visit
+    // them in child order, as the cells are sized from the children's bounding spheres and are too loose to skip
+    // individually with any benefit.
+    BoundingBox bb = group.getIndexBoundingBox();
+    if (bb.valid() && _bb.valid())
+    {
+        bool contained = true;
+        for(unsigned int i=0; i<8 && contained; ++i)
+        {
+            contained = _bb.contains(_matrixStack.empty() ? bb.corner(i) : bb.corner(i) * _matrixStack.back());
+        }
+
+        if (contained)
+        {
+            SkipCellCallback skip;
+            group.traverse(*this, skip);
+            return;
+        }
+    }
+
+    traverse(group);
+}
+
 void ComputeBoundsVisitor::apply(osg::Drawable& drawable)
 {
     applyBoundingBox(drawable.getBoundingBox());
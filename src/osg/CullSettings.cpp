@@ -92,6 +92,7 @@ void CullSettings::inheritCullSettings(const CullSettings& settings, unsigned in
 
 static ApplicationUsageProxy ApplicationUsageProxyCullSettings_e0(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_COMPUTE_NEAR_FAR_MODE <mode>","DO_NOT_COMPUTE_NEAR_FAR | COMPUTE_NEAR_FAR_USING_BOUNDING_VOLUMES | COMPUTE_NEAR_FAR_USING_PRIMITIVES");
 static ApplicationUsageProxy ApplicationUsageProxyCullSettings_e1(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_NEAR_FAR_RATIO <float>","Set the ratio between near and far planes - must greater than 0.0 but less than 1.0.");
+static ApplicationUsageProxy ApplicationUsageProxyCullSettings_e2(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_SOFTWARE_OCCLUSION_CULLING <mode>","ON | OFF - Enable/disable culling against a software rasterized depth buffer of the occluder meshes attached to OccluderNodes.");
 
 void CullSettings::readEnvironmentalVariables()
 {
@@ -116,6 +117,14 @@ void CullSettings::readEnvironmentalVariables()
         OSG_INFO<<"Set near/far ratio to "<<_nearFarRatio<<std::endl;
     }
 
+    if ((ptr = getenv("OSG_SOFTWARE_OCCLUSION_CULLING")) != 0)
+    {
+        if (strcmp(ptr,"ON")==0 || strcmp(ptr,"on")==0) _cullingMode |= SOFTWARE_OCCLUSION_CULLING;
+        else if (strcmp(ptr,"OFF")==0 || strcmp(ptr,"off")==0) _cullingMode &= ~SOFTWARE_OCCLUSION_CULLING;
+
+        OSG_INFO<<"Set culling mode to "<<_cullingMode<<std::endl;
+    }
+
 }
 
 void CullSettings::readCommandLine(ArgumentParser& arguments)
@@ -673,6 +673,7 @@ GLExtensions::GLExtensions(unsigned int contextID)
     setGLExtensionFuncPtr(glBindBuffer, "glBindBuffer","glBindBufferARB", validContext);
     setGLExtensionFuncPtr(glBufferData, "glBufferData","glBufferDataARB", validContext);
     setGLExtensionFuncPtr(glBufferSubData, "glBufferSubData","glBufferSubDataARB", validContext);
+    setGLExtensionFuncPtr(glBufferStorage, "glBufferStorage", validContext);
     setGLExtensionFuncPtr(glDeleteBuffers, "glDeleteBuffers","glDeleteBuffersARB", validContext);
     setGLExtensionFuncPtr(glIsBuffer, "glIsBuffer","glIsBufferARB", validContext);
     setGLExtensionFuncPtr(glGetBufferSubData, "glGetBufferSubData","glGetBufferSubDataARB", validContext);
@@ -691,6 +692,9 @@ GLExtensions::GLExtensions(unsigned int contextID)
     isVAOSupported = validContext && osg::isGLExtensionSupported(contextID, "GL_ARB_vertex_array_object");
     isTransformFeedbackSupported = validContext && osg::isGLExtensionSupported(contextID, "GL_ARB_transform_feedback2");
     isBufferObjectSupported = isPBOSupported && isVAOSupported;
+    isBufferStorageSupported = validContext &&
+                               (osg::isGLExtensionSupported(contextID, "GL_ARB_buffer_storage") || (glVersion >= 4.4f)) &&
+                               glBufferStorage!=0 && glMapBufferRange!=0;
 
 
     // BlendFunc extensions
@@ -14,10 +14,21 @@
 
 #include <osg/Geometry>
 #include <osg/ArrayDispatchers>
+#include <osg/ContextData>
 #include <osg/Notify>
 
 using namespace osg;
 
+GLVertexArrayObjectManager::GLVertexArrayObjectManager(unsigned int contextID):
+    GLObjectManager("GLVertexArrayObjectManager",contextID)
+{}
+
+void GLVertexArrayObjectManager::deleteGLObject(GLuint globj)
+{
+    const GLExtensions* extensions = GLExtensions::Get(_contextID,true);
+    if (extensions->glDeleteVertexArrays) extensions->glDeleteVertexArrays(1, &globj);
+}
+
 
 Geometry::Geometry():
     _containsDeprecatedData(false)
@@ -81,6 +92,11 @@ Geometry::~Geometry()
     // do dirty here to keep the getGLObjectSizeHint() estimate on the ball
     dirtyDisplayList();
 
+    for(unsigned int i=0; i<_vertexArrayObjects.size(); ++i)
+    {
+        if (_vertexArrayObjects[i].id) osg::get<GLVertexArrayObjectManager>(i)->scheduleGLObjectForDeletion(_vertexArrayObjects[i].id);
+    }
+
     // no need to delete, all automatically handled by ref_ptr :-)
 }
 
@@ -603,6 +619,8 @@ void Geometry::resizeGLObjectBuffers(unsigned int maxSize)
 {
     Drawable::resizeGLObjectBuffers(maxSize);
 
+    _vertexArrayObjects.resize(maxSize);
+
     ArrayList arrays;
     if (getArrayList(arrays))
     {
@@ -630,6 +648,15 @@ void Geometry::releaseGLObjects(State* state) const
 {
     Drawable::releaseGLObjects(state);
 
+    for(unsigned int i=0; i<_vertexArrayObjects.size(); ++i)
+    {
+        if (state && state->getContextID()!=i) continue;
+
+        VertexArrayObject& vao = _vertexArrayObjects[i];
+        if (vao.id) osg::get<GLVertexArrayObjectManager>(i)->scheduleGLObjectForDeletion(vao.id);
+        vao = VertexArrayObject();
+    }
+
     ArrayList arrays;
     if (getArrayList(arrays))
     {
@@ -718,6 +745,15 @@ void Geometry::compileGLObjects(RenderInfo& renderInfo) const
         extensions->glBindBuffer(GL_ARRAY_BUFFER_ARB,0);
         extensions->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB,0);
 
+        // record the array set up in a vertex array object so the first draw only needs to bind it.
+        if (state.useVertexArrayObjects())
+        {
+            state.setCurrentVertexBufferObject(0);
+            state.setCurrentElementBufferObject(0);
+
+            bool recorded = false;
+            if (bindVertexArrayObject(renderInfo, recorded)) unbindVertexArrayObject(renderInfo, recorded);
+        }
     }
     else
     {
@@ -738,7 +774,11 @@ void Geometry::drawImplementation(RenderInfo& renderInfo) const
     bool checkForGLErrors = state.getCheckForGLErrors()==osg::State::ONCE_PER_ATTRIBUTE;
     if (checkForGLErrors) state.checkGLErrors("start of Geometry::drawImplementation()");
 
-    drawVertexArraysImplementation(renderInfo);
+    bool recorded = false;
+    bool usingVertexArrayObject = _useVertexBufferObjects && state.useVertexArrayObjects() && state.isVertexBufferObjectSupported() &&
+                                  bindVertexArrayObject(renderInfo, recorded);
+
+    if (!usingVertexArrayObject) drawVertexArraysImplementation(renderInfo);
 
     if (checkForGLErrors) state.checkGLErrors("Geometry::drawImplementation() after vertex arrays setup.");
 
@@ -748,6 +788,8 @@ void Geometry::drawImplementation(RenderInfo& renderInfo) const
     //
     drawPrimitivesImplementation(renderInfo);
 
+    if (usingVertexArrayObject) unbindVertexArrayObject(renderInfo, recorded);
+
     // unbind the VBO's if any are used.
     state.unbindVertexBufferObject();
     state.unbindElementBufferObject();
@@ -755,12 +797,8 @@ void Geometry::drawImplementation(RenderInfo& renderInfo) const
     if (checkForGLErrors) state.checkGLErrors("end of Geometry::drawImplementation().");
 }
 
-void Geometry::drawVertexArraysImplementation(RenderInfo& renderInfo) const
+void Geometry::setUpArrayDispatchers(State& state) const
 {
-    State& state = *renderInfo.getState();
-
-    bool handleVertexAttributes = !_vertexAttribList.empty();
-
     ArrayDispatchers& arrayDispatchers = state.getArrayDispatchers();
 
     arrayDispatchers.reset();
@@ -771,16 +809,24 @@ void Geometry::drawVertexArraysImplementation(RenderInfo& renderInfo) const
     arrayDispatchers.activateSecondaryColorArray(_secondaryColorArray.get());
     arrayDispatchers.activateFogCoordArray(_fogCoordArray.get());
 
-    if (handleVertexAttributes)
+    for(unsigned int unit=0;unit<_vertexAttribList.size();++unit)
     {
-        for(unsigned int unit=0;unit<_vertexAttribList.size();++unit)
-        {
-            arrayDispatchers.activateVertexAttribArray(unit, _vertexAttribList[unit].get());
-        }
+        arrayDispatchers.activateVertexAttribArray(unit, _vertexAttribList[unit].get());
     }
 
     // dispatch any attributes that are bound overall
     arrayDispatchers.dispatch(osg::Array::BIND_OVERALL,0);
+}
+
+void Geometry::drawVertexArraysImplementation(RenderInfo& renderInfo) const
+{
+    State& state = *renderInfo.getState();
+
+    bool handleVertexAttributes = !_vertexAttribList.empty();
+
+    setUpArrayDispatchers(state);
+
+    ++state.getVertexArrayStats().numVertexArraySetups;
 
     state.lazyDisablingOfVertexAttributes();
 
@@ -834,6 +880,149 @@ void Geometry::drawVertexArraysImplementation(RenderInfo& renderInfo) const
     state.applyDisablingOfVertexAttributes();
 }
 
+bool Geometry::updateVertexArrayObjectBindings(State& state, VertexArrayObject& vao, bool& changed) const
+{
+    unsigned int contextID = state.getContextID();
+
+    VertexArrayObject::Bindings& bindings = vao.bindings;
+    unsigned int numBindings = 0;
+    changed = false;
+
+    // collect the arrays in the order drawVertexArraysImplementation() sets them up.
+    const Array* arrays[5] = { _vertexArray.get(), _normalArray.get(), _colorArray.get(), _secondaryColorArray.get(), _fogCoordArray.get() };
+    unsigned int numArrays = 5 + static_cast<unsigned int>(_texCoordList.size() + _vertexAttribList.size());
+
+    for(unsigned int i=0; i<numArrays; ++i)
+    {
+        const Array* array = (i<5) ? arrays[i] :
+                             (i<5+_texCoordList.size()) ? _texCoordList[i-5].get() :
+                             _vertexAttribList[i-5-_texCoordList.size()].get();
+
+        VertexArrayObject::Binding binding;
+        if (array)
+        {
+            bool perVertex = array->getBinding()==osg::Array::BIND_PER_VERTEX || i==0 || (i>=5 && i<5+_texCoordList.size());
+            if (perVertex)
+            {
+                // client side arrays can't be recorded in a vertex array object.
+                GLBufferObject* glBufferObject = array->getOrCreateGLBufferObject(contextID);
+                if (!glBufferObject)
+                {
+                    bindings.clear();
+                    return false;
+                }
+
+                if (glBufferObject->isDirty()) state.bindVertexBufferObject(glBufferObject);
+
+                binding = VertexArrayObject::Binding(array, array->getBinding(), glBufferObject->getGLObjectID(), glBufferObject->getOffset(array->getBufferIndex()));
+            }
+            else
+            {
+                binding = VertexArrayObject::Binding(array, array->getBinding(), 0, 0);
+            }
+        }
+
+        if (numBindings<bindings.size())
+        {
+            if (!(bindings[numBindings]==binding))
+            {
+                bindings[numBindings] = binding;
+                changed = true;
+            }
+        }
+        else
+        {
+            bindings.push_back(binding);
+            changed = true;
+        }
+        ++numBindings;
+    }
+
+    // the element buffer object binding is recorded too, so make sure it's still the same buffer.
+    for(PrimitiveSetList::const_iterator itr = _primitives.begin();
+        itr != _primitives.end();
+        ++itr)
+    {
+        const DrawElements* drawElements = (*itr)->getDrawElements();
+        GLBufferObject* glBufferObject = drawElements ? drawElements->getOrCreateGLBufferObject(contextID) : 0;
+        if (!glBufferObject) continue;
+
+        if (glBufferObject->isDirty()) state.bindElementBufferObject(glBufferObject);
+
+        VertexArrayObject::Binding binding(glBufferObject, 0, glBufferObject->getGLObjectID(), 0);
+        if (numBindings<bindings.size())
+        {
+            if (!(bindings[numBindings]==binding))
+            {
+                bindings[numBindings] = binding;
+                changed = true;
+            }
+        }
+        else
+        {
+            bindings.push_back(binding);
+            changed = true;
+        }
+        ++numBindings;
+    }
+
+    if (numBindings!=bindings.size())
+    {
+        bindings.resize(numBindings);
+        changed = true;
+    }
+
+    if (changed) vao.elementBufferObject = 0;
+
+    return true;
+}
+
+bool Geometry::bindVertexArrayObject(RenderInfo& renderInfo, bool& recorded) const
+{
+    State& state = *renderInfo.getState();
+    VertexArrayObject& vao = _vertexArrayObjects[state.getContextID()];
+
+    bool changed = false;
+    if (!updateVertexArrayObjectBindings(state, vao, changed)) return false;
+
+    GLExtensions* extensions = state.get<GLExtensions>();
+
+    recorded = changed || vao.id==0;
+    if (vao.id==0) extensions->glGenVertexArrays(1, &vao.id);
+
+    if (recorded)
+    {
+        // State's array tracking refers to the default vertex array object, so force all the arrays to be set up in the new one.
+        state.dirtyAllVertexArrays();
+        state.bindVertexArrayObject(vao.id, 0);
+
+        drawVertexArraysImplementation(renderInfo);
+
+        ++state.getVertexArrayStats().numVertexArrayObjectCompiles;
+    }
+    else
+    {
+        state.bindVertexArrayObject(vao.id, vao.elementBufferObject);
+
+        setUpArrayDispatchers(state);
+    }
+
+    return true;
+}
+
+void Geometry::unbindVertexArrayObject(RenderInfo& renderInfo, bool recorded) const
+{
+    State& state = *renderInfo.getState();
+    VertexArrayObject& vao = _vertexArrayObjects[state.getContextID()];
+
+    vao.elementBufferObject = const_cast<GLBufferObject*>(state.getCurrentElementBufferObject());
+
+    state.unbindVertexArrayObject();
+
+    // the arrays set up when recording were applied to the vertex array object rather than the default one.
+    if (recorded) state.dirtyAllVertexArrays();
+}
+
 void Geometry::drawPrimitivesImplementation(RenderInfo& renderInfo) const
 {
     State& state = *renderInfo.getState();
@@ -0,0 +1,427 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+#include <osg/InstancedGeometry>
+#include <osg/GLExtensions>
+#include <osg/KdTree>
+#include <osg/Notify>
+#include <osg/State>
+
+#include <math.h>
+
+using namespace osg;
+
+namespace
+{
+
+/** Return the bounding box of the vertices of a single instance, or an invalid box if the vertex array isn't made of floats or doubles.*/
+BoundingBox computeVertexBoundingBox(const Array* vertices)
+{
+    BoundingBox bb;
+    if (!vertices || vertices->getNumElements()==0) return bb;
+
+    unsigned int size = vertices->getDataSize();
+    if (size<2) return bb;
+
+    unsigned int numVertices = vertices->getNumElements();
+    if (vertices->getDataType()==GL_FLOAT)
+    {
+        const float* ptr = static_cast<const float*>(vertices->getDataPointer());
+        for(unsigned int i=0; i<numVertices; ++i, ptr+=size)
+        {
+            bb.expandBy(ptr[0], ptr[1], size>2 ? ptr[2] : 0.0f);
+        }
+    }
+    else if (vertices->getDataType()==GL_DOUBLE)
+    {
+        const double* ptr = static_cast<const double*>(vertices->getDataPointer());
+        for(unsigned int i=0; i<numVertices; ++i, ptr+=size)
+        {
+            bb.expandBy(ptr[0], ptr[1], size>2 ? ptr[2] : 0.0);
+        }
+    }
+    return bb;
+}
+
+/** Return the vertex of a float or double vertex array.*/
+inline Vec3 getVertex(const Array* vertices, unsigned int i)
+{
+    unsigned int size = vertices->getDataSize();
+    if (vertices->getDataType()==GL_FLOAT)
+    {
+        const float* ptr = static_cast<const float*>(vertices->getDataPointer()) + i*size;
+        return Vec3(ptr[0], ptr[1], size>2 ? ptr[2] : 0.0f);
+    }
+    else
+    {
+        const double* ptr = static_cast<const double*>(vertices->getDataPointer()) + i*size;
+        return Vec3(ptr[0], ptr[1], size>2 ? ptr[2] : 0.0);
+    }
+}
+
+/** Return the box containing bb once transformed by matrix, without transforming its eight corners.*/
+inline BoundingBox transformBoundingBox(const BoundingBox& bb, const Matrixf& matrix)
+{
+    Vec3 center = bb.center() * matrix;
+    Vec3 halfSize = (bb._max - bb._min)*0.5f;
+
+    Vec3 extent;
+    for(unsigned int j=0; j<3; ++j)
+    {
+        extent[j] = fabs(matrix(0,j))*halfSize.x() + fabs(matrix(1,j))*halfSize.y() + fabs(matrix(2,j))*halfSize.z();
+    }
+
+    return BoundingBox(center-extent, center+extent);
+}
+
+/** Return the largest scale the matrix applies along any axis.*/
+inline float getMaximumScale(const Matrixf& matrix)
+{
+    float scale2 = 0.0f;
+    for(unsigned int i=0; i<3; ++i)
+    {
+        float length2 = matrix(i,0)*matrix(i,0) + matrix(i,1)*matrix(i,1) + matrix(i,2)*matrix(i,2);
+        if (length2>scale2) scale2 = length2;
+    }
+    return sqrtf(scale2);
+}
+
+}
+
+InstancedGeometry::InstancedGeometry():
+    _instanceMatrixLocation(DEFAULT_INSTANCE_MATRIX_LOCATION),
+    _instanceCulling(true)
+{
+    // the instances are culled each time they are drawn, which a display list would freeze.
+    setUseDisplayList(false);
+}
+
+InstancedGeometry::InstancedGeometry(const InstancedGeometry& geometry,const CopyOp& copyop):
+    Geometry(geometry,copyop),
+    _instanceMatrices(static_cast<MatrixfArray*>(copyop(geometry._instanceMatrices.get()))),
+    _instanceMatrixLocation(geometry._instanceMatrixLocation),
+    _instanceCulling(geometry._instanceCulling)
+{
+}
+
+InstancedGeometry::InstancedGeometry(const Geometry& geometry,const CopyOp& copyop):
+    Geometry(geometry,copyop),
+    _instanceMatrixLocation(DEFAULT_INSTANCE_MATRIX_LOCATION),
+    _instanceCulling(true)
+{
+    setUseDisplayList(false);
+
+    // a KdTree built for the geometry only covers a single instance, so would hide the others from intersection testing.
+    if (dynamic_cast<KdTree*>(getShape())) setShape(0);
+}
+
+InstancedGeometry::~InstancedGeometry()
+{
+}
+
+void InstancedGeometry::setInstanceMatrices(MatrixfArray* matrices)
+{
+    _instanceMatrices = matrices;
+
+    if (_instanceMatrices.valid() && _useVertexBufferObjects && !_instanceMatrices->getVertexBufferObject())
+    {
+        _instanceMatrices->setVertexBufferObject(new VertexBufferObject);
+    }
+
+    dirtyInstances();
+}
+
+void InstancedGeometry::dirtyInstances()
+{
+    if (_instanceMatrices.valid()) _instanceMatrices->dirty();
+    dirtyBound();
+}
+
+Polytope InstancedGeometry::computeFrustum(const Matrix& modelView, const Matrix& projection)
+{
+    // the near and far planes are left out, as the depth range is computed from the bound of the geometry as a whole.
+    Polytope frustum;
+    frustum.setToUnitFrustum(false, false);
+    frustum.transformProvidingInverse(modelView*projection);
+    return frustum;
+}
+
+unsigned int InstancedGeometry::computeVisibleInstances(const Polytope& frustum, InstanceRuns& runs) const
+{
+    getBoundingBox();
+
+    Polytope polytope(frustum);
+
+    unsigned int numVisible = 0;
+    for(unsigned int i=0; i<_instanceBounds.size(); ++i)
+    {
+        if (!polytope.contains(_instanceBounds[i])) continue;
+
+        if (!runs.empty() && runs.back().first+runs.back().second==i) ++runs.back().second;
+        else runs.push_back(InstanceRun(i, 1));
+
+        ++numVisible;
+    }
+    return numVisible;
+}
+
+BoundingBox InstancedGeometry::computeBoundingBox() const
+{
+    BoundingBox instanceBoundingBox = computeVertexBoundingBox(_vertexArray.get());
+    BoundingSphere instanceBound(instanceBoundingBox);
+
+    unsigned int numInstances = getNumInstances();
+    _instanceBounds.resize(numInstances);
+
+    BoundingBox bb;
+    if (!instanceBoundingBox.valid()) return bb;
+
+    for(unsigned int i=0; i<numInstances; ++i)
+    {
+        const Matrixf& matrix = (*_instanceMatrices)[i];
+        _instanceBounds[i] = BoundingSphere(instanceBound.center()*matrix, instanceBound.radius()*getMaximumScale(matrix));
+        bb.expandBy(transformBoundingBox(instanceBoundingBox, matrix));
+    }
+    return bb;
+}
+
+void InstancedGeometry::setUseVertexBufferObjects(bool flag)
+{
+    Geometry::setUseVertexBufferObjects(flag);
+
+    if (_instanceMatrices.valid())
+    {
+        if (flag && !_instanceMatrices->getVertexBufferObject()) _instanceMatrices->setVertexBufferObject(new VertexBufferObject);
+        else if (!flag && _instanceMatrices->getVertexBufferObject()) _instanceMatrices->setVertexBufferObject(0);
+    }
+}
+
+void InstancedGeometry::resizeGLObjectBuffers(unsigned int maxSize)
+{
+    Geometry::resizeGLObjectBuffers(maxSize);
+
+    _instanceRuns.resize(maxSize);
+    if (_instanceMatrices.valid()) _instanceMatrices->resizeGLObjectBuffers(maxSize);
+}
+
+void InstancedGeometry::releaseGLObjects(State* state) const
+{
+    Geometry::releaseGLObjects(state);
+
+    if (_instanceMatrices.valid()) _instanceMatrices->releaseGLObjects(state);
+}
+
+void InstancedGeometry::compileGLObjects(RenderInfo& renderInfo) const
+{
+    Geometry::compileGLObjects(renderInfo);
+
+    State& state = *renderInfo.getState();
+    if (_instanceMatrices.valid() && _useVertexBufferObjects && state.isVertexBufferObjectSupported())
+    {
+        GLBufferObject* glBufferObject = _instanceMatrices->getOrCreateGLBufferObject(state.getContextID());
+        if (glBufferObject && glBufferObject->isDirty())
+        {
+            glBufferObject->compileBuffer();
+            state.unbindVertexBufferObject();
+            state.get<GLExtensions>()->glBindBuffer(GL_ARRAY_BUFFER_ARB, 0);
+        }
+    }
+}
+
+void InstancedGeometry::drawImplementation(RenderInfo& renderInfo) const
+{
+    if (_containsDeprecatedData || getNumInstances()==0)
+    {
+        // leave the warning about deprecated data to Geometry.
+        if (_containsDeprecatedData) Geometry::drawImplementation(renderInfo);
+        return;
+    }
+
+    State& state = *renderInfo.getState();
+
+    InstanceRuns& runs = _instanceRuns[state.getContextID()];
+    runs.clear();
+
+    if (_instanceCulling) computeVisibleInstances(computeFrustum(state.getModelViewMatrix(), state.getProjectionMatrix()), runs);
+    else runs.push_back(InstanceRun(0, getNumInstances()));
+
+    if (runs.empty()) return;
+
+    bool checkForGLErrors = state.getCheckForGLErrors()==osg::State::ONCE_PER_ATTRIBUTE;
+    if (checkForGLErrors) state.checkGLErrors("start of InstancedGeometry::drawImplementation()");
+
+    bool recorded = false;
+    bool usingVertexArrayObject = _useVertexBufferObjects && state.useVertexArrayObjects() && state.isVertexBufferObjectSupported() &&
+                                  bindVertexArrayObject(renderInfo, recorded);
+
+    if (!usingVertexArrayObject) drawVertexArraysImplementation(renderInfo);
+
+    drawInstances(renderInfo, runs);
+
+    if (usingVertexArrayObject)
+    {
+        unbindVertexArrayObject(renderInfo, recorded);
+
+        // the instance matrix arrays were set up in the vertex array object rather than the default one.
+        state.dirtyAllVertexArrays();
+    }
+
+    state.unbindVertexBufferObject();
+    state.unbindElementBufferObject();
+
+    if (checkForGLErrors) state.checkGLErrors("end of InstancedGeometry::drawImplementation().");
+}
+
+void InstancedGeometry::drawInstances(RenderInfo& renderInfo, const InstanceRuns& runs) const
+{
+    State& state = *renderInfo.getState();
+    GLExtensions* extensions = state.get<GLExtensions>();
+
+    const Matrixf* matrices = &(_instanceMatrices->front());
+
+    if (!extensions->glVertexAttribDivisor)
+    {
+        // without instanced arrays draw the visible instances one at a time, passing the matrix as a constant vertex attribute.
+        for(unsigned int c=0; c<4; ++c)
+        {
+            state.disableVertexAttribPointer(_instanceMatrixLocation+c);
+        }
+
+        for(InstanceRuns::const_iterator itr = runs.begin(); itr != runs.end(); ++itr)
+        {
+            for(unsigned int i=itr->first; i<itr->first+itr->second; ++i)
+            {
+                for(unsigned int c=0; c<4; ++c)
+                {
+                    extensions->glVertexAttrib4fv(_instanceMatrixLocation+c, matrices[i].ptr()+c*4);
+                }
+                drawPrimitivesImplementation(renderInfo);
+            }
+        }
+        return;
+    }
+
+    GLBufferObject* vbo = (_useVertexBufferObjects && state.isVertexBufferObjectSupported()) ?
+                          _instanceMatrices->getOrCreateGLBufferObject(state.getContextID()) : 0;
+
+    const GLubyte* base = vbo ? reinterpret_cast<const GLubyte*>(vbo->getOffset(_instanceMatrices->getBufferIndex())) :
+                                static_cast<const GLubyte*>(_instanceMatrices->getDataPointer());
+
+    for(unsigned int c=0; c<4; ++c)
+    {
+        extensions->glVertexAttribDivisor(_instanceMatrixLocation+c, 1);
+    }
+
+    for(InstanceRuns::const_iterator itr = runs.begin(); itr != runs.end(); ++itr)
+    {
+        // point the matrix attributes at the first instance of the run rather than relying on a base instance.
+        state.bindVertexBufferObject(vbo);
+        for(unsigned int c=0; c<4; ++c)
+        {
+            state.setVertexAttribPointer(_instanceMatrixLocation+c, 4, GL_FLOAT, GL_FALSE, sizeof(Matrixf),
+                                         base + itr->first*sizeof(Matrixf) + c*4*sizeof(float));
+        }
+
+        drawInstancedPrimitives(state, itr->second);
+    }
+
+    // the divisor isn't tracked by State, so restore it for the geometry drawn next.
+    for(unsigned int c=0; c<4; ++c)
+    {
+        extensions->glVertexAttribDivisor(_instanceMatrixLocation+c, 0);
+    }
+}
+
+void InstancedGeometry::drawInstancedPrimitives(State& state, unsigned int numInstances) const
+{
+    bool usingVertexBufferObjects = _useVertexBufferObjects && state.isVertexBufferObjectSupported();
+
+    for(PrimitiveSetList::const_iterator itr = _primitives.begin(); itr != _primitives.end(); ++itr)
+    {
+        const PrimitiveSet* primitiveSet = itr->get();
+
+        GLenum mode = primitiveSet->getMode();
+        #if defined(OSG_GLES1_AVAILABLE) || defined(OSG_GLES2_AVAILABLE)
+            if (mode==GL_POLYGON) mode = GL_TRIANGLE_FAN;
+            if (mode==GL_QUAD_STRIP) mode = GL_TRIANGLE_STRIP;
+        #endif
+
+        switch(primitiveSet->getType())
+        {
+            case(PrimitiveSet::DrawArraysPrimitiveType):
+            {
+                const DrawArrays* drawArrays = static_cast<const DrawArrays*>(primitiveSet);
+                state.glDrawArraysInstanced(mode, drawArrays->getFirst(), drawArrays->getCount(), numInstances);
+                break;
+            }
+            case(PrimitiveSet::DrawArrayLengthsPrimitiveType):
+            {
+                const DrawArrayLengths* drawArrayLengths = static_cast<const DrawArrayLengths*>(primitiveSet);
+                GLint first = drawArrayLengths->getFirst();
+                for(DrawArrayLengths::const_iterator litr = drawArrayLengths->begin(); litr != drawArrayLengths->end(); ++litr)
+                {
+                    state.glDrawArraysInstanced(mode, first, *litr, numInstances);
+                    first += *litr;
+                }
+                break;
+            }
+            default:
+            {
+                const DrawElements* drawElements = primitiveSet->getDrawElements();
+                if (!drawElements)
+                {
+                    OSG_INFO<<"InstancedGeometry::drawInstancedPrimitives() unable to instance "<<primitiveSet->className()<<std::endl;
+                    break;
+                }
+
+                if (drawElements->getNumIndices()==0) break;
+
+                GLBufferObject* ebo = usingVertexBufferObjects ? drawElements->getOrCreateGLBufferObject(state.getContextID()) : 0;
+                state.bindElementBufferObject(ebo);
+
+                const GLvoid* indices = ebo ? reinterpret_cast<const GLvoid*>(ebo->getOffset(drawElements->getBufferIndex())) : drawElements->getDataPointer();
+                state.glDrawElementsInstanced(mode, drawElements->getNumIndices(), const_cast<DrawElements*>(drawElements)->getDataType(), indices, numInstances);
+                break;
+            }
+        }
+    }
+}
+
+void InstancedGeometry::accept(PrimitiveFunctor& functor) const
+{
+    const Array* vertices = _vertexArray.get();
+    if (!vertices || !_instanceMatrices.valid() ||
+        (vertices->getDataType()!=GL_FLOAT && vertices->getDataType()!=GL_DOUBLE) || vertices->getDataSize()<2)
+    {
+        Geometry::accept(functor);
+        return;
+    }
+
+    unsigned int numVertices = vertices->getNumElements();
+    if (numVertices==0) return;
+
+    std::vector<Vec3> instanceVertices(numVertices);
+    for(MatrixfArray::const_iterator mitr = _instanceMatrices->begin(); mitr != _instanceMatrices->end(); ++mitr)
+    {
+        for(unsigned int i=0; i<numVertices; ++i)
+        {
+            instanceVertices[i] = getVertex(vertices, i) * (*mitr);
+        }
+
+        functor.setVertexArray(numVertices, &instanceVertices.front());
+
+        for(PrimitiveSetList::const_iterator itr = _primitives.begin(); itr != _primitives.end(); ++itr)
+        {
+            (*itr)->accept(functor);
+        }
+    }
+}
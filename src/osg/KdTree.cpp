@@ -13,6 +13,7 @@
 
 #include <osg/KdTree>
 #include <osg/Geode>
+#include <osg/InstancedGeometry>
 #include <osg/TriangleIndexFunctor>
 #include <osg/Timer>
 
@@ -807,6 +808,9 @@ void KdTreeBuilder::apply(osg::Geometry& geometry)
     osg::KdTree* previous = dynamic_cast<osg::KdTree*>(geometry.getShape());
     if (previous) return;
 
+    // a KdTree would only hold the primitives of a single instance.
+    if (dynamic_cast<osg::InstancedGeometry*>(&geometry)) return;
+
     osg::ref_ptr<osg::KdTree> kdTree = osg::clone(_kdTreePrototype.get());
 
     if (kdTree->build(_buildOptions, &geometry))
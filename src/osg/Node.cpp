@@ -12,11 +12,13 @@
 */
 
 #include <osg/Node>
+#include <osg/BoundUpdateQueue>
 #include <osg/Group>
 #include <osg/NodeVisitor>
 #include <osg/Notify>
 #include <osg/OccluderNode>
 #include <osg/Transform>
+#include <osg/UpdateCountQueue>
 #include <osg/UserDataContainer>
 
 #include <algorithm>
@@ -228,12 +230,15 @@ void Node::setUpdateCallback(Callback* nc)
             // the number of callbacks has changed, need to pass this
             // on to parents so they know whether app traversal is
             // required on this subgraph.
+            UpdateCountQueue* queue = UpdateCountQueue::getCurrent();
             for(ParentList::iterator itr =_parents.begin();
                 itr != _parents.end();
                 ++itr)
             {
-                (*itr)->setNumChildrenRequiringUpdateTraversal(
-                        (*itr)->getNumChildrenRequiringUpdateTraversal()+delta );
+                // while an UpdateCountQueue is collecting the change is deferred, parents with no references are
+                // still being constructed so can't be shared, and are changed immediately.
+                if (queue && (*itr)->referenceCount()>0) queue->add(*itr, delta);
+                else (*itr)->setNumChildrenRequiringUpdateTraversal((*itr)->getNumChildrenRequiringUpdateTraversal()+delta);
             }
 
         }
@@ -264,13 +269,15 @@ void Node::setNumChildrenRequiringUpdateTraversal(unsigned int num)
             // the number of callbacks has changed, need to pass this
             // on to parents so they know whether app traversal is
             // required on this subgraph.
+            UpdateCountQueue* queue = UpdateCountQueue::getCurrent();
             for(ParentList::iterator itr =_parents.begin();
                 itr != _parents.end();
                 ++itr)
             {
-                (*itr)->setNumChildrenRequiringUpdateTraversal(
-                    (*itr)->getNumChildrenRequiringUpdateTraversal()+delta
-                    );
+                // while an UpdateCountQueue is collecting the change is deferred, parents with no references are
+                // still being constructed so can't be shared, and are changed immediately.
+                if (queue && (*itr)->referenceCount()>0) queue->add(*itr, delta);
+                else (*itr)->setNumChildrenRequiringUpdateTraversal((*itr)->getNumChildrenRequiringUpdateTraversal()+delta);
             }
 
         }
@@ -537,6 +544,18 @@ void Node::dirtyBound()
     {
         _boundingSphereComputed = false;
 
+        // when bound updates are batched the parents are dirtied by BoundUpdateQueue::end(), nodes being
+        // constructed or deleted (with no references) aren't recorded as the queue would take a reference.
+        if (!_parents.empty() && referenceCount()>0)
+        {
+            BoundUpdateQueue* queue = BoundUpdateQueue::getCurrent();
+            if (queue)
+            {
+                queue->add(this);
+                return;
+            }
+        }
+
         // dirty parent bounding sphere's to ensure that all are valid.
         for(ParentList::iterator itr=_parents.begin();
             itr!=_parents.end();
@@ -28,6 +28,7 @@
 #include <osg/Projection>
 #include <osg/ProxyNode>
 #include <osg/Sequence>
+#include <osg/SpatialIndexGroup>
 #include <osg/Switch>
 #include <osg/TexGenNode>
 #include <osg/Transform>
@@ -195,3 +196,8 @@ void NodeVisitor::apply(OcclusionQueryNode& node)
 {
     apply(static_cast<Group&>(node));
 }
+
+void NodeVisitor::apply(SpatialIndexGroup& node)
+{
+    apply(static_cast<Group&>(node));
+}
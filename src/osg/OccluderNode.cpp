@@ -20,7 +20,8 @@ OccluderNode::OccluderNode()
 
 OccluderNode::OccluderNode(const OccluderNode& node,const CopyOp& copyop):
     Group(node,copyop),
-    _occluder(dynamic_cast<ConvexPlanarOccluder*>(copyop(node._occluder.get())))
+    _occluder(dynamic_cast<ConvexPlanarOccluder*>(copyop(node._occluder.get()))),
+    _occluderMesh(dynamic_cast<Geometry*>(copyop(node._occluderMesh.get())))
 {
 }
 
@@ -43,5 +44,14 @@ BoundingSphere OccluderNode::computeBound() const
             bsphere.expandBy(bb);
         }
     }
+
+    if (getOccluderMesh())
+    {
+        const BoundingBox& bb = getOccluderMesh()->getBoundingBox();
+        if (bb.valid())
+        {
+            bsphere.expandBy(bb);
+        }
+    }
     return bsphere;
 }
@@ -32,11 +32,15 @@
 #include <osg/Shader>
 #include <osg/GLExtensions>
 #include <osg/ContextData>
+#include <osg/GraphicsContext>
+#include <osg/GraphicsThread>
+#include <osg/ApplicationUsage>
 
 #include <OpenThreads/ScopedLock>
 #include <OpenThreads/Mutex>
 
 #include <string.h>
+#include <stdlib.h>
 
 using namespace osg;
 
@@ -86,6 +90,115 @@ void Program::ProgramBinary::assign(unsigned int size, const unsigned char* data
 }
 
 
+///////////////////////////////////////////////////////////////////////////
+// osg::Program::ProgramBinaryCache
+///////////////////////////////////////////////////////////////////////////
+
+Program::ProgramBinaryCache::ProgramBinaryCache():
+    _numHits(0),
+    _numMisses(0),
+    _loadTime(0.0),
+    _compileTime(0.0)
+{
+}
+
+Program::ProgramBinaryCache::~ProgramBinaryCache()
+{
+}
+
+void Program::ProgramBinaryCache::addHit(double time)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    ++_numHits;
+    _loadTime += time;
+}
+
+void Program::ProgramBinaryCache::addMiss(double time)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    ++_numMisses;
+    _compileTime += time;
+}
+
+unsigned int Program::ProgramBinaryCache::getNumHits() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    return _numHits;
+}
+
+unsigned int Program::ProgramBinaryCache::getNumMisses() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    return _numMisses;
+}
+
+double Program::ProgramBinaryCache::getLoadTime() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    return _loadTime;
+}
+
+double Program::ProgramBinaryCache::getCompileTime() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    return _compileTime;
+}
+
+void Program::ProgramBinaryCache::resetStats()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    _numHits = 0;
+    _numMisses = 0;
+    _loadTime = 0.0;
+    _compileTime = 0.0;
+}
+
+void Program::ProgramBinaryCache::reportStats(std::ostream& out) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    out<<"Program::ProgramBinaryCache::reportStats()"<<std::endl;
+    out<<"   _numHits="<<_numHits<<", _loadTime="<<_loadTime*1000.0<<"ms, average="<<(_numHits>0 ? _loadTime/double(_numHits)*1000.0 : 0.0)<<"ms"<<std::endl;
+    out<<"   _numMisses="<<_numMisses<<", _compileTime="<<_compileTime*1000.0<<"ms, average="<<(_numMisses>0 ? _compileTime/double(_numMisses)*1000.0 : 0.0)<<"ms"<<std::endl;
+}
+
+static osg::ref_ptr<Program::ProgramBinaryCache> s_programBinaryCache;
+
+void Program::setProgramBinaryCache(ProgramBinaryCache* cache)
+{
+    s_programBinaryCache = cache;
+}
+
+Program::ProgramBinaryCache* Program::getProgramBinaryCache()
+{
+    return s_programBinaryCache.get();
+}
+
+static bool s_asyncCompileInitialized = false;
+static bool s_asyncCompile = false;
+static osg::ApplicationUsageProxy Program_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_ASYNC_PROGRAM_COMPILE <mode>","ON | OFF - compile and link programs on the compile context rather than the draw thread.");
+
+void Program::setAsyncCompile(bool flag)
+{
+    s_asyncCompileInitialized = true;
+    s_asyncCompile = flag;
+}
+
+bool Program::getAsyncCompile()
+{
+    if (!s_asyncCompileInitialized)
+    {
+        s_asyncCompileInitialized = true;
+
+        const char* str = getenv("OSG_ASYNC_PROGRAM_COMPILE");
+        if (str)
+        {
+            s_asyncCompile = (strcmp(str,"ON")==0 || strcmp(str,"on")==0 || strcmp(str,"On")==0);
+        }
+    }
+    return s_asyncCompile;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////
 // osg::Program
 ///////////////////////////////////////////////////////////////////////////
@@ -203,14 +316,27 @@ void Program::compileGLObjects( osg::State& state ) const
 {
     if( isFixedFunction() ) return;
 
-    for( unsigned int i=0; i < _shaderList.size(); ++i )
+    compilePerContextProgram( state, getPCP( state ) );
+}
+
+void Program::compilePerContextProgram( osg::State& state, PerContextProgram* pcp ) const
+{
+    if( isFixedFunction() || !pcp ) return;
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    bool useProgramBinaryCache = pcp->needsLink() && pcp->loadCachedProgramBinary(state);
+
+    // shaders only need compiling if the program can't be linked from a cached binary.
+    if (!pcp->hasCachedProgramBinary())
     {
-        _shaderList[i]->compileShader( state );
+        for( unsigned int i=0; i < _shaderList.size(); ++i )
+        {
+            _shaderList[i]->compileShader( state );
+        }
     }
 
     if(!_feedbackout.empty())
     {
-        const PerContextProgram* pcp = getPCP(state);
         const GLExtensions* extensions = state.get<GLExtensions>();
 
         unsigned int numfeedback = _feedbackout.size();
@@ -226,7 +352,81 @@ void Program::compileGLObjects( osg::State& state ) const
         extensions->glTransformFeedbackVaryings( pcp->getHandle(), numfeedback, varyings, _feedbackmode);
         delete [] varyings;
     }
-    getPCP( state )->linkProgram(state);
+    pcp->linkProgram(state);
+
+    ProgramBinaryCache* programBinaryCache = getProgramBinaryCache();
+    if (useProgramBinaryCache && programBinaryCache)
+    {
+        double time = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+        if (pcp->loadedBinary()) programBinaryCache->addHit(time);
+        else programBinaryCache->addMiss(time);
+    }
+}
+
+namespace
+{
+
+class CompileProgramOperation : public osg::GraphicsOperation
+{
+    public:
+
+        CompileProgramOperation(const Program* program, Program::PerContextProgram* pcp, const StateSet::DefineList& defines):
+            osg::Referenced(true),
+            osg::GraphicsOperation("CompileProgramOperation", false),
+            _program(program),
+            _pcp(pcp),
+            _defines(defines) {}
+
+        virtual void operator () (osg::GraphicsContext* context)
+        {
+            osg::State* state = context->getState();
+            if (state)
+            {
+                // use the draw thread's defines so that the Shaders resolve to the same per context objects.
+                State::DefineMap& defineMap = state->getDefineMap();
+                bool previousChanged = defineMap.changed;
+                StateSet::DefineList defines(_defines);
+                defineMap.swapCurrentDefines(defines);
+
+                if (_pcp->needsLink()) _program->compilePerContextProgram(*state, _pcp.get());
+
+                // make sure the linked program is complete before the shared draw context uses it.
+                glFinish();
+
+                defineMap.swapCurrentDefines(defines);
+                defineMap.changed = previousChanged;
+            }
+
+            _pcp->setCompilePending(false);
+        }
+
+    protected:
+
+        osg::ref_ptr<const Program>                 _program;
+        osg::ref_ptr<Program::PerContextProgram>    _pcp;
+        StateSet::DefineList                        _defines;
+};
+
+}
+
+bool Program::compileAsynchronously(osg::State& state, PerContextProgram* pcp) const
+{
+    if (pcp->isCompilePending()) return true;
+    if (!getAsyncCompile()) return false;
+
+    osg::GraphicsContext* compileContext = osg::GraphicsContext::getCompileContext(state.getContextID());
+    if (!compileContext || !compileContext->getGraphicsThread() || compileContext==state.getGraphicsContext()) return false;
+
+    // create the per context shaders on this thread so the compile thread only has to look them up.
+    for( unsigned int i=0; i < _shaderList.size(); ++i )
+    {
+        _shaderList[i]->getPCS( state );
+    }
+
+    pcp->setCompilePending(true);
+    compileContext->add(new CompileProgramOperation(this, pcp, state.getDefineMap().currentDefines));
+
+    return true;
 }
 
 void Program::setThreadSafeRefUnref(bool threadSafe)
@@ -400,6 +600,17 @@ void Program::getComputeGroups( GLint& numGroupsX, GLint& numGroupsY, GLint& num
     numGroupsZ = _numGroupsZ;
 }
 
+void Program::setShaderDefines(const ShaderDefines& shaderDefs)
+{
+    _shaderDefines = shaderDefs;
+
+    // the define string used to select each PerContextProgram depends on the ShaderDefines, so discard the cached matches.
+    for(unsigned int i=0; i < _pcpList.size(); ++i)
+    {
+        if (_pcpList[i].valid()) _pcpList[i]->resetLastPCP();
+    }
+}
+
 void Program::addBindAttribLocation( const std::string& name, GLuint index )
 {
     _attribBindingList[name] = index;
@@ -511,8 +722,8 @@ void Program::apply( osg::State& state ) const
 
 
     PerContextProgram* pcp = getPCP( state );
-    if( pcp->needsLink() ) compileGLObjects( state );
-    if( pcp->isLinked() )
+    if( pcp->needsLink() && !compileAsynchronously( state, pcp ) ) compileGLObjects( state );
+    if( !pcp->isCompilePending() && pcp->isLinked() )
     {
         // for shader debugging: to minimize performance impact,
         // optionally validate based on notify level.
@@ -534,7 +745,10 @@ void Program::apply( osg::State& state ) const
 
 Program::ProgramObjects::ProgramObjects(const osg::Program* program, unsigned int contextID):
     _contextID(contextID),
-    _program(program)
+    _program(program),
+    _lastState(0),
+    _lastDefinesModifiedCount(0),
+    _lastPCP(0)
 {
 }
 
@@ -609,24 +823,40 @@ bool Program::ProgramObjects::getGlProgramInfoLog(std::string& log) const
 Program::PerContextProgram* Program::getPCP(State& state) const
 {
     unsigned int contextID = state.getContextID();
-    const std::string defineStr = state.getDefineString(getShaderDefines());
 
     if( ! _pcpList[contextID].valid() )
     {
         _pcpList[contextID] = new ProgramObjects( this, contextID );
     }
 
-    Program::PerContextProgram* pcp = _pcpList[contextID]->getPCP(defineStr);
-    if (pcp) return pcp;
+    const ProgramObjects* programObjects = _pcpList[contextID].get();
+
+    // if the defines haven't changed since the last call the same PerContextProgram applies, avoiding building and comparing define strings.
+    State::DefineMap& defineMap = state.getDefineMap();
+    if (defineMap.changed) defineMap.updateCurrentDefines();
+    if (programObjects->_lastPCP && programObjects->_lastState==&state && programObjects->_lastDefinesModifiedCount==defineMap.modifiedCount)
+    {
+        return programObjects->_lastPCP;
+    }
 
-    pcp = _pcpList[contextID]->createPerContextProgram(defineStr);
+    const std::string defineStr = state.getDefineString(getShaderDefines());
 
-    // attach all PCSs to this new PCP
-    for( unsigned int i=0; i < _shaderList.size(); ++i )
+    Program::PerContextProgram* pcp = _pcpList[contextID]->getPCP(defineStr);
+    if (!pcp)
     {
-        pcp->addShaderToAttach( _shaderList[i].get() );
+        pcp = _pcpList[contextID]->createPerContextProgram(defineStr);
+
+        // attach all PCSs to this new PCP
+        for( unsigned int i=0; i < _shaderList.size(); ++i )
+        {
+            pcp->addShaderToAttach( _shaderList[i].get() );
+        }
     }
 
+    programObjects->_lastState = &state;
+    programObjects->_lastDefinesModifiedCount = defineMap.modifiedCount;
+    programObjects->_lastPCP = pcp;
+
     return pcp;
 }
 
@@ -673,7 +903,8 @@ Program::PerContextProgram::PerContextProgram(const Program* program, unsigned i
         _glProgramHandle(programHandle),
         _loadedBinary(false),
         _contextID( contextID ),
-        _ownsProgramHandle(false)
+        _ownsProgramHandle(false),
+        _uniformBlocksDirty(false)
 {
     _program = program;
     if (_glProgramHandle == 0)
@@ -701,6 +932,22 @@ void Program::PerContextProgram::requestLink()
 }
 
 
+static Program::ProgramBinary* getLinkedProgramBinary(GLExtensions* extensions, GLuint programHandle)
+{
+    GLint binaryLength = 0;
+    extensions->glGetProgramiv( programHandle, GL_PROGRAM_BINARY_LENGTH, &binaryLength );
+    if (binaryLength)
+    {
+        Program::ProgramBinary* programBinary = new Program::ProgramBinary;
+        programBinary->allocate(binaryLength);
+        GLenum binaryFormat = 0;
+        extensions->glGetProgramBinary( programHandle, binaryLength, 0, &binaryFormat, reinterpret_cast<GLvoid*>(programBinary->getData()) );
+        programBinary->setFormat(binaryFormat);
+        return programBinary;
+    }
+    return 0;
+}
+
 void Program::PerContextProgram::linkProgram(osg::State& state)
 {
     if( ! _needsLink ) return;
@@ -712,17 +959,33 @@ void Program::PerContextProgram::linkProgram(osg::State& state)
              <<  std::endl;
 
     const ProgramBinary* programBinary = _program->getProgramBinary();
+    ProgramBinaryCache* programBinaryCache = (!programBinary && !_programBinaryCacheKey.empty()) ? Program::getProgramBinaryCache() : 0;
+
+    // take ownership of any binary found by loadCachedProgramBinary() so it's only used for this link.
+    osg::ref_ptr<ProgramBinary> cachedProgramBinary;
+    cachedProgramBinary.swap(_cachedProgramBinary);
+    const ProgramBinary* binaryToLoad = programBinary ? programBinary : cachedProgramBinary.get();
 
     _loadedBinary = false;
-    if (programBinary && programBinary->getSize())
+    if (binaryToLoad && binaryToLoad->getSize())
     {
         GLint linked = GL_FALSE;
-        _extensions->glProgramBinary( _glProgramHandle, programBinary->getFormat(),
-            reinterpret_cast<const GLvoid*>(programBinary->getData()), programBinary->getSize() );
+        _extensions->glProgramBinary( _glProgramHandle, binaryToLoad->getFormat(),
+            reinterpret_cast<const GLvoid*>(binaryToLoad->getData()), binaryToLoad->getSize() );
         _extensions->glGetProgramiv( _glProgramHandle, GL_LINK_STATUS, &linked );
         _loadedBinary = _isLinked = (linked == GL_TRUE);
     }
 
+    if (cachedProgramBinary.valid() && !_loadedBinary)
+    {
+        // the cached binary was rejected, typically after a driver update, so the shaders still need compiling.
+        OSG_INFO << "Cached program binary for \"" << _program->getName() << "\" rejected, compiling from source." << std::endl;
+        for( unsigned int i=0; i < _program->_shaderList.size(); ++i )
+        {
+            _program->_shaderList[i]->compileShader( state );
+        }
+    }
+
     if (!_loadedBinary && _extensions->isGeometryShader4Supported)
     {
         _extensions->glProgramParameteri( _glProgramHandle, GL_GEOMETRY_VERTICES_OUT_EXT, _program->_geometryVerticesOut );
@@ -757,6 +1020,9 @@ void Program::PerContextProgram::linkProgram(osg::State& state)
     _uniformInfoMap.clear();
     _attribInfoMap.clear();
     _lastAppliedUniformList.clear();
+    _automaticUniformBlocks.clear();
+    _uniformBlockMemberMap.clear();
+    _uniformBlocksDirty = false;
 
     if (!_loadedBinary)
     {
@@ -790,8 +1056,8 @@ void Program::PerContextProgram::linkProgram(osg::State& state)
             _extensions->glBindFragDataLocation( _glProgramHandle, itr->second, reinterpret_cast<const GLchar*>(itr->first.c_str()) );
         }
 
-        // if any program binary has been set then assume we want to retrieve a binary later.
-        if (programBinary)
+        // if any program binary has been set, or binaries are being cached, then assume we want to retrieve a binary later.
+        if (programBinary || programBinaryCache)
         {
             _extensions->glProgramParameteri( _glProgramHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
         }
@@ -826,6 +1092,12 @@ void Program::PerContextProgram::linkProgram(osg::State& state)
         }
     }
 
+    if (programBinaryCache && !_loadedBinary)
+    {
+        osg::ref_ptr<ProgramBinary> linkedBinary = getLinkedProgramBinary(_extensions.get(), _glProgramHandle);
+        if (linkedBinary.valid()) programBinaryCache->writeProgramBinary(_programBinaryCacheKey, *linkedBinary);
+    }
+
     if (_extensions->isUniformBufferObjectSupported)
     {
         GLuint activeUniformBlocks = 0;
@@ -871,7 +1143,12 @@ void Program::PerContextProgram::linkProgram(osg::State& state)
             }
             else
             {
-                OSG_WARN << "uniform block " << blockName << " has no binding.\n";
+                // no explicit binding so pack the block's members from the matching osg::Uniform's.
+                AutomaticUniformBlock block;
+                block.name = blockName;
+                block.index = itr->second._index;
+                block.size = itr->second._size;
+                _automaticUniformBlocks.push_back(block);
             }
         }
     }
@@ -879,6 +1156,10 @@ void Program::PerContextProgram::linkProgram(osg::State& state)
     typedef std::map<GLuint, std::string> AtomicCounterMap;
     AtomicCounterMap atomicCounterMap;
 
+    // uniforms without a location, which may be members of automatic uniform blocks.
+    std::vector<GLuint> blockUniformIndices;
+    std::vector<std::string> blockUniformNames;
+
     // build _uniformInfoMap
     GLint numUniforms = 0;
     GLsizei maxLen = 0;
@@ -921,10 +1202,20 @@ void Program::PerContextProgram::linkProgram(osg::State& state)
                     << " type=" << Uniform::getTypename((Uniform::Type)type)
                     << std::endl;
             }
+            else if (!_automaticUniformBlocks.empty() && type != GL_UNSIGNED_INT_ATOMIC_COUNTER)
+            {
+                blockUniformIndices.push_back(i);
+                blockUniformNames.push_back(name);
+            }
         }
         delete [] name;
     }
 
+    if (!_automaticUniformBlocks.empty())
+    {
+        setUpAutomaticUniformBlocks(blockUniformIndices, blockUniformNames);
+    }
+
     // print atomic counter
 
     if (_extensions->isShaderAtomicCountersSupported && !atomicCounterMap.empty())
@@ -1069,25 +1360,413 @@ bool Program::PerContextProgram::getInfoLog( std::string& infoLog ) const
 Program::ProgramBinary* Program::PerContextProgram::compileProgramBinary(osg::State& state)
 {
     linkProgram(state);
-    GLint binaryLength = 0;
-    _extensions->glGetProgramiv( _glProgramHandle, GL_PROGRAM_BINARY_LENGTH, &binaryLength );
-    if (binaryLength)
+    return getLinkedProgramBinary(_extensions.get(), _glProgramHandle);
+}
+
+bool Program::PerContextProgram::loadCachedProgramBinary(osg::State& state)
+{
+    _cachedProgramBinary = 0;
+    _programBinaryCacheKey.clear();
+
+    ProgramBinaryCache* programBinaryCache = Program::getProgramBinaryCache();
+    if (!programBinaryCache || _program->getProgramBinary() || !_extensions->glProgramBinary || !_extensions->glGetProgramBinary) return false;
+
+    // programs with shader binaries or transform feedback aren't cached.
+    if (!_program->_feedbackout.empty()) return false;
+    for( unsigned int i=0; i < _program->_shaderList.size(); ++i )
     {
-        ProgramBinary* programBinary = new ProgramBinary;
-        programBinary->allocate(binaryLength);
-        GLenum binaryFormat = 0;
-        _extensions->glGetProgramBinary( _glProgramHandle, binaryLength, 0, &binaryFormat, reinterpret_cast<GLvoid*>(programBinary->getData()) );
-        programBinary->setFormat(binaryFormat);
-        return programBinary;
+        if (_program->_shaderList[i]->getShaderBinary()) return false;
     }
-    return 0;
+
+    _programBinaryCacheKey = computeProgramBinaryCacheKey(state);
+    _cachedProgramBinary = programBinaryCache->readProgramBinary(_programBinaryCacheKey);
+
+    return true;
+}
+
+namespace
+{
+
+// 64 bit FNV-1a hash
+struct ProgramBinaryKeyHash
+{
+    ProgramBinaryKeyHash(): value(0xcbf29ce484222325ull) {}
+
+    void add(const void* data, unsigned int size)
+    {
+        const unsigned char* ptr = static_cast<const unsigned char*>(data);
+        for(unsigned int i=0; i<size; ++i)
+        {
+            value ^= ptr[i];
+            value *= 0x100000001b3ull;
+        }
+    }
+
+    void add(const std::string& str) { add(str.c_str(), static_cast<unsigned int>(str.size()+1)); }
+    void add(GLint v) { add(&v, sizeof(v)); }
+
+    std::string str() const
+    {
+        static const char* digits = "0123456789abcdef";
+        std::string result(16, '0');
+        for(unsigned int i=0; i<16; ++i)
+        {
+            result[15-i] = digits[(value>>(i*4)) & 0xf];
+        }
+        return result;
+    }
+
+    unsigned long long value;
+};
+
+}
+
+std::string Program::PerContextProgram::computeProgramBinaryCacheKey(osg::State& state) const
+{
+    ProgramBinaryKeyHash hash;
+
+    // binaries are only valid for the driver that created them.
+    const GLubyte* driverStrings[3] = { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) };
+    for(unsigned int i=0; i<3; ++i)
+    {
+        if (driverStrings[i]) hash.add(std::string(reinterpret_cast<const char*>(driverStrings[i])));
+    }
+
+    hash.add(_defineStr);
+    hash.add(state.getUseVertexAttributeAliasing() ? 1 : 0);
+    hash.add(state.getUseModelViewAndProjectionUniforms() ? 1 : 0);
+
+    for( unsigned int i=0; i < _program->_shaderList.size(); ++i )
+    {
+        const Shader* shader = _program->_shaderList[i].get();
+        hash.add(static_cast<GLint>(shader->getType()));
+        hash.add(shader->getShaderSource());
+    }
+
+    hash.add(_program->_geometryVerticesOut);
+    hash.add(_program->_geometryInputType);
+    hash.add(_program->_geometryOutputType);
+
+    for(AttribBindingList::const_iterator itr = _program->_attribBindingList.begin(); itr != _program->_attribBindingList.end(); ++itr)
+    {
+        hash.add(itr->first);
+        hash.add(static_cast<GLint>(itr->second));
+    }
+
+    if (state.getUseVertexAttributeAliasing())
+    {
+        const AttribBindingList& stateBindlist = state.getAttributeBindingList();
+        for(AttribBindingList::const_iterator itr = stateBindlist.begin(); itr != stateBindlist.end(); ++itr)
+        {
+            hash.add(itr->first);
+            hash.add(static_cast<GLint>(itr->second));
+        }
+    }
+
+    for(FragDataBindingList::const_iterator itr = _program->_fragDataBindingList.begin(); itr != _program->_fragDataBindingList.end(); ++itr)
+    {
+        hash.add(itr->first);
+        hash.add(static_cast<GLint>(itr->second));
+    }
+
+    return hash.str();
 }
 
 void Program::PerContextProgram::useProgram() const
 {
     _extensions->glUseProgram( _glProgramHandle  );
+
+    if (!_automaticUniformBlocks.empty())
+    {
+        // other programs may have bound their buffers to the same binding points so rebind on next applyUniformBlocks().
+        for(AutomaticUniformBlocks::iterator itr = _automaticUniformBlocks.begin();
+            itr != _automaticUniformBlocks.end();
+            ++itr)
+        {
+            itr->lastBound = 0;
+        }
+        _uniformBlocksDirty = true;
+    }
+
     if ( _program->_numGroupsX>0 && _program->_numGroupsY>0 && _program->_numGroupsZ>0 )
     {
         _extensions->glDispatchCompute( _program->_numGroupsX, _program->_numGroupsY, _program->_numGroupsZ );
     }
 }
+
+static unsigned int getUniformTypeNumColumns(GLenum type)
+{
+    switch(type)
+    {
+        case(Uniform::FLOAT_MAT2):
+        case(Uniform::FLOAT_MAT2x3):
+        case(Uniform::FLOAT_MAT2x4):
+        case(Uniform::DOUBLE_MAT2):
+        case(Uniform::DOUBLE_MAT2x3):
+        case(Uniform::DOUBLE_MAT2x4):
+            return 2;
+        case(Uniform::FLOAT_MAT3):
+        case(Uniform::FLOAT_MAT3x2):
+        case(Uniform::FLOAT_MAT3x4):
+        case(Uniform::DOUBLE_MAT3):
+        case(Uniform::DOUBLE_MAT3x2):
+        case(Uniform::DOUBLE_MAT3x4):
+            return 3;
+        case(Uniform::FLOAT_MAT4):
+        case(Uniform::FLOAT_MAT4x2):
+        case(Uniform::FLOAT_MAT4x3):
+        case(Uniform::DOUBLE_MAT4):
+        case(Uniform::DOUBLE_MAT4x2):
+        case(Uniform::DOUBLE_MAT4x3):
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+unsigned int Program::PerContextProgram::packUniformBlockMember(const UniformBlockMember& member, const Uniform& uniform, unsigned char* data, unsigned int dataSize)
+{
+    if (uniform.getType()!=static_cast<Uniform::Type>(member.type)) return 0;
+
+    const unsigned char* source = 0;
+    unsigned int componentSize = 4;
+    switch(Uniform::getInternalArrayType(uniform.getType()))
+    {
+        case(GL_FLOAT): if (uniform.getFloatArray()) source = static_cast<const unsigned char*>(uniform.getFloatArray()->getDataPointer()); break;
+        case(GL_DOUBLE): if (uniform.getDoubleArray()) source = static_cast<const unsigned char*>(uniform.getDoubleArray()->getDataPointer()); componentSize = 8; break;
+        case(GL_INT): if (uniform.getIntArray()) source = static_cast<const unsigned char*>(uniform.getIntArray()->getDataPointer()); break;
+        case(GL_UNSIGNED_INT): if (uniform.getUIntArray()) source = static_cast<const unsigned char*>(uniform.getUIntArray()->getDataPointer()); break;
+        default: break;
+    }
+    if (!source) return 0;
+
+    unsigned int numElements = osg::minimum(uniform.getNumElements(), static_cast<unsigned int>(member.size));
+    unsigned int numColumns = getUniformTypeNumColumns(member.type);
+    unsigned int numRows = Uniform::getTypeNumComponents(uniform.getType())/numColumns;
+    unsigned int columnSize = numRows*componentSize;
+
+    unsigned int end = 0;
+    for(unsigned int e=0; e<numElements; ++e)
+    {
+        for(unsigned int c=0; c<numColumns; ++c)
+        {
+            unsigned int offset = member.offset + e*member.arrayStride + c*member.matrixStride;
+            if (offset+columnSize>dataSize) return end;
+
+            memcpy(data+offset, source+(e*numColumns+c)*columnSize, columnSize);
+            end = offset+columnSize;
+        }
+    }
+    return end;
+}
+
+void Program::PerContextProgram::setUpAutomaticUniformBlocks(const std::vector<GLuint>& uniformIndices, const std::vector<std::string>& uniformNames)
+{
+    GLint maxBindings = 0;
+    glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings);
+
+    // use the binding points from the top of the range to keep clear of the ones set explicitly by applications.
+    for(unsigned int i=0; i<_automaticUniformBlocks.size(); ++i)
+    {
+        AutomaticUniformBlock& block = _automaticUniformBlocks[i];
+        if (static_cast<GLint>(i)>=maxBindings)
+        {
+            OSG_WARN << "uniform block " << block.name << " has no binding.\n";
+            continue;
+        }
+
+        block.binding = maxBindings-1-i;
+        _extensions->glUniformBlockBinding(_glProgramHandle, block.index, block.binding);
+
+        OSG_INFO << "uniform block " << block.name << ": " << block.index << " automatic binding: " << block.binding << "\n";
+    }
+
+    if (uniformIndices.empty()) return;
+
+    GLsizei numUniforms = static_cast<GLsizei>(uniformIndices.size());
+    std::vector<GLint> types(numUniforms), sizes(numUniforms), blockIndices(numUniforms), offsets(numUniforms), arrayStrides(numUniforms), matrixStrides(numUniforms);
+    _extensions->glGetActiveUniformsiv(_glProgramHandle, numUniforms, &uniformIndices[0], GL_UNIFORM_TYPE, &types[0]);
+    _extensions->glGetActiveUniformsiv(_glProgramHandle, numUniforms, &uniformIndices[0], GL_UNIFORM_SIZE, &sizes[0]);
+    _extensions->glGetActiveUniformsiv(_glProgramHandle, numUniforms, &uniformIndices[0], GL_UNIFORM_BLOCK_INDEX, &blockIndices[0]);
+    _extensions->glGetActiveUniformsiv(_glProgramHandle, numUniforms, &uniformIndices[0], GL_UNIFORM_OFFSET, &offsets[0]);
+    _extensions->glGetActiveUniformsiv(_glProgramHandle, numUniforms, &uniformIndices[0], GL_UNIFORM_ARRAY_STRIDE, &arrayStrides[0]);
+    _extensions->glGetActiveUniformsiv(_glProgramHandle, numUniforms, &uniformIndices[0], GL_UNIFORM_MATRIX_STRIDE, &matrixStrides[0]);
+
+    for(GLsizei i=0; i<numUniforms; ++i)
+    {
+        for(unsigned int b=0; b<_automaticUniformBlocks.size(); ++b)
+        {
+            AutomaticUniformBlock& block = _automaticUniformBlocks[b];
+            if (static_cast<GLuint>(blockIndices[i])!=block.index) continue;
+
+            // members of blocks with an instance name are reported as BlockName.member, the osg::Uniform just uses the member name.
+            std::string name = uniformNames[i];
+            if (name.size()>block.name.size() && name.compare(0, block.name.size(), block.name)==0 && name[block.name.size()]=='.')
+            {
+                name.erase(0, block.name.size()+1);
+            }
+
+            UniformBlockMember member;
+            member.nameID = Uniform::getNameID(name);
+            member.type = types[i];
+            member.size = sizes[i];
+            member.offset = offsets[i];
+            member.arrayStride = arrayStrides[i];
+            member.matrixStride = matrixStrides[i];
+
+            _uniformBlockMemberMap[member.nameID] = std::pair<unsigned int, unsigned int>(b, static_cast<unsigned int>(block.members.size()));
+            block.members.push_back(member);
+            block.appliedUniforms.push_back(UniformModifiedCountList::value_type(observer_ptr<const Uniform>(), 0));
+
+            OSG_INFO << "\tUniform block member \"" << name << "\" block=" << block.name << " offset=" << member.offset << std::endl;
+            break;
+        }
+    }
+}
+
+void Program::PerContextProgram::applyToUniformBlock(const Uniform& uniform) const
+{
+    UniformBlockMemberMap::const_iterator itr = _uniformBlockMemberMap.find(uniform.getNameID());
+    if (itr==_uniformBlockMemberMap.end()) return;
+
+    AutomaticUniformBlock& block = _automaticUniformBlocks[itr->second.first];
+    UniformModifiedCountList::value_type& applied = block.appliedUniforms[itr->second.second];
+    if (applied.first.get()!=&uniform || applied.second!=uniform.getModifiedCount())
+    {
+        applied.first = &uniform;
+        applied.second = uniform.getModifiedCount();
+        block.dirty = true;
+        _uniformBlocksDirty = true;
+    }
+}
+
+static unsigned int s_maximumNumUniformBlockBuffers = 256;
+
+void Program::PerContextProgram::setMaximumNumUniformBlockBuffers(unsigned int num)
+{
+    s_maximumNumUniformBlockBuffers = num>0 ? num : 1;
+}
+
+unsigned int Program::PerContextProgram::getMaximumNumUniformBlockBuffers()
+{
+    return s_maximumNumUniformBlockBuffers;
+}
+
+bool Program::PerContextProgram::UniformBlockBuffer::hasDeletedUniforms() const
+{
+    for(UniformModifiedCountList::const_iterator itr = packedUniforms.begin();
+        itr != packedUniforms.end();
+        ++itr)
+    {
+        // the raw pointer of an observer_ptr is kept once the uniform has been deleted, only get() returns 0.
+        if (itr->first!=static_cast<const Uniform*>(0) && !itr->first.valid()) return true;
+    }
+    return false;
+}
+
+void Program::PerContextProgram::AutomaticUniformBlock::trimBuffers(unsigned int num)
+{
+    if (buffers.size()<num) return;
+
+    for(UniformBlockBuffers::iterator itr = buffers.begin();
+        itr != buffers.end();)
+    {
+        if (itr->second->hasDeletedUniforms())
+        {
+            if (lastBound==itr->second.get()) lastBound = 0;
+            buffers.erase(itr++);
+        }
+        else ++itr;
+    }
+
+    while(buffers.size()>=num)
+    {
+        UniformBlockBuffers::iterator oldest = buffers.begin();
+        for(UniformBlockBuffers::iterator itr = buffers.begin();
+            itr != buffers.end();
+            ++itr)
+        {
+            if (itr->second->lastUsed<oldest->second->lastUsed) oldest = itr;
+        }
+
+        if (lastBound==oldest->second.get()) lastBound = 0;
+        buffers.erase(oldest);
+    }
+}
+
+void Program::PerContextProgram::applyUniformBlocksImplementation(osg::State& state) const
+{
+    _uniformBlocksDirty = false;
+
+    for(AutomaticUniformBlocks::iterator itr = _automaticUniformBlocks.begin();
+        itr != _automaticUniformBlocks.end();
+        ++itr)
+    {
+        AutomaticUniformBlock& block = *itr;
+        if (block.size<=0 || (!block.dirty && block.lastBound)) continue;
+        block.dirty = false;
+
+        // each combination of uniforms, typically one per StateSet, gets its own buffer so unchanged ones just need binding.
+        std::vector<const Uniform*> key(block.appliedUniforms.size());
+        for(unsigned int i=0; i<block.appliedUniforms.size(); ++i)
+        {
+            key[i] = block.appliedUniforms[i].first.get();
+        }
+
+        AutomaticUniformBlock::UniformBlockBuffers::iterator bitr = block.buffers.find(key);
+        if (bitr==block.buffers.end())
+        {
+            block.trimBuffers(s_maximumNumUniformBlockBuffers);
+            bitr = block.buffers.insert(AutomaticUniformBlock::UniformBlockBuffers::value_type(key, 0)).first;
+        }
+
+        osg::ref_ptr<UniformBlockBuffer>& buffer = bitr->second;
+        if (!buffer)
+        {
+            buffer = new UniformBlockBuffer;
+            buffer->data = new osg::UByteArray(block.size);
+            buffer->bufferObject = new osg::UniformBufferObject;
+            buffer->data->setBufferObject(buffer->bufferObject.get());
+            buffer->binding = new osg::UniformBufferBinding(block.binding, buffer->bufferObject.get(), 0, block.size);
+            buffer->packedUniforms.resize(block.appliedUniforms.size(), UniformModifiedCountList::value_type(observer_ptr<const Uniform>(), 0));
+        }
+        buffer->lastUsed = ++block.useCount;
+
+        // repack the members whose uniforms have been modified since the buffer was last updated.
+        unsigned char* data = &(buffer->data->front());
+        unsigned int dirtyStart = block.size;
+        unsigned int dirtyEnd = 0;
+        for(unsigned int i=0; i<block.members.size(); ++i)
+        {
+            const UniformModifiedCountList::value_type& applied = block.appliedUniforms[i];
+            UniformModifiedCountList::value_type& packed = buffer->packedUniforms[i];
+            const Uniform* uniform = applied.first.get();
+            if (!uniform || (packed.first.get()==uniform && packed.second==applied.second)) continue;
+
+            unsigned int end = packUniformBlockMember(block.members[i], *uniform, data, block.size);
+            if (end>0)
+            {
+                dirtyStart = osg::minimum(dirtyStart, static_cast<unsigned int>(block.members[i].offset));
+                dirtyEnd = osg::maximum(dirtyEnd, end);
+            }
+            packed = applied;
+        }
+
+        GLBufferObject* glBufferObject = buffer->bufferObject->getOrCreateGLBufferObject(_contextID);
+        if (glBufferObject->isDirty())
+        {
+            glBufferObject->compileBuffer();
+        }
+        else if (dirtyStart<dirtyEnd)
+        {
+            _extensions->glBindBuffer(GL_UNIFORM_BUFFER, glBufferObject->getGLObjectID());
+            _extensions->glBufferSubData(GL_UNIFORM_BUFFER, glBufferObject->getOffset(0)+dirtyStart, dirtyEnd-dirtyStart, data+dirtyStart);
+        }
+
+        if (block.lastBound!=buffer.get())
+        {
+            buffer->binding->apply(state);
+            block.lastBound = buffer.get();
+        }
+    }
+}
@@ -19,6 +19,8 @@
 #include <osg/ShaderComposer>
 #include <osg/Notify>
 
+#include <algorithm>
+
 using namespace osg;
 
 ShaderComposer::ShaderComposer()
@@ -43,7 +45,7 @@ void ShaderComposer::releaseGLObjects(osg::State* state) const
         itr != _programMap.end();
         ++itr)
     {
-        itr->second->releaseGLObjects(state);
+        itr->second.second->releaseGLObjects(state);
     }
 
     for(ShaderMainMap::const_iterator itr = _shaderMainMap.begin();
@@ -54,13 +56,49 @@ void ShaderComposer::releaseGLObjects(osg::State* state) const
     }
 }
 
+ShaderComponentsKey ShaderComposer::computeShaderComponentsKey(const ShaderComponents& shaderComponents)
+{
+    ShaderComponentsKey key = 0;
+    for(ShaderComponents::const_iterator itr = shaderComponents.begin();
+        itr != shaderComponents.end();
+        ++itr)
+    {
+        key += getShaderComponentKey(*itr);
+    }
+    return key;
+}
+
+bool ShaderComposer::sameShaderComponents(const ShaderComponents& lhs, const ShaderComponents& rhs)
+{
+    if (lhs.size()!=rhs.size()) return false;
+
+    ShaderComponents sortedLhs(lhs);
+    ShaderComponents sortedRhs(rhs);
+    std::sort(sortedLhs.begin(), sortedLhs.end());
+    std::sort(sortedRhs.begin(), sortedRhs.end());
+    return sortedLhs==sortedRhs;
+}
+
+osg::Program* ShaderComposer::getProgram(const ShaderComponents& shaderComponents, ShaderComponentsKey key) const
+{
+    std::pair<ProgramMap::const_iterator, ProgramMap::const_iterator> range = _programMap.equal_range(key);
+    for(ProgramMap::const_iterator itr = range.first;
+        itr != range.second;
+        ++itr)
+    {
+        if (sameShaderComponents(itr->second.first, shaderComponents)) return itr->second.second.get();
+    }
+    return 0;
+}
+
 osg::Program* ShaderComposer::getOrCreateProgram(const ShaderComponents& shaderComponents)
 {
-    ProgramMap::iterator pmitr = _programMap.find(shaderComponents);
-    if (pmitr != _programMap.end())
+    ShaderComponentsKey key = computeShaderComponentsKey(shaderComponents);
+    osg::Program* cachedProgram = getProgram(shaderComponents, key);
+    if (cachedProgram)
     {
         // OSG_NOTICE<<"ShaderComposer::getOrCreateProgram(..) using cached Program"<<std::endl;
-        return pmitr->second.get();
+        return cachedProgram;
     }
 
     // strip out vertex shaders
@@ -142,7 +180,7 @@ osg::Program* ShaderComposer::getOrCreateProgram(const ShaderComponents& shaderC
     }
 
     // assign newly created program to map.
-    _programMap[shaderComponents] = program;
+    _programMap.insert(ProgramMap::value_type(key, ProgramMap::mapped_type(shaderComponents, program)));
 
     OSG_NOTICE<<"ShaderComposer::getOrCreateProgram(..) created new Program"<<std::endl;
 
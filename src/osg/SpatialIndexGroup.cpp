@@ -0,0 +1,330 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+#include <osg/SpatialIndexGroup>
+#include <osg/CullStack>
+#include <osg/Drawable>
+#include <osg/Transform>
+
+#include <algorithm>
+
+using namespace osg;
+
+namespace
+{
+
+inline BoundingBox computeChildBoundingBox(const Node* child)
+{
+    const Drawable* drawable = child->asDrawable();
+    if (drawable) return drawable->getBoundingBox();
+
+    BoundingBox bb;
+    bb.expandBy(child->getBound());
+    return bb;
+}
+
+inline float surfaceArea(const BoundingBox& bb)
+{
+    if (!bb.valid()) return 0.0f;
+
+    float dx = bb.xMax()-bb.xMin();
+    float dy = bb.yMax()-bb.yMin();
+    float dz = bb.zMax()-bb.zMin();
+    return 2.0f*(dx*dy + dy*dz + dz*dx);
+}
+
+struct LessCenter
+{
+    LessCenter(unsigned int axis):
+        _axis(axis) {}
+
+    bool operator() (const std::pair<Vec3, unsigned int>& lhs, const std::pair<Vec3, unsigned int>& rhs) const
+    {
+        return lhs.first[_axis] < rhs.first[_axis];
+    }
+
+    unsigned int _axis;
+};
+
+/** Culls the cells outside the view frustum, pushing the culling mask for the children of the cells entered,
+  * the way CullVisitor does for the nodes it traverses.*/
+class CullCellCallback : public SpatialIndexGroup::CellCallback
+{
+    public:
+
+        CullCellCallback(CullStack* cullStack):
+            _cullStack(cullStack) {}
+
+        virtual bool enter(const BoundingBox& bb)
+        {
+            if (_cullStack->isCulled(bb)) return false;
+
+            _cullStack->pushCurrentMask();
+            return true;
+        }
+
+        virtual void leave()
+        {
+            _cullStack->popCurrentMask();
+        }
+
+    protected:
+
+        CullStack* _cullStack;
+};
+
+}
+
+SpatialIndexGroup::SpatialIndexGroup():
+    _maximumChildrenPerCell(8),
+    _rebuildRatio(2.0f),
+    _indexDirty(true),
+    _builtArea(0.0f),
+    _numIndexBuilds(0)
+{
+}
+
+SpatialIndexGroup::SpatialIndexGroup(const SpatialIndexGroup& group,const CopyOp& copyop):
+    Group(group,copyop),
+    _maximumChildrenPerCell(group._maximumChildrenPerCell),
+    _rebuildRatio(group._rebuildRatio),
+    _indexDirty(true),
+    _builtArea(0.0f),
+    _numIndexBuilds(0)
+{
+}
+
+SpatialIndexGroup::SpatialIndexGroup(const Group& group,const CopyOp& copyop):
+    Group(group,copyop),
+    _maximumChildrenPerCell(8),
+    _rebuildRatio(2.0f),
+    _indexDirty(true),
+    _builtArea(0.0f),
+    _numIndexBuilds(0)
+{
+}
+
+void SpatialIndexGroup::traverse(NodeVisitor& nv)
+{
+    if (nv.getVisitorType()==NodeVisitor::CULL_VISITOR)
+    {
+        CullStack* cullStack = dynamic_cast<CullStack*>(&nv);
+        if (cullStack)
+        {
+            CullCellCallback callback(cullStack);
+            traverse(nv, callback);
+            return;
+        }
+    }
+
+    Group::traverse(nv);
+}
+
+void SpatialIndexGroup::traverse(NodeVisitor& nv, CellCallback& callback)
+{
+    // make sure the index is up to date with the children.
+    getBound();
+
+    if (!_cells.empty()) traverseCell(0, nv, callback);
+
+    for(Indices::const_iterator itr = _unindexedChildren.begin();
+        itr != _unindexedChildren.end();
+        ++itr)
+    {
+        _children[*itr]->accept(nv);
+    }
+}
+
+void SpatialIndexGroup::traverseCell(unsigned int cellIndex, NodeVisitor& nv, CellCallback& callback)
+{
+    // copy the cell as the children's traversal may resize the cell list.
+    Cell cell = _cells[cellIndex];
+
+    if (!callback.enter(cell.bb)) return;
+
+    if (cell.count>0)
+    {
+        for(unsigned int i=cell.first; i<cell.first+cell.count; ++i)
+        {
+            _children[_indices[i]]->accept(nv);
+        }
+    }
+    else
+    {
+        traverseCell(cellIndex+1, nv, callback);
+        traverseCell(cell.first, nv, callback);
+    }
+
+    callback.leave();
+}
+
+bool SpatialIndexGroup::setChild( unsigned  int i, Node* node )
+{
+    if (!Group::setChild(i, node)) return false;
+
+    _indexDirty = true;
+    return true;
+}
+
+void SpatialIndexGroup::childRemoved(unsigned int /*pos*/, unsigned int /*numChildrenToRemove*/)
+{
+    _indexDirty = true;
+}
+
+void SpatialIndexGroup::childInserted(unsigned int /*pos*/)
+{
+    _indexDirty = true;
+}
+
+bool SpatialIndexGroup::isIndexed(const Node* child) const
+{
+    // as in Group::computeBound(), Transforms relative to an absolute reference frame aren't in this group's coordinate frame.
+    const Transform* transform = child->asTransform();
+    if (transform && transform->getReferenceFrame()!=Transform::RELATIVE_RF) return false;
+
+    return child->getCullingActive() && child->getNumChildrenWithCullingDisabled()==0;
+}
+
+BoundingSphere SpatialIndexGroup::computeBound() const
+{
+    if (_indexDirty)
+    {
+        buildIndex();
+    }
+    else if (!_cells.empty())
+    {
+        // children have moved, refit the cells around them and only rebuild once the cells overlap too much.
+        float area = refitIndex();
+        if (area > _builtArea*_rebuildRatio) buildIndex();
+    }
+
+    return Group::computeBound();
+}
+
+void SpatialIndexGroup::buildIndex() const
+{
+    _indexDirty = false;
+    ++_numIndexBuilds;
+
+    _cells.clear();
+    _indices.clear();
+    _unindexedChildren.clear();
+    _childBoundingBoxes.resize(_children.size());
+
+    for(unsigned int i=0; i<_children.size(); ++i)
+    {
+        const Node* child = _children[i].get();
+        if (isIndexed(child))
+        {
+            _childBoundingBoxes[i] = computeChildBoundingBox(child);
+            _childCenters.push_back(Centers::value_type(_childBoundingBoxes[i].center(), i));
+            _indices.push_back(i);
+        }
+        else
+        {
+            _childBoundingBoxes[i].init();
+            _unindexedChildren.push_back(i);
+        }
+    }
+
+    _builtArea = 0.0f;
+    if (_indices.empty()) return;
+
+    buildCell(0, static_cast<unsigned int>(_indices.size()));
+
+    // the centers are only needed to split the cells.
+    Centers().swap(_childCenters);
+
+    for(Cells::const_iterator itr = _cells.begin(); itr != _cells.end(); ++itr)
+    {
+        _builtArea += surfaceArea(itr->bb);
+    }
+}
+
+unsigned int SpatialIndexGroup::buildCell(unsigned int first, unsigned int count) const
+{
+    unsigned int cellIndex = static_cast<unsigned int>(_cells.size());
+    _cells.push_back(Cell());
+
+    if (count>_maximumChildrenPerCell)
+    {
+        // split at the median of the child centers along the longest axis of the centers.
+        BoundingBox centers;
+        for(unsigned int i=first; i<first+count; ++i)
+        {
+            centers.expandBy(_childCenters[i].first);
+        }
+
+        Vec3 size = centers._max - centers._min;
+        unsigned int axis = 0;
+        if (size.y()>size[axis]) axis = 1;
+        if (size.z()>size[axis]) axis = 2;
+
+        unsigned int half = count/2;
+        Centers::iterator begin = _childCenters.begin()+first;
+        std::nth_element(begin, begin+half, begin+count, LessCenter(axis));
+
+        buildCell(first, half);
+        unsigned int second = buildCell(first+half, count-half);
+
+        Cell& cell = _cells[cellIndex];
+        cell.bb.expandBy(_cells[cellIndex+1].bb);
+        cell.bb.expandBy(_cells[second].bb);
+        cell.first = second;
+        cell.count = 0;
+    }
+    else
+    {
+        Cell& cell = _cells[cellIndex];
+        for(unsigned int i=first; i<first+count; ++i)
+        {
+            _indices[i] = _childCenters[i].second;
+            cell.bb.expandBy(_childBoundingBoxes[_indices[i]]);
+        }
+        cell.first = first;
+        cell.count = count;
+    }
+
+    return cellIndex;
+}
+
+float SpatialIndexGroup::refitIndex() const
+{
+    for(Indices::const_iterator itr = _indices.begin(); itr != _indices.end(); ++itr)
+    {
+        _childBoundingBoxes[*itr] = computeChildBoundingBox(_children[*itr].get());
+    }
+
+    // the cells of a subtree always follow their parent cell, so refitting in reverse order is bottom up.
+    float area = 0.0f;
+    for(Cells::reverse_iterator ritr = _cells.rbegin(); ritr != _cells.rend(); ++ritr)
+    {
+        Cell& cell = *ritr;
+        cell.bb.init();
+        if (cell.count>0)
+        {
+            for(unsigned int i=cell.first; i<cell.first+cell.count; ++i)
+            {
+                cell.bb.expandBy(_childBoundingBoxes[_indices[i]]);
+            }
+        }
+        else
+        {
+            unsigned int cellIndex = static_cast<unsigned int>(&cell - &_cells.front());
+            cell.bb.expandBy(_cells[cellIndex+1].bb);
+            cell.bb.expandBy(_cells[cell.first].bb);
+        }
+        area += surfaceArea(cell.bb);
+    }
+
+    return area;
+}
@@ -38,6 +38,7 @@ using namespace std;
 using namespace osg;
 
 static ApplicationUsageProxy State_e0(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_GL_ERROR_CHECKING <type>","ONCE_PER_ATTRIBUTE | ON | on enables fine grained checking,  ONCE_PER_FRAME enables coarse grained checking");
+static ApplicationUsageProxy State_e1(ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_VERTEX_ARRAY_OBJECTS <mode>","ON | OFF, enable caching of the vertex array set up of Geometry using vertex buffer objects in vertex array objects");
 
 State::State():
     Referenced(true)
@@ -48,6 +49,7 @@ State::State():
     _shaderCompositionEnabled = false;
     _shaderCompositionDirty = true;
     _shaderComposer = new ShaderComposer;
+    _shaderComponentsKey = 0;
     _currentShaderCompositionProgram = 0L;
 
     _identity = new osg::RefMatrix(); // default RefMatrix constructs to identity.
@@ -92,6 +94,16 @@ State::State():
     _currentEBO = 0;
     _currentPBO = 0;
 
+    _useVertexArrayObjects = false;
+    _currentVAO = 0;
+    _defaultVAOElementBufferObject = 0;
+
+    str = getenv("OSG_VERTEX_ARRAY_OBJECTS");
+    if (str && (strcmp(str,"ON")==0 || strcmp(str,"on")==0))
+    {
+        _useVertexArrayObjects = true;
+    }
+
     _isSecondaryColorSupportResolved = false;
     _isSecondaryColorSupported = false;
 
@@ -185,6 +197,8 @@ void State::releaseGLObjects()
     }
     _attributeMap.clear();
 
+    clearMapIndices();
+
     // release any cached texture attributes
     for(TextureAttributeMapList::iterator itr = _textureAttributeMapList.begin();
         itr != _textureAttributeMapList.end();
@@ -216,14 +230,16 @@ void State::reset()
         ModeStack& ms = mitr->second;
         ms.valueVec.clear();
         ms.last_applied_value = !ms.global_default_value;
-        ms.changed = true;
+        setModeChanged(_modeMap, *mitr);
     }
 #else
     _modeMap.clear();
+    clearMapIndices();
 #endif
 
-    _modeMap[GL_DEPTH_TEST].global_default_value = true;
-    _modeMap[GL_DEPTH_TEST].changed = true;
+    ModeMap::value_type& depthTestEntry = getModeEntry(_modeMap, GL_DEPTH_TEST);
+    depthTestEntry.second.global_default_value = true;
+    setModeChanged(_modeMap, depthTestEntry);
 
     // go through all active StateAttribute's, setting to change to force update,
     // the idea is to leave only the global defaults left.
@@ -235,7 +251,7 @@ void State::reset()
         as.attributeVec.clear();
         as.last_applied_attribute = NULL;
         as.last_applied_shadercomponent = NULL;
-        as.changed = true;
+        setAttributeChanged(_attributeMap, *aitr);
     }
 
     // we can do a straight clear, we arn't interested in GL_DEPTH_TEST defaults in texture modes.
@@ -285,6 +301,7 @@ void State::reset()
 #endif
 
     _shaderCompositionDirty = true;
+    _shaderComponentsKey = 0;
     _currentShaderCompositionUniformList.clear();
 
     _lastAppliedProgramObject = 0;
@@ -569,6 +586,8 @@ void State::apply(const StateSet* dstate)
             }
         }
 
+        if (_lastAppliedProgramObject) _lastAppliedProgramObject->applyUniformBlocks(*this);
+
 #if 1
         popDefineList(_defineMap, dstate->getDefineList());
 #endif
@@ -625,6 +644,8 @@ void State::apply()
     if (_currentShaderCompositionUniformList.empty()) applyUniformMap(_uniformMap);
     else applyUniformList(_uniformMap, _currentShaderCompositionUniformList);
 
+    if (_lastAppliedProgramObject) _lastAppliedProgramObject->applyUniformBlocks(*this);
+
     if (_checkGLErrors==ONCE_PER_ATTRIBUTE) checkGLErrors("end of State::apply()");
 }
 
@@ -636,6 +657,8 @@ void State::applyShaderComposition()
         {
             // if (isNotifyEnabled(osg::INFO)) print(notify(osg::INFO));
 
+            _shaderCompositionDirty = false;
+
             // build lits of current ShaderComponents
             ShaderComponents shaderComponents;
 
@@ -654,7 +677,13 @@ void State::applyShaderComposition()
                 }
             }
 
-            _currentShaderCompositionProgram = _shaderComposer->getOrCreateProgram(shaderComponents);
+            // the key is maintained as ShaderComponents are applied so it doesn't need computing for the lookup,
+            // the components are compared against those of the Programs with the same key.
+            _currentShaderCompositionProgram = _shaderComposer->getProgram(shaderComponents, _shaderComponentsKey);
+            if (!_currentShaderCompositionProgram)
+            {
+                _currentShaderCompositionProgram = _shaderComposer->getOrCreateProgram(shaderComponents);
+            }
         }
 
         if (_currentShaderCompositionProgram)
@@ -732,25 +761,26 @@ const StateAttribute* State::getLastAppliedTextureAttribute(unsigned int unit,St
 
 void State::haveAppliedMode(ModeMap& modeMap,StateAttribute::GLMode mode,StateAttribute::GLModeValue value)
 {
-    ModeStack& ms = modeMap[mode];
+    ModeMap::value_type& entry = getModeEntry(modeMap, mode);
 
-    ms.last_applied_value = value & StateAttribute::ON;
+    entry.second.last_applied_value = value & StateAttribute::ON;
 
     // will need to disable this mode on next apply so set it to changed.
-    ms.changed = true;
+    setModeChanged(modeMap, entry);
 }
 
 /** mode has been set externally, update state to reflect this setting.*/
 void State::haveAppliedMode(ModeMap& modeMap,StateAttribute::GLMode mode)
 {
-    ModeStack& ms = modeMap[mode];
+    ModeMap::value_type& entry = getModeEntry(modeMap, mode);
+    ModeStack& ms = entry.second;
 
     // don't know what last applied value is can't apply it.
     // assume that it has changed by toggle the value of last_applied_value.
     ms.last_applied_value = !ms.last_applied_value;
 
     // will need to disable this mode on next apply so set it to changed.
-    ms.changed = true;
+    setModeChanged(modeMap, entry);
 }
 
 /** attribute has been applied externally, update state to reflect this setting.*/
@@ -758,12 +788,12 @@ void State::haveAppliedAttribute(AttributeMap& attributeMap,const StateAttribute
 {
     if (attribute)
     {
-        AttributeStack& as = attributeMap[attribute->getTypeMemberPair()];
+        AttributeMap::value_type& entry = getAttributeEntry(attributeMap, attribute->getTypeMemberPair());
 
-        as.last_applied_attribute = attribute;
+        entry.second.last_applied_attribute = attribute;
 
         // will need to update this attribute on next apply so set it to changed.
-        as.changed = true;
+        setAttributeChanged(attributeMap, entry);
     }
 }
 
@@ -773,11 +803,10 @@ void State::haveAppliedAttribute(AttributeMap& attributeMap,StateAttribute::Type
     AttributeMap::iterator itr = attributeMap.find(StateAttribute::TypeMemberPair(type,member));
     if (itr!=attributeMap.end())
     {
-        AttributeStack& as = itr->second;
-        as.last_applied_attribute = 0L;
+        itr->second.last_applied_attribute = 0L;
 
         // will need to update this attribute on next apply so set it to changed.
-        as.changed = true;
+        setAttributeChanged(attributeMap, *itr);
     }
 }
 
@@ -809,6 +838,19 @@ const StateAttribute* State::getLastAppliedAttribute(const AttributeMap& attribu
     }
 }
 
+void State::clearMapIndices()
+{
+    _modeMapIndex.clear();
+    _changedModes.clear();
+    _previouslyChangedModes.clear();
+
+    _attributeMapIndex.clear();
+    _changedAttributes.clear();
+    _previouslyChangedAttributes.clear();
+
+    _uniformMapIndex.clear();
+}
+
 void State::dirtyAllModes()
 {
     for(ModeMap::iterator mitr=_modeMap.begin();
@@ -817,8 +859,7 @@ void State::dirtyAllModes()
     {
         ModeStack& ms = mitr->second;
         ms.last_applied_value = !ms.last_applied_value;
-        ms.changed = true;
-
+        setModeChanged(_modeMap, *mitr);
     }
 
     for(TextureModeMapList::iterator tmmItr=_textureModeMapList.begin();
@@ -843,9 +884,8 @@ void State::dirtyAllAttributes()
         aitr!=_attributeMap.end();
         ++aitr)
     {
-        AttributeStack& as = aitr->second;
-        as.last_applied_attribute = 0;
-        as.changed = true;
+        aitr->second.last_applied_attribute = 0;
+        setAttributeChanged(_attributeMap, *aitr);
     }
 
 
@@ -1410,6 +1450,8 @@ void State::applyModelViewAndProjectionUniformsIfRequired()
     if (_projectionMatrixUniform) _lastAppliedProgramObject->apply(*_projectionMatrixUniform);
     if (_modelViewProjectionMatrixUniform) _lastAppliedProgramObject->apply(*_modelViewProjectionMatrixUniform);
     if (_normalMatrixUniform) _lastAppliedProgramObject->apply(*_normalMatrixUniform);
+
+    _lastAppliedProgramObject->applyUniformBlocks(*this);
 }
 
 namespace State_Utils
@@ -1826,7 +1868,7 @@ void State::frameCompleted()
 
 bool State::DefineMap::updateCurrentDefines()
 {
-    currentDefines.clear();
+    StateSet::DefineList defines;
     for(DefineStackMap::const_iterator itr = map.begin();
         itr != map.end();
         ++itr)
@@ -1837,11 +1879,17 @@ bool State::DefineMap::updateCurrentDefines()
             const StateSet::DefinePair& dp = dv.back();
             if (dp.second & osg::StateAttribute::ON)
             {
-                currentDefines[itr->first] = dp;
+                defines[itr->first] = dp;
             }
         }
     }
     changed = false;
+
+    // pushing and popping StateSets often restores the same defines, in which case cached matches remain valid.
+    if (defines == currentDefines) return false;
+
+    currentDefines.swap(defines);
+    ++modifiedCount;
     return true;
 }
 
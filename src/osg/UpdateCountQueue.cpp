@@ -0,0 +1,112 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/UpdateCountQueue>
+
+#include <OpenThreads/Atomic>
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+
+using namespace osg;
+
+// the queue deferring changes, 0 when no queue is between begin() and end().
+static OpenThreads::AtomicPtr s_collectingQueue;
+
+UpdateCountQueue::UpdateCountQueue():
+    _collecting(false),
+    _beginThread(0)
+{
+}
+
+UpdateCountQueue::~UpdateCountQueue()
+{
+    if (_collecting) end();
+}
+
+UpdateCountQueue* UpdateCountQueue::getCurrent()
+{
+    UpdateCountQueue* queue = static_cast<UpdateCountQueue*>(s_collectingQueue.get());
+    return (queue && queue->participates(OpenThreads::Thread::CurrentThread())) ? queue : 0;
+}
+
+bool UpdateCountQueue::participates(OpenThreads::Thread* thread) const
+{
+    // the begin thread is set before the queue is made current, so only the added threads need the lock.
+    if (thread==_beginThread) return _collecting;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _collecting && std::find(_threads.begin(), _threads.end(), thread)!=_threads.end();
+}
+
+bool UpdateCountQueue::begin()
+{
+    if (_collecting) return true;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _beginThread = OpenThreads::Thread::CurrentThread();
+        _collecting = true;
+    }
+
+    if (!s_collectingQueue.assign(this, 0))
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _collecting = false;
+        return false;
+    }
+
+    return true;
+}
+
+void UpdateCountQueue::addThread(OpenThreads::Thread* thread)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    if (std::find(_threads.begin(), _threads.end(), thread)==_threads.end()) _threads.push_back(thread);
+}
+
+void UpdateCountQueue::removeThread(OpenThreads::Thread* thread)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    Threads::iterator itr = std::find(_threads.begin(), _threads.end(), thread);
+    if (itr!=_threads.end()) _threads.erase(itr);
+}
+
+void UpdateCountQueue::add(Node* parent, int delta)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _changes.push_back(Changes::value_type(parent, delta));
+}
+
+void UpdateCountQueue::end()
+{
+    if (!_collecting) return;
+
+    s_collectingQueue.assign(0, this);
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _collecting = false;
+    }
+
+    // each child's changes are recorded in the order it made them, so the parents' counts never go below the
+    // number of their children requiring update traversal while they are applied.
+    for(Changes::iterator itr = _changes.begin(); itr != _changes.end(); ++itr)
+    {
+        Node* parent = itr->first.get();
+        parent->setNumChildrenRequiringUpdateTraversal(parent->getNumChildrenRequiringUpdateTraversal()+itr->second);
+    }
+
+    // release the references on the parents, keeping the capacity for the next frame
+    _changes.clear();
+}
@@ -312,20 +312,62 @@ osg::Object* ClassInterface::createObject(const std::string& compoundClassName)
     // return (ow!=0) ? ow->createInstance() : 0;
 }
 
-bool ClassInterface::copyPropertyDataFromObject(const osg::Object* object, const std::string& propertyName, void* valuePtr, unsigned int valueSize, osgDB::BaseSerializer::Type valueType)
+bool ClassInterface::getPropertyHandle(const osg::Object* object, const std::string& propertyName, PropertyHandle& handle) const
 {
-    _poi->flush();
+    handle.name = propertyName;
+    handle.type = osgDB::BaseSerializer::RW_UNDEFINED;
+    handle.serializer = getSerializer(object, propertyName, handle.type);
+    return handle.valid();
+}
+
+// return true if the value can be passed straight to the BaseSerializer::get()/set() of a serializer of the specified type.
+static bool supportsDirectAccess(osgDB::BaseSerializer::Type serializerType, osgDB::BaseSerializer::Type valueType)
+{
+    switch(serializerType)
+    {
+        case(osgDB::BaseSerializer::RW_UNDEFINED):
+        case(osgDB::BaseSerializer::RW_USER):
+        case(osgDB::BaseSerializer::RW_LIST):
+        case(osgDB::BaseSerializer::RW_VECTOR):
+        case(osgDB::BaseSerializer::RW_MAP):
+            return false;
+        case(osgDB::BaseSerializer::RW_GLENUM):
+            return valueType==osgDB::BaseSerializer::RW_UINT;
+        case(osgDB::BaseSerializer::RW_ENUM):
+            return valueType==osgDB::BaseSerializer::RW_INT;
+        case(osgDB::BaseSerializer::RW_MATRIX):
+#ifdef OSG_USE_FLOAT_MATRIX
+            return valueType==osgDB::BaseSerializer::RW_MATRIXF;
+#else
+            return valueType==osgDB::BaseSerializer::RW_MATRIXD;
+#endif
+        default:
+            return serializerType==valueType;
+    }
+}
 
+bool ClassInterface::copyPropertyDataFromObject(const osg::Object* object, const std::string& propertyName, void* valuePtr, unsigned int valueSize, osgDB::BaseSerializer::Type valueType)
+{
     osgDB::BaseSerializer::Type sourceType;
     osgDB::BaseSerializer* serializer = getSerializer(object, propertyName, sourceType);
     if (!serializer) return false;
 
+    return copyPropertyDataFromObject(object, serializer, sourceType, valuePtr, valueSize, valueType);
+}
+
+bool ClassInterface::copyPropertyDataFromObject(const osg::Object* object, osgDB::BaseSerializer* serializer, osgDB::BaseSerializer::Type sourceType, void* valuePtr, unsigned int valueSize, osgDB::BaseSerializer::Type valueType)
+{
     if (!areTypesCompatible(sourceType, valueType))
     {
         OSG_NOTICE<<"ClassInterface::copyPropertyDataFromObject() Types are not compatible, valueType = "<<valueType<<", sourceType="<<sourceType<<std::endl;
         return false;
     }
 
+    // use the serializer's typed accessor when available, avoiding the round trip through the PropertyOutputIterator
+    if (supportsDirectAccess(sourceType, valueType) && serializer->get(*object, valuePtr)) return true;
+
+    _poi->flush();
+
     if (serializer->write(_outputStream, *object))
     {
         unsigned int sourceSize = _poi->_str.size();
@@ -356,6 +398,30 @@ bool ClassInterface::copyPropertyDataFromObject(const osg::Object* object, const
 
 bool ClassInterface::copyPropertyDataToObject(osg::Object* object, const std::string& propertyName, const void* valuePtr, unsigned int valueSize, osgDB::BaseSerializer::Type valueType)
 {
+    osgDB::BaseSerializer::Type destinationType;
+    osgDB::BaseSerializer* serializer = getSerializer(object, propertyName, destinationType);
+    if (serializer)
+    {
+        return copyPropertyDataToObject(object, serializer, destinationType, valuePtr, valueSize, valueType);
+    }
+    else
+    {
+        OSG_INFO<<"ClassInterface::copyPropertyDataFromObject() no serializer available."<<std::endl;
+        return false;
+    }
+}
+
+bool ClassInterface::copyPropertyDataToObject(osg::Object* object, osgDB::BaseSerializer* serializer, osgDB::BaseSerializer::Type destinationType, const void* valuePtr, unsigned int valueSize, osgDB::BaseSerializer::Type valueType)
+{
+    if (!areTypesCompatible(valueType, destinationType))
+    {
+        OSG_NOTICE<<"ClassInterface::copyPropertyDataToObject() Types are not compatible, valueType = "<<valueType<<" ["<<getTypeName(valueType)<<"] , destinationType="<<destinationType<<" ["<<getTypeName(destinationType)<<"]"<<std::endl;
+        return false;
+    }
+
+    // use the serializer's typed accessor when available, avoiding the round trip through the PropertyInputIterator
+    if (supportsDirectAccess(destinationType, valueType) && serializer->set(*object, const_cast<void*>(valuePtr))) return true;
+
     // copy data to PropertyInputIterator
     if (valueType==osgDB::BaseSerializer::RW_STRING)
     {
@@ -367,65 +433,44 @@ bool ClassInterface::copyPropertyDataToObject(osg::Object* object, const std::st
         _pii->set(valuePtr, valueSize);
     }
 
-    osgDB::BaseSerializer::Type destinationType;
-    osgDB::BaseSerializer* serializer = getSerializer(object, propertyName, destinationType);
+    return serializer->read(_inputStream, *object);
+}
+
+bool ClassInterface::copyPropertyObjectFromObject(const osg::Object* object, const std::string& propertyName, void* valuePtr, unsigned int valueSize, osgDB::BaseSerializer::Type valueType)
+{
+    osgDB::BaseSerializer::Type sourceType;
+    osgDB::BaseSerializer* serializer = getSerializer(object, propertyName, sourceType);
     if (serializer)
     {
-        if (areTypesCompatible(valueType, destinationType))
-        {
-            return serializer->read(_inputStream, *object);
-        }
-        else
-        {
-            OSG_NOTICE<<"ClassInterface::copyPropertyDataToObject() Types are not compatible, valueType = "<<valueType<<" ["<<getTypeName(valueType)<<"] , destinationType="<<destinationType<<" ["<<getTypeName(destinationType)<<"]"<<std::endl;
-            return false;
-        }
+        return copyPropertyObjectFromObject(object, serializer, sourceType, valuePtr, valueSize, valueType);
     }
     else
     {
-        OSG_INFO<<"ClassInterface::copyPropertyDataFromObject() no serializer available."<<std::endl;
+        OSG_INFO<<"ClassInterface::copyPropertyObjectFromObject() no serializer available."<<std::endl;
         return false;
     }
 }
 
-bool ClassInterface::copyPropertyObjectFromObject(const osg::Object* object, const std::string& propertyName, void* valuePtr, unsigned int /*valueSize*/, osgDB::BaseSerializer::Type valueType)
+bool ClassInterface::copyPropertyObjectFromObject(const osg::Object* object, osgDB::BaseSerializer* serializer, osgDB::BaseSerializer::Type sourceType, void* valuePtr, unsigned int /*valueSize*/, osgDB::BaseSerializer::Type valueType)
 {
-    osgDB::BaseSerializer::Type sourceType;
-    osgDB::BaseSerializer* serializer = getSerializer(object, propertyName, sourceType);
-    if (serializer)
+    if (areTypesCompatible(sourceType, valueType))
     {
-        if (areTypesCompatible(sourceType, valueType))
-        {
-            return serializer->get(*object, valuePtr);
-        }
-        else
-        {
-            OSG_NOTICE<<"ClassInterface::copyPropertyObjectFromObject() Types are not compatible, valueType = "<<valueType<<" ["<<getTypeName(valueType)<<"] , sourceType="<<sourceType<<" ["<<getTypeName(sourceType)<<"]"<<std::endl;
-            return false;
-        }
+        return serializer->get(*object, valuePtr);
     }
     else
     {
-        OSG_INFO<<"ClassInterface::copyPropertyObjectFromObject() no serializer available."<<std::endl;
+        OSG_NOTICE<<"ClassInterface::copyPropertyObjectFromObject() Types are not compatible, valueType = "<<valueType<<" ["<<getTypeName(valueType)<<"] , sourceType="<<sourceType<<" ["<<getTypeName(sourceType)<<"]"<<std::endl;
         return false;
     }
 }
 
-bool ClassInterface::copyPropertyObjectToObject(osg::Object* object, const std::string& propertyName, const void* valuePtr, unsigned int /*valueSize*/, osgDB::BaseSerializer::Type valueType)
+bool ClassInterface::copyPropertyObjectToObject(osg::Object* object, const std::string& propertyName, const void* valuePtr, unsigned int valueSize, osgDB::BaseSerializer::Type valueType)
 {
     osgDB::BaseSerializer::Type destinationType;
     osgDB::BaseSerializer* serializer = getSerializer(object, propertyName, destinationType);
     if (serializer)
     {
-        if (areTypesCompatible(valueType, destinationType))
-        {
-            return serializer->set(*object, const_cast<void*>(valuePtr));
-        }
-        else
-        {
-            OSG_NOTICE<<"ClassInterface::copyPropertyObjectToObject() Types are not compatible, valueType = "<<valueType<<", destinationType="<<destinationType<<std::endl;
-            return false;
-        }
+        return copyPropertyObjectToObject(object, serializer, destinationType, valuePtr, valueSize, valueType);
     }
     else
     {
@@ -434,6 +479,19 @@ bool ClassInterface::copyPropertyObjectToObject(osg::Object* object, const std::
     }
 }
 
+bool ClassInterface::copyPropertyObjectToObject(osg::Object* object, osgDB::BaseSerializer* serializer, osgDB::BaseSerializer::Type destinationType, const void* valuePtr, unsigned int /*valueSize*/, osgDB::BaseSerializer::Type valueType)
+{
+    if (areTypesCompatible(valueType, destinationType))
+    {
+        return serializer->set(*object, const_cast<void*>(valuePtr));
+    }
+    else
+    {
+        OSG_NOTICE<<"ClassInterface::copyPropertyObjectToObject() Types are not compatible, valueType = "<<valueType<<", destinationType="<<destinationType<<std::endl;
+        return false;
+    }
+}
+
 
 class GetPropertyType : public osg::ValueObject::GetValueVisitor
 {
@@ -16,10 +16,22 @@
 #include <osgDB/Registry>
 #include <osgDB/Registry>
 #include <osgDB/ObjectWrapper>
+#include <osgDB/FileUtils>
+#include <OpenThreads/ScopedLock>
+#include <fstream>
 #include <sstream>
+#include <stdlib.h>
 
 using namespace osgDB;
 
+// Return the integer value of the named plugin string data of options, or defaultValue if it isn't set.
+static int getIntegerOption( const Options* options, const char* name, int defaultValue )
+{
+    if ( !options ) return defaultValue;
+    const std::string& value = options->getPluginStringData( name );
+    return value.empty() ? defaultValue : atoi( value.c_str() );
+}
+
 // Example compressor copying data to/from stream directly
 class NullCompressor : public BaseCompressor
 {
@@ -48,12 +60,12 @@ public:
 
 REGISTER_COMPRESSOR( "null", NullCompressor )
 
+#define CHUNK 32768
+
 #ifdef USE_ZLIB
 
 #include <zlib.h>
 
-#define CHUNK 32768
-
 // ZLib compressor
 class ZLibCompressor : public BaseCompressor
 {
@@ -61,13 +73,23 @@ public:
     ZLibCompressor() {}
 
     virtual bool compress( std::ostream& fout, const std::string& src )
+    {
+        return compress( fout, src, 0 );
+    }
+
+    virtual bool decompress( std::istream& fin, std::string& target )
+    {
+        return decompress( fin, target, 0 );
+    }
+
+    virtual bool compress( std::ostream& fout, const std::string& src, const Options* options )
     {
         int ret, flush = Z_FINISH;
         unsigned have;
         z_stream strm;
         unsigned char out[CHUNK];
 
-        int level = 6;
+        int level = osg::clampBetween( getIntegerOption(options, "CompressionLevel", 6), 0, 9 );
         int stategy = Z_DEFAULT_STRATEGY;
 
         /* allocate deflate state */
@@ -112,7 +134,7 @@ public:
         return true;
     }
 
-    virtual bool decompress( std::istream& fin, std::string& target )
+    virtual bool decompress( std::istream& fin, std::string& target, const Options* )
     {
         int ret;
         unsigned have;
@@ -174,3 +196,252 @@ public:
 REGISTER_COMPRESSOR( "zlib", ZLibCompressor )
 
 #endif
+
+#ifdef USE_LZ4
+
+#include <lz4frame.h>
+#include <string.h>
+
+// LZ4 compressor, writes a single LZ4 frame. Decompression is several times faster than zlib,
+// CompressionLevel=<n> selects the fast compressor for values below 3 and the high compression one above.
+class LZ4Compressor : public BaseCompressor
+{
+public:
+    LZ4Compressor() {}
+
+    virtual bool compress( std::ostream& fout, const std::string& src )
+    {
+        return compress( fout, src, 0 );
+    }
+
+    virtual bool decompress( std::istream& fin, std::string& target )
+    {
+        return decompress( fin, target, 0 );
+    }
+
+    virtual bool compress( std::ostream& fout, const std::string& src, const Options* options )
+    {
+        LZ4F_preferences_t preferences;
+        memset( &preferences, 0, sizeof(preferences) );
+        preferences.compressionLevel = getIntegerOption( options, "CompressionLevel", 0 );
+        preferences.frameInfo.contentSize = src.size();
+        preferences.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+
+        std::vector<char> out( LZ4F_compressFrameBound(src.size(), &preferences) );
+        size_t size = LZ4F_compressFrame( &out[0], out.size(), src.data(), src.size(), &preferences );
+        if ( LZ4F_isError(size) )
+        {
+            OSG_WARN << "LZ4Compressor::compress(): " << LZ4F_getErrorName(size) << std::endl;
+            return false;
+        }
+
+        fout.write( &out[0], size );
+        return !fout.fail();
+    }
+
+    virtual bool decompress( std::istream& fin, std::string& target, const Options* )
+    {
+        LZ4F_dctx* context = 0;
+        if ( LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION)) ) return false;
+
+        char in[CHUNK];
+        std::vector<char> out( 4*CHUNK );
+        size_t ret = 1;
+        while ( ret!=0 )
+        {
+            fin.read( in, CHUNK );
+            size_t available = fin.gcount();
+            if ( available==0 ) break;
+
+            const char* next = in;
+            while ( ret!=0 && available>0 )
+            {
+                size_t outSize = out.size(), inSize = available;
+                ret = LZ4F_decompress( context, &out[0], &outSize, next, &inSize, NULL );
+                if ( LZ4F_isError(ret) )
+                {
+                    OSG_WARN << "LZ4Compressor::decompress(): " << LZ4F_getErrorName(ret) << std::endl;
+                    LZ4F_freeDecompressionContext( context );
+                    return false;
+                }
+
+                target.append( &out[0], outSize );
+                next += inSize;
+                available -= inSize;
+            }
+        }
+
+        LZ4F_freeDecompressionContext( context );
+        return ret==0;
+    }
+};
+
+REGISTER_COMPRESSOR( "lz4", LZ4Compressor )
+
+#endif
+
+#ifdef USE_ZSTD
+
+#include <zstd.h>
+
+// Zstandard compressor, compresses better than zlib at a similar speed and decompresses faster.
+// CompressionLevel=<n> selects the level (default 3), CompressionThreads=<n> compresses with worker threads
+// when zstd is built with multithreading support, and CompressionDictionary=<file> uses a dictionary trained
+// on similar data, such as with 'zstd --train', which helps most for small files like paged database tiles.
+// The same dictionary must be given when reading.
+class ZstdCompressor : public BaseCompressor
+{
+public:
+    ZstdCompressor() {}
+
+    virtual bool compress( std::ostream& fout, const std::string& src )
+    {
+        return compress( fout, src, 0 );
+    }
+
+    virtual bool decompress( std::istream& fin, std::string& target )
+    {
+        return decompress( fin, target, 0 );
+    }
+
+    virtual bool compress( std::ostream& fout, const std::string& src, const Options* options )
+    {
+        int level = osg::clampBetween( getIntegerOption(options, "CompressionLevel", ZSTD_CLEVEL_DEFAULT), ZSTD_minCLevel(), ZSTD_maxCLevel() );
+
+        ZSTD_CCtx* context = ZSTD_createCCtx();
+        if ( !context ) return false;
+
+        ZSTD_CCtx_setParameter( context, ZSTD_c_compressionLevel, level );
+        ZSTD_CCtx_setParameter( context, ZSTD_c_checksumFlag, 1 );
+        ZSTD_CCtx_setPledgedSrcSize( context, src.size() );
+
+        int numThreads = getIntegerOption( options, "CompressionThreads", 0 );
+        if ( numThreads>0 && ZSTD_isError(ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, numThreads)) )
+            OSG_INFO << "ZstdCompressor::compress(): zstd library doesn't support multithreading" << std::endl;
+
+        ZSTD_CDict* dictionary = getCompressionDictionary( options, level );
+        if ( dictionary ) ZSTD_CCtx_refCDict( context, dictionary );
+
+        std::vector<char> out( ZSTD_CStreamOutSize() );
+        ZSTD_inBuffer input = { src.data(), src.size(), 0 };
+        size_t remaining = 0;
+        do
+        {
+            ZSTD_outBuffer output = { &out[0], out.size(), 0 };
+            remaining = ZSTD_compressStream2( context, &output, &input, ZSTD_e_end );
+            if ( ZSTD_isError(remaining) )
+            {
+                OSG_WARN << "ZstdCompressor::compress(): " << ZSTD_getErrorName(remaining) << std::endl;
+                ZSTD_freeCCtx( context );
+                return false;
+            }
+            fout.write( &out[0], output.pos );
+        } while ( remaining!=0 );
+
+        ZSTD_freeCCtx( context );
+        return !fout.fail();
+    }
+
+    virtual bool decompress( std::istream& fin, std::string& target, const Options* options )
+    {
+        ZSTD_DCtx* context = ZSTD_createDCtx();
+        if ( !context ) return false;
+
+        ZSTD_DDict* dictionary = getDecompressionDictionary( options );
+        if ( dictionary ) ZSTD_DCtx_refDDict( context, dictionary );
+
+        std::vector<char> in( ZSTD_DStreamInSize() ), out( ZSTD_DStreamOutSize() );
+        size_t ret = 1;
+        while ( ret!=0 )
+        {
+            fin.read( &in[0], in.size() );
+            size_t available = fin.gcount();
+            if ( available==0 ) break;
+
+            // keep calling while the output buffer fills up, as data may remain buffered in the context
+            ZSTD_inBuffer input = { &in[0], available, 0 };
+            bool outputFull = true;
+            while ( ret!=0 && (input.pos<input.size || outputFull) )
+            {
+                ZSTD_outBuffer output = { &out[0], out.size(), 0 };
+                ret = ZSTD_decompressStream( context, &output, &input );
+                if ( ZSTD_isError(ret) )
+                {
+                    OSG_WARN << "ZstdCompressor::decompress(): " << ZSTD_getErrorName(ret) << std::endl;
+                    ZSTD_freeDCtx( context );
+                    return false;
+                }
+                target.append( &out[0], output.pos );
+                outputFull = (output.pos==output.size);
+            }
+        }
+
+        ZSTD_freeDCtx( context );
+        return ret==0;
+    }
+
+protected:
+    typedef std::map< std::pair<std::string, int>, ZSTD_CDict* > CompressionDictionaryMap;
+    typedef std::map< std::string, ZSTD_DDict* > DecompressionDictionaryMap;
+
+    virtual ~ZstdCompressor()
+    {
+        for ( CompressionDictionaryMap::iterator itr=_compressionDictionaries.begin(); itr!=_compressionDictionaries.end(); ++itr )
+            ZSTD_freeCDict( itr->second );
+        for ( DecompressionDictionaryMap::iterator itr=_decompressionDictionaries.begin(); itr!=_decompressionDictionaries.end(); ++itr )
+            ZSTD_freeDDict( itr->second );
+    }
+
+    static bool loadDictionary( const std::string& name, const Options* options, std::string& data )
+    {
+        std::string fileName = findDataFile( name, options );
+        std::ifstream fin( fileName.c_str(), std::ios::in|std::ios::binary );
+        data.assign( std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>() );
+        if ( data.empty() )
+        {
+            OSG_WARN << "ZstdCompressor: Failed to load dictionary " << name << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Return the digested dictionary named by the CompressionDictionary option, loading it on first use.
+    // Compression dictionaries are kept per level as the level is baked into them.
+    ZSTD_CDict* getCompressionDictionary( const Options* options, int level )
+    {
+        const std::string name = options ? options->getPluginStringData("CompressionDictionary") : std::string();
+        if ( name.empty() ) return 0;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _dictionaryMutex );
+        CompressionDictionaryMap::iterator itr = _compressionDictionaries.find( std::make_pair(name, level) );
+        if ( itr!=_compressionDictionaries.end() ) return itr->second;
+
+        std::string data;
+        ZSTD_CDict* dictionary = loadDictionary(name, options, data) ? ZSTD_createCDict(data.data(), data.size(), level) : 0;
+        _compressionDictionaries[std::make_pair(name, level)] = dictionary;
+        return dictionary;
+    }
+
+    ZSTD_DDict* getDecompressionDictionary( const Options* options )
+    {
+        const std::string name = options ? options->getPluginStringData("CompressionDictionary") : std::string();
+        if ( name.empty() ) return 0;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _dictionaryMutex );
+        DecompressionDictionaryMap::iterator itr = _decompressionDictionaries.find( name );
+        if ( itr!=_decompressionDictionaries.end() ) return itr->second;
+
+        std::string data;
+        ZSTD_DDict* dictionary = loadDictionary(name, options, data) ? ZSTD_createDDict(data.data(), data.size()) : 0;
+        _decompressionDictionaries[name] = dictionary;
+        return dictionary;
+    }
+
+    OpenThreads::Mutex          _dictionaryMutex;
+    CompressionDictionaryMap    _compressionDictionaries;
+    DecompressionDictionaryMap  _decompressionDictionaries;
+};
+
+REGISTER_COMPRESSOR( "zstd", ZstdCompressor )
+
+#endif
@@ -0,0 +1,727 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgDB/DXTCImageProcessor>
+#include <osg/Notify>
+
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
+
+#include <algorithm>
+#include <vector>
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+
+using namespace osgDB;
+
+namespace
+{
+
+// 4x4 block of RGBA pixels, each component in the 0..255 range, stored row by row.
+struct Block
+{
+    int r[16];
+    int g[16];
+    int b[16];
+    int a[16];
+};
+
+struct LevelJob
+{
+    const unsigned char*                    source;
+    unsigned int                            sourceRowStep;
+    unsigned int                            numComponents;
+    bool                                    bgrOrder;
+    int                                     width;
+    int                                     height;
+    GLenum                                  format;
+    ImageProcessor::CompressionQuality      quality;
+    unsigned char*                          destination;
+    unsigned int                            blockSize;
+};
+
+inline int clampComponent(float v)
+{
+    int i = static_cast<int>(v+0.5f);
+    return i<0 ? 0 : (i>255 ? 255 : i);
+}
+
+inline unsigned short packRGB565(int r, int g, int b)
+{
+    return static_cast<unsigned short>(((r*31+127)/255)<<11 | ((g*63+127)/255)<<5 | ((b*31+127)/255));
+}
+
+inline void unpackRGB565(unsigned short c, int& r, int& g, int& b)
+{
+    int r5 = (c>>11)&31;
+    int g6 = (c>>5)&63;
+    int b5 = c&31;
+    r = (r5<<3)|(r5>>2);
+    g = (g6<<2)|(g6>>4);
+    b = (b5<<3)|(b5>>2);
+}
+
+void fetchBlock(const LevelJob& job, int bx, int by, Block& block)
+{
+    for(int y=0; y<4; ++y)
+    {
+        // replicate the edge pixels for blocks that straddle the image border
+        int sy = osg::minimum(by*4+y, job.height-1);
+        const unsigned char* row = job.source + sy*job.sourceRowStep;
+        for(int x=0; x<4; ++x)
+        {
+            int sx = osg::minimum(bx*4+x, job.width-1);
+            const unsigned char* pixel = row + sx*job.numComponents;
+            int i = y*4+x;
+            switch(job.numComponents)
+            {
+                case 1:
+                    block.r[i] = block.g[i] = block.b[i] = pixel[0];
+                    block.a[i] = 255;
+                    break;
+                case 2:
+                    block.r[i] = block.g[i] = block.b[i] = pixel[0];
+                    block.a[i] = pixel[1];
+                    break;
+                default:
+                    block.r[i] = job.bgrOrder ? pixel[2] : pixel[0];
+                    block.g[i] = pixel[1];
+                    block.b[i] = job.bgrOrder ? pixel[0] : pixel[2];
+                    block.a[i] = (job.numComponents==4) ? pixel[3] : 255;
+                    break;
+            }
+        }
+    }
+}
+
+// Select the palette entry nearest to each used pixel, returning the accumulated squared error.
+int selectColourIndices(const Block& block, const bool* used, const int palette[4][3], int numColours, int* indices)
+{
+    int error = 0;
+    for(int i=0; i<16; ++i)
+    {
+        if (!used[i]) continue;
+
+        int bestIndex = 0;
+        int bestError = 0x7fffffff;
+        for(int p=0; p<numColours; ++p)
+        {
+            int dr = block.r[i]-palette[p][0];
+            int dg = block.g[i]-palette[p][1];
+            int db = block.b[i]-palette[p][2];
+            int e = dr*dr + dg*dg + db*db;
+            if (e<bestError) { bestError = e; bestIndex = p; }
+        }
+        indices[i] = bestIndex;
+        error += bestError;
+    }
+    return error;
+}
+
+void computePalette(unsigned short c0, unsigned short c1, bool fourColourMode, int palette[4][3])
+{
+    unpackRGB565(c0, palette[0][0], palette[0][1], palette[0][2]);
+    unpackRGB565(c1, palette[1][0], palette[1][1], palette[1][2]);
+    for(int c=0; c<3; ++c)
+    {
+        if (fourColourMode)
+        {
+            palette[2][c] = (2*palette[0][c]+palette[1][c])/3;
+            palette[3][c] = (palette[0][c]+2*palette[1][c])/3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c]+palette[1][c])/2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+// Compute the initial end points of the used pixels, either from the bounding box of the
+// colours or from the extent of the colours along their principal axis.
+void fitEndPoints(const Block& block, const bool* used, bool principalAxis, float* start, float* end)
+{
+    float minC[3] = { 255.0f, 255.0f, 255.0f };
+    float maxC[3] = { 0.0f, 0.0f, 0.0f };
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    int count = 0;
+    for(int i=0; i<16; ++i)
+    {
+        if (!used[i]) continue;
+        float c[3] = { float(block.r[i]), float(block.g[i]), float(block.b[i]) };
+        for(int k=0; k<3; ++k)
+        {
+            minC[k] = osg::minimum(minC[k], c[k]);
+            maxC[k] = osg::maximum(maxC[k], c[k]);
+            mean[k] += c[k];
+        }
+        ++count;
+    }
+
+    if (principalAxis && count>1)
+    {
+        for(int k=0; k<3; ++k) mean[k] /= float(count);
+
+        float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        for(int i=0; i<16; ++i)
+        {
+            if (!used[i]) continue;
+            float dr = float(block.r[i])-mean[0];
+            float dg = float(block.g[i])-mean[1];
+            float db = float(block.b[i])-mean[2];
+            cov[0] += dr*dr; cov[1] += dr*dg; cov[2] += dr*db;
+            cov[3] += dg*dg; cov[4] += dg*db; cov[5] += db*db;
+        }
+
+        // power iteration to find the dominant eigen vector of the covariance matrix
+        float axis[3] = { maxC[0]-minC[0], maxC[1]-minC[1], maxC[2]-minC[2] };
+        for(int iteration=0; iteration<8; ++iteration)
+        {
+            float x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+            float y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+            float z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+            float length = osg::maximum(fabsf(x), osg::maximum(fabsf(y), fabsf(z)));
+            if (length==0.0f) break;
+            axis[0] = x/length; axis[1] = y/length; axis[2] = z/length;
+        }
+
+        float length2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+        if (length2>0.0f)
+        {
+            float minT = 1e30f, maxT = -1e30f;
+            for(int i=0; i<16; ++i)
+            {
+                if (!used[i]) continue;
+                float t = ((float(block.r[i])-mean[0])*axis[0] +
+                           (float(block.g[i])-mean[1])*axis[1] +
+                           (float(block.b[i])-mean[2])*axis[2])/length2;
+                minT = osg::minimum(minT, t);
+                maxT = osg::maximum(maxT, t);
+            }
+            for(int k=0; k<3; ++k)
+            {
+                minC[k] = mean[k] + axis[k]*minT;
+                maxC[k] = mean[k] + axis[k]*maxT;
+            }
+        }
+    }
+
+    // inset the end points slightly to reduce the error of the interpolated colours
+    for(int k=0; k<3; ++k)
+    {
+        float inset = (maxC[k]-minC[k])/16.0f;
+        end[k] = minC[k]+inset;
+        start[k] = maxC[k]-inset;
+    }
+}
+
+// Least squares fit of the end points to the pixels given the current index selection.
+bool refineEndPoints(const Block& block, const bool* used, const int* indices, bool fourColourMode, float* start, float* end)
+{
+    static const float s_weights4[4] = { 1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f };
+    static const float s_weights3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+    const float* weights = fourColourMode ? s_weights4 : s_weights3;
+
+    float alpha2 = 0.0f, beta2 = 0.0f, alphaBeta = 0.0f;
+    float alphaX[3] = { 0.0f, 0.0f, 0.0f };
+    float betaX[3] = { 0.0f, 0.0f, 0.0f };
+    for(int i=0; i<16; ++i)
+    {
+        if (!used[i]) continue;
+        float alpha = weights[indices[i]];
+        float beta = 1.0f-alpha;
+        float c[3] = { float(block.r[i]), float(block.g[i]), float(block.b[i]) };
+        alpha2 += alpha*alpha;
+        beta2 += beta*beta;
+        alphaBeta += alpha*beta;
+        for(int k=0; k<3; ++k)
+        {
+            alphaX[k] += alpha*c[k];
+            betaX[k] += beta*c[k];
+        }
+    }
+
+    float denominator = alpha2*beta2 - alphaBeta*alphaBeta;
+    if (fabsf(denominator)<1e-6f) return false;
+
+    for(int k=0; k<3; ++k)
+    {
+        start[k] = (alphaX[k]*beta2 - betaX[k]*alphaBeta)/denominator;
+        end[k] = (betaX[k]*alpha2 - alphaX[k]*alphaBeta)/denominator;
+    }
+    return true;
+}
+
+struct ColourBlockResult
+{
+    unsigned short  c0;
+    unsigned short  c1;
+    int             indices[16];
+    int             error;
+};
+
+void quantizeAndSelect(const Block& block, const bool* used, const float* start, const float* end, bool fourColourMode, ColourBlockResult& result)
+{
+    unsigned short c0 = packRGB565(clampComponent(start[0]), clampComponent(start[1]), clampComponent(start[2]));
+    unsigned short c1 = packRGB565(clampComponent(end[0]), clampComponent(end[1]), clampComponent(end[2]));
+
+    // the relative order of the end points selects between the four and three colour modes
+    if (fourColourMode ? (c0<c1) : (c0>c1)) std::swap(c0, c1);
+
+    result.c0 = c0;
+    result.c1 = c1;
+
+    for(int i=0; i<16; ++i) result.indices[i] = 0;
+
+    if (fourColourMode && c0==c1)
+    {
+        // degenerate block, decodes in three colour mode so only use the first entry
+        int palette[4][3];
+        computePalette(c0, c1, false, palette);
+        result.error = selectColourIndices(block, used, palette, 1, result.indices);
+        return;
+    }
+
+    int palette[4][3];
+    computePalette(c0, c1, fourColourMode, palette);
+    result.error = selectColourIndices(block, used, palette, fourColourMode ? 4 : 3, result.indices);
+}
+
+void encodeColourBlock(const Block& block, bool allowTransparency, ImageProcessor::CompressionQuality quality, unsigned char* output)
+{
+    bool used[16];
+    bool hasTransparent = false;
+    for(int i=0; i<16; ++i)
+    {
+        used[i] = !allowTransparency || block.a[i]>=128;
+        if (!used[i]) hasTransparent = true;
+    }
+
+    bool fourColourMode = !hasTransparent;
+
+    ColourBlockResult best;
+    if (hasTransparent && std::find(used, used+16, true)==used+16)
+    {
+        // fully transparent block
+        best.c0 = best.c1 = 0;
+        best.error = 0;
+        for(int i=0; i<16; ++i) best.indices[i] = 3;
+    }
+    else
+    {
+        float start[3], end[3];
+        fitEndPoints(block, used, quality!=ImageProcessor::FASTEST, start, end);
+        quantizeAndSelect(block, used, start, end, fourColourMode, best);
+
+        int numRefinements = (quality==ImageProcessor::HIGHEST) ? 3 : ((quality==ImageProcessor::PRODUCTION) ? 1 : 0);
+        for(int iteration=0; iteration<numRefinements && best.error>0; ++iteration)
+        {
+            if (!refineEndPoints(block, used, best.indices, fourColourMode, start, end)) break;
+
+            ColourBlockResult candidate;
+            quantizeAndSelect(block, used, start, end, fourColourMode, candidate);
+            if (candidate.error>=best.error) break;
+            best = candidate;
+        }
+
+        if (hasTransparent)
+        {
+            for(int i=0; i<16; ++i) if (!used[i]) best.indices[i] = 3;
+        }
+    }
+
+    unsigned int bits = 0;
+    for(int i=0; i<16; ++i) bits |= static_cast<unsigned int>(best.indices[i]) << (2*i);
+
+    output[0] = best.c0 & 0xff;
+    output[1] = best.c0 >> 8;
+    output[2] = best.c1 & 0xff;
+    output[3] = best.c1 >> 8;
+    output[4] = bits & 0xff;
+    output[5] = (bits >> 8) & 0xff;
+    output[6] = (bits >> 16) & 0xff;
+    output[7] = (bits >> 24) & 0xff;
+}
+
+void encodeExplicitAlphaBlock(const Block& block, unsigned char* output)
+{
+    for(int i=0; i<8; ++i)
+    {
+        int a0 = (block.a[i*2]*15+127)/255;
+        int a1 = (block.a[i*2+1]*15+127)/255;
+        output[i] = static_cast<unsigned char>(a0 | (a1<<4));
+    }
+}
+
+void encodeInterpolatedAlphaBlock(const Block& block, unsigned char* output)
+{
+    int minA = 255, maxA = 0;
+    for(int i=0; i<16; ++i)
+    {
+        minA = osg::minimum(minA, block.a[i]);
+        maxA = osg::maximum(maxA, block.a[i]);
+    }
+
+    int indices[16];
+    if (minA==maxA)
+    {
+        for(int i=0; i<16; ++i) indices[i] = 0;
+    }
+    else
+    {
+        // eight alpha mode, a0 > a1
+        int palette[8];
+        palette[0] = maxA;
+        palette[1] = minA;
+        for(int p=2; p<8; ++p) palette[p] = ((8-p)*maxA + (p-1)*minA)/7;
+
+        for(int i=0; i<16; ++i)
+        {
+            int bestIndex = 0;
+            int bestError = 256;
+            for(int p=0; p<8; ++p)
+            {
+                int e = abs(block.a[i]-palette[p]);
+                if (e<bestError) { bestError = e; bestIndex = p; }
+            }
+            indices[i] = bestIndex;
+        }
+    }
+
+    output[0] = static_cast<unsigned char>(maxA);
+    output[1] = static_cast<unsigned char>(minA);
+
+    unsigned int bits = 0;
+    int bitCount = 0;
+    unsigned char* ptr = output+2;
+    for(int i=0; i<16; ++i)
+    {
+        bits |= static_cast<unsigned int>(indices[i]) << bitCount;
+        bitCount += 3;
+        while(bitCount>=8)
+        {
+            *ptr++ = static_cast<unsigned char>(bits & 0xff);
+            bits >>= 8;
+            bitCount -= 8;
+        }
+    }
+}
+
+void compressBlockRows(const LevelJob& job, int firstBlockRow, int lastBlockRow)
+{
+    int numBlocksX = (job.width+3)/4;
+    Block block;
+    for(int by=firstBlockRow; by<lastBlockRow; ++by)
+    {
+        unsigned char* output = job.destination + by*numBlocksX*job.blockSize;
+        for(int bx=0; bx<numBlocksX; ++bx)
+        {
+            fetchBlock(job, bx, by, block);
+            switch(job.format)
+            {
+                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                    encodeColourBlock(block, false, job.quality, output);
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+                    encodeColourBlock(block, true, job.quality, output);
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+                    encodeExplicitAlphaBlock(block, output);
+                    encodeColourBlock(block, false, job.quality, output+8);
+                    break;
+                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                    encodeInterpolatedAlphaBlock(block, output);
+                    encodeColourBlock(block, false, job.quality, output+8);
+                    break;
+            }
+            output += job.blockSize;
+        }
+    }
+}
+
+/** Compresses a slice of the block rows of a level on one of the DXTCImageProcessor's threads.*/
+class CompressBlockRowsOperation : public osg::Operation
+{
+    public:
+
+        CompressBlockRowsOperation(const LevelJob& job, int firstBlockRow, int lastBlockRow, osg::RefBlockCount* block):
+            osg::Operation("CompressBlockRowsOperation", false),
+            _job(job),
+            _firstBlockRow(firstBlockRow),
+            _lastBlockRow(lastBlockRow),
+            _block(block) {}
+
+        virtual void operator () (osg::Object*)
+        {
+            compressBlockRows(_job, _firstBlockRow, _lastBlockRow);
+            _block->completed();
+        }
+
+    protected:
+
+        const LevelJob&                     _job;
+        int                                 _firstBlockRow;
+        int                                 _lastBlockRow;
+        osg::ref_ptr<osg::RefBlockCount>    _block;
+};
+
+void compressLevel(const LevelJob& job, unsigned int numThreads, osg::OperationQueue* operationQueue)
+{
+    int numBlockRows = (job.height+3)/4;
+
+    // don't bother spreading small levels across threads.
+    unsigned int maxThreads = static_cast<unsigned int>(osg::maximum(numBlockRows/16, 1));
+    numThreads = osg::minimum(numThreads, maxThreads);
+
+    if (numThreads<=1 || !operationQueue)
+    {
+        compressBlockRows(job, 0, numBlockRows);
+        return;
+    }
+
+    // the calling thread takes the first slice itself.
+    int rowsPerThread = (numBlockRows+numThreads-1)/numThreads;
+    unsigned int numSlices = (numBlockRows+rowsPerThread-1)/rowsPerThread;
+
+    osg::ref_ptr<osg::RefBlockCount> block = new osg::RefBlockCount(numSlices-1);
+    block->reset();
+    for(unsigned int t=1; t<numSlices; ++t)
+    {
+        int first = t*rowsPerThread;
+        int last = osg::minimum(first+rowsPerThread, numBlockRows);
+        operationQueue->add(new CompressBlockRowsOperation(job, first, last, block.get()));
+    }
+
+    compressBlockRows(job, 0, osg::minimum(rowsPerThread, numBlockRows));
+
+    block->block();
+}
+
+}
+
+DXTCImageProcessor::DXTCImageProcessor():
+    _numThreads(0)
+{
+}
+
+DXTCImageProcessor::DXTCImageProcessor(const DXTCImageProcessor& rhs,const osg::CopyOp& copyop):
+    ImageProcessor(rhs, copyop),
+    _numThreads(rhs._numThreads)
+{
+}
+
+osg::OperationQueue* DXTCImageProcessor::getOrCreateOperationQueue(unsigned int numThreads)
+{
+    // the threads are shared by all the levels and images compressed, including those compressed concurrently by other reading threads,
+    // the thread calling compress() working on a slice itself.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_operationThreadsMutex);
+    if (!_operationQueue) _operationQueue = new osg::OperationQueue;
+    while(_operationThreads.size()+1<numThreads)
+    {
+        osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+        thread->setOperationQueue(_operationQueue.get());
+        thread->startThread();
+        _operationThreads.push_back(thread);
+    }
+    return _operationQueue.get();
+}
+
+bool DXTCImageProcessor::isImageCompressible(const osg::Image& image)
+{
+    if (!image.data() || image.isCompressed()) return false;
+    if (image.getDataType()!=GL_UNSIGNED_BYTE) return false;
+    if (image.r()!=1) return false;
+
+    switch(image.getPixelFormat())
+    {
+        case GL_RGB:
+        case GL_RGBA:
+        case GL_BGR:
+        case GL_BGRA:
+        case GL_LUMINANCE:
+        case GL_LUMINANCE_ALPHA:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void DXTCImageProcessor::compress(osg::Image& image, osg::Texture::InternalFormatMode compressedFormat, bool generateMipMap, bool resizeToPowerOfTwo, CompressionMethod method, CompressionQuality quality)
+{
+    if (!isImageCompressible(image))
+    {
+        OSG_NOTICE<<"DXTCImageProcessor::compress() cannot compress image "<<image.getFileName()<<", unsupported pixel format or data type."<<std::endl;
+        return;
+    }
+
+    GLenum format = 0;
+    switch(compressedFormat)
+    {
+        case osg::Texture::USE_S3TC_DXT1_COMPRESSION:
+        case osg::Texture::USE_S3TC_DXT1c_COMPRESSION:
+            format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            break;
+        case osg::Texture::USE_S3TC_DXT1a_COMPRESSION:
+            format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            break;
+        case osg::Texture::USE_S3TC_DXT3_COMPRESSION:
+            format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+            break;
+        case osg::Texture::USE_S3TC_DXT5_COMPRESSION:
+            format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            break;
+        case osg::Texture::USE_IMAGE_DATA_FORMAT:
+        case osg::Texture::USE_ARB_COMPRESSION:
+            format = image.isImageTranslucent() ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            break;
+        default:
+            OSG_NOTICE<<"DXTCImageProcessor::compress() only supports S3TC compression formats."<<std::endl;
+            return;
+    }
+
+    if (generateMipMap && !image.isMipmap())
+    {
+        this->generateMipMap(image, resizeToPowerOfTwo, method);
+    }
+    else if (resizeToPowerOfTwo)
+    {
+        int s = osg::Image::computeNearestPowerOfTwo(image.s());
+        int t = osg::Image::computeNearestPowerOfTwo(image.t());
+        if (s!=image.s() || t!=image.t()) image.scaleImage(s, t, 1);
+    }
+
+    unsigned int blockSize = (format==GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format==GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
+    unsigned int numLevels = image.getNumMipmapLevels();
+
+    // compute the size and offset of each compressed mipmap level.
+    osg::Image::MipmapDataType mipmapOffsets;
+    unsigned int totalSize = 0;
+    int width = image.s();
+    int height = image.t();
+    for(unsigned int level=0; level<numLevels; ++level)
+    {
+        if (level>0) mipmapOffsets.push_back(totalSize);
+        totalSize += ((width+3)/4)*((height+3)/4)*blockSize;
+        width = osg::maximum(width>>1, 1);
+        height = osg::maximum(height>>1, 1);
+    }
+
+    unsigned char* data = new unsigned char[totalSize];
+
+    unsigned int numThreads = _numThreads>0 ? _numThreads : static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1));
+    osg::OperationQueue* operationQueue = numThreads>1 ? getOrCreateOperationQueue(numThreads) : 0;
+
+    LevelJob job;
+    job.numComponents = osg::Image::computeNumComponents(image.getPixelFormat());
+    job.bgrOrder = (image.getPixelFormat()==GL_BGR || image.getPixelFormat()==GL_BGRA);
+    job.format = format;
+    job.quality = quality;
+    job.blockSize = blockSize;
+
+    width = image.s();
+    height = image.t();
+    for(unsigned int level=0; level<numLevels; ++level)
+    {
+        job.source = image.getMipmapData(level);
+        job.sourceRowStep = (level==0) ? image.getRowStepInBytes() : osg::Image::computeRowWidthInBytes(width, image.getPixelFormat(), image.getDataType(), image.getPacking());
+        job.width = width;
+        job.height = height;
+        job.destination = data + (level==0 ? 0 : mipmapOffsets[level-1]);
+
+        compressLevel(job, numThreads, operationQueue);
+
+        width = osg::maximum(width>>1, 1);
+        height = osg::maximum(height>>1, 1);
+    }
+
+    image.setImage(image.s(), image.t(), 1, format, format, GL_UNSIGNED_BYTE, data, osg::Image::USE_NEW_DELETE);
+    image.setMipmapLevels(mipmapOffsets);
+}
+
+void DXTCImageProcessor::generateMipMap(osg::Image& image, bool resizeToPowerOfTwo, CompressionMethod /*method*/)
+{
+    if (!isImageCompressible(image))
+    {
+        OSG_NOTICE<<"DXTCImageProcessor::generateMipMap() cannot process image "<<image.getFileName()<<", unsupported pixel format or data type."<<std::endl;
+        return;
+    }
+
+    if (resizeToPowerOfTwo)
+    {
+        int s = osg::Image::computeNearestPowerOfTwo(image.s());
+        int t = osg::Image::computeNearestPowerOfTwo(image.t());
+        if (s!=image.s() || t!=image.t()) image.scaleImage(s, t, 1);
+    }
+
+    unsigned int numComponents = osg::Image::computeNumComponents(image.getPixelFormat());
+    unsigned int numLevels = osg::Image::computeNumberOfMipmapLevels(image.s(), image.t());
+
+    osg::Image::MipmapDataType mipmapOffsets;
+    unsigned int totalSize = 0;
+    int width = image.s();
+    int height = image.t();
+    for(unsigned int level=0; level<numLevels; ++level)
+    {
+        if (level>0) mipmapOffsets.push_back(totalSize);
+        totalSize += width*height*numComponents;
+        width = osg::maximum(width>>1, 1);
+        height = osg::maximum(height>>1, 1);
+    }
+
+    unsigned char* data = new unsigned char[totalSize];
+
+    // copy the base level, removing any row padding.
+    unsigned int rowSize = image.s()*numComponents;
+    for(int row=0; row<image.t(); ++row)
+    {
+        memcpy(data + row*rowSize, image.data(0, row), rowSize);
+    }
+
+    // box filter each level from the one above.
+    width = image.s();
+    height = image.t();
+    const unsigned char* source = data;
+    for(unsigned int level=1; level<numLevels; ++level)
+    {
+        int newWidth = osg::maximum(width>>1, 1);
+        int newHeight = osg::maximum(height>>1, 1);
+        unsigned char* destination = data + mipmapOffsets[level-1];
+
+        for(int y=0; y<newHeight; ++y)
+        {
+            int y0 = osg::minimum(y*2, height-1);
+            int y1 = osg::minimum(y*2+1, height-1);
+            for(int x=0; x<newWidth; ++x)
+            {
+                int x0 = osg::minimum(x*2, width-1);
+                int x1 = osg::minimum(x*2+1, width-1);
+                for(unsigned int c=0; c<numComponents; ++c)
+                {
+                    unsigned int sum = source[(y0*width+x0)*numComponents+c] +
+                                       source[(y0*width+x1)*numComponents+c] +
+                                       source[(y1*width+x0)*numComponents+c] +
+                                       source[(y1*width+x1)*numComponents+c];
+                    destination[(y*newWidth+x)*numComponents+c] = static_cast<unsigned char>((sum+2)/4);
+                }
+            }
+        }
+
+        source = destination;
+        width = newWidth;
+        height = newHeight;
+    }
+
+    image.setImage(image.s(), image.t(), 1, image.getInternalTextureFormat(), image.getPixelFormat(), image.getDataType(), data, osg::Image::USE_NEW_DELETE, 1);
+    image.setMipmapLevels(mipmapOffsets);
+}
@@ -905,6 +905,14 @@ void DatabasePager::DatabaseThread::run()
             //osg::Timer_t before = osg::Timer::instance()->tick();
 
 
+            // when several pager threads request the same remote file only one fetches it, the others wait and then read it from the file cache.
+            bool fetching = false;
+            if (!readFromFileCache && fileCache.valid() && fileCache->isFileAppropriateForFileCache(fileName))
+            {
+                fetching = fileCache->beginFetch(fileName);
+                if (!fetching && fileCache->existsInCache(fileName)) readFromFileCache = true;
+            }
+
             // assume that readNode is thread safe...
             ReaderWriter::ReadResult rr = readFromFileCache ?
                         fileCache->readNode(fileName, dr_loadOptions.get(), false) :
@@ -922,6 +930,8 @@ void DatabasePager::DatabaseThread::run()
                 fileCache->writeNode(*(loadedModel), fileName, dr_loadOptions.get());
             }
 
+            if (fetching) fileCache->endFetch(fileName);
+
             {
                 OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
                 if ((_pager->_frameNumber-databaseRequest->_frameNumberLastRequest)>1)
@@ -16,16 +16,77 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
+#include <osgDB/fstream>
+
+#include <OpenThreads/Atomic>
+#include <OpenThreads/ScopedLock>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+    #include <process.h>
+    #define getpid _getpid
+#else
+    #include <unistd.h>
+#endif
 
 using namespace osgDB;
 
+static const char* s_tempFileMarker = "~fctmp";
+
+// the files written by the cache are listed in this file, so that files placed in the cache directory by others are never evicted.
+static const char* s_indexFileName = "filecache.index";
+
+static OpenThreads::Atomic s_tempFileCount;
+
+static bool getFileSizeAndTime(const std::string& fileName, unsigned long long& size, time_t& modificationTime)
+{
+    struct stat fileStat;
+    if (::stat(fileName.c_str(), &fileStat)!=0) return false;
+
+    size = static_cast<unsigned long long>(fileStat.st_size);
+    modificationTime = fileStat.st_mtime;
+    return true;
+}
+
+static std::string hashFileName(const std::string& fileName)
+{
+    // 64 bit FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+    for(std::string::const_iterator itr = fileName.begin(); itr != fileName.end(); ++itr)
+    {
+        hash ^= static_cast<unsigned char>(*itr);
+        hash *= 1099511628211ULL;
+    }
+
+    static const char* digits = "0123456789abcdef";
+    std::string str(16, '0');
+    for(int i=15; i>=0; --i)
+    {
+        str[i] = digits[hash & 0xf];
+        hash >>= 4;
+    }
+    return str;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 //
 // FileCache
 //
 FileCache::FileCache(const std::string& path):
     osg::Referenced(true),
-    _fileCachePath(path)
+    _fileCachePath(path),
+    _useHashedFileNames(false),
+    _compressCachedFiles(false),
+    _cacheCompressor("zlib"),
+    _maximumCacheSize(0),
+    _indexValid(false),
+    _cacheSize(0)
 {
     OSG_INFO<<"Constructed FileCache : "<<path<<std::endl;
 }
@@ -42,10 +103,27 @@ bool FileCache::isFileAppropriateForFileCache(const std::string& originalFileNam
 
 std::string FileCache::createCacheFileName(const std::string& originalFileName) const
 {
-    std::string serverAddress = osgDB::getServerAddress(originalFileName);
-    std::string cacheFileName = _fileCachePath + "/" +
-                                serverAddress + (serverAddress.empty()?"":"/") +
-                                osgDB::getServerFileName(originalFileName);
+    std::string cacheFileName;
+    if (_useHashedFileNames)
+    {
+        std::string hash = hashFileName(originalFileName);
+        std::string ext = osgDB::getFileExtension(osgDB::getServerFileName(originalFileName));
+        cacheFileName = _fileCachePath + "/" + hash.substr(0,2) + "/" + hash + (ext.empty() ? "" : ".") + ext;
+    }
+    else
+    {
+        std::string serverAddress = osgDB::getServerAddress(originalFileName);
+        std::string serverFileName = osgDB::getServerFileName(originalFileName);
+
+        // local files are cached by their path relative to the root, with any drive letter as the first directory.
+        std::string::size_type start = serverFileName.find_first_not_of("/\\");
+        serverFileName = (start==std::string::npos) ? std::string() : serverFileName.substr(start);
+        if (serverFileName.size()>1 && serverFileName[1]==':') serverFileName.erase(1, 1);
+
+        cacheFileName = _fileCachePath + "/" +
+                        serverAddress + (serverAddress.empty()?"":"/") +
+                        serverFileName;
+    }
 
     OSG_DEBUG<<"FileCache::createCacheFileName("<<originalFileName<<") = "<<cacheFileName<<std::endl;
 
@@ -61,16 +139,308 @@ bool FileCache::existsInCache(const std::string& originalFileName) const
     return false;
 }
 
+void FileCache::setMaximumCacheSize(unsigned long long size)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    _maximumCacheSize = size;
+}
+
+unsigned long long FileCache::getCacheSize() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    return _cacheSize;
+}
+
+void FileCache::trimCache() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    if (_maximumCacheSize==0) return;
+
+    updateIndex();
+    evict();
+}
+
+bool FileCache::beginFetch(const std::string& originalFileName) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_fetchMutex);
+
+    bool waited = false;
+    while(_fetchesInProgress.count(originalFileName)!=0)
+    {
+        waited = true;
+        _fetchCondition.wait(&_fetchMutex);
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> indexLock(_indexMutex);
+    if (waited)
+    {
+        ++_statistics.numSharedFetches;
+        return false;
+    }
+
+    // the caller fetches the file because the cache doesn't hold it.
+    ++_statistics.numMisses;
+
+    _fetchesInProgress.insert(originalFileName);
+    return true;
+}
+
+void FileCache::endFetch(const std::string& originalFileName) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_fetchMutex);
+    _fetchesInProgress.erase(originalFileName);
+    _fetchCondition.broadcast();
+}
+
+FileCache::Statistics FileCache::getStatistics() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    return _statistics;
+}
+
+void FileCache::resetStatistics()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    _statistics = Statistics();
+}
+
+void FileCache::reportStatistics(std::ostream& out) const
+{
+    Statistics statistics = getStatistics();
+    unsigned int numReads = statistics.numHits + statistics.numMisses;
+
+    out<<"FileCache "<<_fileCachePath<<std::endl;
+    out<<"    hits "<<statistics.numHits<<", misses "<<statistics.numMisses;
+    if (numReads>0) out<<" ("<<(100.0*double(statistics.numHits)/double(numReads))<<"% hit rate)";
+    out<<std::endl;
+    out<<"    writes "<<statistics.numWrites<<", "<<statistics.bytesWritten<<" bytes"<<std::endl;
+    out<<"    evictions "<<statistics.numEvictions<<", "<<statistics.bytesEvicted<<" bytes"<<std::endl;
+    out<<"    fetches shared with another thread "<<statistics.numSharedFetches<<std::endl;
+    if (_maximumCacheSize>0)
+    {
+        out<<"    cache size "<<getCacheSize()<<" of "<<_maximumCacheSize<<" bytes"<<std::endl;
+    }
+}
+
+void FileCache::recordRead(const std::string& cacheFileName, bool hit) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+    if (!hit)
+    {
+        ++_statistics.numMisses;
+        return;
+    }
+
+    ++_statistics.numHits;
+
+    if (_maximumCacheSize==0) return;
+
+    updateIndex();
+
+    // move the file to the most recently used end of the list
+    CacheEntryMap::iterator itr = _cacheEntries.find(cacheFileName);
+    if (itr!=_cacheEntries.end())
+    {
+        _lruList.splice(_lruList.end(), _lruList, itr->second.position);
+    }
+}
+
+std::string FileCache::getIndexFileName() const
+{
+    return _fileCachePath + "/" + s_indexFileName;
+}
+
+void FileCache::updateIndex() const
+{
+    if (_indexValid) return;
+    _indexValid = true;
+
+    // gather the files previously written by the cache, ordered by modification time so the oldest are evicted first
+    typedef std::vector< std::pair<time_t, std::string> > FileTimes;
+    FileTimes fileTimes;
+
+    std::string indexFileName = getIndexFileName();
+    osgDB::ifstream fin(indexFileName.c_str());
+    std::string line;
+    while(std::getline(fin, line))
+    {
+        std::string fileName = _fileCachePath + "/" + line;
+        if (line.empty() || _cacheEntries.count(fileName)!=0) continue;
+
+        unsigned long long size = 0;
+        time_t modificationTime = 0;
+        if (osgDB::fileType(fileName)==osgDB::REGULAR_FILE && getFileSizeAndTime(fileName, size, modificationTime))
+        {
+            CacheEntry& entry = _cacheEntries[fileName];
+            entry.size = size;
+            _cacheSize += size;
+            fileTimes.push_back(FileTimes::value_type(modificationTime, fileName));
+        }
+    }
+    fin.close();
+
+    std::sort(fileTimes.begin(), fileTimes.end());
+    for(FileTimes::iterator itr = fileTimes.begin(); itr != fileTimes.end(); ++itr)
+    {
+        _cacheEntries[itr->second].position = _lruList.insert(_lruList.end(), itr->second);
+    }
+
+    // rewrite the index without the files that have since been removed or listed more than once.
+    osgDB::ofstream fout(indexFileName.c_str(), std::ios::out | std::ios::trunc);
+    for(LRUList::iterator itr = _lruList.begin(); itr != _lruList.end(); ++itr)
+    {
+        fout<<itr->substr(_fileCachePath.size()+1)<<std::endl;
+    }
+
+    OSG_INFO<<"FileCache::updateIndex() found "<<_cacheEntries.size()<<" files, "<<_cacheSize<<" bytes in "<<_fileCachePath<<std::endl;
+}
+
+void FileCache::recordWrite(const std::string& cacheFileName) const
+{
+    // cache files are always named within the cache path, any others aren't ours to evict.
+    if (cacheFileName.size()<=_fileCachePath.size()+1 || cacheFileName.compare(0, _fileCachePath.size(), _fileCachePath)!=0) return;
+
+    osgDB::ofstream fout(getIndexFileName().c_str(), std::ios::out | std::ios::app);
+    fout<<cacheFileName.substr(_fileCachePath.size()+1)<<std::endl;
+}
+
+void FileCache::evict() const
+{
+    // always keep the most recently used file, even if on its own it exceeds the maximum size
+    while(_cacheSize>_maximumCacheSize && _lruList.size()>1)
+    {
+        std::string fileName = _lruList.front();
+        _lruList.pop_front();
+
+        CacheEntryMap::iterator itr = _cacheEntries.find(fileName);
+        if (itr!=_cacheEntries.end())
+        {
+            _cacheSize -= itr->second.size;
+            _statistics.bytesEvicted += itr->second.size;
+            _cacheEntries.erase(itr);
+        }
+
+        if (::remove(fileName.c_str())!=0 && osgDB::fileExists(fileName))
+        {
+            OSG_INFO<<"FileCache::evict() could not remove "<<fileName<<std::endl;
+        }
+        else
+        {
+            OSG_DEBUG<<"FileCache::evict() removed "<<fileName<<std::endl;
+        }
+
+        ++_statistics.numEvictions;
+    }
+}
+
+bool FileCache::prepareCacheFile(const std::string& cacheFileName, std::string& tempFileName) const
+{
+    std::string path = osgDB::getFilePath(cacheFileName);
+    if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
+    {
+        OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
+        return false;
+    }
+
+    // write to a temporary file in the same directory, keeping the extension so the same ReaderWriter is selected,
+    // then rename it into place so that readers never see a partially written file.
+    std::ostringstream str;
+    str<<osgDB::getNameLessExtension(cacheFileName)<<s_tempFileMarker<<getpid()<<"_"<<(++s_tempFileCount);
+
+    std::string ext = osgDB::getFileExtension(cacheFileName);
+    if (!ext.empty()) str<<"."<<ext;
+
+    tempFileName = str.str();
+    return true;
+}
+
+ReaderWriter::WriteResult FileCache::publishCacheFile(const ReaderWriter::WriteResult& result, const std::string& originalFileName, const std::string& tempFileName, const std::string& cacheFileName) const
+{
+    if (!result.success())
+    {
+        ::remove(tempFileName.c_str());
+        return result;
+    }
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+    // rename doesn't replace an existing file on Windows
+    ::remove(cacheFileName.c_str());
+#endif
+
+    if (::rename(tempFileName.c_str(), cacheFileName.c_str())!=0)
+    {
+        OSG_NOTICE<<"FileCache: could not rename "<<tempFileName<<" to "<<cacheFileName<<std::endl;
+        ::remove(tempFileName.c_str());
+        return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
+    }
+
+    unsigned long long size = 0;
+    time_t modificationTime = 0;
+    getFileSizeAndTime(cacheFileName, size, modificationTime);
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+
+        ++_statistics.numWrites;
+        _statistics.bytesWritten += size;
+
+        if (_maximumCacheSize>0) updateIndex();
+
+        // record every write, even when the cache is unbounded, so a later size limit can evict the file.
+        if (_cacheEntries.count(cacheFileName)==0) recordWrite(cacheFileName);
+
+        if (_maximumCacheSize>0)
+        {
+            CacheEntryMap::iterator itr = _cacheEntries.find(cacheFileName);
+            if (itr!=_cacheEntries.end())
+            {
+                _cacheSize -= itr->second.size;
+                _lruList.erase(itr->second.position);
+            }
+
+            CacheEntry& entry = _cacheEntries[cacheFileName];
+            entry.size = size;
+            entry.position = _lruList.insert(_lruList.end(), cacheFileName);
+            _cacheSize += size;
+
+            evict();
+        }
+    }
+
+    removeFileFromBlackListed(originalFileName);
+
+    return result;
+}
+
+const Options* FileCache::getWriteOptions(const Options* options, osg::ref_ptr<Options>& writeOptions) const
+{
+    if (!_compressCachedFiles) return options;
+
+    writeOptions = options ? options->cloneOptions() : new Options;
+
+    std::string optionString = writeOptions->getOptionString();
+    if (optionString.find("Compressor")==std::string::npos)
+    {
+        std::string compressorOption = std::string("Compressor=") + _cacheCompressor;
+        writeOptions->setOptionString(optionString.empty() ? compressorOption : optionString + " " + compressorOption);
+    }
+
+    return writeOptions.get();
+}
+
 ReaderWriter::ReadResult FileCache::readObject(const std::string& originalFileName, const osgDB::Options* options) const
 {
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
     {
         OSG_INFO<<"FileCache::readObjectFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readObject(cacheFileName, options);
+        ReaderWriter::ReadResult result = osgDB::Registry::instance()->readObject(cacheFileName, options);
+        recordRead(cacheFileName, result.success());
+        return result;
     }
     else
     {
+        recordRead(cacheFileName, false);
         return 0;
     }
 }
@@ -80,21 +450,13 @@ ReaderWriter::WriteResult FileCache::writeObject(const osg::Object& object, cons
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
-        std::string path = osgDB::getFilePath(cacheFileName);
-
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+        std::string tempFileName;
+        if (!prepareCacheFile(cacheFileName, tempFileName)) return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
 
+        osg::ref_ptr<Options> writeOptions;
         OSG_INFO<<"FileCache::writeObjectToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeObject(object, cacheFileName, options);
-        if (result.success())
-        {
-            removeFileFromBlackListed(originalFileName);
-        }
-        return result;
+        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeObject(object, tempFileName, getWriteOptions(options, writeOptions));
+        return publishCacheFile(result, originalFileName, tempFileName, cacheFileName);
     }
     return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
 }
@@ -105,10 +467,13 @@ ReaderWriter::ReadResult FileCache::readImage(const std::string& originalFileNam
     if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
     {
         OSG_INFO<<"FileCache::readImageFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readImage(cacheFileName, options);
+        ReaderWriter::ReadResult result = osgDB::Registry::instance()->readImage(cacheFileName, options);
+        recordRead(cacheFileName, result.success());
+        return result;
     }
     else
     {
+        recordRead(cacheFileName, false);
         return 0;
     }
 }
@@ -118,21 +483,13 @@ ReaderWriter::WriteResult FileCache::writeImage(const osg::Image& image, const s
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
-        std::string path = osgDB::getFilePath(cacheFileName);
-
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+        std::string tempFileName;
+        if (!prepareCacheFile(cacheFileName, tempFileName)) return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
 
+        osg::ref_ptr<Options> writeOptions;
         OSG_INFO<<"FileCache::writeImageToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeImage(image, cacheFileName, options);
-        if (result.success())
-        {
-            removeFileFromBlackListed(originalFileName);
-        }
-        return result;
+        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeImage(image, tempFileName, getWriteOptions(options, writeOptions));
+        return publishCacheFile(result, originalFileName, tempFileName, cacheFileName);
     }
     return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
 }
@@ -143,10 +500,13 @@ ReaderWriter::ReadResult FileCache::readHeightField(const std::string& originalF
     if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
     {
         OSG_INFO<<"FileCache::readHeightFieldFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readHeightField(cacheFileName, options);
+        ReaderWriter::ReadResult result = osgDB::Registry::instance()->readHeightField(cacheFileName, options);
+        recordRead(cacheFileName, result.success());
+        return result;
     }
     else
     {
+        recordRead(cacheFileName, false);
         return 0;
     }
 }
@@ -156,21 +516,13 @@ ReaderWriter::WriteResult FileCache::writeHeightField(const osg::HeightField& hf
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
-        std::string path = osgDB::getFilePath(cacheFileName);
-
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+        std::string tempFileName;
+        if (!prepareCacheFile(cacheFileName, tempFileName)) return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
 
+        osg::ref_ptr<Options> writeOptions;
         OSG_INFO<<"FileCache::writeHeightFieldToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeHeightField(hf, cacheFileName, options);
-        if (result.success())
-        {
-            removeFileFromBlackListed(originalFileName);
-        }
-        return result;
+        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeHeightField(hf, tempFileName, getWriteOptions(options, writeOptions));
+        return publishCacheFile(result, originalFileName, tempFileName, cacheFileName);
     }
     return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
 }
@@ -181,10 +533,13 @@ ReaderWriter::ReadResult FileCache::readNode(const std::string& originalFileName
     if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
     {
         OSG_INFO<<"FileCache::readNodeFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readNode(cacheFileName, options, buildKdTreeIfRequired);
+        ReaderWriter::ReadResult result = osgDB::Registry::instance()->readNode(cacheFileName, options, buildKdTreeIfRequired);
+        recordRead(cacheFileName, result.success());
+        return result;
     }
     else
     {
+        recordRead(cacheFileName, false);
         return 0;
     }
 }
@@ -194,21 +549,13 @@ ReaderWriter::WriteResult FileCache::writeNode(const osg::Node& node, const std:
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
-        std::string path = osgDB::getFilePath(cacheFileName);
-
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+        std::string tempFileName;
+        if (!prepareCacheFile(cacheFileName, tempFileName)) return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
 
+        osg::ref_ptr<Options> writeOptions;
         OSG_INFO<<"FileCache::writeNodeToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeNode(node, cacheFileName, options);
-        if (result.success())
-        {
-            removeFileFromBlackListed(originalFileName);
-        }
-        return result;
+        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeNode(node, tempFileName, getWriteOptions(options, writeOptions));
+        return publishCacheFile(result, originalFileName, tempFileName, cacheFileName);
     }
     return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
 }
@@ -220,10 +567,13 @@ ReaderWriter::ReadResult FileCache::readShader(const std::string& originalFileNa
     if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
     {
         OSG_INFO<<"FileCache::readShaderFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readShader(cacheFileName, options);
+        ReaderWriter::ReadResult result = osgDB::Registry::instance()->readShader(cacheFileName, options);
+        recordRead(cacheFileName, result.success());
+        return result;
     }
     else
     {
+        recordRead(cacheFileName, false);
         return 0;
     }
 }
@@ -233,21 +583,13 @@ ReaderWriter::WriteResult FileCache::writeShader(const osg::Shader& shader, cons
     std::string cacheFileName = createCacheFileName(originalFileName);
     if (!cacheFileName.empty())
     {
-        std::string path = osgDB::getFilePath(cacheFileName);
-
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+        std::string tempFileName;
+        if (!prepareCacheFile(cacheFileName, tempFileName)) return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
 
+        osg::ref_ptr<Options> writeOptions;
         OSG_INFO<<"FileCache::writeShaderToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeShader(shader, cacheFileName, options);
-        if (result.success())
-        {
-            removeFileFromBlackListed(originalFileName);
-        }
-        return result;
+        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeShader(shader, tempFileName, getWriteOptions(options, writeOptions));
+        return publishCacheFile(result, originalFileName, tempFileName, cacheFileName);
     }
     return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
 }
@@ -0,0 +1,205 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/Notify>
+
+#include <osgDB/FileLocationCache>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+
+#include <OpenThreads/ScopedLock>
+
+using namespace osgDB;
+
+FileLocationCache::FileLocationCache(double timeToLive):
+    _timeToLive(timeToLive),
+    _numHits(0),
+    _numDirectoryReads(0),
+    _numSystemCallsAvoided(0)
+{
+    OSG_INFO<<"Constructed FileLocationCache, timeToLive = "<<timeToLive<<std::endl;
+}
+
+FileLocationCache::~FileLocationCache()
+{
+}
+
+void FileLocationCache::setTimeToLive(double timeToLive)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _timeToLive = timeToLive;
+}
+
+double FileLocationCache::getTimeToLive() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _timeToLive;
+}
+
+std::string FileLocationCache::findInDirectory(const std::string& directory, const std::string& simpleFileName, bool caseInsensitive)
+{
+    osg::Timer_t currentTime = osg::Timer::instance()->tick();
+
+    DirectoryListingMap::iterator itr = _directoryListings.find(directory);
+    if (itr != _directoryListings.end() &&
+        _timeToLive>=0.0 && osg::Timer::instance()->delta_s(itr->second.readTime, currentTime)>_timeToLive)
+    {
+        _directoryListings.erase(itr);
+        itr = _directoryListings.end();
+    }
+
+    if (itr == _directoryListings.end())
+    {
+        // a directory that doesn't exist gives an empty listing, so failed lookups are cached as well.
+        DirectoryListing& listing = _directoryListings[directory];
+        listing.readTime = currentTime;
+
+        DirectoryContents contents = getDirectoryContents(directory.empty() ? std::string(".") : directory);
+        for(DirectoryContents::iterator citr = contents.begin();
+            citr != contents.end();
+            ++citr)
+        {
+            if (*citr=="." || *citr=="..") continue;
+            listing.names[*citr] = *citr;
+            listing.lowerCaseNames[convertToLowerCase(*citr)] = *citr;
+        }
+
+        ++_numDirectoryReads;
+
+        itr = _directoryListings.find(directory);
+    }
+    else
+    {
+        ++_numHits;
+        ++_numSystemCallsAvoided;
+    }
+
+    const DirectoryListing::NameMap& names = caseInsensitive ? itr->second.lowerCaseNames : itr->second.names;
+    DirectoryListing::NameMap::const_iterator nitr = names.find(caseInsensitive ? convertToLowerCase(simpleFileName) : simpleFileName);
+    return (nitr != names.end()) ? nitr->second : std::string();
+}
+
+bool FileLocationCache::fileExists(const std::string& filename)
+{
+    std::string simpleFileName = getSimpleFileName(filename);
+    if (simpleFileName.empty() || simpleFileName=="." || simpleFileName=="..") return osgDB::fileExists(filename);
+
+#ifdef WIN32
+    // windows file names are case insensitive.
+    bool caseInsensitive = true;
+#else
+    bool caseInsensitive = false;
+#endif
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return !findInDirectory(getFilePath(filename), simpleFileName, caseInsensitive).empty();
+}
+
+std::string FileLocationCache::findFileCaseInsensitive(const std::string& filename)
+{
+    std::string simpleFileName = getSimpleFileName(filename);
+    if (simpleFileName.empty()) return std::string();
+
+    std::string directory = getFilePath(filename);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    std::string foundName = findInDirectory(directory, simpleFileName, true);
+    if (foundName.empty()) return std::string();
+
+    return directory.empty() ? foundName : concatPaths(directory, foundName);
+}
+
+std::string FileLocationCache::findFileInPath(const std::string& filename, const FilePathList& filePath, CaseSensitivity caseSensitivity)
+{
+    if (filename.empty())
+        return filename;
+
+    if (!isFileNameNativeStyle(filename))
+        return findFileInPath(convertFileNameToNativeStyle(filename), filePath, caseSensitivity);
+
+    for(FilePathList::const_iterator itr=filePath.begin();
+        itr!=filePath.end();
+        ++itr)
+    {
+        std::string path = itr->empty() ? filename : concatPaths(*itr, filename);
+
+        if (fileExists(path))
+        {
+            // resolve the real path only for the file found rather than for every path tried.
+            return getRealPath(path);
+        }
+        else if (caseSensitivity==CASE_INSENSITIVE)
+        {
+            std::string foundfile = findFileCaseInsensitive(path);
+            if (!foundfile.empty()) return getRealPath(foundfile);
+
+#ifndef WIN32
+            // the cache only matches the last path component case insensitively, leave sub directories to findFileInDirectory.
+            if (filename != getSimpleFileName(filename))
+            {
+                foundfile = findFileInDirectory(filename, *itr, CASE_INSENSITIVE);
+                if (!foundfile.empty()) return foundfile;
+            }
+#endif
+        }
+    }
+
+    return std::string();
+}
+
+void FileLocationCache::flush()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _directoryListings.clear();
+}
+
+void FileLocationCache::flushDirectory(const std::string& directory)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _directoryListings.erase(directory);
+}
+
+unsigned int FileLocationCache::getNumHits() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _numHits;
+}
+
+unsigned int FileLocationCache::getNumDirectoryReads() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _numDirectoryReads;
+}
+
+unsigned int FileLocationCache::getNumSystemCallsAvoided() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _numSystemCallsAvoided;
+}
+
+void FileLocationCache::resetStats()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _numHits = 0;
+    _numDirectoryReads = 0;
+    _numSystemCallsAvoided = 0;
+}
+
+void FileLocationCache::reportStats(std::ostream& out) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    out<<"FileLocationCache::reportStats()"<<std::endl;
+    out<<"   directories cached = "<<_directoryListings.size()<<std::endl;
+    out<<"   _numHits = "<<_numHits<<", _numDirectoryReads = "<<_numDirectoryReads<<std::endl;
+    out<<"   _numSystemCallsAvoided = "<<_numSystemCallsAvoided<<std::endl;
+}
@@ -0,0 +1,129 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgDB/ImageBufferPool>
+#include <osgDB/Options>
+
+#include <OpenThreads/ScopedLock>
+
+using namespace osgDB;
+
+static const char* s_imageBufferPoolKey = "ImageBufferPool";
+
+ImageBufferPool::ImageBufferPool(unsigned int maximumNumImages):
+    _maximumNumImages(maximumNumImages),
+    _numImagesReused(0),
+    _numImagesAllocated(0)
+{
+}
+
+ImageBufferPool::~ImageBufferPool()
+{
+}
+
+void ImageBufferPool::setMaximumNumImages(unsigned int maximumNumImages)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _maximumNumImages = maximumNumImages;
+}
+
+osg::ref_ptr<osg::Image> ImageBufferPool::allocateImage(int s, int t, int r, GLenum pixelFormat, GLenum type, int packing)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    unsigned int requiredSize = osg::Image::computeRowWidthInBytes(s, pixelFormat, type, packing)*t*r;
+
+    // look for a free image of the same size, otherwise note the first free image which can be recycled with new storage.
+    ImageList::iterator freeItr = _images.end();
+    for(ImageList::iterator itr = _images.begin(); itr != _images.end(); ++itr)
+    {
+        if ((*itr)->referenceCount()!=1) continue;
+
+        if ((*itr)->getTotalSizeInBytes()==requiredSize)
+        {
+            freeItr = itr;
+            break;
+        }
+
+        if (freeItr==_images.end()) freeItr = itr;
+    }
+
+    osg::ref_ptr<osg::Image> image;
+    if (freeItr!=_images.end())
+    {
+        image = *freeItr;
+        if (image->getTotalSizeInBytes()==requiredSize) ++_numImagesReused;
+        else ++_numImagesAllocated;
+
+        // move to the back so that the least recently used images are checked first.
+        _images.erase(freeItr);
+        _images.push_back(image);
+
+        image->setFileName(std::string());
+        image->setOrigin(osg::Image::BOTTOM_LEFT);
+        image->setInternalTextureFormat(0);
+    }
+    else
+    {
+        ++_numImagesAllocated;
+
+        image = new osg::Image;
+        if (_images.size()<_maximumNumImages) _images.push_back(image);
+    }
+
+    image->allocateImage(s, t, r, pixelFormat, type, packing);
+    image->setInternalTextureFormat(pixelFormat);
+
+    return image;
+}
+
+void ImageBufferPool::trim()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    for(ImageList::iterator itr = _images.begin(); itr != _images.end();)
+    {
+        if ((*itr)->referenceCount()==1) itr = _images.erase(itr);
+        else ++itr;
+    }
+}
+
+unsigned int ImageBufferPool::getNumImages() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return static_cast<unsigned int>(_images.size());
+}
+
+void ImageBufferPool::setImageBufferPool(Options* options, ImageBufferPool* pool)
+{
+    if (!options) return;
+
+    if (pool) options->setPluginData(s_imageBufferPoolKey, pool);
+    else options->removePluginData(s_imageBufferPoolKey);
+}
+
+ImageBufferPool* ImageBufferPool::getImageBufferPool(const Options* options)
+{
+    if (!options) return 0;
+    return const_cast<ImageBufferPool*>(reinterpret_cast<const ImageBufferPool*>(options->getPluginData(s_imageBufferPoolKey)));
+}
+
+osg::ref_ptr<osg::Image> ImageBufferPool::allocateImage(const Options* options, int s, int t, int r, GLenum pixelFormat, GLenum type, int packing)
+{
+    ImageBufferPool* pool = getImageBufferPool(options);
+    if (pool) return pool->allocateImage(s, t, r, pixelFormat, type, packing);
+
+    osg::ref_ptr<osg::Image> image = new osg::Image;
+    image->allocateImage(s, t, r, pixelFormat, type, packing);
+    return image;
+}
@@ -16,9 +16,16 @@
 
 #include <osg/Notify>
 #include <osg/ImageSequence>
+#include <osg/ApplicationUsage>
+
+#include <set>
+#include <sstream>
+#include <stdlib.h>
 
 using namespace osgDB;
 
+static osg::ApplicationUsageProxy ImagePager_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_NUM_IMAGE_THREADS <int>","Set the number of threads the ImagePager uses to decode images in parallel.");
+
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
@@ -211,32 +218,12 @@ void ImagePager::ImageThread::run()
         if (imageRequest.valid())
         {
             // OSG_NOTICE<<"doing readImageFile("<<imageRequest->_fileName<<") index to assign = "<<imageRequest->_attachmentIndex<<std::endl;
-            osg::ref_ptr<osg::Image> image = osgDB::readRefImageFile(imageRequest->_fileName, imageRequest->_readOptions.get());
-            if (image.valid())
-            {
-                // OSG_NOTICE<<"   successful readImageFile("<<imageRequest->_fileName<<") index to assign = "<<imageRequest->_attachmentIndex<<std::endl;
-
-                osg::ImageSequence* is = dynamic_cast<osg::ImageSequence*>(imageRequest->_attachmentPoint.get());
-                if (is)
-                {
-                    if (imageRequest->_attachmentIndex >= 0)
-                    {
-                        is->setImage(imageRequest->_attachmentIndex, image.get());
-                    }
-                    else
-                    {
-                        is->addImage(image.get());
-                    }
-                }
-                else
-                {
-                    imageRequest->_loadedImage = image;
-
-                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pager->_completedQueue->_requestMutex);
-                    _pager->_completedQueue->_requestList.push_back(imageRequest);
-                }
-            }
+            osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+            imageRequest->_loadedImage = osgDB::readRefImageFile(imageRequest->_fileName, imageRequest->_readOptions.get());
+            imageRequest->_decodeTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
 
+            _pager->completeRequest(imageRequest.get());
         }
         else
         {
@@ -265,25 +252,45 @@ void ImagePager::ImageThread::run()
 // ImagePager
 //
 ImagePager::ImagePager():
-    _done(false)
+    _done(false),
+    _numImagesDecoded(0),
+    _totalDecodeTime(0.0),
+    _maximumDecodeTime(0.0),
+    _numImagesDelivered(0),
+    _totalRequestLatency(0.0),
+    _maximumRequestLatency(0.0)
 {
     _startThreadCalled = false;
     _databasePagerThreadPaused = false;
 
     _readQueue = new ReadQueue(this,"Image Queue");
     _completedQueue = new RequestQueue;
-    _imageThreads.push_back(new ImageThread(this, ImageThread::HANDLE_ALL_REQUESTS, "Image Thread 1"));
-    _imageThreads.push_back(new ImageThread(this, ImageThread::HANDLE_ALL_REQUESTS, "Image Thread 2"));
-    _imageThreads.push_back(new ImageThread(this, ImageThread::HANDLE_ALL_REQUESTS, "Image Thread 3"));
-#if 0
-    _imageThreads.push_back(new ImageThread(this, ImageThread::HANDLE_ALL_REQUESTS, "Image Thread 4"));
-    _imageThreads.push_back(new ImageThread(this, ImageThread::HANDLE_ALL_REQUESTS, "Image Thread 5"));
-    _imageThreads.push_back(new ImageThread(this, ImageThread::HANDLE_ALL_REQUESTS, "Image Thread 6"));
-#endif
+    _imageBufferPool = new ImageBufferPool;
+
+    unsigned int numThreads = 3;
+    const char* str = getenv("OSG_NUM_IMAGE_THREADS");
+    if (str && atoi(str)>0) numThreads = atoi(str);
+
+    setUpThreads(numThreads);
+
     // 1 second
     _preLoadTime = 1.0;
 }
 
+void ImagePager::setUpThreads(unsigned int numThreads)
+{
+    if (_startThreadCalled) cancel();
+
+    _imageThreads.clear();
+
+    for(unsigned int i=0; i<osg::maximum(numThreads, 1u); ++i)
+    {
+        std::ostringstream name;
+        name<<"Image Thread "<<i+1;
+        _imageThreads.push_back(new ImageThread(this, ImageThread::HANDLE_ALL_REQUESTS, name.str()));
+    }
+}
+
 ImagePager::~ImagePager()
 {
     cancel();
@@ -345,9 +352,22 @@ void ImagePager::requestImageFile(const std::string& fileName, osg::Object* atta
     request->_attachmentIndex = attachmentIndex;
     request->_requestQueue = _readQueue.get();
     request->_readOptions = readOptions;
+    request->_requestTick = osg::Timer::instance()->tick();
+
+    // ImageSequence frames are decoded into pooled images so the storage of discarded frames is recycled.
+    if (_imageBufferPool.valid() && dynamic_cast<osg::ImageSequence*>(attachmentPoint))
+    {
+        request->_readOptions = readOptions ? readOptions->cloneOptions() : new Options;
+        ImageBufferPool::setImageBufferPool(request->_readOptions.get(), _imageBufferPool.get());
+    }
 
     imageRequest = request;
 
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestsInFlightMutex);
+        _requestsInFlight.push_back(request);
+    }
+
     // OSG_NOTICE<<"ImagePager::requestImageFile("<<fileName<<") new request."<<std::endl;
 
     _readQueue->add(request.get());
@@ -402,3 +422,127 @@ void ImagePager::updateSceneGraph(const osg::FrameStamp&)
     _completedQueue->_requestList.clear();
 }
 
+
+void ImagePager::completeRequest(ImageRequest* imageRequest)
+{
+    // the delivery mutex keeps the delivery order consistent across image threads, the requests in flight mutex
+    // is released before images are handed to the ImageSequence as its update() requests images with its own mutex held.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> deliveryLock(_deliveryMutex);
+
+    ++_numImagesDecoded;
+    _totalDecodeTime += imageRequest->_decodeTime;
+    _maximumDecodeTime = osg::maximum(_maximumDecodeTime, imageRequest->_decodeTime);
+
+    typedef std::vector< osg::ref_ptr<ImageRequest> > RequestVector;
+    typedef std::vector< osg::ref_ptr<osg::Object> > AttachmentVector;
+    RequestVector requestsToDeliver;
+    AttachmentVector attachmentPoints;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestsInFlightMutex);
+
+        imageRequest->_completed = true;
+
+        std::set<osg::Object*> blockedAttachmentPoints;
+        for(RequestList::iterator itr = _requestsInFlight.begin();
+            itr != _requestsInFlight.end();)
+        {
+            osg::ref_ptr<osg::Object> attachmentPoint;
+            if (!(*itr)->_attachmentPoint.lock(attachmentPoint))
+            {
+                itr = _requestsInFlight.erase(itr);
+            }
+            else if (blockedAttachmentPoints.count(attachmentPoint.get())!=0)
+            {
+                ++itr;
+            }
+            else if (!(*itr)->_completed)
+            {
+                // later requests for the same attachment point wait until this one is decoded.
+                blockedAttachmentPoints.insert(attachmentPoint.get());
+                ++itr;
+            }
+            else
+            {
+                requestsToDeliver.push_back(*itr);
+                attachmentPoints.push_back(attachmentPoint);
+                itr = _requestsInFlight.erase(itr);
+            }
+        }
+    }
+
+    osg::Timer_t currentTick = osg::Timer::instance()->tick();
+    for(unsigned int i=0; i<requestsToDeliver.size(); ++i)
+    {
+        ImageRequest* request = requestsToDeliver[i].get();
+
+        double latency = osg::Timer::instance()->delta_s(request->_requestTick, currentTick);
+        ++_numImagesDelivered;
+        _totalRequestLatency += latency;
+        _maximumRequestLatency = osg::maximum(_maximumRequestLatency, latency);
+
+        if (!request->_loadedImage) continue;
+
+        // OSG_NOTICE<<"   successful readImageFile("<<request->_fileName<<") index to assign = "<<request->_attachmentIndex<<std::endl;
+
+        osg::ImageSequence* is = dynamic_cast<osg::ImageSequence*>(attachmentPoints[i].get());
+        if (is)
+        {
+            if (request->_attachmentIndex >= 0)
+            {
+                is->setImage(request->_attachmentIndex, request->_loadedImage.get());
+            }
+            else
+            {
+                is->addImage(request->_loadedImage.get());
+            }
+            request->_loadedImage = 0;
+        }
+        else
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_completedQueue->_requestMutex);
+            _completedQueue->_requestList.push_back(request);
+        }
+    }
+}
+
+unsigned int ImagePager::getNumRequestsPending() const
+{
+    return _readQueue->size();
+}
+
+unsigned int ImagePager::getNumRequestsAwaitingDelivery() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestsInFlightMutex);
+
+    unsigned int numRequests = 0;
+    for(RequestList::const_iterator itr = _requestsInFlight.begin();
+        itr != _requestsInFlight.end();
+        ++itr)
+    {
+        if ((*itr)->_completed) ++numRequests;
+    }
+    return numRequests;
+}
+
+double ImagePager::getAverageDecodeTime() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_deliveryMutex);
+    return _numImagesDecoded>0 ? _totalDecodeTime/double(_numImagesDecoded) : 0.0;
+}
+
+double ImagePager::getAverageRequestLatency() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_deliveryMutex);
+    return _numImagesDelivered>0 ? _totalRequestLatency/double(_numImagesDelivered) : 0.0;
+}
+
+void ImagePager::resetStats()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_deliveryMutex);
+    _numImagesDecoded = 0;
+    _totalDecodeTime = 0.0;
+    _maximumDecodeTime = 0.0;
+    _numImagesDelivered = 0;
+    _totalRequestLatency = 0.0;
+    _maximumRequestLatency = 0.0;
+}
@@ -20,13 +20,19 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/ObjectWrapper>
 #include <osgDB/ConvertBase64>
+#include <OpenThreads/Thread>
+#include <OpenThreads/Condition>
+#include <set>
 
 using namespace osgDB;
 
 static std::string s_lastSchema;
 
+// guards against resizing the identifier tables for corrupt ids
+static const unsigned int MAXIMUM_IDENTIFIER = 1u<<28;
+
 InputStream::InputStream( const osgDB::Options* options )
-    :   _fileVersion(0), _useSchemaData(false), _forceReadingImage(false), _dataDecompress(0)
+    :   _fileVersion(0), _useSchemaData(false), _forceReadingImage(false), _useClassNameTable(false), _readChunks(false), _dataDecompress(0)
 {
     BEGIN_BRACKET.set( "{", +INDENT_VALUE );
     END_BRACKET.set( "}", -INDENT_VALUE );
@@ -327,10 +333,14 @@ osg::ref_ptr<osg::Array> InputStream::readArray()
     unsigned int id = 0;
     *this >> PROPERTY("ArrayID") >> id;
 
-    ArrayMap::iterator itr = _arrayMap.find( id );
-    if ( itr!=_arrayMap.end() )
+    if ( id<_arrayMap.size() && _arrayMap[id].valid() )
+    {
+        return _arrayMap[id].get();
+    }
+    if ( id>MAXIMUM_IDENTIFIER )
     {
-        return itr->second.get();
+        throwException( "InputStream::readArray(): Invalid array ID." );
+        return NULL;
     }
 
     DEF_MAPPEE(ArrayType, type);
@@ -569,7 +579,7 @@ osg::ref_ptr<osg::Array> InputStream::readArray()
     }
 
     if ( getException() ) return NULL;
-    _arrayMap[id] = array;
+    setIdentifiedEntry( _arrayMap, id, array.get() );
 
     return array;
 }
@@ -676,10 +686,14 @@ osg::ref_ptr<osg::Image> InputStream::readImage(bool readFromExternal)
     *this >> PROPERTY("UniqueID") >> id;
     if ( getException() ) return NULL;
 
-    IdentifierMap::iterator itr = _identifierMap.find( id );
-    if ( itr!=_identifierMap.end() )
+    if ( id<_identifierMap.size() && _identifierMap[id].valid() )
+    {
+        return static_cast<osg::Image*>( _identifierMap[id].get() );
+    }
+    if ( id>MAXIMUM_IDENTIFIER )
     {
-        return static_cast<osg::Image*>( itr->second.get() );
+        throwException( "InputStream::readImage(): Invalid image ID." );
+        return NULL;
     }
 
     std::string name;
@@ -854,7 +868,7 @@ osg::ref_ptr<osg::Image> InputStream::readImage(bool readFromExternal)
         // we don't want to overwrite the properties of the image in the cache as this could cause theading problems if the object is currently being used
         // so we read the properties from the file into a dummy object and discard the changes.
         osg::ref_ptr<osg::Object> temp_obj = readObjectFields("osg::Object", id, _dummyReadObject.get() );
-        _identifierMap[id] = image;
+        setIdentifiedEntry<osg::Object>( _identifierMap, id, image.get() );
     }
     else
     {
@@ -870,26 +884,32 @@ osg::ref_ptr<osg::Image> InputStream::readImage(bool readFromExternal)
 
 osg::ref_ptr<osg::Object> InputStream::readObject( osg::Object* existingObj )
 {
-    std::string className;
-    unsigned int id = 0;
-    *this >> className;
-
-    if (className=="NULL")
+    if ( _readChunks )
     {
-        return 0;
+        _readChunks = false;
+        readChunks();
+        if ( getException() ) return 0;
     }
 
+    ClassEntry* entry = readClassEntry();
+    if ( !entry ) return 0;
+
+    unsigned int id = 0;
     *this >> BEGIN_BRACKET >> PROPERTY("UniqueID") >> id;
     if ( getException() ) return 0;
 
-    IdentifierMap::iterator itr = _identifierMap.find( id );
-    if ( itr!=_identifierMap.end() )
+    if ( id<_identifierMap.size() && _identifierMap[id].valid() )
     {
         advanceToCurrentEndBracket();
-        return itr->second;
+        return _identifierMap[id];
+    }
+    if ( id>MAXIMUM_IDENTIFIER )
+    {
+        throwException( "InputStream::readObject(): Invalid object ID." );
+        return 0;
     }
 
-    osg::ref_ptr<osg::Object> obj = readObjectFields( className, id, existingObj );
+    osg::ref_ptr<osg::Object> obj = readObjectFields( *entry, id, existingObj );
 
     advanceToCurrentEndBracket();
 
@@ -898,46 +918,111 @@ osg::ref_ptr<osg::Object> InputStream::readObject( osg::Object* existingObj )
 
 osg::ref_ptr<osg::Object> InputStream::readObjectFields( const std::string& className, unsigned int id, osg::Object* existingObj )
 {
-    ObjectWrapper* wrapper = Registry::instance()->getObjectWrapperManager()->findWrapper( className );
+    return readObjectFields( *getClassEntry(className), id, existingObj );
+}
+
+osg::ref_ptr<osg::Object> InputStream::readObjectFields( ClassEntry& entry, unsigned int id, osg::Object* existingObj )
+{
+    resolveClassEntry( entry );
+
+    ObjectWrapper* wrapper = entry.wrapper;
     if ( !wrapper )
     {
         OSG_WARN << "InputStream::readObject(): Unsupported wrapper class "
-                               << className << std::endl;
+                               << entry.name << std::endl;
         return NULL;
     }
-    int inputVersion =  getFileVersion(wrapper->getDomain());
 
     osg::ref_ptr<osg::Object> obj = existingObj ? existingObj : wrapper->createInstance();
-    _identifierMap[id] = obj;
+    setIdentifiedEntry( _identifierMap, id, obj.get() );
     if ( obj.valid() )
     {
-        const ObjectWrapper::RevisionAssociateList& associates = wrapper->getAssociates();
-        for ( ObjectWrapper::RevisionAssociateList::const_iterator itr=associates.begin(); itr!=associates.end(); ++itr )
+        for ( std::vector<ObjectWrapper*>::const_iterator itr=entry.associates.begin(); itr!=entry.associates.end(); ++itr )
         {
-            if ( itr->_firstVersion <= inputVersion &&
-                    inputVersion <= itr->_lastVersion)
-            {
-                ObjectWrapper* assocWrapper = Registry::instance()->getObjectWrapperManager()->findWrapper(itr->_name);
-                if ( !assocWrapper )
-                {
-                    OSG_WARN << "InputStream::readObject(): Unsupported associated class "
-                                           << itr->_name << std::endl;
-                    continue;
-                }
-                _fields.push_back( assocWrapper->getName() );
-                assocWrapper->read( *this, *obj );
-                if ( getException() ) return NULL;
+            ObjectWrapper* assocWrapper = *itr;
+            _fields.push_back( assocWrapper->getName() );
+            assocWrapper->read( *this, *obj );
+            if ( getException() ) return NULL;
 
-                _fields.pop_back();
-            }
-            else
+            _fields.pop_back();
+        }
+    }
+    return obj;
+}
+
+InputStream::ClassEntry* InputStream::getClassEntry( const std::string& className )
+{
+    ClassEntryMap::iterator itr = _classEntryMap.find( className );
+    if ( itr!=_classEntryMap.end() ) return itr->second;
+
+    _classEntries.push_back( ClassEntry() );
+    ClassEntry* entry = &_classEntries.back();
+    entry->name = className;
+    _classEntryMap[className] = entry;
+    return entry;
+}
+
+InputStream::ClassEntry* InputStream::readClassEntry()
+{
+    if ( !_useClassNameTable )
+    {
+        std::string className;
+        *this >> className;
+        if ( className=="NULL" || getException() ) return NULL;
+        return getClassEntry( className );
+    }
+
+    // index 0 is the NULL token, the next unused index is followed by the name of a class not seen before.
+    unsigned int index = 0;
+    *this >> index;
+    if ( index==0 || getException() ) return NULL;
+
+    if ( index<=_classNameTable.size() ) return _classNameTable[index-1];
+
+    if ( index>_classNameTable.size()+1 )
+    {
+        throwException( "InputStream::readObject(): Invalid class name index." );
+        return NULL;
+    }
+
+    std::string className;
+    *this >> className;
+    if ( getException() ) return NULL;
+
+    ClassEntry* entry = getClassEntry( className );
+    _classNameTable.push_back( entry );
+    return entry;
+}
+
+void InputStream::resolveClassEntry( ClassEntry& entry )
+{
+    if ( entry.resolved ) return;
+    entry.resolved = true;
+
+    // look up the wrapper and the associates matching the file version once per stream,
+    // rather than going through the ObjectWrapperManager for every object read.
+    ObjectWrapperManager* manager = Registry::instance()->getObjectWrapperManager();
+    entry.wrapper = manager->findWrapper( entry.name );
+    if ( !entry.wrapper ) return;
+
+    int inputVersion = getFileVersion( entry.wrapper->getDomain() );
+
+    const ObjectWrapper::RevisionAssociateList& associates = entry.wrapper->getAssociates();
+    for ( ObjectWrapper::RevisionAssociateList::const_iterator itr=associates.begin(); itr!=associates.end(); ++itr )
+    {
+        if ( itr->_firstVersion <= inputVersion &&
+                inputVersion <= itr->_lastVersion)
+        {
+            ObjectWrapper* assocWrapper = manager->findWrapper(itr->_name);
+            if ( !assocWrapper )
             {
-               /* OSG_INFO << "InputStream::readObject():"<<className<<" Ignoring associated class due to version mismatch"
-                         << itr->_name<<"["<<itr->_firstVersion <<","<<itr->_lastVersion <<"]for version "<<inputVersion<< std::endl;*/
+                OSG_WARN << "InputStream::readObject(): Unsupported associated class "
+                                       << itr->_name << std::endl;
+                continue;
             }
+            entry.associates.push_back( assocWrapper );
         }
     }
-    return obj;
 }
 
 void InputStream::readSchema( std::istream& fin )
@@ -970,6 +1055,13 @@ InputStream::ReadType InputStream::start( InputIterator* inIterator )
 
     _in->setInputStream(this);
 
+    _classNameTable.clear();
+    _classEntryMap.clear();
+    _classEntries.clear();
+    _useClassNameTable = false;
+    _readChunks = false;
+    _chunkCompressorName.clear();
+
     // Check OSG header information
     unsigned int version = 0;
     if ( isBinary() )
@@ -981,6 +1073,8 @@ InputStream::ReadType InputStream::start( InputIterator* inIterator )
         unsigned int attributes; *this >> attributes;
         if ( attributes&0x4 ) inIterator->setSupportBinaryBrackets( true );
         if ( attributes&0x2 ) _useSchemaData = true;
+        if ( attributes&0x8 ) _useClassNameTable = true;
+        if ( attributes&0x10 ) _readChunks = true;
 
         // Record custom domains
         if ( attributes&0x1 )
@@ -1025,7 +1119,12 @@ void InputStream::decompress()
     _fields.clear();
 
     std::string compressorName; *this >> compressorName;
-    if ( compressorName!="0" )
+    if ( compressorName!="0" && _readChunks )
+    {
+        // chunks are compressed individually and decompressed by the threads decoding them
+        _chunkCompressorName = compressorName;
+    }
+    else if ( compressorName!="0" )
     {
         std::string data;
         _fields.push_back( "Decompression" );
@@ -1037,7 +1136,7 @@ void InputStream::decompress()
             return;
         }
 
-        if ( !compressor->decompress(*(_in->getStream()), data) )
+        if ( !compressor->decompress(*(_in->getStream()), data, _options.get()) )
             throwException( "InputStream: Failed to decompress stream." );
         if ( getException() ) return;
 
@@ -1121,3 +1220,288 @@ void InputStream::readArrayImplementation( T* a, unsigned int numComponentsPerEl
     }
     *this >> END_BRACKET;
 }
+
+namespace osgDB
+{
+
+/** Decodes the chunks of a chunked binary stream, each with its own InputStream, on a set of threads.
+  * A chunk is started once the chunks defining the objects it refers to have been decoded.*/
+class ChunkDecoder
+{
+public:
+    struct Chunk
+    {
+        Chunk() : firstObjectID(0), endObjectID(0), firstArrayID(0), endArrayID(0), done(false) {}
+
+        std::string data;
+        unsigned int firstObjectID, endObjectID;
+        unsigned int firstArrayID, endArrayID;
+        std::vector<unsigned int> importedObjects;
+        std::vector<unsigned int> importedArrays;
+        std::vector<unsigned int> dependencies;
+        bool done;
+        std::string error;
+    };
+
+    typedef std::vector<Chunk> Chunks;
+
+    class DecodeThread : public OpenThreads::Thread
+    {
+    public:
+        DecodeThread( ChunkDecoder* decoder ) : _decoder(decoder) {}
+        virtual void run() { _decoder->run(); }
+
+    protected:
+        ChunkDecoder* _decoder;
+    };
+
+    ChunkDecoder( InputStream* parent, Chunks& chunks, BaseCompressor* compressor )
+    :   _parent(parent), _chunks(chunks), _compressor(compressor), _nextChunk(0) {}
+
+    void decode( unsigned int numThreads )
+    {
+        std::vector<DecodeThread*> threads;
+        for ( unsigned int i=1; i<numThreads; ++i )
+        {
+            threads.push_back( new DecodeThread(this) );
+            threads.back()->start();
+        }
+
+        run();
+
+        for ( std::vector<DecodeThread*>::iterator itr=threads.begin(); itr!=threads.end(); ++itr )
+        {
+            (*itr)->join();
+            delete *itr;
+        }
+    }
+
+    void run()
+    {
+        while ( true )
+        {
+            Chunk* chunk = 0;
+            {
+                // chunks are taken in order and only depend on earlier ones, so waiting here can't deadlock
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                if ( _nextChunk>=_chunks.size() ) return;
+                chunk = &_chunks[_nextChunk++];
+                while ( !dependenciesDone(*chunk) ) _condition.wait( &_mutex );
+            }
+
+            decodeChunk( *chunk );
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            chunk->done = true;
+            _condition.broadcast();
+        }
+    }
+
+protected:
+    bool dependenciesDone( const Chunk& chunk ) const
+    {
+        for ( std::vector<unsigned int>::const_iterator itr=chunk.dependencies.begin(); itr!=chunk.dependencies.end(); ++itr )
+        {
+            if ( !_chunks[*itr].done ) return false;
+        }
+        return true;
+    }
+
+    void decodeChunk( Chunk& chunk )
+    {
+        std::string decompressed;
+        if ( _compressor )
+        {
+            std::istringstream compressed( chunk.data );
+            if ( !_compressor->decompress(compressed, decompressed, _parent->_options.get()) )
+            {
+                chunk.error = "Failed to decompress chunk.";
+                return;
+            }
+        }
+        std::istringstream data( _compressor ? decompressed : chunk.data );
+        std::string().swap( chunk.data );
+
+        osg::ref_ptr<InputIterator> iterator = _parent->_in->cloneIterator( &data );
+        if ( !iterator )
+        {
+            chunk.error = "Stream doesn't support chunks.";
+            return;
+        }
+
+        InputStream is( _parent->_options.get() );
+        is._in = iterator;
+        iterator->setInputStream( &is );
+        is._fileVersion = _parent->_fileVersion;
+        is._domainVersionMap = _parent->_domainVersionMap;
+        is._useClassNameTable = _parent->_useClassNameTable;
+        is._fields.push_back( "Chunk" );
+
+        {
+            // imported entries were published by chunks that are done, only their slots are read here
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            is._identifierMap.resize( chunk.endObjectID );
+            is._arrayMap.resize( chunk.endArrayID );
+            for ( std::vector<unsigned int>::const_iterator itr=chunk.importedObjects.begin(); itr!=chunk.importedObjects.end(); ++itr )
+                is._identifierMap[*itr] = _parent->_identifierMap[*itr];
+            for ( std::vector<unsigned int>::const_iterator itr=chunk.importedArrays.begin(); itr!=chunk.importedArrays.end(); ++itr )
+                is._arrayMap[*itr] = _parent->_arrayMap[*itr];
+        }
+
+        unsigned int numObjects = 0;
+        is >> numObjects;
+        for ( unsigned int i=0; i<numObjects && !is.getException(); ++i )
+        {
+            is.readObject();
+        }
+
+        if ( is.getException() )
+        {
+            chunk.error = is.getException()->getError();
+            return;
+        }
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        for ( unsigned int id=chunk.firstObjectID; id<chunk.endObjectID && id<is._identifierMap.size(); ++id )
+            _parent->_identifierMap[id] = is._identifierMap[id];
+        for ( unsigned int id=chunk.firstArrayID; id<chunk.endArrayID && id<is._arrayMap.size(); ++id )
+            _parent->_arrayMap[id] = is._arrayMap[id];
+    }
+
+    InputStream*        _parent;
+    Chunks&             _chunks;
+    BaseCompressor*     _compressor;
+    unsigned int        _nextChunk;
+    OpenThreads::Mutex  _mutex;
+    OpenThreads::Condition _condition;
+};
+
+}
+
+// Return the index of the chunk among the first numChunks that defines id, or numChunks if none does.
+// Ids are allocated in writing order so the id ranges of the chunks are ascending.
+static unsigned int findChunk( const ChunkDecoder::Chunks& chunks, unsigned int numChunks, unsigned int id, bool array )
+{
+    unsigned int first = 0, last = numChunks;
+    while ( first<last )
+    {
+        unsigned int middle = (first+last)/2;
+        const ChunkDecoder::Chunk& chunk = chunks[middle];
+        unsigned int begin = array ? chunk.firstArrayID : chunk.firstObjectID;
+        unsigned int end = array ? chunk.endArrayID : chunk.endObjectID;
+        if ( id<begin ) last = middle;
+        else if ( id>=end ) first = middle+1;
+        else return middle;
+    }
+    return numChunks;
+}
+
+void InputStream::readChunks()
+{
+    _fields.push_back( "Chunks" );
+
+    unsigned int numChunks = 0;
+    *this >> numChunks;
+    if ( getException() || numChunks==0 )
+    {
+        _fields.pop_back();
+        return;
+    }
+
+    unsigned int endObjectID = 0, endArrayID = 0;
+    *this >> endObjectID >> endArrayID;
+    if ( getException() ) return;
+    if ( endObjectID>MAXIMUM_IDENTIFIER || endArrayID>MAXIMUM_IDENTIFIER )
+    {
+        throwException( "InputStream::readChunks(): Invalid chunk index." );
+        return;
+    }
+
+    // the index gives the size and id ranges of each chunk, and the ids it refers to from earlier chunks
+    ChunkDecoder::Chunks chunks( numChunks );
+    std::vector<unsigned int> sizes( numChunks );
+    for ( unsigned int i=0; i<numChunks; ++i )
+    {
+        ChunkDecoder::Chunk& chunk = chunks[i];
+        *this >> sizes[i] >> chunk.firstObjectID >> chunk.endObjectID >> chunk.firstArrayID >> chunk.endArrayID;
+        if ( getException() ) return;
+        if ( chunk.firstObjectID>chunk.endObjectID || chunk.endObjectID>endObjectID ||
+             chunk.firstArrayID>chunk.endArrayID || chunk.endArrayID>endArrayID )
+        {
+            throwException( "InputStream::readChunks(): Invalid chunk index." );
+            return;
+        }
+
+        std::set<unsigned int> dependencies;
+        unsigned int numImports = readSize();
+        for ( unsigned int j=0; j<numImports && !getException(); ++j )
+        {
+            unsigned int id = readSize();
+            unsigned int dependency = findChunk( chunks, i, id, false );
+            if ( dependency>=i )
+            {
+                throwException( "InputStream::readChunks(): Invalid chunk import." );
+                return;
+            }
+            chunk.importedObjects.push_back( id );
+            dependencies.insert( dependency );
+        }
+
+        numImports = readSize();
+        for ( unsigned int j=0; j<numImports && !getException(); ++j )
+        {
+            unsigned int id = readSize();
+            unsigned int dependency = findChunk( chunks, i, id, true );
+            if ( dependency>=i )
+            {
+                throwException( "InputStream::readChunks(): Invalid chunk import." );
+                return;
+            }
+            chunk.importedArrays.push_back( id );
+            dependencies.insert( dependency );
+        }
+        if ( getException() ) return;
+
+        chunk.dependencies.assign( dependencies.begin(), dependencies.end() );
+    }
+
+    for ( unsigned int i=0; i<numChunks; ++i )
+    {
+        chunks[i].data.resize( sizes[i] );
+        if ( sizes[i]>0 ) readCharArray( &(chunks[i].data[0]), sizes[i] );
+        if ( getException() ) return;
+    }
+
+    BaseCompressor* compressor = 0;
+    if ( !_chunkCompressorName.empty() )
+    {
+        compressor = Registry::instance()->getObjectWrapperManager()->findCompressor( _chunkCompressorName );
+        if ( !compressor )
+        {
+            throwException( "InputStream: Failed to decompress stream, No such compressor." );
+            return;
+        }
+    }
+
+    unsigned int numThreads = OpenThreads::GetNumberOfProcessors();
+    if ( _options.valid() && !_options->getPluginStringData("DecodeThreads").empty() )
+        numThreads = atoi( _options->getPluginStringData("DecodeThreads").c_str() );
+    numThreads = osg::clampBetween( numThreads, 1u, numChunks );
+
+    // chunks publish their objects into the tables of this stream, which then reads the top level object
+    _identifierMap.resize( endObjectID );
+    _arrayMap.resize( endArrayID );
+
+    ChunkDecoder decoder( this, chunks, compressor );
+    decoder.decode( numThreads );
+
+    for ( unsigned int i=0; i<numChunks; ++i )
+    {
+        if ( !chunks[i].error.empty() )
+        {
+            throwException( "InputStream::readChunks(): " + chunks[i].error );
+            return;
+        }
+    }
+    _fields.pop_back();
+}
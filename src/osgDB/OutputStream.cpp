@@ -18,6 +18,8 @@
 #include <osgDB/FileUtils>
 #include <osgDB/WriteFile>
 #include <osgDB/ObjectWrapper>
+#include <osg/PagedLOD>
+#include <osg/ProxyNode>
 #include <fstream>
 #include <sstream>
 #include <stdlib.h>
@@ -25,7 +27,8 @@
 using namespace osgDB;
 
 OutputStream::OutputStream( const osgDB::Options* options )
-:   _writeImageHint(WRITE_USE_IMAGE_HINT), _useSchemaData(false), _useRobustBinaryFormat(true)
+:   _useClassNameTable(true), _useChunkedLayout(false), _writeChunks(false), _compressChunks(false),
+    _chunkSize(1024*1024), _currentChunk(0), _writeImageHint(WRITE_USE_IMAGE_HINT), _useSchemaData(false), _useRobustBinaryFormat(true)
 {
     BEGIN_BRACKET.set( "{", +INDENT_VALUE );
     END_BRACKET.set( "}", -INDENT_VALUE );
@@ -37,6 +40,12 @@ OutputStream::OutputStream( const osgDB::Options* options )
         _useRobustBinaryFormat = false;
     if ( options->getPluginStringData("SchemaData")=="true" )
         _useSchemaData = true;
+    if ( options->getPluginStringData("ClassNameTable")=="false" )
+        _useClassNameTable = false;
+    if ( options->getPluginStringData("ChunkedLayout")=="true" )
+        _useChunkedLayout = true;
+    if ( !options->getPluginStringData("ChunkSize").empty() )
+        _chunkSize = osg::maximum( atoi(options->getPluginStringData("ChunkSize").c_str()), 1 );
     if ( !options->getPluginStringData("SchemaFile").empty() )
         _schemaName = options->getPluginStringData("SchemaFile");
     if ( !options->getPluginStringData("Compressor").empty() )
@@ -603,9 +612,17 @@ void OutputStream::writeImage( const osg::Image* img )
 
 void OutputStream::writeObject( const osg::Object* obj )
 {
+    if ( _writeChunks )
+    {
+        _writeChunks = false;
+        writeChunks( obj );
+        if ( getException() ) return;
+    }
+
     if ( !obj )
     {
-        *this << std::string("NULL") << std::endl;  // Write NULL token.
+        writeClassName( std::string("NULL") );  // Write NULL token.
+        *this << std::endl;
         return;
     }
 
@@ -615,7 +632,8 @@ void OutputStream::writeObject( const osg::Object* obj )
     bool newID = false;
     unsigned int id = findOrCreateObjectID( obj, newID );
 
-    *this << name << BEGIN_BRACKET << std::endl;       // Write object name
+    writeClassName( name );
+    *this << BEGIN_BRACKET << std::endl;       // Write object name
     *this << PROPERTY("UniqueID") << id << std::endl;  // Write object ID
     if ( getException() ) return;
 
@@ -729,6 +747,16 @@ void OutputStream::start( OutputIterator* outIterator, OutputStream::WriteType t
             outIterator->setSupportBinaryBrackets( true );
             attributes |= 0x4;
         }
+
+        // From SOVERSION 146, class names are written once and then referred to by index
+        if ( _useClassNameTable ) attributes |= 0x8;
+
+        // From SOVERSION 146, subgraphs of the written object may be stored as separately decodable chunks
+        if ( _useChunkedLayout && (type==WRITE_SCENE || type==WRITE_OBJECT) )
+        {
+            attributes |= 0x10;
+            _writeChunks = true;
+        }
         *this << attributes;
 
         // Record all custom versions
@@ -752,6 +780,11 @@ void OutputStream::start( OutputIterator* outIterator, OutputStream::WriteType t
                                        << _compressorName << std::endl;
                 _compressorName.clear();
             }
+            else if ( _writeChunks )
+            {
+                // each chunk is compressed on its own so that they can be decompressed in parallel
+                _compressChunks = true;
+            }
             else
             {
                 useCompressSource = true;
@@ -822,7 +855,7 @@ void OutputStream::compress( std::ostream* ostream )
         _fields.pop_back();
     }
 
-    if ( !_compressorName.empty() )
+    if ( !_compressorName.empty() && !_compressChunks )
     {
         _fields.push_back( "Compression" );
         BaseCompressor* compressor = Registry::instance()->getObjectWrapperManager()->findCompressor(_compressorName);
@@ -832,7 +865,7 @@ void OutputStream::compress( std::ostream* ostream )
             return;
         }
 
-        if ( !compressor->compress(*ostream, schemaSource.str() + _compressSource.str()) )
+        if ( !compressor->compress(*ostream, schemaSource.str() + _compressSource.str(), _options.get()) )
             throwException( "OutputStream: Failed to compress stream." );
         if ( getException() ) return;
         _fields.pop_back();
@@ -906,10 +939,40 @@ unsigned int OutputStream::findOrCreateArrayID( const osg::Array* array, bool& n
         newID = true;
         return id;
     }
+    if ( _currentChunk && itr->second<_currentChunk->firstArrayID )
+        _currentChunk->arrays.insert( itr->second );
     newID = false;
     return itr->second;
 }
 
+void OutputStream::writeClassName( const std::string& name )
+{
+    if ( !isBinary() || !_useClassNameTable )
+    {
+        *this << name;
+        return;
+    }
+
+    // index 0 is the NULL token, a new name is written after its index the first time it is used.
+    if ( name=="NULL" )
+    {
+        *this << (unsigned int)0;
+        return;
+    }
+
+    ClassNameTable::iterator itr = _classNameTable.find( name );
+    if ( itr!=_classNameTable.end() )
+    {
+        *this << itr->second;
+    }
+    else
+    {
+        unsigned int index = _classNameTable.size()+1;
+        _classNameTable[name] = index;
+        *this << index << name;
+    }
+}
+
 unsigned int OutputStream::findOrCreateObjectID( const osg::Object* obj, bool& newID )
 {
     ObjectMap::iterator itr = _objectMap.find( obj );
@@ -920,6 +983,134 @@ unsigned int OutputStream::findOrCreateObjectID( const osg::Object* obj, bool& n
         newID = true;
         return id;
     }
+    if ( _currentChunk && itr->second<_currentChunk->firstObjectID )
+        _currentChunk->objects.insert( itr->second );
     newID = false;
     return itr->second;
 }
+
+void OutputStream::writeChunks( const osg::Object* obj )
+{
+    _fields.push_back( "Chunks" );
+
+    // Collect the subgraphs to write as chunks, splitting groups until there are enough of them to spread
+    // over several threads. Any node split this way is written by the parent stream after the chunks.
+    const unsigned int minimumNumSubgraphs = 64;
+    std::vector<const osg::Node*> subgraphs;
+    std::set<const osg::Node*> visited;
+    const osg::Group* root = dynamic_cast<const osg::Group*>( obj );
+    if ( root )
+    {
+        visited.insert( root );
+        std::vector<const osg::Node*> candidates( 1, root );
+        while ( !candidates.empty() && candidates.size()+subgraphs.size()<minimumNumSubgraphs )
+        {
+            std::vector<const osg::Node*> expanded;
+            for ( std::vector<const osg::Node*>::iterator itr=candidates.begin(); itr!=candidates.end(); ++itr )
+            {
+                const osg::Group* group = (*itr)->asGroup();
+                if ( !group || group->getNumChildren()==0 ||
+                     dynamic_cast<const osg::PagedLOD*>(group) || dynamic_cast<const osg::ProxyNode*>(group) )
+                {
+                    subgraphs.push_back( *itr );
+                    continue;
+                }
+
+                for ( unsigned int i=0; i<group->getNumChildren(); ++i )
+                {
+                    const osg::Node* child = group->getChild(i);
+                    if ( child && visited.insert(child).second ) expanded.push_back( child );
+                }
+            }
+            candidates.swap( expanded );
+        }
+        subgraphs.insert( subgraphs.end(), candidates.begin(), candidates.end() );
+    }
+
+    BaseCompressor* compressor = _compressChunks ?
+        Registry::instance()->getObjectWrapperManager()->findCompressor(_compressorName) : 0;
+
+    // Write the subgraphs into chunks of about _chunkSize bytes. Ids are allocated sequentially so each
+    // chunk defines a contiguous range of them, references to earlier chunks are recorded as imports.
+    std::ostream* mainStream = _out->getStream();
+    std::vector<ChunkImports> chunks;
+    std::vector<std::string> payloads;
+    std::vector<unsigned int> endObjectIDs, endArrayIDs;
+    unsigned int index = 0;
+    while ( index<subgraphs.size() )
+    {
+        chunks.push_back( ChunkImports() );
+        ChunkImports& chunk = chunks.back();
+        chunk.firstObjectID = _objectMap.size()+1;
+        chunk.firstArrayID = _arrayMap.size()+1;
+        _currentChunk = &chunk;
+        _classNameTable.clear();
+
+        std::stringstream data;
+        _out->setStream( &data );
+
+        unsigned int numObjects = 0;
+        while ( index<subgraphs.size() && (numObjects==0 || data.tellp()<(std::streampos)_chunkSize) )
+        {
+            writeObject( subgraphs[index++] );
+            ++numObjects;
+            if ( getException() ) break;
+        }
+
+        std::stringstream payload;
+        _out->setStream( &payload );
+        *this << numObjects;
+        payload << data.rdbuf();
+
+        _currentChunk = 0;
+        _out->setStream( mainStream );
+        if ( getException() ) return;
+
+        endObjectIDs.push_back( _objectMap.size()+1 );
+        endArrayIDs.push_back( _arrayMap.size()+1 );
+
+        if ( compressor )
+        {
+            std::stringstream compressed;
+            if ( !compressor->compress(compressed, payload.str(), _options.get()) )
+            {
+                throwException( "OutputStream: Failed to compress chunk." );
+                return;
+            }
+            payloads.push_back( compressed.str() );
+        }
+        else
+        {
+            payloads.push_back( payload.str() );
+        }
+    }
+    _classNameTable.clear();
+
+    // Write the chunk index followed by the chunk data
+    unsigned int numChunks = chunks.size();
+    *this << numChunks;
+    if ( numChunks>0 )
+    {
+        *this << (unsigned int)(_objectMap.size()+1) << (unsigned int)(_arrayMap.size()+1);
+        for ( unsigned int i=0; i<numChunks; ++i )
+        {
+            const ChunkImports& chunk = chunks[i];
+            *this << (unsigned int)payloads[i].size();
+            *this << chunk.firstObjectID << endObjectIDs[i] << chunk.firstArrayID << endArrayIDs[i];
+
+            *this << (unsigned int)chunk.objects.size();
+            for ( std::set<unsigned int>::const_iterator itr=chunk.objects.begin(); itr!=chunk.objects.end(); ++itr )
+                *this << *itr;
+
+            *this << (unsigned int)chunk.arrays.size();
+            for ( std::set<unsigned int>::const_iterator itr=chunk.arrays.begin(); itr!=chunk.arrays.end(); ++itr )
+                *this << *itr;
+        }
+
+        for ( unsigned int i=0; i<numChunks; ++i )
+        {
+            writeCharArray( payloads[i].c_str(), payloads[i].size() );
+        }
+    }
+    _fields.pop_back();
+}
@@ -0,0 +1,114 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/Notify>
+
+#include <osgDB/ProgramBinaryFileCache>
+#include <osgDB/FileUtils>
+#include <osgDB/fstream>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace osgDB;
+
+static const char s_programBinaryMagic[8] = { 'O', 'S', 'G', 'P', 'B', 'I', 'N', '1' };
+
+ProgramBinaryFileCache::ProgramBinaryFileCache(const std::string& path):
+    _programBinaryCachePath(path)
+{
+    OSG_INFO<<"Constructed ProgramBinaryFileCache : "<<path<<std::endl;
+}
+
+ProgramBinaryFileCache::~ProgramBinaryFileCache()
+{
+    OSG_INFO<<"Destructed ProgramBinaryFileCache "<<std::endl;
+}
+
+std::string ProgramBinaryFileCache::createCacheFileName(const std::string& key) const
+{
+    return _programBinaryCachePath + "/" + key + ".osgpb";
+}
+
+osg::ref_ptr<osg::Program::ProgramBinary> ProgramBinaryFileCache::readProgramBinary(const std::string& key)
+{
+    std::string fileName = createCacheFileName(key);
+
+    osgDB::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!fin) return 0;
+
+    char magic[sizeof(s_programBinaryMagic)];
+    GLenum format = 0;
+    unsigned int size = 0;
+    fin.read(magic, sizeof(magic));
+    fin.read(reinterpret_cast<char*>(&format), sizeof(format));
+    fin.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!fin || memcmp(magic, s_programBinaryMagic, sizeof(magic))!=0 || size==0)
+    {
+        OSG_INFO<<"ProgramBinaryFileCache::readProgramBinary() ignoring invalid file "<<fileName<<std::endl;
+        return 0;
+    }
+
+    osg::ref_ptr<osg::Program::ProgramBinary> programBinary = new osg::Program::ProgramBinary;
+    programBinary->allocate(size);
+    programBinary->setFormat(format);
+    fin.read(reinterpret_cast<char*>(programBinary->getData()), size);
+    if (!fin)
+    {
+        OSG_INFO<<"ProgramBinaryFileCache::readProgramBinary() truncated file "<<fileName<<std::endl;
+        return 0;
+    }
+
+    return programBinary;
+}
+
+bool ProgramBinaryFileCache::writeProgramBinary(const std::string& key, const osg::Program::ProgramBinary& programBinary)
+{
+    if (programBinary.getSize()==0) return false;
+
+    std::string fileName = createCacheFileName(key);
+    if (!osgDB::makeDirectoryForFile(fileName))
+    {
+        OSG_NOTICE<<"ProgramBinaryFileCache::writeProgramBinary() could not create directory for "<<fileName<<std::endl;
+        return false;
+    }
+
+    // write to a temporary file first so that a concurrent reader never sees a partial binary.
+    std::string tmpFileName = fileName + ".tmp";
+    {
+        osgDB::ofstream fout(tmpFileName.c_str(), std::ios::out | std::ios::binary);
+        if (!fout) return false;
+
+        GLenum format = programBinary.getFormat();
+        unsigned int size = programBinary.getSize();
+        fout.write(s_programBinaryMagic, sizeof(s_programBinaryMagic));
+        fout.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        fout.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        fout.write(reinterpret_cast<const char*>(programBinary.getData()), size);
+        if (!fout)
+        {
+            OSG_NOTICE<<"ProgramBinaryFileCache::writeProgramBinary() failed writing "<<tmpFileName<<std::endl;
+            return false;
+        }
+    }
+
+    remove(fileName.c_str());
+    if (rename(tmpFileName.c_str(), fileName.c_str())!=0)
+    {
+        remove(tmpFileName.c_str());
+        return false;
+    }
+
+    OSG_INFO<<"ProgramBinaryFileCache::writeProgramBinary() written "<<fileName<<std::endl;
+    return true;
+}
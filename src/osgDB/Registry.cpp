@@ -30,6 +30,8 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/fstream>
 #include <osgDB/Archive>
+#include <osgDB/DXTCImageProcessor>
+#include <osgDB/ProgramBinaryFileCache>
 
 #include <algorithm>
 #include <set>
@@ -62,6 +64,10 @@ static osg::ApplicationUsageProxy Registry_e1(osg::ApplicationUsage::ENVIRONMENT
 #endif
 
 static osg::ApplicationUsageProxy Registry_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_BUILD_KDTREES on/off","Enable/disable the automatic building of KdTrees for each loaded Geometry.");
+static osg::ApplicationUsageProxy Registry_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_COMPRESS_IMAGES off/FASTEST/NORMAL/PRODUCTION/HIGHEST","Enable/disable S3TC compression of uncompressed images as they are read, and select the compression quality.");
+static osg::ApplicationUsageProxy Registry_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_PROGRAM_BINARY_CACHE <path>","Directory used to cache linked shader program binaries between runs.");
+static osg::ApplicationUsageProxy Registry_e5(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FILE_LOCATION_CACHE <seconds>","Cache directory listings when searching for data and library files, re-reading each listing after the specified number of seconds.");
+static osg::ApplicationUsageProxy Registry_e6(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FILE_CACHE_MAXIMUM_SIZE <megabytes>","Maximum size of the OSG_FILE_CACHE, least recently used files are removed once exceeded.");
 
 
 // from MimeTypes.cpp
@@ -243,10 +249,41 @@ Registry::Registry()
         OSG_INFO<<"Registry : Expiry delay = "<<_expiryDelay<<std::endl;
     }
 
+    _compressImagesOnRead = false;
+    _imageCompressionQuality = ImageProcessor::NORMAL;
+    _defaultImageProcessor = new DXTCImageProcessor;
+
+    if( (ptr = getenv("OSG_COMPRESS_IMAGES")) != 0)
+    {
+        std::string value(ptr);
+        _compressImagesOnRead = (value!="off" && value!="OFF" && value!="Off");
+        if (value=="FASTEST") _imageCompressionQuality = ImageProcessor::FASTEST;
+        else if (value=="PRODUCTION") _imageCompressionQuality = ImageProcessor::PRODUCTION;
+        else if (value=="HIGHEST") _imageCompressionQuality = ImageProcessor::HIGHEST;
+    }
+
     const char* fileCachePath = getenv("OSG_FILE_CACHE");
     if (fileCachePath)
     {
         _fileCache = new FileCache(fileCachePath);
+
+        const char* fileCacheMaximumSize = getenv("OSG_FILE_CACHE_MAXIMUM_SIZE");
+        if (fileCacheMaximumSize)
+        {
+            _fileCache->setMaximumCacheSize(static_cast<unsigned long long>(osg::asciiToDouble(fileCacheMaximumSize)*1024.0*1024.0));
+        }
+    }
+
+    const char* fileLocationCacheTimeToLive = getenv("OSG_FILE_LOCATION_CACHE");
+    if (fileLocationCacheTimeToLive)
+    {
+        _fileLocationCache = new FileLocationCache(osg::asciiToDouble(fileLocationCacheTimeToLive));
+    }
+
+    const char* programBinaryCachePath = getenv("OSG_PROGRAM_BINARY_CACHE");
+    if (programBinaryCachePath)
+    {
+        osg::Program::setProgramBinaryCache(new ProgramBinaryFileCache(programBinaryCachePath));
     }
 
     // assign ObjectCache.
@@ -629,7 +666,8 @@ ImageProcessor* Registry::getImageProcessor()
             return _ipList.front().get();
         }
     }
-    return getImageProcessorForExtension("nvtt");
+    ImageProcessor* ip = getImageProcessorForExtension("nvtt");
+    return ip ? ip : _defaultImageProcessor.get();
 }
 
 ImageProcessor* Registry::getImageProcessorForExtension(const std::string& ext)
@@ -929,7 +967,12 @@ struct Registry::ReadImageFunctor : public Registry::ReadFunctor
 {
     ReadImageFunctor(const std::string& filename, const Options* options):ReadFunctor(filename,options) {}
 
-    virtual ReaderWriter::ReadResult doRead(ReaderWriter& rw)const  { return rw.readImage(_filename, _options); }
+    virtual ReaderWriter::ReadResult doRead(ReaderWriter& rw)const
+    {
+        ReaderWriter::ReadResult rr = rw.readImage(_filename, _options);
+        Registry::instance()->compressImageIfRequired(rr, _filename, _options);
+        return rr;
+    }
     virtual bool isValid(ReaderWriter::ReadResult& readResult) const { return readResult.validImage(); }
     virtual bool isValid(osg::Object* object) const { return dynamic_cast<osg::Image*>(object)!=0;  }
 
@@ -1010,16 +1053,29 @@ void Registry::addArchiveExtension(const std::string ext)
     _archiveExtList.push_back(ext);
 }
 
+// use the FileLocationCache when one is assigned, otherwise query the file system directly.
+static inline bool findFileExists(FileLocationCache* fileLocationCache, const std::string& filename)
+{
+    return fileLocationCache ? fileLocationCache->fileExists(filename) : fileExists(filename);
+}
+
+static inline std::string findFileInSearchPath(FileLocationCache* fileLocationCache, const std::string& filename, const FilePathList& filePath, CaseSensitivity caseSensitivity)
+{
+    return fileLocationCache ? fileLocationCache->findFileInPath(filename, filePath, caseSensitivity) : osgDB::findFileInPath(filename, filePath, caseSensitivity);
+}
+
 std::string Registry::findDataFileImplementation(const std::string& filename, const Options* options, CaseSensitivity caseSensitivity)
 {
     if (filename.empty()) return filename;
 
+    FileLocationCache* fileLocationCache = _fileLocationCache.get();
+
     // if data file contains a server address then we can't find it in local directories so return empty string.
     if (containsServerAddress(filename)) return std::string();
 
     bool absolutePath = osgDB::isAbsolutePath(filename);
 
-    if (absolutePath && fileExists(filename))
+    if (absolutePath && findFileExists(fileLocationCache, filename))
     {
         OSG_DEBUG << "FindFileInPath(" << filename << "): returning " << filename << std::endl;
         return filename;
@@ -1030,7 +1086,7 @@ std::string Registry::findDataFileImplementation(const std::string& filename, co
 
     if (options && !options->getDatabasePathList().empty())
     {
-        fileFound = findFileInPath(filename, options->getDatabasePathList(), caseSensitivity);
+        fileFound = findFileInSearchPath(fileLocationCache, filename, options->getDatabasePathList(), caseSensitivity);
         if (!fileFound.empty()) return fileFound;
 
         if (osgDB::containsCurrentWorkingDirectoryReference(options->getDatabasePathList()))
@@ -1043,7 +1099,7 @@ std::string Registry::findDataFileImplementation(const std::string& filename, co
     const FilePathList& filepaths = Registry::instance()->getDataFilePathList();
     if (!filepaths.empty())
     {
-        fileFound = findFileInPath(filename, filepaths, caseSensitivity);
+        fileFound = findFileInSearchPath(fileLocationCache, filename, filepaths, caseSensitivity);
         if (!fileFound.empty()) return fileFound;
 
         if (!pathsContainsCurrentWorkingDirectory && osgDB::containsCurrentWorkingDirectoryReference(filepaths))
@@ -1055,7 +1111,7 @@ std::string Registry::findDataFileImplementation(const std::string& filename, co
     if (!absolutePath && !pathsContainsCurrentWorkingDirectory)
     {
         // check current working directory
-        if (fileExists(filename))
+        if (findFileExists(fileLocationCache, filename))
         {
             return filename;
         }
@@ -1067,7 +1123,7 @@ std::string Registry::findDataFileImplementation(const std::string& filename, co
     if (simpleFileName!=filename)
     {
 
-        if(fileExists(simpleFileName))
+        if(findFileExists(fileLocationCache, simpleFileName))
         {
             OSG_DEBUG << "FindFileInPath(" << filename << "): returning " << simpleFileName << std::endl;
             return simpleFileName;
@@ -1075,13 +1131,13 @@ std::string Registry::findDataFileImplementation(const std::string& filename, co
 
         if (options && !options->getDatabasePathList().empty())
         {
-            fileFound = findFileInPath(simpleFileName, options->getDatabasePathList(), caseSensitivity);
+            fileFound = findFileInSearchPath(fileLocationCache, simpleFileName, options->getDatabasePathList(), caseSensitivity);
             if (!fileFound.empty()) return fileFound;
         }
 
         if (!filepaths.empty())
         {
-            fileFound = findFileInPath(simpleFileName, filepaths,caseSensitivity);
+            fileFound = findFileInSearchPath(fileLocationCache, simpleFileName, filepaths,caseSensitivity);
             if (!fileFound.empty()) return fileFound;
         }
 
@@ -1096,14 +1152,16 @@ std::string Registry::findLibraryFileImplementation(const std::string& filename,
     if (filename.empty())
         return filename;
 
+    FileLocationCache* fileLocationCache = _fileLocationCache.get();
+
     const FilePathList& filepath = Registry::instance()->getLibraryFilePathList();
 
 
-    std::string fileFound = findFileInPath(filename, filepath,caseSensitivity);
+    std::string fileFound = findFileInSearchPath(fileLocationCache, filename, filepath,caseSensitivity);
     if (!fileFound.empty())
         return fileFound;
 
-    if(fileExists(filename))
+    if(findFileExists(fileLocationCache, filename))
     {
         OSG_DEBUG << "FindFileInPath(" << filename << "): returning " << filename << std::endl;
         return filename;
@@ -1113,7 +1171,7 @@ std::string Registry::findLibraryFileImplementation(const std::string& filename,
     std::string simpleFileName = getSimpleFileName(filename);
     if (simpleFileName!=filename)
     {
-        fileFound = findFileInPath(simpleFileName, filepath,caseSensitivity);
+        fileFound = findFileInSearchPath(fileLocationCache, simpleFileName, filepath,caseSensitivity);
         if (!fileFound.empty()) return fileFound;
     }
 
@@ -1364,8 +1422,63 @@ ReaderWriter::WriteResult Registry::writeObjectImplementation(const Object& obj,
 
 
 
+static std::string createCompressedImageCacheName(const std::string& fileName, ImageProcessor::CompressionQuality quality)
+{
+    switch(quality)
+    {
+        case(ImageProcessor::FASTEST): return fileName + ".fastest.dds";
+        case(ImageProcessor::PRODUCTION): return fileName + ".production.dds";
+        case(ImageProcessor::HIGHEST): return fileName + ".highest.dds";
+        default: return fileName + ".normal.dds";
+    }
+}
+
+void Registry::compressImageIfRequired(ReaderWriter::ReadResult& result, const std::string& fileName, const Options* options)
+{
+    if (!options || options->getCompressImagesHint()!=Options::COMPRESS_IMAGES || !result.validImage()) return;
+
+    osg::Image* image = result.getImage();
+    if (!DXTCImageProcessor::isImageCompressible(*image)) return;
+
+    osg::ref_ptr<ImageProcessor> ip;
+    {
+        OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+        ip = _ipList.empty() ? _defaultImageProcessor.get() : _ipList.front().get();
+    }
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    // generate the mipmaps up front as drivers can't reliably generate mipmaps for compressed textures
+    ip->compress(*image, osg::Texture::USE_ARB_COMPRESSION, true, false, ImageProcessor::USE_CPU, _imageCompressionQuality);
+    if (!image->isCompressed()) return;
+
+    OSG_INFO<<"Registry::compressImageIfRequired("<<fileName<<") compressed in "<<osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())<<"ms"<<std::endl;
+
+    if (_fileCache.valid())
+    {
+        std::string cacheFileName = createCompressedImageCacheName(fileName, _imageCompressionQuality);
+        _fileCache->writeImage(*image, cacheFileName, options);
+    }
+}
+
 ReaderWriter::ReadResult Registry::readImageImplementation(const std::string& fileName,const Options* options)
 {
+    if (options && options->getCompressImagesHint()==Options::COMPRESS_IMAGES && _fileCache.valid() &&
+        fileName.compare(0, _fileCache->getFileCachePath().size(), _fileCache->getFileCachePath())!=0)
+    {
+        std::string cacheFileName = createCompressedImageCacheName(fileName, _imageCompressionQuality);
+        // read directly rather than checking existsInCache() first, so a missing image is only counted as one miss.
+        if (!_fileCache->isCachedFileBlackListed(cacheFileName))
+        {
+            ReaderWriter::ReadResult rr = _fileCache->readImage(cacheFileName, options);
+            if (rr.validImage())
+            {
+                rr.getImage()->setFileName(fileName);
+                return rr;
+            }
+        }
+    }
+
     return readImplementation(ReadImageFunctor(fileName, options),Options::CACHE_IMAGES);
 }
 
@@ -1466,7 +1579,17 @@ ReaderWriter::ReadResult Registry::readNodeImplementation(const std::string& fil
 
 #else
 
-    return readImplementation(ReadNodeFunctor(fileName, options),Options::CACHE_NODES);
+    // pass the compression preference on to the texture images the loader reads.
+    osg::ref_ptr<const Options> nodeOptions = options;
+    if (_compressImagesOnRead && (!options || options->getCompressImagesHint()==Options::COMPRESS_IMAGES_NO_PREFERENCE))
+    {
+        const Options* baseOptions = options ? options : _options.get();
+        osg::ref_ptr<Options> compressOptions = baseOptions ? baseOptions->cloneOptions() : new Options;
+        compressOptions->setCompressImagesHint(Options::COMPRESS_IMAGES);
+        nodeOptions = compressOptions.get();
+    }
+
+    return readImplementation(ReadNodeFunctor(fileName, nodeOptions.get()),Options::CACHE_NODES);
 
 #endif
 }
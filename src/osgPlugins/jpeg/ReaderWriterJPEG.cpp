@@ -7,6 +7,7 @@
 #include <osgDB/Registry>
 #include <osgDB/FileNameUtils>
 #include <osgDB/FileUtils>
+#include <osgDB/ImageBufferPool>
 
 #include <sstream>
 
@@ -466,7 +467,9 @@ unsigned char* simage_jpeg_load(std::istream& fin,
                                 int *width_ret,
                                 int *height_ret,
                                 int *numComponents_ret,
-                                unsigned int* exif_orientation)
+                                unsigned int* exif_orientation,
+                                osgDB::ImageBufferPool* pool,
+                                osg::Image** pooledImage_ret)
 {
     int width;
     int height;
@@ -516,6 +519,11 @@ unsigned char* simage_jpeg_load(std::istream& fin,
         jpeg_destroy_decompress(&cinfo);
         //fclose(infile);
         //if (buffer) delete [] buffer;
+        if (*pooledImage_ret)
+        {
+            (*pooledImage_ret)->unref();
+            *pooledImage_ret = NULL;
+        }
         return NULL;
     }
 
@@ -586,7 +594,19 @@ unsigned char* simage_jpeg_load(std::istream& fin,
         ((j_common_ptr) &cinfo, JPOOL_IMAGE, row_stride, 1);
     width = cinfo.output_width;
     height = cinfo.output_height;
-    buffer = currPtr = new unsigned char [width*height*cinfo.output_components];
+    if (pool)
+    {
+        // decode straight into a recycled image, the caller takes over the reference.
+        // the pool doesn't keep a reference to images allocated once it is full, so hold one before returning the pointer.
+        osg::ref_ptr<osg::Image> pooledImage = pool->allocateImage(width, height, 1, format==1 ? GL_LUMINANCE : GL_RGB, GL_UNSIGNED_BYTE, 1);
+        pooledImage->ref();
+        *pooledImage_ret = pooledImage.get();
+        buffer = currPtr = pooledImage->data();
+    }
+    else
+    {
+        buffer = currPtr = new unsigned char [width*height*cinfo.output_components];
+    }
 
     /* Step 6: while (scan lines remain to be read) */
     /*           jpeg_read_scanlines(...); */
@@ -826,15 +846,17 @@ class ReaderWriterJPEG : public osgDB::ReaderWriter
 
         virtual const char* className() const { return "JPEG Image Reader/Writer"; }
 
-        ReadResult readJPGStream(std::istream& fin) const
+        ReadResult readJPGStream(std::istream& fin, const osgDB::ReaderWriter::Options* options=NULL) const
         {
             unsigned char *imageData = NULL;
             int width_ret;
             int height_ret;
             int numComponents_ret;
             unsigned int exif_orientation=0;
+            osg::Image* pooledImage = NULL;
 
-            imageData = osgDBJPEG::simage_jpeg_load(fin, &width_ret, &height_ret, &numComponents_ret, &exif_orientation);
+            imageData = osgDBJPEG::simage_jpeg_load(fin, &width_ret, &height_ret, &numComponents_ret, &exif_orientation,
+                                                    osgDB::ImageBufferPool::getImageBufferPool(options), &pooledImage);
 
             if (imageData==NULL) return ReadResult::ERROR_IN_READING_FILE;
 
@@ -857,13 +879,23 @@ class ReaderWriterJPEG : public osgDB::ReaderWriter
 
             unsigned int dataType = GL_UNSIGNED_BYTE;
 
-            osg::ref_ptr<osg::Image> pOsgImage = new osg::Image;
-            pOsgImage->setImage(s,t,r,
-                internalFormat,
-                pixelFormat,
-                dataType,
-                imageData,
-                osg::Image::USE_NEW_DELETE);
+            osg::ref_ptr<osg::Image> pOsgImage;
+            if (pooledImage)
+            {
+                pOsgImage = pooledImage;
+                pooledImage->unref();
+                pOsgImage->setInternalTextureFormat(internalFormat);
+            }
+            else
+            {
+                pOsgImage = new osg::Image;
+                pOsgImage->setImage(s,t,r,
+                    internalFormat,
+                    pixelFormat,
+                    dataType,
+                    imageData,
+                    osg::Image::USE_NEW_DELETE);
+            }
 
             if (exif_orientation>0)
             {
@@ -946,9 +978,9 @@ class ReaderWriterJPEG : public osgDB::ReaderWriter
             return readImage(file, options);
         }
 
-        virtual ReadResult readImage(std::istream& fin,const osgDB::ReaderWriter::Options* =NULL) const
+        virtual ReadResult readImage(std::istream& fin,const osgDB::ReaderWriter::Options* options =NULL) const
         {
-            return readJPGStream(fin);
+            return readJPGStream(fin, options);
         }
 
         virtual ReadResult readImage(const std::string& file, const osgDB::ReaderWriter::Options* options) const
@@ -961,7 +993,7 @@ class ReaderWriterJPEG : public osgDB::ReaderWriter
 
             osgDB::ifstream istream(fileName.c_str(), std::ios::in | std::ios::binary);
             if(!istream) return ReadResult::ERROR_IN_READING_FILE;
-            ReadResult rr = readJPGStream(istream);
+            ReadResult rr = readJPGStream(istream, options);
             if(rr.validImage()) rr.getImage()->setFileName(file);
             return rr;
         }
@@ -2192,10 +2192,23 @@ public:
     virtual void apply(osg::BoundingSphered& value) { if (_lse->getValue(_index, value)) { _success=true; } }
 };
 
+const osgDB::ClassInterface::PropertyHandle& LuaScriptEngine::getPropertyHandle(const osg::Object* object, const std::string& propertyName) const
+{
+    PropertyHandleMap& handles = _propertyHandles[ClassKey(object->libraryName(), object->className())];
+    PropertyHandleMap::iterator itr = handles.find(propertyName);
+    if (itr!=handles.end()) return itr->second;
+
+    osgDB::ClassInterface::PropertyHandle& handle = handles[propertyName];
+    _ci.getPropertyHandle(object, propertyName, handle);
+    return handle;
+}
+
 int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string& propertyName) const
 {
-    osgDB::BaseSerializer::Type type;
-    if (!_ci.getPropertyType(object, propertyName, type))
+    const osgDB::ClassInterface::PropertyHandle& handle = getPropertyHandle(object, propertyName);
+
+    osgDB::BaseSerializer::Type type = handle.type;
+    if (!handle.valid() && !_ci.getPropertyType(object, propertyName, type))
     {
         if (_ci.hasMethod(object, propertyName))
         {
@@ -2228,7 +2241,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_BOOL):
         {
             bool value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 lua_pushboolean(_lua, value ? 1 : 0);
                 return 1;
@@ -2238,7 +2251,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_STRING):
         {
             std::string value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 lua_pushstring(_lua, value.c_str());
                 return 1;
@@ -2248,7 +2261,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_GLENUM):
         {
             GLenum value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 std::string enumString = lookUpGLenumString(value);
                 lua_pushstring(_lua, enumString.c_str());
@@ -2259,10 +2272,9 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_ENUM):
         {
             int value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
-                osgDB::BaseSerializer* serializer = _ci.getSerializer(object, propertyName, type);
-                osgDB::IntLookup* lookup = serializer ? serializer->getIntLookup() : 0;
+                osgDB::IntLookup* lookup = handle.valid() ? handle.serializer->getIntLookup() : 0;
                 if (lookup)
                 {
                     std::string enumString = lookup->getString(value);
@@ -2279,7 +2291,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_SHORT):
         {
             short value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 lua_pushinteger(_lua, value);
                 return 1;
@@ -2289,7 +2301,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_USHORT):
         {
             unsigned short value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 lua_pushinteger(_lua, value);
                 return 1;
@@ -2299,7 +2311,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_INT):
         {
             int value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 lua_pushinteger(_lua, value);
                 return 1;
@@ -2309,7 +2321,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_UINT):
         {
             unsigned int value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 lua_pushinteger(_lua, value);
                 return 1;
@@ -2319,7 +2331,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_FLOAT):
         {
             float value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 lua_pushnumber(_lua, value);
                 return 1;
@@ -2329,7 +2341,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_DOUBLE):
         {
             double value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 lua_pushnumber(_lua, value);
                 return 1;
@@ -2337,40 +2349,40 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
             break;
         }
 
-        case(osgDB::BaseSerializer::RW_VEC2B): if (getPropertyAndPushValue<osg::Vec2b>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC3B): if (getPropertyAndPushValue<osg::Vec3b>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC4B): if (getPropertyAndPushValue<osg::Vec4b>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC2B): if (getPropertyAndPushValue<osg::Vec2b>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC3B): if (getPropertyAndPushValue<osg::Vec3b>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC4B): if (getPropertyAndPushValue<osg::Vec4b>(object, handle)) return 1; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2UB): if (getPropertyAndPushValue<osg::Vec2ub>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC3UB): if (getPropertyAndPushValue<osg::Vec3ub>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC4UB): if (getPropertyAndPushValue<osg::Vec4ub>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC2UB): if (getPropertyAndPushValue<osg::Vec2ub>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC3UB): if (getPropertyAndPushValue<osg::Vec3ub>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC4UB): if (getPropertyAndPushValue<osg::Vec4ub>(object, handle)) return 1; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2S): if (getPropertyAndPushValue<osg::Vec2s>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC3S): if (getPropertyAndPushValue<osg::Vec3s>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC4S): if (getPropertyAndPushValue<osg::Vec4s>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC2S): if (getPropertyAndPushValue<osg::Vec2s>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC3S): if (getPropertyAndPushValue<osg::Vec3s>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC4S): if (getPropertyAndPushValue<osg::Vec4s>(object, handle)) return 1; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2US): if (getPropertyAndPushValue<osg::Vec2us>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC3US): if (getPropertyAndPushValue<osg::Vec3us>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC4US): if (getPropertyAndPushValue<osg::Vec4us>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC2US): if (getPropertyAndPushValue<osg::Vec2us>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC3US): if (getPropertyAndPushValue<osg::Vec3us>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC4US): if (getPropertyAndPushValue<osg::Vec4us>(object, handle)) return 1; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2I): if (getPropertyAndPushValue<osg::Vec2i>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC3I): if (getPropertyAndPushValue<osg::Vec3i>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC4I): if (getPropertyAndPushValue<osg::Vec4i>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC2I): if (getPropertyAndPushValue<osg::Vec2i>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC3I): if (getPropertyAndPushValue<osg::Vec3i>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC4I): if (getPropertyAndPushValue<osg::Vec4i>(object, handle)) return 1; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2UI): if (getPropertyAndPushValue<osg::Vec2ui>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC3UI): if (getPropertyAndPushValue<osg::Vec3ui>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC4UI): if (getPropertyAndPushValue<osg::Vec4ui>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC2UI): if (getPropertyAndPushValue<osg::Vec2ui>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC3UI): if (getPropertyAndPushValue<osg::Vec3ui>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC4UI): if (getPropertyAndPushValue<osg::Vec4ui>(object, handle)) return 1; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2F): if (getPropertyAndPushValue<osg::Vec2f>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC3F): if (getPropertyAndPushValue<osg::Vec3f>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC4F): if (getPropertyAndPushValue<osg::Vec4f>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC2F): if (getPropertyAndPushValue<osg::Vec2f>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC3F): if (getPropertyAndPushValue<osg::Vec3f>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC4F): if (getPropertyAndPushValue<osg::Vec4f>(object, handle)) return 1; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2D): if (getPropertyAndPushValue<osg::Vec2d>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC3D): if (getPropertyAndPushValue<osg::Vec3d>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_VEC4D): if (getPropertyAndPushValue<osg::Vec4d>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC2D): if (getPropertyAndPushValue<osg::Vec2d>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC3D): if (getPropertyAndPushValue<osg::Vec3d>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_VEC4D): if (getPropertyAndPushValue<osg::Vec4d>(object, handle)) return 1; break;
 
-        case(osgDB::BaseSerializer::RW_QUAT): if (getPropertyAndPushValue<osg::Quat>(object, propertyName)) return 1; break;
-        case(osgDB::BaseSerializer::RW_PLANE): if (getPropertyAndPushValue<osg::Plane>(object, propertyName)) return 1; break;
+        case(osgDB::BaseSerializer::RW_QUAT): if (getPropertyAndPushValue<osg::Quat>(object, handle)) return 1; break;
+        case(osgDB::BaseSerializer::RW_PLANE): if (getPropertyAndPushValue<osg::Plane>(object, handle)) return 1; break;
 
         #ifdef OSG_USE_FLOAT_MATRIX
         case(osgDB::BaseSerializer::RW_MATRIX):
@@ -2378,7 +2390,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_MATRIXF):
         {
             osg::Matrixf value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 pushValue(value);
                 return 1;
@@ -2391,7 +2403,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_MATRIXD):
         {
             osg::Matrixd value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 pushValue(value);
                 return 1;
@@ -2401,7 +2413,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_BOUNDINGBOXF):
         {
             osg::BoundingBoxf value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 pushValue(value);
                 return 1;
@@ -2411,7 +2423,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_BOUNDINGBOXD):
         {
             osg::BoundingBoxd value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 pushValue(value);
                 return 1;
@@ -2421,7 +2433,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_BOUNDINGSPHEREF):
         {
             osg::BoundingSpheref value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 pushValue(value);
                 return 1;
@@ -2431,7 +2443,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_BOUNDINGSPHERED):
         {
             osg::BoundingSphered value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 pushValue(value);
                 return 1;
@@ -2447,7 +2459,7 @@ int LuaScriptEngine::pushPropertyToStack(osg::Object* object, const std::string&
         case(osgDB::BaseSerializer::RW_OBJECT):
         {
             osg::Object* value = 0;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 pushObject(value);
                 return 1;
@@ -3019,8 +3031,10 @@ int LuaScriptEngine::getDataFromStack(SerializerScratchPad* ssp, osgDB::BaseSeri
 
 int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string& propertyName) const
 {
-    osgDB::BaseSerializer::Type type;
-    if (!_ci.getPropertyType(object, propertyName, type))
+    const osgDB::ClassInterface::PropertyHandle& handle = getPropertyHandle(object, propertyName);
+
+    osgDB::BaseSerializer::Type type = handle.type;
+    if (!handle.valid() && !_ci.getPropertyType(object, propertyName, type))
     {
         if (lua_type(_lua,-1)==LUA_TFUNCTION)
         {
@@ -3044,23 +3058,25 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         type = LuaScriptEngine::getType(-1);
     }
 
-    return setPropertyFromStack(object, propertyName, type);
+    return setPropertyFromStack(object, handle, type);
 }
 
-int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string& propertyName, osgDB::BaseSerializer::Type type) const
+int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const osgDB::ClassInterface::PropertyHandle& handle, osgDB::BaseSerializer::Type type) const
 {
+    const std::string& propertyName = handle.name;
+
     switch(type)
     {
         case(osgDB::BaseSerializer::RW_BOOL):
         {
             if (lua_isboolean(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<bool>(lua_toboolean(_lua, -1)!=0));
+                _ci.setProperty(object, handle, static_cast<bool>(lua_toboolean(_lua, -1)!=0));
                 return 0;
             }
             else if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<bool>(lua_tonumber(_lua, -1)!=0));
+                _ci.setProperty(object, handle, static_cast<bool>(lua_tonumber(_lua, -1)!=0));
                 return 0;
             }
             break;
@@ -3069,7 +3085,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isstring(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, std::string(lua_tostring(_lua, -1)));
+                _ci.setProperty(object, handle, std::string(lua_tostring(_lua, -1)));
                 return 0;
             }
             break;
@@ -3078,7 +3094,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<GLenum>(lua_tonumber(_lua, -1)));
+                _ci.setProperty(object, handle, static_cast<GLenum>(lua_tonumber(_lua, -1)));
                 return 0;
             }
             else if (lua_isstring(_lua, -1))
@@ -3086,7 +3102,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
                 const char* enumString = lua_tostring(_lua, -1);
                 GLenum value = lookUpGLenumValue(enumString); //getValue("GL",enumString);
 
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return 0;
             }
             OSG_NOTICE<<"LuaScriptEngine::setPropertyFromStack("<<propertyName<<") osgDB::BaseSerializer::RW_GLENUM Failed"<<std::endl;
@@ -3096,18 +3112,17 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<int>(lua_tonumber(_lua, -1)));
+                _ci.setProperty(object, handle, static_cast<int>(lua_tonumber(_lua, -1)));
                 return 0;
             }
             else if (lua_isstring(_lua, -1))
             {
                 const char* enumString = lua_tostring(_lua, -1);
-                osgDB::BaseSerializer* serializer = _ci.getSerializer(object, propertyName, type);
-                osgDB::IntLookup* lookup = serializer ? serializer->getIntLookup() : 0;
+                osgDB::IntLookup* lookup = handle.valid() ? handle.serializer->getIntLookup() : 0;
                 if (lookup)
                 {
                     int value = lookup->getValue(enumString);
-                    _ci.setProperty(object, propertyName, value);
+                    _ci.setProperty(object, handle, value);
                 }
                 return 0;
             }
@@ -3117,7 +3132,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<short>(lua_tonumber(_lua, -1)));
+                _ci.setProperty(object, handle, static_cast<short>(lua_tonumber(_lua, -1)));
                 return 0;
             }
             break;
@@ -3126,7 +3141,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<unsigned short>(lua_tonumber(_lua, -1)));
+                _ci.setProperty(object, handle, static_cast<unsigned short>(lua_tonumber(_lua, -1)));
                 return 0;
             }
             break;
@@ -3135,7 +3150,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<int>(lua_tonumber(_lua, -1)));
+                _ci.setProperty(object, handle, static_cast<int>(lua_tonumber(_lua, -1)));
                 return 0;
             }
             break;
@@ -3144,7 +3159,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<unsigned int>(lua_tonumber(_lua, -1)));
+                _ci.setProperty(object, handle, static_cast<unsigned int>(lua_tonumber(_lua, -1)));
                 return 0;
             }
             break;
@@ -3153,7 +3168,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<float>(lua_tonumber(_lua, -1)));
+                _ci.setProperty(object, handle, static_cast<float>(lua_tonumber(_lua, -1)));
                 return 0;
             }
             break;
@@ -3162,30 +3177,30 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
         {
             if (lua_isnumber(_lua, -1))
             {
-                _ci.setProperty(object, propertyName, static_cast<double>(lua_tonumber(_lua, -1)));
+                _ci.setProperty(object, handle, static_cast<double>(lua_tonumber(_lua, -1)));
                 return 0;
             }
             break;
         }
 
-        case(osgDB::BaseSerializer::RW_VEC2B): if (getValueAndSetProperty<osg::Vec2b>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_VEC3B): if (getValueAndSetProperty<osg::Vec3b>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_VEC4B): if (getValueAndSetProperty<osg::Vec4b>(object, propertyName)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC2B): if (getValueAndSetProperty<osg::Vec2b>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC3B): if (getValueAndSetProperty<osg::Vec3b>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC4B): if (getValueAndSetProperty<osg::Vec4b>(object, handle)) return 0; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2UB): if (getValueAndSetProperty<osg::Vec2ub>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_VEC3UB): if (getValueAndSetProperty<osg::Vec3ub>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_VEC4UB): if (getValueAndSetProperty<osg::Vec4ub>(object, propertyName)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC2UB): if (getValueAndSetProperty<osg::Vec2ub>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC3UB): if (getValueAndSetProperty<osg::Vec3ub>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC4UB): if (getValueAndSetProperty<osg::Vec4ub>(object, handle)) return 0; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2F): if (getValueAndSetProperty<osg::Vec2f>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_VEC3F): if (getValueAndSetProperty<osg::Vec3f>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_VEC4F): if (getValueAndSetProperty<osg::Vec4f>(object, propertyName)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC2F): if (getValueAndSetProperty<osg::Vec2f>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC3F): if (getValueAndSetProperty<osg::Vec3f>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC4F): if (getValueAndSetProperty<osg::Vec4f>(object, handle)) return 0; break;
 
-        case(osgDB::BaseSerializer::RW_VEC2D): if (getValueAndSetProperty<osg::Vec2d>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_VEC3D): if (getValueAndSetProperty<osg::Vec3d>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_VEC4D): if (getValueAndSetProperty<osg::Vec4d>(object, propertyName)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC2D): if (getValueAndSetProperty<osg::Vec2d>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC3D): if (getValueAndSetProperty<osg::Vec3d>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_VEC4D): if (getValueAndSetProperty<osg::Vec4d>(object, handle)) return 0; break;
 
-        case(osgDB::BaseSerializer::RW_QUAT): if (getValueAndSetProperty<osg::Quat>(object, propertyName)) return 0; break;
-        case(osgDB::BaseSerializer::RW_PLANE): if (getValueAndSetProperty<osg::Plane>(object, propertyName)) return 0; break;
+        case(osgDB::BaseSerializer::RW_QUAT): if (getValueAndSetProperty<osg::Quat>(object, handle)) return 0; break;
+        case(osgDB::BaseSerializer::RW_PLANE): if (getValueAndSetProperty<osg::Plane>(object, handle)) return 0; break;
 
 #ifdef OSG_USE_FLOAT_MATRIX
         case(osgDB::BaseSerializer::RW_MATRIX):
@@ -3195,7 +3210,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
             osg::Matrixd value;
             if (getValue(-1, value))
             {
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return 0;
             }
             break;
@@ -3208,7 +3223,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
             osg::Matrixd value;
             if (getValue(-1, value))
             {
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return 0;
             }
             break;
@@ -3218,7 +3233,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
             osg::BoundingBoxf value;
             if (getValue(-1, value))
             {
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return 0;
             }
             break;
@@ -3228,7 +3243,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
             osg::BoundingBoxd value;
             if (getValue(-1, value))
             {
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return 0;
             }
             break;
@@ -3238,7 +3253,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
             osg::BoundingSpheref value;
             if (getValue(-1, value))
             {
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return 0;
             }
             break;
@@ -3248,7 +3263,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
             osg::BoundingSphered value;
             if (getValue(-1, value))
             {
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return 0;
             }
             break;
@@ -3266,7 +3281,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
 
                 if (value)
                 {
-                    _ci.setProperty(object, propertyName, value);
+                    _ci.setProperty(object, handle, value);
                     return 0;
                 }
                 else
@@ -3279,7 +3294,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
                 int ref = luaL_ref(_lua, LUA_REGISTRYINDEX);
                 osg::ref_ptr<LuaCallbackObject> lco = new LuaCallbackObject(propertyName, this, ref);
                 osg::Object* value = lco.get();
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
 
                 return 0;
             }
@@ -3287,7 +3302,7 @@ int LuaScriptEngine::setPropertyFromStack(osg::Object* object, const std::string
             {
                 OSG_NOTICE<<"Assigning property object (nil) to to object "<<object->className()<<"::"<<propertyName<<std::endl;
                 osg::Object* value = 0;
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return 0;
             }
             else
@@ -130,7 +130,10 @@ class LuaScriptEngine : public osg::ScriptEngine
 
         int pushPropertyToStack(osg::Object* object, const std::string& propertyName) const;
         int setPropertyFromStack(osg::Object* object, const std::string& propertyName) const;
-        int setPropertyFromStack(osg::Object* object, const std::string& propertyName, osgDB::BaseSerializer::Type type) const;
+        int setPropertyFromStack(osg::Object* object, const osgDB::ClassInterface::PropertyHandle& handle, osgDB::BaseSerializer::Type type) const;
+
+        /** get the ClassInterface::PropertyHandle for the object's class and property, resolved on first use and cached per class.*/
+        const osgDB::ClassInterface::PropertyHandle& getPropertyHandle(const osg::Object* object, const std::string& propertyName) const;
 
         bool loadScript(osg::Script* script);
 
@@ -229,12 +232,12 @@ class LuaScriptEngine : public osg::ScriptEngine
 
 
         template<typename T>
-        bool getValueAndSetProperty(osg::Object* object, const std::string& propertyName) const
+        bool getValueAndSetProperty(osg::Object* object, const osgDB::ClassInterface::PropertyHandle& handle) const
         {
             T value;
             if (getValue(-1, value))
             {
-                _ci.setProperty(object, propertyName, value);
+                _ci.setProperty(object, handle, value);
                 return true;
             }
             return false;
@@ -250,10 +253,10 @@ class LuaScriptEngine : public osg::ScriptEngine
 
 
         template<typename T>
-        bool getPropertyAndPushValue(const osg::Object* object, const std::string& propertyName) const
+        bool getPropertyAndPushValue(const osg::Object* object, const osgDB::ClassInterface::PropertyHandle& handle) const
         {
             T value;
-            if (_ci.getProperty(object, propertyName, value))
+            if (_ci.getProperty(object, handle, value))
             {
                 pushValue(value);
                 return true;
@@ -430,6 +433,12 @@ class LuaScriptEngine : public osg::ScriptEngine
         ScriptMap _loadedScripts;
 
         mutable osgDB::ClassInterface _ci;
+
+        // property handles cached per class, keyed on the libraryName()/className() strings of the class
+        typedef std::pair<const char*, const char*> ClassKey;
+        typedef std::map<std::string, osgDB::ClassInterface::PropertyHandle> PropertyHandleMap;
+        typedef std::map<ClassKey, PropertyHandleMap> ClassPropertyHandleMap;
+        mutable ClassPropertyHandleMap _propertyHandles;
 };
 
 
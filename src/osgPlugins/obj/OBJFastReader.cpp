@@ -0,0 +1,883 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2004 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include "OBJFastReader.h"
+
+#include <osg/Notify>
+#include <osg/Timer>
+
+#include <osgDB/FileUtils>
+#include <osgDB/fstream>
+
+#include <OpenThreads/Thread>
+
+#include <string.h>
+
+#if !defined(_WIN32) || defined(__CYGWIN__)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define OBJ_USE_MMAP
+#endif
+
+using namespace obj;
+
+namespace
+{
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Read only view of a whole file, memory mapped where available.
+//
+class MappedFile
+{
+public:
+
+    MappedFile():
+        _data(0),
+        _size(0) {}
+
+    ~MappedFile()
+    {
+#ifdef OBJ_USE_MMAP
+        if (_data && _size>0) munmap(const_cast<char*>(_data), _size);
+#endif
+    }
+
+    bool open(const std::string& fileName)
+    {
+#ifdef OBJ_USE_MMAP
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd<0) return false;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat)!=0 || fileStat.st_size==0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* ptr = mmap(0, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (ptr==MAP_FAILED) return false;
+
+        madvise(ptr, fileStat.st_size, MADV_SEQUENTIAL);
+
+        _data = static_cast<const char*>(ptr);
+        _size = fileStat.st_size;
+        return true;
+#else
+        osgDB::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+        if (!fin) return false;
+
+        fin.seekg(0, std::ios::end);
+        std::streamoff length = fin.tellg();
+        fin.seekg(0, std::ios::beg);
+        if (length<=0) return false;
+
+        _buffer.resize(static_cast<size_t>(length));
+        fin.read(&_buffer[0], length);
+
+        _data = &_buffer[0];
+        _size = _buffer.size();
+        return true;
+#endif
+    }
+
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+protected:
+
+    const char*         _data;
+    size_t              _size;
+#ifndef OBJ_USE_MMAP
+    std::vector<char>   _buffer;
+#endif
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Hand written number parsing, sscanf is locale aware and far too slow for large files.
+//
+inline bool isSpace(char c) { return c==' ' || c=='\t'; }
+
+inline const char* skipSpace(const char* ptr, const char* end)
+{
+    while(ptr<end && isSpace(*ptr)) ++ptr;
+    return ptr;
+}
+
+bool parseFloat(const char*& ptr, const char* end, float& value)
+{
+    static const double s_powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    const char* p = skipSpace(ptr, end);
+
+    bool negative = false;
+    if (p<end && (*p=='-' || *p=='+'))
+    {
+        negative = (*p=='-');
+        ++p;
+    }
+
+    double mantissa = 0.0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    while(p<end && *p>='0' && *p<='9')
+    {
+        mantissa = mantissa*10.0 + double(*p-'0');
+        hasDigits = true;
+        ++p;
+    }
+
+    if (p<end && *p=='.')
+    {
+        ++p;
+        while(p<end && *p>='0' && *p<='9')
+        {
+            mantissa = mantissa*10.0 + double(*p-'0');
+            --exponent;
+            hasDigits = true;
+            ++p;
+        }
+    }
+
+    if (!hasDigits) return false;
+
+    if (p<end && (*p=='e' || *p=='E'))
+    {
+        const char* e = p+1;
+        bool negativeExponent = false;
+        if (e<end && (*e=='-' || *e=='+'))
+        {
+            negativeExponent = (*e=='-');
+            ++e;
+        }
+        if (e<end && *e>='0' && *e<='9')
+        {
+            int explicitExponent = 0;
+            while(e<end && *e>='0' && *e<='9')
+            {
+                explicitExponent = explicitExponent*10 + (*e-'0');
+                ++e;
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            p = e;
+        }
+    }
+
+    while(exponent>22) { mantissa *= 1e22; exponent -= 22; }
+    while(exponent<-22) { mantissa /= 1e22; exponent += 22; }
+    if (exponent>=0) mantissa *= s_powersOfTen[exponent];
+    else mantissa /= s_powersOfTen[-exponent];
+
+    value = static_cast<float>(negative ? -mantissa : mantissa);
+    ptr = p;
+    return true;
+}
+
+bool parseInt(const char*& ptr, const char* end, int& value)
+{
+    const char* p = ptr;
+    bool negative = false;
+    if (p<end && (*p=='-' || *p=='+'))
+    {
+        negative = (*p=='-');
+        ++p;
+    }
+    if (p>=end || *p<'0' || *p>'9') return false;
+
+    int v = 0;
+    while(p<end && *p>='0' && *p<='9')
+    {
+        v = v*10 + (*p-'0');
+        ++p;
+    }
+    value = negative ? -v : v;
+    ptr = p;
+    return true;
+}
+
+inline int parseHexByte(const char* ptr)
+{
+    int value = 0;
+    for(int i=0; i<2; ++i)
+    {
+        char c = ptr[i];
+        value *= 16;
+        if (c>='0' && c<='9') value += c-'0';
+        else if (c>='a' && c<='f') value += c-'a'+10;
+        else if (c>='A' && c<='F') value += c-'A'+10;
+    }
+    return value;
+}
+
+std::string trimmedString(const char* begin, const char* end)
+{
+    begin = skipSpace(begin, end);
+    while(end>begin && isSpace(*(end-1))) --end;
+    return std::string(begin, end);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Per chunk parse results. Face indices are kept as written in the file, relative (negative)
+// indices are resolved during the merge once the number of vertices in earlier chunks is known.
+//
+struct Record
+{
+    enum Type
+    {
+        POINTS,
+        POLYLINE,
+        POLYGON,
+        USEMTL,
+        MTLLIB,
+        OBJECT,
+        GROUP,
+        SMOOTHING_GROUP
+    };
+
+    Type            type;
+    unsigned int    firstCorner;
+    unsigned int    numCorners;
+    unsigned int    numVertices;
+    unsigned int    numNormals;
+    unsigned int    numTexCoords;
+    int             value;
+};
+
+struct Chunk
+{
+    const char*                 begin;
+    const char*                 end;
+
+    std::vector<osg::Vec3>      vertices;
+    std::vector<osg::Vec3>      normals;
+    std::vector<osg::Vec2>      texcoords;
+    std::vector<osg::Vec4>      colors;
+
+    // three ints per corner, vertex/texcoord/normal with 0 marking an unspecified index.
+    std::vector<int>            corners;
+    std::vector<Record>         records;
+    std::vector<std::string>    names;
+
+    unsigned int                vertexBase;
+    unsigned int                normalBase;
+    unsigned int                texcoordBase;
+
+    void addRecord(Record::Type type, int value=0, unsigned int firstCorner=0, unsigned int numCorners=0)
+    {
+        Record record;
+        record.type = type;
+        record.firstCorner = firstCorner;
+        record.numCorners = numCorners;
+        record.numVertices = vertices.size();
+        record.numNormals = normals.size();
+        record.numTexCoords = texcoords.size();
+        record.value = value;
+        records.push_back(record);
+    }
+
+    void addNamedRecord(Record::Type type, const std::string& name)
+    {
+        addRecord(type, names.size());
+        names.push_back(name);
+    }
+
+    void parseLine(const char* ptr, const char* end);
+    void parse();
+};
+
+void Chunk::parseLine(const char* ptr, const char* end)
+{
+    ptr = skipSpace(ptr, end);
+    if (ptr>=end) return;
+
+    if (*ptr=='#')
+    {
+        // ZBrush vertex colours, #MRGB MMRRGGBB MMRRGGBB ...
+        if (end-ptr>5 && strncmp(ptr, "#MRGB", 5)==0)
+        {
+            const char* p = skipSpace(ptr+5, end);
+            while(end-p>=8 && !isSpace(*p))
+            {
+                colors.push_back(osg::Vec4(float(parseHexByte(p+2))/255.0f,
+                                           float(parseHexByte(p+4))/255.0f,
+                                           float(parseHexByte(p+6))/255.0f,
+                                           1.0f));
+                p += 8;
+            }
+        }
+        return;
+    }
+
+    const char* keywordEnd = ptr;
+    while(keywordEnd<end && !isSpace(*keywordEnd)) ++keywordEnd;
+    size_t keywordLength = keywordEnd-ptr;
+    const char* args = keywordEnd;
+
+    if (keywordLength==1 && *ptr=='v')
+    {
+        float values[7] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+        int numValues = 0;
+        while(numValues<7 && parseFloat(args, end, values[numValues])) ++numValues;
+
+        if (numValues==4) vertices.push_back(osg::Vec3(values[0]/values[3], values[1]/values[3], values[2]/values[3]));
+        else vertices.push_back(osg::Vec3(values[0], values[1], values[2]));
+
+        if (numValues==6) colors.push_back(osg::Vec4(values[3], values[4], values[5], 1.0f));
+        else if (numValues==7) colors.push_back(osg::Vec4(values[3], values[4], values[5], values[6]));
+    }
+    else if (keywordLength==2 && ptr[0]=='v' && ptr[1]=='n')
+    {
+        osg::Vec3 n;
+        for(int i=0; i<3 && parseFloat(args, end, n[i]); ++i) {}
+        normals.push_back(n);
+    }
+    else if (keywordLength==2 && ptr[0]=='v' && ptr[1]=='t')
+    {
+        osg::Vec2 t;
+        for(int i=0; i<2 && parseFloat(args, end, t[i]); ++i) {}
+        texcoords.push_back(t);
+    }
+    else if (keywordLength==1 && (*ptr=='f' || *ptr=='l' || *ptr=='p'))
+    {
+        unsigned int firstCorner = corners.size()/3;
+        const char* p = skipSpace(args, end);
+        while(p<end)
+        {
+            int vi = 0, ti = 0, ni = 0;
+            if (!parseInt(p, end, vi)) break;
+            if (p<end && *p=='/')
+            {
+                ++p;
+                parseInt(p, end, ti);
+                if (p<end && *p=='/')
+                {
+                    ++p;
+                    parseInt(p, end, ni);
+                }
+            }
+            corners.push_back(vi);
+            corners.push_back(ti);
+            corners.push_back(ni);
+
+            // skip to the next corner
+            while(p<end && !isSpace(*p)) ++p;
+            p = skipSpace(p, end);
+        }
+
+        unsigned int numCorners = corners.size()/3 - firstCorner;
+        if (numCorners>0)
+        {
+            Record::Type type = (*ptr=='p') ? Record::POINTS : ((*ptr=='l') ? Record::POLYLINE : Record::POLYGON);
+            addRecord(type, 0, firstCorner, numCorners);
+        }
+    }
+    else if (keywordLength==6 && strncmp(ptr, "usemtl", 6)==0)
+    {
+        // as with Model::readOBJ() everything after the first space is the material name
+        addNamedRecord(Record::USEMTL, std::string(args<end ? args+1 : end, end));
+    }
+    else if (keywordLength==6 && strncmp(ptr, "mtllib", 6)==0)
+    {
+        addNamedRecord(Record::MTLLIB, trimmedString(args, end));
+    }
+    else if (keywordLength==1 && *ptr=='o')
+    {
+        addNamedRecord(Record::OBJECT, std::string(args<end ? args+1 : end, end));
+    }
+    else if (keywordLength==1 && *ptr=='g')
+    {
+        addNamedRecord(Record::GROUP, std::string(args<end ? args+1 : end, end));
+    }
+    else if (keywordLength==1 && *ptr=='s')
+    {
+        const char* p = skipSpace(args, end);
+        int smoothingGroup = 0;
+        if (!(end-p>=3 && strncmp(p, "off", 3)==0) && !parseInt(p, end, smoothingGroup))
+        {
+            OSG_NOTICE <<"*** error reading smoothing group ***"<<std::endl;
+        }
+        addRecord(Record::SMOOTHING_GROUP, smoothingGroup);
+    }
+}
+
+void Chunk::parse()
+{
+    std::string joinedLine;
+    const char* ptr = begin;
+    while(ptr<end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(ptr, '\n', end-ptr));
+        if (!lineEnd) lineEnd = end;
+
+        const char* next = (lineEnd<end) ? lineEnd+1 : end;
+        const char* contentEnd = lineEnd;
+        if (contentEnd>ptr && *(contentEnd-1)=='\r') --contentEnd;
+
+        if (contentEnd>ptr && *(contentEnd-1)=='\\')
+        {
+            // line continuation, join the lines in a scratch buffer
+            joinedLine.assign(ptr, contentEnd-1);
+            while(next<end)
+            {
+                const char* continuedEnd = static_cast<const char*>(memchr(next, '\n', end-next));
+                if (!continuedEnd) continuedEnd = end;
+                const char* continuedContentEnd = continuedEnd;
+                if (continuedContentEnd>next && *(continuedContentEnd-1)=='\r') --continuedContentEnd;
+
+                bool continues = continuedContentEnd>next && *(continuedContentEnd-1)=='\\';
+                joinedLine += ' ';
+                joinedLine.append(next, continues ? continuedContentEnd-1 : continuedContentEnd);
+
+                next = (continuedEnd<end) ? continuedEnd+1 : end;
+                if (!continues) break;
+            }
+            parseLine(joinedLine.data(), joinedLine.data()+joinedLine.size());
+        }
+        else
+        {
+            parseLine(ptr, contentEnd);
+        }
+
+        ptr = next;
+    }
+}
+
+class ChunkThread : public OpenThreads::Thread
+{
+public:
+
+    ChunkThread(Chunk& chunk): _chunk(chunk) {}
+
+    virtual void run() { _chunk.parse(); }
+
+protected:
+
+    Chunk& _chunk;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Open addressing hash table mapping a vertex/texcoord/normal index triple to its output index.
+//
+class VertexHashTable
+{
+public:
+
+    VertexHashTable():
+        _size(0)
+    {
+        _entries.resize(1024);
+    }
+
+    // returns true if the triple was already present, otherwise inserts it with newIndex.
+    bool findOrInsert(int vi, int ti, int ni, unsigned int newIndex, unsigned int& index)
+    {
+        if ((_size+1)*2>_entries.size()) grow();
+
+        size_t mask = _entries.size()-1;
+        size_t slot = hash(vi, ti, ni) & mask;
+        while(_entries[slot].used)
+        {
+            const Entry& entry = _entries[slot];
+            if (entry.vi==vi && entry.ti==ti && entry.ni==ni)
+            {
+                index = entry.index;
+                return true;
+            }
+            slot = (slot+1) & mask;
+        }
+
+        Entry& entry = _entries[slot];
+        entry.vi = vi;
+        entry.ti = ti;
+        entry.ni = ni;
+        entry.index = newIndex;
+        entry.used = true;
+        ++_size;
+
+        index = newIndex;
+        return false;
+    }
+
+protected:
+
+    struct Entry
+    {
+        Entry(): vi(0), ti(0), ni(0), index(0), used(false) {}
+
+        int             vi;
+        int             ti;
+        int             ni;
+        unsigned int    index;
+        bool            used;
+    };
+
+    static size_t hash(int vi, int ti, int ni)
+    {
+        unsigned int h = static_cast<unsigned int>(vi)*73856093u;
+        h ^= static_cast<unsigned int>(ti)*19349663u;
+        h ^= static_cast<unsigned int>(ni)*83492791u;
+        h ^= h>>15;
+        return h;
+    }
+
+    void grow()
+    {
+        std::vector<Entry> oldEntries;
+        oldEntries.swap(_entries);
+        _entries.resize(oldEntries.size()*2);
+        _size = 0;
+
+        unsigned int index;
+        for(std::vector<Entry>::iterator itr = oldEntries.begin();
+            itr != oldEntries.end();
+            ++itr)
+        {
+            if (itr->used) findOrInsert(itr->vi, itr->ti, itr->ni, itr->index, index);
+        }
+    }
+
+    std::vector<Entry>  _entries;
+    size_t              _size;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Builds the indexed osg::Geometry for one ElementState.
+//
+struct GeometryBuilder
+{
+    GeometryBuilder():
+        model(0),
+        rotate(true) {}
+
+    void init(const Model* m, bool r, bool hasNormals, bool hasTexCoords)
+    {
+        model = m;
+        rotate = r;
+        geometry = new osg::Geometry;
+        vertices = new osg::Vec3Array;
+        geometry->setVertexArray(vertices.get());
+        if (hasNormals)
+        {
+            normals = new osg::Vec3Array;
+            geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+        }
+        if (hasTexCoords)
+        {
+            texcoords = new osg::Vec2Array;
+            geometry->setTexCoordArray(0, texcoords.get(), osg::Array::BIND_PER_VERTEX);
+        }
+        if (!model->colors.empty())
+        {
+            colors = new osg::Vec4Array;
+            geometry->setColorArray(colors.get(), osg::Array::BIND_PER_VERTEX);
+        }
+    }
+
+    unsigned int addVertex(int vi, int ti, int ni)
+    {
+        if (!normals) ni = -1;
+        if (!texcoords) ti = -1;
+
+        unsigned int index;
+        if (hashTable.findOrInsert(vi, ti, ni, vertices->size(), index)) return index;
+
+        const osg::Vec3& v = model->vertices[vi];
+        vertices->push_back(rotate ? osg::Vec3(v.x(),-v.z(),v.y()) : v);
+
+        if (normals.valid())
+        {
+            osg::Vec3 n = (ni>=0 && ni<static_cast<int>(model->normals.size())) ? model->normals[ni] : osg::Vec3(0.0f,0.0f,1.0f);
+            normals->push_back(rotate ? osg::Vec3(n.x(),-n.z(),n.y()) : n);
+        }
+
+        if (texcoords.valid())
+        {
+            texcoords->push_back((ti>=0 && ti<static_cast<int>(model->texcoords.size())) ? model->texcoords[ti] : osg::Vec2(0.0f,0.0f));
+        }
+
+        if (colors.valid())
+        {
+            colors->push_back((vi<static_cast<int>(model->colors.size())) ? model->colors[vi] : osg::Vec4(1.0f,1.0f,1.0f,1.0f));
+        }
+
+        return index;
+    }
+
+    osg::DrawElementsUInt* getOrCreatePrimitives(osg::ref_ptr<osg::DrawElementsUInt>& primitives, GLenum mode)
+    {
+        if (!primitives)
+        {
+            primitives = new osg::DrawElementsUInt(mode);
+            geometry->addPrimitiveSet(primitives.get());
+        }
+        return primitives.get();
+    }
+
+    const Model*                        model;
+    bool                                rotate;
+    VertexHashTable                     hashTable;
+
+    osg::ref_ptr<osg::Geometry>         geometry;
+    osg::ref_ptr<osg::Vec3Array>        vertices;
+    osg::ref_ptr<osg::Vec3Array>        normals;
+    osg::ref_ptr<osg::Vec2Array>        texcoords;
+    osg::ref_ptr<osg::Vec4Array>        colors;
+    osg::ref_ptr<osg::DrawElementsUInt> triangles;
+    osg::ref_ptr<osg::DrawElementsUInt> lines;
+    osg::ref_ptr<osg::DrawElementsUInt> points;
+};
+
+inline int resolveIndex(int index, unsigned int base, unsigned int localCount)
+{
+    // returns -1 for an unspecified index
+    if (index>0) return index-1;
+    if (index<0) return static_cast<int>(base+localCount)+index;
+    return -1;
+}
+
+}
+
+FastReader::FastReader():
+    _numThreads(0),
+    _rotate(true)
+{
+}
+
+bool FastReader::read(const std::string& fileName, Model& model, GeometryMap& geometryMap, const osgDB::ReaderWriter::Options* options)
+{
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    MappedFile file;
+    if (!file.open(fileName)) return false;
+
+    // split the file into line aligned chunks, avoiding splits after a line continuation.
+    unsigned int numThreads = _numThreads>0 ? _numThreads : static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1));
+    const size_t minimumChunkSize = 1024*1024;
+    unsigned int numChunks = osg::maximum(1u, osg::minimum(numThreads, static_cast<unsigned int>(file.size()/minimumChunkSize)));
+
+    const char* fileBegin = file.data();
+    const char* fileEnd = file.data()+file.size();
+
+    std::vector<Chunk> chunks(numChunks);
+    const char* chunkBegin = fileBegin;
+    for(unsigned int i=0; i<numChunks; ++i)
+    {
+        const char* chunkEnd = (i+1==numChunks) ? fileEnd : fileBegin + (file.size()/numChunks)*(i+1);
+        if (chunkEnd<chunkBegin) chunkEnd = chunkBegin;
+        while(chunkEnd<fileEnd)
+        {
+            const char* newline = static_cast<const char*>(memchr(chunkEnd, '\n', fileEnd-chunkEnd));
+            if (!newline) { chunkEnd = fileEnd; break; }
+
+            const char* last = newline;
+            if (last>fileBegin && *(last-1)=='\r') --last;
+            chunkEnd = newline+1;
+            if (!(last>fileBegin && *(last-1)=='\\')) break;
+        }
+
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    // parse the chunks, the calling thread takes the first chunk itself.
+    std::vector<ChunkThread*> threads;
+    for(unsigned int i=1; i<numChunks; ++i)
+    {
+        ChunkThread* thread = new ChunkThread(chunks[i]);
+        thread->start();
+        threads.push_back(thread);
+    }
+    chunks[0].parse();
+    for(std::vector<ChunkThread*>::iterator itr = threads.begin();
+        itr != threads.end();
+        ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+
+    osg::Timer_t parsedTick = osg::Timer::instance()->tick();
+
+    // merge the per chunk arrays into the model.
+    unsigned int numVertices = 0, numNormals = 0, numTexCoords = 0, numColors = 0;
+    for(std::vector<Chunk>::iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+    {
+        itr->vertexBase = numVertices;
+        itr->normalBase = numNormals;
+        itr->texcoordBase = numTexCoords;
+        numVertices += itr->vertices.size();
+        numNormals += itr->normals.size();
+        numTexCoords += itr->texcoords.size();
+        numColors += itr->colors.size();
+    }
+
+    model.vertices.reserve(numVertices);
+    model.normals.reserve(numNormals);
+    model.texcoords.reserve(numTexCoords);
+    model.colors.reserve(numColors);
+    for(std::vector<Chunk>::iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+    {
+        model.vertices.insert(model.vertices.end(), itr->vertices.begin(), itr->vertices.end());
+        model.normals.insert(model.normals.end(), itr->normals.begin(), itr->normals.end());
+        model.texcoords.insert(model.texcoords.end(), itr->texcoords.begin(), itr->texcoords.end());
+        model.colors.insert(model.colors.end(), itr->colors.begin(), itr->colors.end());
+
+        std::vector<osg::Vec3>().swap(itr->vertices);
+        std::vector<osg::Vec3>().swap(itr->normals);
+        std::vector<osg::Vec2>().swap(itr->texcoords);
+        std::vector<osg::Vec4>().swap(itr->colors);
+    }
+
+    // replay the records in file order, tracking the ElementState as Model::readOBJ() does.
+    typedef std::map<ElementState, GeometryBuilder> BuilderMap;
+    BuilderMap builders;
+    GeometryBuilder* currentBuilder = 0;
+    ElementState& state = model.currentElementState;
+
+    int maxVertexIndex = static_cast<int>(model.vertices.size());
+    std::vector<unsigned int> indices;
+
+    for(std::vector<Chunk>::iterator citr = chunks.begin(); citr != chunks.end(); ++citr)
+    {
+        Chunk& chunk = *citr;
+        for(std::vector<Record>::iterator ritr = chunk.records.begin(); ritr != chunk.records.end(); ++ritr)
+        {
+            const Record& record = *ritr;
+            switch(record.type)
+            {
+                case Record::USEMTL:
+                    if (state.materialName!=chunk.names[record.value]) { state.materialName = chunk.names[record.value]; currentBuilder = 0; }
+                    break;
+                case Record::OBJECT:
+                    if (state.objectName!=chunk.names[record.value]) { state.objectName = chunk.names[record.value]; currentBuilder = 0; }
+                    break;
+                case Record::GROUP:
+                    if (state.groupName!=chunk.names[record.value]) { state.groupName = chunk.names[record.value]; currentBuilder = 0; }
+                    break;
+                case Record::SMOOTHING_GROUP:
+                    if (state.smoothingGroup!=record.value) { state.smoothingGroup = record.value; currentBuilder = 0; }
+                    break;
+                case Record::MTLLIB:
+                {
+                    std::string fullPathFileName = osgDB::findDataFile(chunk.names[record.value], options);
+                    osgDB::ifstream mfin(fullPathFileName.c_str());
+                    if (!fullPathFileName.empty() && mfin)
+                    {
+                        OSG_INFO << "Obj reading mtllib '" << fullPathFileName << "'\n";
+                        model.readMTL(mfin);
+                    }
+                    else
+                    {
+                        OSG_WARN << "Obj unable to load mtllib '" << chunk.names[record.value] << "'\n";
+                    }
+                    break;
+                }
+                default:
+                {
+                    const int* corner = &chunk.corners[record.firstCorner*3];
+
+                    // only use normals and texcoords when every corner specifies them.
+                    bool hasTexCoords = true;
+                    bool hasNormals = true;
+                    for(unsigned int i=0; i<record.numCorners; ++i)
+                    {
+                        if (corner[i*3+1]==0) hasTexCoords = false;
+                        if (corner[i*3+2]==0) hasNormals = false;
+                    }
+
+                    Element::CoordinateCombination coordinateCombination =
+                        hasNormals ? (hasTexCoords ? Element::VERTICES_NORMALS_TEXCOORDS : Element::VERTICES_NORMALS) :
+                                     (hasTexCoords ? Element::VERTICES_TEXCOORDS : Element::VERTICES);
+                    if (coordinateCombination!=state.coordinateCombination)
+                    {
+                        state.coordinateCombination = coordinateCombination;
+                        currentBuilder = 0;
+                    }
+
+                    if (!currentBuilder)
+                    {
+                        currentBuilder = &builders[state];
+                        if (!currentBuilder->geometry) currentBuilder->init(&model, _rotate, hasNormals, hasTexCoords);
+                    }
+
+                    indices.resize(record.numCorners);
+                    unsigned int numValid = 0;
+                    for(unsigned int i=0; i<record.numCorners; ++i)
+                    {
+                        int vi = resolveIndex(corner[i*3], chunk.vertexBase, record.numVertices);
+                        if (vi<0 || vi>=maxVertexIndex) continue;
+
+                        int ti = resolveIndex(corner[i*3+1], chunk.texcoordBase, record.numTexCoords);
+                        int ni = resolveIndex(corner[i*3+2], chunk.normalBase, record.numNormals);
+                        indices[numValid++] = currentBuilder->addVertex(vi, ti, ni);
+                    }
+
+                    if (record.type==Record::POLYGON && numValid>=3)
+                    {
+                        osg::DrawElementsUInt* triangles = currentBuilder->getOrCreatePrimitives(currentBuilder->triangles, GL_TRIANGLES);
+                        for(unsigned int i=2; i<numValid; ++i)
+                        {
+                            triangles->push_back(indices[0]);
+                            triangles->push_back(indices[i-1]);
+                            triangles->push_back(indices[i]);
+                        }
+                    }
+                    else if (record.type==Record::POLYLINE && numValid>=2)
+                    {
+                        osg::DrawElementsUInt* lines = currentBuilder->getOrCreatePrimitives(currentBuilder->lines, GL_LINES);
+                        for(unsigned int i=1; i<numValid; ++i)
+                        {
+                            lines->push_back(indices[i-1]);
+                            lines->push_back(indices[i]);
+                        }
+                    }
+                    else if (record.type==Record::POINTS)
+                    {
+                        osg::DrawElementsUInt* points = currentBuilder->getOrCreatePrimitives(currentBuilder->points, GL_POINTS);
+                        points->insert(points->end(), indices.begin(), indices.begin()+numValid);
+                    }
+                    break;
+                }
+            }
+        }
+
+        std::vector<int>().swap(chunk.corners);
+        std::vector<Record>().swap(chunk.records);
+    }
+
+    for(BuilderMap::iterator itr = builders.begin(); itr != builders.end(); ++itr)
+    {
+        if (itr->second.geometry.valid() && itr->second.geometry->getNumPrimitiveSets()>0)
+        {
+            geometryMap[itr->first] = itr->second.geometry;
+        }
+    }
+
+    osg::Timer_t endTick = osg::Timer::instance()->tick();
+    OSG_INFO<<"obj::FastReader read "<<fileName<<" using "<<numChunks<<" chunks, parse "
+            <<osg::Timer::instance()->delta_m(startTick, parsedTick)<<"ms, merge "
+            <<osg::Timer::instance()->delta_m(parsedTick, endTick)<<"ms"<<std::endl;
+
+    return true;
+}
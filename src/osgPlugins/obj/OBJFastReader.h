@@ -0,0 +1,55 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2004 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#ifndef OBJ_FASTREADER_H
+#define OBJ_FASTREADER_H
+
+#include <osg/Geometry>
+
+#include "obj.h"
+
+namespace obj
+{
+
+/** Alternative to Model::readOBJ() for very large files. The file is memory mapped and split into
+  * line aligned chunks that are parsed in parallel, the chunks are then merged in file order straight
+  * into indexed osg::Geometry, one per ElementState, with vertices that share the same position,
+  * normal and texcoord indices deduplicated. Polygons are triangulated as fans, polylines become
+  * GL_LINES segments. Materials are read into the Model's materialMap as with readOBJ().*/
+class FastReader
+{
+public:
+
+    typedef std::map< ElementState, osg::ref_ptr<osg::Geometry> > GeometryMap;
+
+    FastReader();
+
+    /** Set the number of threads used to parse the file, 0 selects the number of processors.*/
+    void setNumThreads(unsigned int numThreads) { _numThreads = numThreads; }
+    unsigned int getNumThreads() const { return _numThreads; }
+
+    /** Set whether vertices and normals are rotated from OBJ's Y up to OSG's Z up.*/
+    void setRotate(bool rotate) { _rotate = rotate; }
+    bool getRotate() const { return _rotate; }
+
+    bool read(const std::string& fileName, Model& model, GeometryMap& geometryMap, const osgDB::ReaderWriter::Options* options);
+
+protected:
+
+    unsigned int    _numThreads;
+    bool            _rotate;
+};
+
+}
+
+#endif
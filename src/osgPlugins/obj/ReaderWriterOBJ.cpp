@@ -47,6 +47,7 @@
 
 #include "obj.h"
 #include "OBJWriterNodeVisitor.h"
+#include "OBJFastReader.h"
 
 #include <map>
 #include <set>
@@ -62,6 +63,7 @@ public:
         supportsOption("noTriStripPolygons","Do not do the default tri stripping of polygons");
         supportsOption("generateFacetNormals","generate facet normals for verticies without normals");
         supportsOption("noReverseFaces","avoid to reverse faces when normals and triangles orientation are reversed");
+        supportsOption("fastParse","Parse the file in parallel chunks straight into indexed triangle geometry, for very large files");
 
         supportsOption("DIFFUSE=<unit>", "Set texture unit for diffuse texture");
         supportsOption("AMBIENT=<unit>", "Set texture unit for ambient texture");
@@ -140,6 +142,7 @@ protected:
         bool generateFacetNormals;
         bool fixBlackMaterials;
         bool noReverseFaces;
+        bool fastParse;
         // This is the order in which the materials will be assigned to texture maps, unless
         // otherwise overriden
         typedef std::vector< std::pair<int,obj::Material::Map::TextureMapType> > TextureAllocationMap;
@@ -154,6 +157,8 @@ protected:
 
     osg::Node* convertModelToSceneGraph(obj::Model& model, ObjOptionsStruct& localOptions, const Options* options) const;
 
+    osg::Node* convertGeometryMapToSceneGraph(obj::Model& model, obj::FastReader::GeometryMap& geometryMap, ObjOptionsStruct& localOptions, const Options* options) const;
+
     inline osg::Vec3 transformVertex(const osg::Vec3& vec, const bool rotate) const ;
     inline osg::Vec3 transformNormal(const osg::Vec3& vec, const bool rotate) const ;
 
@@ -817,6 +822,59 @@ osg::Node* ReaderWriterOBJ::convertModelToSceneGraph(obj::Model& model, ObjOptio
     return group;
 }
 
+osg::Node* ReaderWriterOBJ::convertGeometryMapToSceneGraph(obj::Model& model, obj::FastReader::GeometryMap& geometryMap, ObjOptionsStruct& localOptions, const Options* options) const
+{
+    if (geometryMap.empty()) return 0;
+
+    osg::Group* group = new osg::Group;
+
+    // set up the materials
+    MaterialToStateSetMap materialToStateSetMap;
+    buildMaterialToStateSetMap(model, materialToStateSetMap, localOptions, options);
+
+    for(obj::FastReader::GeometryMap::iterator itr=geometryMap.begin();
+        itr!=geometryMap.end();
+        ++itr)
+    {
+        const obj::ElementState& es = itr->first;
+        osg::Geometry* geometry = itr->second.get();
+
+        MaterialToStateSetMap::const_iterator it = materialToStateSetMap.find(es.materialName);
+        if (it == materialToStateSetMap.end())
+        {
+            OSG_WARN << "Obj unable to find material '" << es.materialName << "'" << std::endl;
+        }
+        geometry->setStateSet(materialToStateSetMap[es.materialName].get());
+
+        // the geometry is already indexed triangles so skip tessellation and tri stripping, just add any missing normals.
+        if (!geometry->getNormalArray() || geometry->getNormalArray()->getNumElements()==0)
+        {
+            osgUtil::SmoothingVisitor sv;
+            sv.smooth(*geometry);
+        }
+
+        osg::Geode* geode = new osg::Geode;
+        geode->addDrawable(geometry);
+
+        if (es.objectName.empty())
+        {
+            geode->setName(es.groupName);
+        }
+        else if (es.groupName.empty())
+        {
+            geode->setName(es.objectName);
+        }
+        else
+        {
+            geode->setName(es.groupName + std::string(":") + es.objectName);
+        }
+
+        group->addChild(geode);
+    }
+
+    return group;
+}
+
 ReaderWriterOBJ::ObjOptionsStruct ReaderWriterOBJ::parseOptions(const osgDB::ReaderWriter::Options* options) const
 {
     ObjOptionsStruct localOptions;
@@ -826,6 +884,7 @@ ReaderWriterOBJ::ObjOptionsStruct ReaderWriterOBJ::parseOptions(const osgDB::Rea
     localOptions.generateFacetNormals = false;
     localOptions.fixBlackMaterials = true;
     localOptions.noReverseFaces = false;
+    localOptions.fastParse = false;
 
     if (options!=NULL)
     {
@@ -868,6 +927,10 @@ ReaderWriterOBJ::ObjOptionsStruct ReaderWriterOBJ::parseOptions(const osgDB::Rea
             {
                 localOptions.noReverseFaces = true;
             }
+            else if (pre_equals == "fastParse")
+            {
+                localOptions.fastParse = true;
+            }
             else if (post_equals.length()>0)
             {
                 obj::Material::Map::TextureMapType type = obj::Material::Map::UNKNOWN;
@@ -904,6 +967,28 @@ osgDB::ReaderWriter::ReadResult ReaderWriterOBJ::readNode(const std::string& fil
     if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
 
+    ObjOptionsStruct localOptions = parseOptions(options);
+
+    if (localOptions.fastParse)
+    {
+        osg::ref_ptr<Options> local_opt = options ? static_cast<Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) : new Options;
+        local_opt->getDatabasePathList().push_front(osgDB::getFilePath(fileName));
+
+        obj::Model model;
+        model.setDatabasePath(osgDB::getFilePath(fileName.c_str()));
+
+        obj::FastReader reader;
+        reader.setRotate(localOptions.rotate);
+
+        obj::FastReader::GeometryMap geometryMap;
+        if (reader.read(fileName, model, geometryMap, local_opt.get()))
+        {
+            return convertGeometryMapToSceneGraph(model, geometryMap, localOptions, local_opt.get());
+        }
+
+        OSG_NOTICE<<"Obj fastParse unable to map file '"<<fileName<<"', falling back to the standard parser."<<std::endl;
+    }
+
     osgDB::ifstream fin(fileName.c_str());
     if (fin)
     {
@@ -916,8 +1001,6 @@ osgDB::ReaderWriter::ReadResult ReaderWriterOBJ::readNode(const std::string& fil
         model.setDatabasePath(osgDB::getFilePath(fileName.c_str()));
         model.readOBJ(fin, local_opt.get());
 
-        ObjOptionsStruct localOptions = parseOptions(options);
-
         osg::Node* node = convertModelToSceneGraph(model, localOptions, local_opt.get());
         return node;
     }
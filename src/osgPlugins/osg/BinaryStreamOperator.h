@@ -253,6 +253,13 @@ public:
     virtual void readWrappedString( std::string& str )
     { readString( str ); }
 
+    virtual osgDB::InputIterator* cloneIterator( std::istream* istream ) const
+    {
+        BinaryInputIterator* itr = new BinaryInputIterator( istream, _byteSwap );
+        itr->setSupportBinaryBrackets( _supportBinaryBrackets );
+        return itr;
+    }
+
     virtual void advanceToCurrentEndBracket()
     {
         if ( _supportBinaryBrackets && _beginPositions.size()>0 )
@@ -131,6 +131,13 @@ public:
         supportsOption( "SchemaData", "Export option: Record inbuilt schema data into a binary file" );
         supportsOption( "SchemaFile=<file>", "Import/Export option: Use/Record an ascii schema file" );
         supportsOption( "Compressor=<name>", "Export option: Use an inbuilt or user-defined compressor" );
+        supportsOption( "ClassNameTable=<true|false>", "Export option: Write each class name once and refer to it by index in binary files, "
+                        "set to false to write files readable by versions before 146 (default true)" );
+        supportsOption( "ChunkedLayout=<true|false>", "Export option: Write the subgraphs of the scene as separately compressed chunks "
+                        "that are decoded in parallel when reading binary files (default false)" );
+        supportsOption( "ChunkSize=<bytes>", "Export option: Approximate size of the chunks of a chunked binary file (default 1048576)" );
+        supportsOption( "DecodeThreads=<num>", "Import option: Number of threads decoding the chunks of a chunked binary file "
+                        "(default is the number of processors)" );
         supportsOption( "WriteImageHint=<hint>", "Export option: Hint of writing image to stream: "
                         "<IncludeData> writes Image::data() directly; "
                         "<IncludeFile> writes the image file itself to stream; "
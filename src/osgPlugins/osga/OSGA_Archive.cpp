@@ -3,9 +3,24 @@
 
 #include <osgDB/Registry>
 #include <osgDB/FileNameUtils>
+#include <osgDB/ConvertUTF>
 
 #include "OSGA_Archive.h"
 
+#include <string.h>
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+    #define WIN32_LEAN_AND_MEAN
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+
 using namespace osgDB;
 
 /*
@@ -95,6 +110,164 @@ inline OSGA_Archive::pos_type ARCHIVE_POS( const std::streampos & pos )
 float OSGA_Archive::s_currentSupportedVersion = 0.0;
 const unsigned int ENDIAN_TEST_NUMBER = 0x00000001;
 
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// FileNameHashIndex
+//
+unsigned int OSGA_Archive::FileNameHashIndex::hash(const std::string& filename)
+{
+    // 32 bit FNV-1a
+    unsigned int value = 2166136261u;
+    for(std::string::const_iterator itr = filename.begin(); itr != filename.end(); ++itr)
+    {
+        value ^= static_cast<unsigned char>(*itr);
+        value *= 16777619u;
+    }
+    return value;
+}
+
+void OSGA_Archive::FileNameHashIndex::build(const FileNamePositionMap& indexMap)
+{
+    clear();
+    if (indexMap.empty()) return;
+
+    _entries.reserve(indexMap.size());
+
+    // keep the load factor below one half so probe sequences stay short.
+    unsigned int numBuckets = 16;
+    while (numBuckets < indexMap.size()*2) numBuckets *= 2;
+    _buckets.resize(numBuckets, 0);
+
+    for(FileNamePositionMap::const_iterator itr = indexMap.begin();
+        itr != indexMap.end();
+        ++itr)
+    {
+        _entries.push_back(Entry(itr->first, itr->second));
+
+        // buckets store entry index + 1 so that 0 marks an empty bucket.
+        unsigned int bucket = hash(itr->first) & (numBuckets-1);
+        while (_buckets[bucket]!=0) bucket = (bucket+1) & (numBuckets-1);
+        _buckets[bucket] = static_cast<unsigned int>(_entries.size());
+    }
+}
+
+const OSGA_Archive::PositionSizePair* OSGA_Archive::FileNameHashIndex::find(const std::string& filename) const
+{
+    if (_buckets.empty()) return 0;
+
+    unsigned int mask = static_cast<unsigned int>(_buckets.size())-1;
+    for(unsigned int bucket = hash(filename) & mask; _buckets[bucket]!=0; bucket = (bucket+1) & mask)
+    {
+        const Entry& entry = _entries[_buckets[bucket]-1];
+        if (entry.first==filename) return &entry.second;
+    }
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// PositionalFile
+//
+#if defined(WIN32) && !defined(__CYGWIN__)
+
+OSGA_Archive::PositionalFile::PositionalFile():
+    _handle(INVALID_HANDLE_VALUE)
+{
+}
+
+bool OSGA_Archive::PositionalFile::open(const std::string& filename)
+{
+    close();
+
+    #ifdef OSG_USE_UTF8_FILENAME
+    _handle = CreateFileW(osgDB::convertUTF8toUTF16(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    #else
+    _handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    #endif
+
+    return _handle!=INVALID_HANDLE_VALUE;
+}
+
+void OSGA_Archive::PositionalFile::close()
+{
+    if (_handle!=INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_handle);
+        _handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool OSGA_Archive::PositionalFile::read(pos_type position, size_type size, char* buffer) const
+{
+    if (_handle==INVALID_HANDLE_VALUE) return false;
+
+    while (size>0)
+    {
+        // the offset in the OVERLAPPED structure makes ReadFile independent of the handle's file pointer.
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = static_cast<DWORD>(position & 0xffffffff);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+        DWORD numToRead = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size);
+        DWORD numRead = 0;
+        if (!ReadFile(_handle, buffer, numToRead, &numRead, &overlapped) || numRead==0) return false;
+
+        position += numRead;
+        size -= numRead;
+        buffer += numRead;
+    }
+    return true;
+}
+
+#else
+
+OSGA_Archive::PositionalFile::PositionalFile():
+    _fileDescriptor(-1)
+{
+}
+
+bool OSGA_Archive::PositionalFile::open(const std::string& filename)
+{
+    close();
+
+    _fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+    return _fileDescriptor>=0;
+}
+
+void OSGA_Archive::PositionalFile::close()
+{
+    if (_fileDescriptor>=0)
+    {
+        ::close(_fileDescriptor);
+        _fileDescriptor = -1;
+    }
+}
+
+bool OSGA_Archive::PositionalFile::read(pos_type position, size_type size, char* buffer) const
+{
+    if (_fileDescriptor<0) return false;
+
+    while (size>0)
+    {
+        ssize_t numRead = ::pread(_fileDescriptor, buffer, static_cast<size_t>(size), static_cast<off_t>(position));
+        if (numRead<0 && errno==EINTR) continue;
+        if (numRead<=0) return false;
+
+        position += numRead;
+        size -= numRead;
+        buffer += numRead;
+    }
+    return true;
+}
+
+#endif
+
+OSGA_Archive::PositionalFile::~PositionalFile()
+{
+    close();
+}
+
 OSGA_Archive::IndexBlock::IndexBlock(unsigned int blockSize):
     _requiresWrite(false),
     _filePosition(0),
@@ -339,6 +512,10 @@ bool OSGA_Archive::open(const std::string& filename, ArchiveStatus status, unsig
         _status = status;
         _input.open(filename.c_str(), std::ios_base::binary | std::ios_base::in);
 
+        // entries are read with positional reads so that reads from several threads can proceed concurrently.
+        _positionalFile = new PositionalFile;
+        if (!_positionalFile->open(filename)) _positionalFile = 0;
+
         return _open(_input);
     }
     else
@@ -373,6 +550,7 @@ bool OSGA_Archive::open(const std::string& filename, ArchiveStatus status, unsig
                 }
             }
             _input.close();
+            _positionalFile = 0;
             _status = WRITE;
 
             osgDB::open(_output, filename.c_str(), std::ios_base::binary | std::ios_base::in | std::ios_base::out);
@@ -473,6 +651,8 @@ bool OSGA_Archive::_open(std::istream& input)
                 (*itr)->getFileReferences(_indexMap);
             }
 
+            _hashIndex.build(_indexMap);
+
             for(FileNamePositionMap::iterator mitr=_indexMap.begin();
                 mitr!=_indexMap.end();
                 ++mitr)
@@ -492,6 +672,7 @@ void OSGA_Archive::close()
     SERIALIZER();
 
     _input.close();
+    _positionalFile = 0;
 
     if (_status==WRITE)
     {
@@ -507,7 +688,7 @@ std::string OSGA_Archive::getMasterFileName() const
 
 osgDB::FileType OSGA_Archive::getFileType(const std::string& filename) const
 {
-    if (_indexMap.count(filename)!=0) return osgDB::REGULAR_FILE;
+    if (_hashIndex.find(filename)!=0) return osgDB::REGULAR_FILE;
     return osgDB::FILE_NOT_FOUND;
 }
 
@@ -546,7 +727,7 @@ void OSGA_Archive::writeIndexBlocks()
 
 bool OSGA_Archive::fileExists(const std::string& filename) const
 {
-    return (_indexMap.count(filename)!=0);
+    return (_hashIndex.find(filename)!=0);
 }
 
 bool OSGA_Archive::addFileReference(pos_type position, size_type size, const std::string& fileName)
@@ -692,6 +873,41 @@ protected:
     }
 };
 
+// streambuffer class to give read access to an archived file that has been read into memory.
+
+class memory_streambuf : public std::streambuf
+{
+public:
+
+    memory_streambuf(char* data, std::streamoff numChars)
+    {
+        setg(data, data, data+numChars);
+    }
+
+protected:
+
+    virtual std::streampos seekoff (std::streamoff off, std::ios_base::seekdir way,
+                   std::ios_base::openmode which = std::ios_base::in)
+    {
+        if ((which & std::ios_base::in)==0) return -1;
+
+        std::streamoff newpos;
+        if ( way == std::ios_base::beg ) newpos = off;
+        else if ( way == std::ios_base::cur ) newpos = (gptr()-eback()) + off;
+        else if ( way == std::ios_base::end ) newpos = (egptr()-eback()) + off;
+        else return -1;
+
+        if ( newpos<0 || newpos>(egptr()-eback()) ) return -1;
+        setg(eback(), eback()+newpos, egptr());
+        return newpos;
+    }
+
+    virtual std::streampos seekpos (std::streampos sp, std::ios_base::openmode which = std::ios_base::in)
+    {
+        return seekoff(sp, std::ios_base::beg, which);
+    }
+};
+
 struct OSGA_Archive::ReadObjectFunctor : public OSGA_Archive::ReadFunctor
 {
     ReadObjectFunctor(const std::string& filename, const ReaderWriter::Options* options):ReadFunctor(filename,options) {}
@@ -724,16 +940,14 @@ struct OSGA_Archive::ReadShaderFunctor : public OSGA_Archive::ReadFunctor
 
 ReaderWriter::ReadResult OSGA_Archive::read(const ReadFunctor& readFunctor)
 {
-    SERIALIZER();
-
     if (_status!=READ)
     {
         OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed, archive opened as write only."<<std::endl;
         return ReadResult(ReadResult::FILE_NOT_HANDLED);
     }
 
-    FileNamePositionMap::const_iterator itr = _indexMap.find(readFunctor._filename);
-    if (itr==_indexMap.end())
+    const PositionSizePair* entry = _hashIndex.find(readFunctor._filename);
+    if (!entry)
     {
         OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed, file not found in archive"<<std::endl;
         return ReadResult(ReadResult::FILE_NOT_FOUND);
@@ -748,11 +962,31 @@ ReaderWriter::ReadResult OSGA_Archive::read(const ReadFunctor& readFunctor)
 
     OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<")"<<std::endl;
 
-    _input.seekg( STREAM_POS( itr->second.first ) );
+    if (_positionalFile.valid())
+    {
+        // read the whole entry without touching the shared input stream, so only the positional read itself
+        // goes through the OS and decoding proceeds in parallel with reads on other threads.
+        std::vector<char> buffer(static_cast<size_t>(entry->second));
+        if (!buffer.empty() && !_positionalFile->read(entry->first, entry->second, &buffer[0]))
+        {
+            OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed to read data from archive."<<std::endl;
+            return ReadResult(ReadResult::ERROR_IN_READING_FILE);
+        }
+
+        memory_streambuf entrystreambuf(buffer.empty() ? 0 : &buffer[0], buffer.size());
+        std::istream entrystream(&entrystreambuf);
+
+        return readFunctor.doRead(*rw, entrystream);
+    }
+
+    // archives opened from a stream share its position so reads have to be serialized.
+    SERIALIZER();
+
+    _input.seekg( STREAM_POS( entry->first ) );
 
     // set up proxy stream buffer to provide the faked ending.
     std::istream& ins = _input;
-    proxy_streambuf mystreambuf(ins.rdbuf(),itr->second.second);
+    proxy_streambuf mystreambuf(ins.rdbuf(),entry->second);
     ins.rdbuf(&mystreambuf);
 
     ReaderWriter::ReadResult result = readFunctor.doRead(*rw, _input);
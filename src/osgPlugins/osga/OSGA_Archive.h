@@ -101,6 +101,51 @@ class OSGA_Archive : public osgDB::Archive
         typedef std::pair<pos_type, size_type> PositionSizePair;
         typedef std::map<std::string, PositionSizePair> FileNamePositionMap;
 
+        /** Open addressing hash table of the archive's file entries, built once when the archive is opened for reading
+          * so that looking up an entry doesn't require string comparisons down a tree of several thousand file names.*/
+        class FileNameHashIndex
+        {
+        public:
+            FileNameHashIndex() {}
+
+            void build(const FileNamePositionMap& indexMap);
+            void clear() { _entries.clear(); _buckets.clear(); }
+
+            const PositionSizePair* find(const std::string& filename) const;
+
+        protected:
+
+            static unsigned int hash(const std::string& filename);
+
+            typedef std::pair<std::string, PositionSizePair> Entry;
+            std::vector<Entry>          _entries;
+            std::vector<unsigned int>   _buckets;
+        };
+
+        /** Read only access to the archive's file using positional reads, so that concurrent reads don't share a stream position
+          * and don't need to be serialized.*/
+        class PositionalFile : public osg::Referenced
+        {
+        public:
+            PositionalFile();
+
+            bool open(const std::string& filename);
+            void close();
+
+            /** Read size bytes starting at position into buffer, return true if all bytes were read.*/
+            bool read(pos_type position, size_type size, char* buffer) const;
+
+        protected:
+
+            virtual ~PositionalFile();
+
+            #if defined(WIN32) && !defined(__CYGWIN__)
+            void*   _handle;
+            #else
+            int     _fileDescriptor;
+            #endif
+        };
+
     protected:
 
         mutable OpenThreads::ReentrantMutex _serializerMutex;
@@ -223,6 +268,8 @@ class OSGA_Archive : public osgDB::Archive
         std::string         _masterFileName;
         IndexBlockList      _indexBlockList;
         FileNamePositionMap _indexMap;
+        FileNameHashIndex   _hashIndex;
+        osg::ref_ptr<PositionalFile> _positionalFile;
 
 
         template <typename T>
@@ -7,6 +7,7 @@
 #include <osgDB/Registry>
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
+#include <osgDB/ImageBufferPool>
 
 #include <sstream>
 
@@ -49,6 +50,33 @@ private:
     std::string _message;
 };
 
+/** Return the pixel format of the decoded image given its PNG color type and number of channels, 0 if it isn't supported.*/
+static GLenum computePixelFormat(int color, png_byte channels)
+{
+    GLenum pixelFormat = 0;
+    switch(color)
+    {
+      case(PNG_SOLID): pixelFormat = GL_LUMINANCE; break;
+      case(PNG_ALPHA): pixelFormat = GL_ALPHA; break;
+      case(PNG_COLOR_TYPE_GRAY): pixelFormat =GL_LUMINANCE ; break;
+      case(PNG_COLOR_TYPE_GRAY_ALPHA): pixelFormat = GL_LUMINANCE_ALPHA; break;
+      case(PNG_COLOR_TYPE_RGB): pixelFormat = GL_RGB; break;
+      case(PNG_COLOR_TYPE_PALETTE): pixelFormat = GL_RGB; break;
+      case(PNG_COLOR_TYPE_RGB_ALPHA): pixelFormat = GL_RGBA; break;
+      default: break;
+    }
+
+    // Some paletted images contain alpha information.  To be
+    // able to give that back to the calling program, we need to
+    // check the number of channels in the image.  However, the
+    // call might not return correct information unless
+    // png_read_end is called first.  See libpng man page.
+    if (pixelFormat == GL_RGB && channels == 4)
+        pixelFormat = GL_RGBA;
+
+    return pixelFormat;
+}
+
 void user_error_fn(png_structp /*png_ptr*/, png_const_charp error_msg)
 {
 #ifdef OSG_CPP_EXCEPTIONS_AVAILABLE
@@ -160,7 +188,7 @@ class ReaderWriterPNG : public osgDB::ReaderWriter
             return WriteResult::FILE_SAVED;
         }
 
-        ReadResult readPNGStream(std::istream& fin) const
+        ReadResult readPNGStream(std::istream& fin, const osgDB::ReaderWriter::Options* options=NULL) const
         {
             int trans = PNG_ALPHA;
             pngInfo pInfo;
@@ -268,7 +296,19 @@ class ReaderWriterPNG : public osgDB::ReaderWriter
 
                 png_read_update_info(png, info);
 
-                data = (png_bytep) new unsigned char [png_get_rowbytes(png, info)*height];
+                GLenum dataType = depth<=8?GL_UNSIGNED_BYTE:GL_UNSIGNED_SHORT;
+
+                // decode straight into a recycled image when the caller provides an ImageBufferPool.
+                osg::ref_ptr<osg::Image> pooledImage;
+                osgDB::ImageBufferPool* pool = osgDB::ImageBufferPool::getImageBufferPool(options);
+                GLenum pooledPixelFormat = pool ? computePixelFormat(color, png_get_channels(png, info)) : 0;
+                if (pooledPixelFormat!=0)
+                {
+                    pooledImage = pool->allocateImage(width, height, 1, pooledPixelFormat, dataType, 1);
+                    if (pooledImage->getRowSizeInBytes()!=png_get_rowbytes(png, info)) pooledImage = 0;
+                }
+
+                data = pooledImage.valid() ? pooledImage->data() : (png_bytep) new unsigned char [png_get_rowbytes(png, info)*height];
                 row_p = new png_bytep [height];
 
                 bool StandardOrientation = true;
@@ -284,27 +324,7 @@ class ReaderWriterPNG : public osgDB::ReaderWriter
                 delete [] row_p;
                 png_read_end(png, endinfo);
 
-                GLenum pixelFormat = 0;
-                GLenum dataType = depth<=8?GL_UNSIGNED_BYTE:GL_UNSIGNED_SHORT;
-                switch(color)
-                {
-                  case(PNG_SOLID): pixelFormat = GL_LUMINANCE; break;
-                  case(PNG_ALPHA): pixelFormat = GL_ALPHA; break;
-                  case(PNG_COLOR_TYPE_GRAY): pixelFormat =GL_LUMINANCE ; break;
-                  case(PNG_COLOR_TYPE_GRAY_ALPHA): pixelFormat = GL_LUMINANCE_ALPHA; break;
-                  case(PNG_COLOR_TYPE_RGB): pixelFormat = GL_RGB; break;
-                  case(PNG_COLOR_TYPE_PALETTE): pixelFormat = GL_RGB; break;
-                  case(PNG_COLOR_TYPE_RGB_ALPHA): pixelFormat = GL_RGBA; break;
-                  default: break;
-                }
-
-                // Some paletted images contain alpha information.  To be
-                // able to give that back to the calling program, we need to
-                // check the number of channels in the image.  However, the
-                // call might not return correct information unless
-                // png_read_end is called first.  See libpng man page.
-                if (pixelFormat == GL_RGB && png_get_channels(png, info) == 4)
-                    pixelFormat = GL_RGBA;
+                GLenum pixelFormat = computePixelFormat(color, png_get_channels(png, info));
 
                 int internalFormat = pixelFormat;
 
@@ -313,7 +333,17 @@ class ReaderWriterPNG : public osgDB::ReaderWriter
                 //    delete [] data;
 
                 if (pixelFormat==0)
+                {
+                    if (!pooledImage.valid()) delete [] data;
                     return ReadResult::FILE_NOT_HANDLED;
+                }
+
+                if (pooledImage.valid())
+                {
+                    pooledImage->setPixelFormat(pixelFormat);
+                    pooledImage->setInternalTextureFormat(internalFormat);
+                    return ReadResult(pooledImage.get());
+                }
 
                 osg::Image* pOsgImage = new osg::Image();
 
@@ -364,9 +394,9 @@ class ReaderWriterPNG : public osgDB::ReaderWriter
             return readImage(file, options);
         }
 
-        virtual ReadResult readImage(std::istream& fin,const Options* =NULL) const
+        virtual ReadResult readImage(std::istream& fin,const Options* options =NULL) const
         {
-            return readPNGStream(fin);
+            return readPNGStream(fin, options);
         }
 
         virtual ReadResult readImage(const std::string& file, const osgDB::ReaderWriter::Options* options) const
@@ -379,7 +409,7 @@ class ReaderWriterPNG : public osgDB::ReaderWriter
 
             osgDB::ifstream istream(fileName.c_str(), std::ios::in | std::ios::binary);
             if(!istream) return ReadResult::FILE_NOT_HANDLED;
-            ReadResult rr = readPNGStream(istream);
+            ReadResult rr = readPNGStream(istream, options);
             if(rr.validImage()) rr.getImage()->setFileName(file);
             return rr;
         }
@@ -0,0 +1,325 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include "OctreeBuilder.h"
+
+#include <osg/Notify>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/PagedLOD>
+#include <osg/Timer>
+
+#include <osgDB/FileUtils>
+#include <osgDB/WriteFile>
+
+#include <stdio.h>
+#include <float.h>
+#include <math.h>
+
+using namespace pointcloud;
+
+namespace
+{
+
+// Point record used for the temporary spill files, positions relative to the octree origin.
+struct SpillPoint
+{
+    float           x, y, z;
+    unsigned char   rgba[4];
+};
+
+const unsigned int s_batchSize = 65536;
+
+}
+
+struct OctreeBuilder::Input
+{
+    virtual ~Input() {}
+    virtual uint64_t getNumPoints() const = 0;
+    virtual unsigned int read(std::vector<SpillPoint>& points) = 0;
+};
+
+struct OctreeBuilder::SourceInput : public OctreeBuilder::Input
+{
+    SourceInput(PointSource& source, const osg::Vec3d& origin):
+        _source(source),
+        _origin(origin) {}
+
+    virtual uint64_t getNumPoints() const { return _source.getNumPoints(); }
+
+    virtual unsigned int read(std::vector<SpillPoint>& points)
+    {
+        _points.clear();
+        unsigned int numPoints = _source.read(_points, s_batchSize);
+        points.resize(numPoints);
+        for(unsigned int i=0; i<numPoints; ++i)
+        {
+            const Point& point = _points[i];
+            SpillPoint& sp = points[i];
+            sp.x = static_cast<float>(point.x-_origin.x());
+            sp.y = static_cast<float>(point.y-_origin.y());
+            sp.z = static_cast<float>(point.z-_origin.z());
+            sp.rgba[0] = point.r;
+            sp.rgba[1] = point.g;
+            sp.rgba[2] = point.b;
+            sp.rgba[3] = point.a;
+        }
+        return numPoints;
+    }
+
+    PointSource&    _source;
+    osg::Vec3d      _origin;
+    PointList       _points;
+};
+
+struct OctreeBuilder::SpillInput : public OctreeBuilder::Input
+{
+    SpillInput(FILE* file, uint64_t numPoints):
+        _file(file),
+        _numPoints(numPoints) {}
+
+    virtual uint64_t getNumPoints() const { return _numPoints; }
+
+    virtual unsigned int read(std::vector<SpillPoint>& points)
+    {
+        points.resize(s_batchSize);
+        size_t numPoints = fread(&points[0], sizeof(SpillPoint), s_batchSize, _file);
+        points.resize(numPoints);
+        return static_cast<unsigned int>(numPoints);
+    }
+
+    FILE*       _file;
+    uint64_t    _numPoints;
+};
+
+OctreeBuilder::OctreeBuilder():
+    _maxPointsPerTile(65536),
+    _gridResolution(128),
+    _maxDepth(20),
+    _pixelSize(256.0f),
+    _numTiles(0)
+{
+}
+
+bool OctreeBuilder::build(PointSource& source, const std::string& directory, osg::Vec3d& origin, const osgDB::Options* options)
+{
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    _directory = directory;
+    _options = options;
+    _numTiles = 0;
+
+    if (!osgDB::fileExists(_directory) && !osgDB::makeDirectory(_directory))
+    {
+        OSG_WARN<<"pointcloud: could not create output directory "<<_directory<<std::endl;
+        return false;
+    }
+
+    // use the header bounds when available, otherwise make an extra pass over the file.
+    osg::BoundingBoxd bounds = source.getBounds();
+    if (!source.hasBounds())
+    {
+        PointList points;
+        while(source.read(points, s_batchSize)>0)
+        {
+            for(PointList::const_iterator itr = points.begin(); itr != points.end(); ++itr)
+            {
+                bounds.expandBy(itr->x, itr->y, itr->z);
+            }
+            points.clear();
+        }
+        source.rewind();
+    }
+
+    if (!bounds.valid())
+    {
+        OSG_NOTICE<<"pointcloud: no points to build octree from."<<std::endl;
+        return false;
+    }
+
+    // the octree cells are cubes, slightly enlarged to keep points on the max faces inside.
+    double size = osg::maximum(bounds.xMax()-bounds.xMin(), osg::maximum(bounds.yMax()-bounds.yMin(), bounds.zMax()-bounds.zMin()));
+    size = osg::maximum(size*1.001, 1e-3);
+    origin = bounds._min;
+
+    SourceInput input(source, origin);
+    bool result = processNode(input, "r", osg::Vec3f(0.0f,0.0f,0.0f), static_cast<float>(size), 0);
+
+    OSG_NOTICE<<"pointcloud: built "<<_numTiles<<" tiles from "<<source.getNumPoints()<<" points in "
+              <<osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick())<<"s"<<std::endl;
+
+    return result;
+}
+
+bool OctreeBuilder::processNode(Input& input, const std::string& name, const osg::Vec3f& min, float size, unsigned int depth)
+{
+    bool keepAllPoints = input.getNumPoints()<=_maxPointsPerTile || depth>=_maxDepth;
+
+    std::vector<bool> occupied;
+    if (!keepAllPoints) occupied.resize(_gridResolution*_gridResolution*_gridResolution, false);
+
+    std::vector<SpillPoint> sample;
+    sample.reserve(static_cast<size_t>(osg::minimum(input.getNumPoints(), static_cast<uint64_t>(_maxPointsPerTile))));
+
+    FILE* childFiles[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    uint64_t childCounts[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    std::string childNames[8];
+    for(int c=0; c<8; ++c)
+    {
+        childNames[c] = name;
+        childNames[c] += static_cast<char>('0'+c);
+    }
+
+    float halfSize = size*0.5f;
+    osg::Vec3f mid = min + osg::Vec3f(halfSize, halfSize, halfSize);
+    float cellScale = float(_gridResolution)/size;
+    int maxCell = static_cast<int>(_gridResolution)-1;
+
+    std::vector<SpillPoint> points;
+    while(input.read(points)>0)
+    {
+        for(std::vector<SpillPoint>::const_iterator itr = points.begin(); itr != points.end(); ++itr)
+        {
+            const SpillPoint& point = *itr;
+            if (keepAllPoints)
+            {
+                sample.push_back(point);
+                continue;
+            }
+
+            int cx = osg::clampBetween(static_cast<int>((point.x-min.x())*cellScale), 0, maxCell);
+            int cy = osg::clampBetween(static_cast<int>((point.y-min.y())*cellScale), 0, maxCell);
+            int cz = osg::clampBetween(static_cast<int>((point.z-min.z())*cellScale), 0, maxCell);
+            size_t cell = (static_cast<size_t>(cz)*_gridResolution + cy)*_gridResolution + cx;
+
+            if (!occupied[cell] && sample.size()<_maxPointsPerTile)
+            {
+                occupied[cell] = true;
+                sample.push_back(point);
+                continue;
+            }
+
+            int octant = (point.x>=mid.x() ? 1 : 0) | (point.y>=mid.y() ? 2 : 0) | (point.z>=mid.z() ? 4 : 0);
+            if (!childFiles[octant])
+            {
+                std::string spillFileName = _directory + "/" + childNames[octant] + ".tmp";
+                childFiles[octant] = fopen(spillFileName.c_str(), "w+b");
+                if (!childFiles[octant])
+                {
+                    OSG_WARN<<"pointcloud: could not create temporary file "<<spillFileName<<std::endl;
+                    for(int c=0; c<8; ++c) if (childFiles[c]) fclose(childFiles[c]);
+                    return false;
+                }
+            }
+            fwrite(&point, sizeof(SpillPoint), 1, childFiles[octant]);
+            ++childCounts[octant];
+        }
+    }
+
+    std::vector<bool>().swap(occupied);
+
+    // quantize the sample relative to the tile centre.
+    osg::Vec3f center = mid;
+    float quantizeScale = 32767.0f/halfSize;
+
+    osg::ref_ptr<osg::Vec3sArray> vertices = new osg::Vec3sArray;
+    osg::ref_ptr<osg::Vec4ubArray> colors = new osg::Vec4ubArray;
+    vertices->reserve(sample.size());
+    colors->reserve(sample.size());
+    for(std::vector<SpillPoint>::const_iterator itr = sample.begin(); itr != sample.end(); ++itr)
+    {
+        vertices->push_back(osg::Vec3s(static_cast<short>(osg::clampBetween((itr->x-center.x())*quantizeScale, -32767.0f, 32767.0f)),
+                                       static_cast<short>(osg::clampBetween((itr->y-center.y())*quantizeScale, -32767.0f, 32767.0f)),
+                                       static_cast<short>(osg::clampBetween((itr->z-center.z())*quantizeScale, -32767.0f, 32767.0f))));
+        colors->push_back(osg::Vec4ub(itr->rgba[0], itr->rgba[1], itr->rgba[2], itr->rgba[3]));
+    }
+    std::vector<SpillPoint>().swap(sample);
+
+    colors->setNormalize(true);
+
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setUseVertexBufferObjects(true);
+    geometry->setVertexArray(vertices.get());
+    geometry->setColorArray(colors.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
+
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    geode->addDrawable(geometry.get());
+
+    osg::ref_ptr<osg::MatrixTransform> quantization = new osg::MatrixTransform;
+    quantization->setMatrix(osg::Matrix::scale(halfSize/32767.0f, halfSize/32767.0f, halfSize/32767.0f)*osg::Matrix::translate(center));
+    quantization->addChild(geode.get());
+
+    osg::ref_ptr<osg::Group> tile = new osg::Group;
+    tile->setName(name);
+    tile->addChild(quantization.get());
+
+    float childSize = halfSize;
+    float childRadius = childSize*0.5f*sqrtf(3.0f);
+    for(int c=0; c<8; ++c)
+    {
+        if (childCounts[c]==0) continue;
+
+        osg::Vec3f childMin(min.x() + ((c&1) ? halfSize : 0.0f),
+                            min.y() + ((c&2) ? halfSize : 0.0f),
+                            min.z() + ((c&4) ? halfSize : 0.0f));
+
+        osg::ref_ptr<osg::PagedLOD> plod = new osg::PagedLOD;
+        plod->setCenterMode(osg::LOD::USER_DEFINED_CENTER);
+        plod->setCenter(childMin + osg::Vec3f(childSize*0.5f, childSize*0.5f, childSize*0.5f));
+        plod->setRadius(childRadius);
+        plod->setRangeMode(osg::LOD::PIXEL_SIZE_ON_SCREEN);
+        plod->setFileName(0, childNames[c] + ".osgb.pointcloud");
+        plod->setRange(0, _pixelSize, FLT_MAX);
+        tile->addChild(plod.get());
+    }
+
+    std::string tileFileName = _directory + "/" + name + ".osgb";
+    if (!osgDB::writeNodeFile(*tile, tileFileName, _options.get()))
+    {
+        OSG_WARN<<"pointcloud: could not write tile "<<tileFileName<<std::endl;
+        for(int c=0; c<8; ++c) if (childFiles[c]) fclose(childFiles[c]);
+        return false;
+    }
+    ++_numTiles;
+
+    tile = 0;
+    geometry = 0;
+    vertices = 0;
+    colors = 0;
+
+    // now process the children from their spill files, depth first to bound the temporary disk usage.
+    bool result = true;
+    for(int c=0; c<8; ++c)
+    {
+        if (!childFiles[c]) continue;
+
+        rewind(childFiles[c]);
+        if (result)
+        {
+            osg::Vec3f childMin(min.x() + ((c&1) ? halfSize : 0.0f),
+                                min.y() + ((c&2) ? halfSize : 0.0f),
+                                min.z() + ((c&4) ? halfSize : 0.0f));
+
+            SpillInput childInput(childFiles[c], childCounts[c]);
+            result = processNode(childInput, childNames[c], childMin, childSize, depth+1);
+        }
+
+        fclose(childFiles[c]);
+        std::string spillFileName = _directory + "/" + childNames[c] + ".tmp";
+        remove(spillFileName.c_str());
+    }
+
+    return result;
+}
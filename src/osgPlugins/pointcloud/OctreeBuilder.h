@@ -0,0 +1,77 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#ifndef POINTCLOUD_OCTREEBUILDER
+#define POINTCLOUD_OCTREEBUILDER 1
+
+#include <osg/Vec3d>
+#include <osgDB/Options>
+
+#include "PointSource.h"
+
+namespace pointcloud
+{
+
+/** Builds an on disk octree of PagedLOD tiles from a PointSource without holding the cloud in memory.
+  * Each tile keeps a grid subsample of the points that reach it, the remaining points are spilled to
+  * temporary files per octant which are then processed recursively. Tiles store positions quantized
+  * to shorts relative to the tile centre and colours packed as unsigned bytes.*/
+class OctreeBuilder
+{
+public:
+
+    OctreeBuilder();
+
+    /** Maximum number of points kept in a tile.*/
+    void setMaxPointsPerTile(unsigned int numPoints) { _maxPointsPerTile = numPoints; }
+    unsigned int getMaxPointsPerTile() const { return _maxPointsPerTile; }
+
+    /** Number of sampling grid cells along each axis of a tile.*/
+    void setGridResolution(unsigned int resolution) { _gridResolution = resolution; }
+    unsigned int getGridResolution() const { return _gridResolution; }
+
+    /** Maximum depth of the octree, tiles at this depth keep all their points.*/
+    void setMaxDepth(unsigned int depth) { _maxDepth = depth; }
+    unsigned int getMaxDepth() const { return _maxDepth; }
+
+    /** Size in pixels on screen of a tile's bounding sphere at which its children are paged in.*/
+    void setPixelSize(float pixelSize) { _pixelSize = pixelSize; }
+    float getPixelSize() const { return _pixelSize; }
+
+    /** Build the tiles in directory, returning the origin that the tile coordinates are relative to.*/
+    bool build(PointSource& source, const std::string& directory, osg::Vec3d& origin, const osgDB::Options* options);
+
+    /** File name of the root tile within the output directory.*/
+    static std::string getRootTileName() { return "r.osgb"; }
+
+protected:
+
+    struct Input;
+    struct SourceInput;
+    struct SpillInput;
+
+    bool processNode(Input& input, const std::string& name, const osg::Vec3f& min, float size, unsigned int depth);
+
+    unsigned int                    _maxPointsPerTile;
+    unsigned int                    _gridResolution;
+    unsigned int                    _maxDepth;
+    float                           _pixelSize;
+
+    std::string                     _directory;
+    osg::ref_ptr<const osgDB::Options> _options;
+    uint64_t                        _numTiles;
+};
+
+}
+
+#endif
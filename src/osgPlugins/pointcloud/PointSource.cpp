@@ -0,0 +1,479 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include "PointSource.h"
+
+#include <osg/Notify>
+
+#include <sstream>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace pointcloud;
+
+namespace
+{
+
+// Decoding helpers for little and big endian binary data, independent of the host byte order.
+inline uint32_t decodeUInt(const unsigned char* ptr, unsigned int size, bool bigEndian)
+{
+    uint32_t value = 0;
+    for(unsigned int i=0; i<size; ++i)
+    {
+        value |= static_cast<uint32_t>(ptr[bigEndian ? size-1-i : i]) << (8*i);
+    }
+    return value;
+}
+
+inline uint64_t decodeUInt64(const unsigned char* ptr, bool bigEndian)
+{
+    uint64_t value = 0;
+    for(unsigned int i=0; i<8; ++i)
+    {
+        value |= static_cast<uint64_t>(ptr[bigEndian ? 7-i : i]) << (8*i);
+    }
+    return value;
+}
+
+inline double decodeDouble(const unsigned char* ptr, bool bigEndian)
+{
+    uint64_t bits = decodeUInt64(ptr, bigEndian);
+    double value;
+    memcpy(&value, &bits, sizeof(double));
+    return value;
+}
+
+inline float decodeFloat(const unsigned char* ptr, bool bigEndian)
+{
+    uint32_t bits = decodeUInt(ptr, 4, bigEndian);
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Uncompressed LAS 1.0 - 1.4, point data formats 0 to 10. The points are read directly from the
+// file rather than through libLAS so that the plugin has no external dependencies.
+//
+class LASPointSource : public PointSource
+{
+public:
+
+    LASPointSource():
+        _pointDataOffset(0),
+        _pointFormat(0),
+        _recordLength(0),
+        _colorOffset(0),
+        _eightBitColors(false) {}
+
+    virtual bool open(const std::string& fileName)
+    {
+        _fin.open(fileName.c_str(), std::ios::in | std::ios::binary);
+        if (!_fin) return false;
+
+        unsigned char header[375];
+        memset(header, 0, sizeof(header));
+        _fin.read(reinterpret_cast<char*>(header), 227);
+        if (_fin.gcount()!=227 || strncmp(reinterpret_cast<const char*>(header), "LASF", 4)!=0)
+        {
+            OSG_NOTICE<<"pointcloud: "<<fileName<<" is not a LAS file."<<std::endl;
+            return false;
+        }
+
+        unsigned int versionMinor = header[25];
+        unsigned int headerSize = decodeUInt(header+94, 2, false);
+        if (headerSize>227)
+        {
+            _fin.read(reinterpret_cast<char*>(header+227), osg::minimum(headerSize, 375u)-227);
+        }
+
+        _pointDataOffset = decodeUInt(header+96, 4, false);
+        _pointFormat = header[104] & 0x3f;
+        _recordLength = decodeUInt(header+105, 2, false);
+        _numPoints = decodeUInt(header+107, 4, false);
+        if (versionMinor>=4 && headerSize>=255) _numPoints = decodeUInt64(header+247, false);
+
+        if (_pointFormat>10 || (header[104] & 0x80))
+        {
+            OSG_NOTICE<<"pointcloud: compressed or unsupported LAS point format "<<_pointFormat<<" in "<<fileName<<std::endl;
+            return false;
+        }
+
+        for(int i=0; i<3; ++i)
+        {
+            _scale[i] = decodeDouble(header+131+i*8, false);
+            _offset[i] = decodeDouble(header+155+i*8, false);
+        }
+
+        _bounds.set(decodeDouble(header+187, false), decodeDouble(header+203, false), decodeDouble(header+219, false),
+                    decodeDouble(header+179, false), decodeDouble(header+195, false), decodeDouble(header+211, false));
+
+        switch(_pointFormat)
+        {
+            case 2: _colorOffset = 20; break;
+            case 3:
+            case 5: _colorOffset = 28; break;
+            case 7:
+            case 8:
+            case 10: _colorOffset = 30; break;
+            default: _colorOffset = 0; break;
+        }
+        _hasColors = _colorOffset!=0 && _recordLength>=_colorOffset+6;
+
+        if (_hasColors)
+        {
+            // the spec asks for 16 bit colours but many writers store 8 bit values, check the start of the file.
+            rewind();
+            std::vector<unsigned char> buffer;
+            unsigned int numSamples = static_cast<unsigned int>(osg::minimum(_numPoints, static_cast<uint64_t>(1024)));
+            buffer.resize(numSamples*_recordLength);
+            if (numSamples>0) _fin.read(reinterpret_cast<char*>(&buffer[0]), buffer.size());
+
+            unsigned int maxColor = 0;
+            for(unsigned int i=0; i<numSamples; ++i)
+            {
+                const unsigned char* color = &buffer[i*_recordLength+_colorOffset];
+                for(int c=0; c<3; ++c) maxColor = osg::maximum(maxColor, decodeUInt(color+c*2, 2, false));
+            }
+            _eightBitColors = (maxColor<256);
+        }
+
+        return rewind();
+    }
+
+    virtual bool rewind()
+    {
+        _fin.clear();
+        _fin.seekg(_pointDataOffset, std::ios::beg);
+        _numPointsRead = 0;
+        return _fin.good();
+    }
+
+    virtual unsigned int read(PointList& points, unsigned int maxPoints)
+    {
+        unsigned int numPoints = static_cast<unsigned int>(osg::minimum(static_cast<uint64_t>(maxPoints), _numPoints-_numPointsRead));
+        if (numPoints==0) return 0;
+
+        _buffer.resize(numPoints*_recordLength);
+        _fin.read(reinterpret_cast<char*>(&_buffer[0]), _buffer.size());
+        numPoints = static_cast<unsigned int>(_fin.gcount())/_recordLength;
+
+        for(unsigned int i=0; i<numPoints; ++i)
+        {
+            const unsigned char* record = &_buffer[i*_recordLength];
+
+            Point point;
+            point.x = double(static_cast<int32_t>(decodeUInt(record, 4, false)))*_scale[0] + _offset[0];
+            point.y = double(static_cast<int32_t>(decodeUInt(record+4, 4, false)))*_scale[1] + _offset[1];
+            point.z = double(static_cast<int32_t>(decodeUInt(record+8, 4, false)))*_scale[2] + _offset[2];
+            if (_hasColors)
+            {
+                const unsigned char* color = record+_colorOffset;
+                unsigned int shift = _eightBitColors ? 0 : 8;
+                point.r = static_cast<unsigned char>(decodeUInt(color, 2, false)>>shift);
+                point.g = static_cast<unsigned char>(decodeUInt(color+2, 2, false)>>shift);
+                point.b = static_cast<unsigned char>(decodeUInt(color+4, 2, false)>>shift);
+            }
+            else
+            {
+                point.r = point.g = point.b = 255;
+            }
+            point.a = 255;
+            points.push_back(point);
+        }
+
+        _numPointsRead += numPoints;
+        return numPoints;
+    }
+
+protected:
+
+    unsigned int                _pointDataOffset;
+    unsigned int                _pointFormat;
+    unsigned int                _recordLength;
+    unsigned int                _colorOffset;
+    bool                        _eightBitColors;
+    double                      _scale[3];
+    double                      _offset[3];
+    std::vector<unsigned char>  _buffer;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// PLY files whose first element is the vertex element, in ascii or binary form.
+//
+class PLYPointSource : public PointSource
+{
+public:
+
+    PLYPointSource():
+        _format(ASCII),
+        _vertexSize(0),
+        _dataOffset(0) {}
+
+    virtual bool open(const std::string& fileName)
+    {
+        _fin.open(fileName.c_str(), std::ios::in | std::ios::binary);
+        if (!_fin) return false;
+
+        std::string line;
+        std::getline(_fin, line);
+        if (line.compare(0, 3, "ply")!=0)
+        {
+            OSG_NOTICE<<"pointcloud: "<<fileName<<" is not a PLY file."<<std::endl;
+            return false;
+        }
+
+        bool inVertexElement = false;
+        bool seenElement = false;
+        while(std::getline(_fin, line))
+        {
+            if (!line.empty() && line[line.size()-1]=='\r') line.erase(line.size()-1);
+
+            std::istringstream iss(line);
+            std::string keyword;
+            iss >> keyword;
+
+            if (keyword=="format")
+            {
+                std::string format;
+                iss >> format;
+                if (format=="binary_little_endian") _format = BINARY_LITTLE_ENDIAN;
+                else if (format=="binary_big_endian") _format = BINARY_BIG_ENDIAN;
+                else _format = ASCII;
+            }
+            else if (keyword=="element")
+            {
+                std::string name;
+                uint64_t count = 0;
+                iss >> name >> count;
+                if (!seenElement && name=="vertex")
+                {
+                    inVertexElement = true;
+                    _numPoints = count;
+                }
+                else
+                {
+                    if (!seenElement)
+                    {
+                        OSG_NOTICE<<"pointcloud: the first element of "<<fileName<<" is not the vertex element."<<std::endl;
+                        return false;
+                    }
+                    inVertexElement = false;
+                }
+                seenElement = true;
+            }
+            else if (keyword=="property" && inVertexElement)
+            {
+                std::string type, name;
+                iss >> type;
+                if (type=="list")
+                {
+                    OSG_NOTICE<<"pointcloud: list properties on the vertex element are not supported."<<std::endl;
+                    return false;
+                }
+                iss >> name;
+
+                Property property;
+                property.offset = _vertexSize;
+                property.size = typeSize(type);
+                property.isFloat = (type=="float" || type=="float32" || type=="double" || type=="float64");
+                property.isSigned = (type=="char" || type=="int8" || type=="short" || type=="int16" || type=="int" || type=="int32");
+                property.target = targetForName(name);
+                if (property.size==0)
+                {
+                    OSG_NOTICE<<"pointcloud: unknown PLY property type "<<type<<std::endl;
+                    return false;
+                }
+                if (property.target>=RED && property.target<=BLUE) _hasColors = true;
+
+                _properties.push_back(property);
+                _vertexSize += property.size;
+            }
+            else if (keyword=="end_header")
+            {
+                break;
+            }
+        }
+
+        _dataOffset = _fin.tellg();
+        return !_properties.empty();
+    }
+
+    virtual bool rewind()
+    {
+        _fin.clear();
+        _fin.seekg(_dataOffset, std::ios::beg);
+        _numPointsRead = 0;
+        return _fin.good();
+    }
+
+    virtual unsigned int read(PointList& points, unsigned int maxPoints)
+    {
+        unsigned int numPoints = static_cast<unsigned int>(osg::minimum(static_cast<uint64_t>(maxPoints), _numPoints-_numPointsRead));
+        if (numPoints==0) return 0;
+
+        double values[NUM_TARGETS];
+        if (_format==ASCII)
+        {
+            std::string line;
+            unsigned int numRead = 0;
+            while(numRead<numPoints && std::getline(_fin, line))
+            {
+                const char* ptr = line.c_str();
+                resetValues(values);
+                for(std::vector<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+                {
+                    char* next = 0;
+                    double value = strtod(ptr, &next);
+                    if (next==ptr) break;
+                    ptr = next;
+                    values[itr->target] = itr->isFloat || itr->target<RED ? value : value/255.0;
+                }
+                points.push_back(createPoint(values));
+                ++numRead;
+            }
+            numPoints = numRead;
+        }
+        else
+        {
+            bool bigEndian = (_format==BINARY_BIG_ENDIAN);
+
+            _buffer.resize(numPoints*_vertexSize);
+            _fin.read(reinterpret_cast<char*>(&_buffer[0]), _buffer.size());
+            numPoints = static_cast<unsigned int>(_fin.gcount())/_vertexSize;
+
+            for(unsigned int i=0; i<numPoints; ++i)
+            {
+                const unsigned char* vertex = &_buffer[i*_vertexSize];
+                resetValues(values);
+                for(std::vector<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+                {
+                    if (itr->target==IGNORED) continue;
+
+                    const unsigned char* ptr = vertex+itr->offset;
+                    double value;
+                    if (itr->isFloat) value = (itr->size==8) ? decodeDouble(ptr, bigEndian) : double(decodeFloat(ptr, bigEndian));
+                    else if (itr->isSigned)
+                    {
+                        uint32_t bits = decodeUInt(ptr, itr->size, bigEndian);
+                        if (itr->size<4 && (bits & (1u<<(itr->size*8-1)))) bits |= ~((1u<<(itr->size*8))-1);
+                        value = double(static_cast<int32_t>(bits));
+                    }
+                    else value = double(decodeUInt(ptr, itr->size, bigEndian));
+
+                    // integer colours are normalized from their full range
+                    if (itr->target>=RED && !itr->isFloat) value /= double((itr->size>=2) ? 65535 : 255);
+
+                    values[itr->target] = value;
+                }
+                points.push_back(createPoint(values));
+            }
+        }
+
+        _numPointsRead += numPoints;
+        return numPoints;
+    }
+
+protected:
+
+    enum Format
+    {
+        ASCII,
+        BINARY_LITTLE_ENDIAN,
+        BINARY_BIG_ENDIAN
+    };
+
+    enum Target
+    {
+        X = 0,
+        Y,
+        Z,
+        RED,
+        GREEN,
+        BLUE,
+        ALPHA,
+        IGNORED,
+        NUM_TARGETS
+    };
+
+    struct Property
+    {
+        unsigned int    offset;
+        unsigned int    size;
+        bool            isFloat;
+        bool            isSigned;
+        Target          target;
+    };
+
+    static unsigned int typeSize(const std::string& type)
+    {
+        if (type=="char" || type=="uchar" || type=="int8" || type=="uint8") return 1;
+        if (type=="short" || type=="ushort" || type=="int16" || type=="uint16") return 2;
+        if (type=="int" || type=="uint" || type=="int32" || type=="uint32" || type=="float" || type=="float32") return 4;
+        if (type=="double" || type=="float64") return 8;
+        return 0;
+    }
+
+    static Target targetForName(const std::string& name)
+    {
+        if (name=="x") return X;
+        if (name=="y") return Y;
+        if (name=="z") return Z;
+        if (name=="red" || name=="r" || name=="diffuse_red") return RED;
+        if (name=="green" || name=="g" || name=="diffuse_green") return GREEN;
+        if (name=="blue" || name=="b" || name=="diffuse_blue") return BLUE;
+        if (name=="alpha" || name=="a" || name=="diffuse_alpha") return ALPHA;
+        return IGNORED;
+    }
+
+    static void resetValues(double* values)
+    {
+        values[X] = values[Y] = values[Z] = 0.0;
+        values[RED] = values[GREEN] = values[BLUE] = values[ALPHA] = 1.0;
+    }
+
+    static unsigned char toByte(double value)
+    {
+        return static_cast<unsigned char>(osg::clampBetween(value, 0.0, 1.0)*255.0+0.5);
+    }
+
+    static Point createPoint(const double* values)
+    {
+        Point point;
+        point.x = values[X];
+        point.y = values[Y];
+        point.z = values[Z];
+        point.r = toByte(values[RED]);
+        point.g = toByte(values[GREEN]);
+        point.b = toByte(values[BLUE]);
+        point.a = toByte(values[ALPHA]);
+        return point;
+    }
+
+    Format                      _format;
+    std::vector<Property>       _properties;
+    unsigned int                _vertexSize;
+    std::streampos              _dataOffset;
+    std::vector<unsigned char>  _buffer;
+};
+
+}
+
+PointSource* PointSource::create(const std::string& extension)
+{
+    if (extension=="las") return new LASPointSource;
+    if (extension=="ply") return new PLYPointSource;
+    return 0;
+}
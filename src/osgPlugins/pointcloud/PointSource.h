@@ -0,0 +1,78 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#ifndef POINTCLOUD_POINTSOURCE
+#define POINTCLOUD_POINTSOURCE 1
+
+#include <osg/Referenced>
+#include <osg/BoundingBox>
+#include <osg/Types>
+
+#include <osgDB/fstream>
+
+#include <string>
+#include <vector>
+
+namespace pointcloud
+{
+
+struct Point
+{
+    double          x, y, z;
+    unsigned char   r, g, b, a;
+};
+
+typedef std::vector<Point> PointList;
+
+/** Sequential reader that streams the points of a file in batches so that the whole file never needs to be in memory.*/
+class PointSource : public osg::Referenced
+{
+public:
+
+    PointSource():
+        _numPoints(0),
+        _numPointsRead(0),
+        _hasColors(false) {}
+
+    virtual bool open(const std::string& fileName) = 0;
+
+    /** Restart reading from the first point.*/
+    virtual bool rewind() = 0;
+
+    /** Append up to maxPoints points to the list, returning the number appended, 0 at the end of the file.*/
+    virtual unsigned int read(PointList& points, unsigned int maxPoints) = 0;
+
+    /** Return true if the file header provides the bounds of the points.*/
+    bool hasBounds() const { return _bounds.valid(); }
+    const osg::BoundingBoxd& getBounds() const { return _bounds; }
+
+    uint64_t getNumPoints() const { return _numPoints; }
+    bool hasColors() const { return _hasColors; }
+
+    /** Create the PointSource that handles the given file extension, las and ply are supported.*/
+    static PointSource* create(const std::string& extension);
+
+protected:
+
+    virtual ~PointSource() {}
+
+    osgDB::ifstream     _fin;
+    osg::BoundingBoxd   _bounds;
+    uint64_t            _numPoints;
+    uint64_t            _numPointsRead;
+    bool                _hasColors;
+};
+
+}
+
+#endif
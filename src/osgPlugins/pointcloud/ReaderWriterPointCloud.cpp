@@ -0,0 +1,362 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/Notify>
+#include <osg/MatrixTransform>
+#include <osg/PagedLOD>
+#include <osg/Point>
+#include <osg/NodeVisitor>
+#include <osg/CullStack>
+
+#include <osgDB/ReaderWriter>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/Registry>
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
+#include <map>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stdlib.h>
+
+#include "OctreeBuilder.h"
+
+using namespace pointcloud;
+
+class PointBudgetCallback;
+
+/** Cull callback attached to each tile, recording the number of points it draws. Tiles that the cloud's
+  * PointBudgetCallback hasn't selected for refinement still draw their points, but their PagedLOD children
+  * are neither traversed nor requested from the DatabasePager.*/
+class TileCallback : public osg::NodeCallback
+{
+public:
+
+    TileCallback(unsigned int numPoints):
+        _numPoints(numPoints) {}
+
+    unsigned int getNumPoints() const { return _numPoints; }
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+
+protected:
+
+    unsigned int _numPoints;
+};
+
+/** Cull callback attached to the root of each point cloud, holding the cloud's point budget.
+  * Each cull traversal ranks the loaded tiles within the view frustum by their projected size and refines
+  * the largest first, for as long as the points of the child tiles they page in fit in the budget.
+  * The selection is kept per cull visitor, so each camera, and each cull thread, gets a budget of its own.*/
+class PointBudgetCallback : public osg::NodeCallback
+{
+public:
+
+    PointBudgetCallback(unsigned int budget):
+        _budget(budget) {}
+
+    unsigned int getBudget() const { return _budget; }
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        osg::CullStack* cullStack = dynamic_cast<osg::CullStack*>(nv);
+        osg::Group* group = node->asGroup();
+        if (cullStack && group && group->getNumChildren()>0 && group->getChild(0)->asGroup())
+        {
+            unsigned int frameNumber = nv->getFrameStamp() ? nv->getFrameStamp()->getFrameNumber() : 0;
+
+            Selection* selection = 0;
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+                // forget the visitors that have stopped culling this cloud.
+                for(Selections::iterator itr = _selections.begin(); itr != _selections.end();)
+                {
+                    if (itr->first!=nv && frameNumber>itr->second.frameNumber+1) _selections.erase(itr++);
+                    else ++itr;
+                }
+
+                selection = &_selections[nv];
+            }
+
+            // only this visitor accesses its selection, so it can be filled in without holding the lock.
+            selection->frameNumber = frameNumber;
+            selection->tiles.clear();
+            selectTiles(*cullStack, group->getChild(0)->asGroup(), selection->tiles);
+        }
+
+        traverse(node, nv);
+    }
+
+    /** Return true if the tile may page in and traverse its child tiles for the cull visitor.*/
+    bool isSelected(const osg::NodeVisitor* nv, const osg::Node* tile) const
+    {
+        const Selection* selection = 0;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            Selections::const_iterator itr = _selections.find(nv);
+            if (itr==_selections.end()) return true;
+            selection = &(itr->second);
+        }
+        return selection->tiles.count(tile)!=0;
+    }
+
+protected:
+
+    typedef std::set<const osg::Node*> Tiles;
+
+    struct Selection
+    {
+        Selection() : frameNumber(0) {}
+
+        unsigned int    frameNumber;
+        Tiles           tiles;
+    };
+
+    typedef std::map<const osg::NodeVisitor*, Selection> Selections;
+    typedef std::pair<float, osg::Group*> Candidate;
+
+    static unsigned int getNumPoints(const osg::Node* tile)
+    {
+        const TileCallback* tc = dynamic_cast<const TileCallback*>(tile->getCullCallback());
+        return tc ? tc->getNumPoints() : 0;
+    }
+
+    void selectTiles(osg::CullStack& cullStack, osg::Group* root, Tiles& tiles) const
+    {
+        float lodScale = cullStack.getLODScale()>0.0f ? cullStack.getLODScale() : 1.0f;
+
+        // the root tile is always drawn.
+        unsigned int numPoints = getNumPoints(root);
+
+        std::priority_queue<Candidate> candidates;
+        candidates.push(Candidate(cullStack.clampedPixelSize(root->getBound()), root));
+
+        while(!candidates.empty())
+        {
+            osg::Group* tile = candidates.top().second;
+            candidates.pop();
+
+            // the points drawn by refining the tile are those of its visible children that are large enough on
+            // screen for their PagedLOD to select them, children still to be paged in are assumed as large as the tile.
+            unsigned int numChildPoints = 0;
+            std::vector<Candidate> children;
+            for(unsigned int i=0; i<tile->getNumChildren(); ++i)
+            {
+                osg::PagedLOD* plod = dynamic_cast<osg::PagedLOD*>(tile->getChild(i));
+                if (!plod || plod->getNumRanges()==0 || cullStack.isCulled(plod->getBound())) continue;
+
+                float pixelSize = cullStack.clampedPixelSize(plod->getBound()) / lodScale;
+                if (pixelSize<plod->getMinRange(0)) continue;
+
+                osg::Group* child = plod->getNumChildren()>0 ? plod->getChild(0)->asGroup() : 0;
+                if (child)
+                {
+                    numChildPoints += getNumPoints(child);
+                    children.push_back(Candidate(pixelSize, child));
+                }
+                else
+                {
+                    numChildPoints += getNumPoints(tile);
+                }
+            }
+
+            if (numChildPoints==0 || numPoints+numChildPoints>_budget) continue;
+
+            numPoints += numChildPoints;
+            tiles.insert(tile);
+
+            for(std::vector<Candidate>::iterator itr = children.begin(); itr != children.end(); ++itr)
+            {
+                candidates.push(*itr);
+            }
+        }
+    }
+
+    unsigned int                _budget;
+    mutable OpenThreads::Mutex  _mutex;
+    Selections                  _selections;
+};
+
+void TileCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
+{
+    osg::Group* group = node->asGroup();
+    if (nv->getVisitorType()==osg::NodeVisitor::CULL_VISITOR && group && group->getNumChildren()>0)
+    {
+        // tiles are paged in without knowing which cloud they belong to, so find its budget on the path.
+        const osg::NodePath& nodePath = nv->getNodePath();
+        for(osg::NodePath::const_reverse_iterator itr = nodePath.rbegin(); itr != nodePath.rend(); ++itr)
+        {
+            const PointBudgetCallback* budget = dynamic_cast<const PointBudgetCallback*>((*itr)->getCullCallback());
+            if (budget)
+            {
+                if (!budget->isSelected(nv, node))
+                {
+                    group->getChild(0)->accept(*nv);
+                    return;
+                }
+                break;
+            }
+        }
+    }
+    traverse(node, nv);
+}
+
+class ReaderWriterPointCloud : public osgDB::ReaderWriter
+{
+public:
+
+    ReaderWriterPointCloud()
+    {
+        supportsExtension("pointcloud","Point cloud pseudo loader, builds and pages an octree of tiles from a .las or .ply file, i.e. survey.las.pointcloud");
+        supportsOption("outputDirectory=<path>","Directory in which to build the tiles, defaults to the source file name with .tiles appended");
+        supportsOption("rebuild","Rebuild the tiles even if they already exist");
+        supportsOption("maxPointsPerTile=<n>","Maximum number of points in each tile, default 65536");
+        supportsOption("pixelSize=<n>","Size on screen in pixels at which a tile's children are paged in, default 256");
+        supportsOption("pointBudget=<n>","Maximum number of points drawn per frame by each view of the cloud, default 5000000");
+        supportsOption("pointSize=<n>","Point size in pixels, default 2");
+    }
+
+    virtual const char* className() const { return "Point cloud pseudo-loader"; }
+
+    virtual ReadResult readNode(const std::string& file, const osgDB::ReaderWriter::Options* options) const
+    {
+        std::string ext = osgDB::getLowerCaseFileExtension(file);
+        if (!acceptsExtension(ext)) return ReadResult::FILE_NOT_HANDLED;
+
+        std::string sourceName = osgDB::getNameLessExtension(file);
+        std::string sourceExt = osgDB::getLowerCaseFileExtension(sourceName);
+
+        // tiles written by the OctreeBuilder are referenced as <tile>.osgb.pointcloud
+        if (sourceExt=="osgb") return readTile(sourceName, options);
+
+        osg::ref_ptr<PointSource> source = PointSource::create(sourceExt);
+        if (!source) return ReadResult::FILE_NOT_HANDLED;
+
+        std::string fileName = osgDB::findDataFile(sourceName, options);
+        if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
+
+        std::string directory = fileName + ".tiles";
+        bool rebuild = false;
+        unsigned int pointSize = 2;
+        unsigned int pointBudget = 5000000;
+        OctreeBuilder builder;
+
+        if (options)
+        {
+            std::istringstream iss(options->getOptionString());
+            std::string opt;
+            while (iss >> opt)
+            {
+                std::string::size_type found = opt.find("=");
+                std::string name = opt.substr(0, found);
+                std::string value = (found!=std::string::npos) ? opt.substr(found+1) : std::string();
+
+                if (name=="outputDirectory") directory = value;
+                else if (name=="rebuild") rebuild = true;
+                else if (name=="maxPointsPerTile") builder.setMaxPointsPerTile(atoi(value.c_str()));
+                else if (name=="pixelSize") builder.setPixelSize(osg::asciiToFloat(value.c_str()));
+                else if (name=="pointBudget") pointBudget = atoi(value.c_str());
+                else if (name=="pointSize") pointSize = atoi(value.c_str());
+            }
+        }
+
+        // the origin of the tile coordinates is stored alongside the tiles so existing tiles can be reused.
+        std::string originFileName = directory + "/origin.txt";
+        std::string rootFileName = directory + "/" + OctreeBuilder::getRootTileName();
+        osg::Vec3d origin;
+
+        bool haveTiles = false;
+        if (!rebuild && osgDB::fileExists(rootFileName))
+        {
+            osgDB::ifstream fin(originFileName.c_str());
+            fin.imbue(std::locale::classic());
+            fin >> origin.x() >> origin.y() >> origin.z();
+            haveTiles = !fin.fail();
+        }
+
+        if (!haveTiles)
+        {
+            if (!source->open(fileName)) return ReadResult::ERROR_IN_READING_FILE;
+
+            osg::ref_ptr<osgDB::Options> writeOptions = new osgDB::Options("Compressor=zlib");
+            if (!builder.build(*source, directory, origin, writeOptions.get())) return ReadResult::ERROR_IN_READING_FILE;
+
+            osgDB::ofstream fout(originFileName.c_str());
+            fout.imbue(std::locale::classic());
+            fout.precision(17);
+            fout << origin.x() << " " << origin.y() << " " << origin.z() << std::endl;
+        }
+
+        osg::ref_ptr<osg::Node> root = readTile(rootFileName, options).takeNode();
+        if (!root) return ReadResult::ERROR_IN_READING_FILE;
+
+        osg::ref_ptr<osg::MatrixTransform> transform = new osg::MatrixTransform;
+        transform->setMatrix(osg::Matrixd::translate(origin));
+        transform->addChild(root.get());
+        transform->setCullCallback(new PointBudgetCallback(pointBudget));
+
+        osg::StateSet* stateset = transform->getOrCreateStateSet();
+        stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        stateset->setAttribute(new osg::Point(static_cast<float>(pointSize)));
+
+        return transform.release();
+    }
+
+protected:
+
+    ReadResult readTile(const std::string& tileFileName, const osgDB::ReaderWriter::Options* options) const
+    {
+        std::string fileName = osgDB::findDataFile(tileFileName, options);
+        if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
+
+        osg::ref_ptr<osg::Node> node = osgDB::readRefNodeFile(fileName, options);
+        osg::Group* tile = node.valid() ? node->asGroup() : 0;
+        if (!tile) return ReadResult::ERROR_IN_READING_FILE;
+
+        // make sure the child tiles are found next to this one whatever the search paths.
+        std::string databasePath = osgDB::getFilePath(fileName);
+        if (!databasePath.empty()) databasePath += "/";
+
+        unsigned int numPoints = 0;
+        for(unsigned int i=0; i<tile->getNumChildren(); ++i)
+        {
+            osg::PagedLOD* plod = dynamic_cast<osg::PagedLOD*>(tile->getChild(i));
+            if (plod)
+            {
+                plod->setDatabasePath(databasePath);
+            }
+            else if (tile->getChild(i)->asTransform() && tile->getChild(i)->asTransform()->getNumChildren()>0)
+            {
+                osg::Geode* geode = tile->getChild(i)->asTransform()->getChild(0)->asGeode();
+                if (geode && geode->getNumDrawables()>0 && geode->getDrawable(0)->asGeometry() && geode->getDrawable(0)->asGeometry()->getVertexArray())
+                {
+                    numPoints += geode->getDrawable(0)->asGeometry()->getVertexArray()->getNumElements();
+                }
+            }
+        }
+
+        tile->setCullCallback(new TileCallback(numPoints));
+
+        return node.release();
+    }
+};
+
+// now register with Registry to instantiate the above
+// reader/writer.
+REGISTER_OSGPLUGIN(pointcloud, ReaderWriterPointCloud)
@@ -52,7 +52,8 @@ CullVisitor::CullVisitor():
     _computed_znear(FLT_MAX),
     _computed_zfar(-FLT_MAX),
     _currentReuseRenderLeafIndex(0),
-    _numberOfEncloseOverrideRenderBinDetails(0)
+    _numberOfEncloseOverrideRenderBinDetails(0),
+    _numberOfEncloseDisabledSoftwareOcclusion(0)
 {
     _identifier = new Identifier;
 }
@@ -68,6 +69,7 @@ CullVisitor::CullVisitor(const CullVisitor& rhs):
     _computed_zfar(-FLT_MAX),
     _currentReuseRenderLeafIndex(0),
     _numberOfEncloseOverrideRenderBinDetails(0),
+    _numberOfEncloseDisabledSoftwareOcclusion(0),
     _identifier(rhs._identifier)
 {
 }
@@ -103,6 +105,8 @@ void CullVisitor::reset()
 
     _numberOfEncloseOverrideRenderBinDetails = 0;
 
+    _numberOfEncloseDisabledSoftwareOcclusion = 0;
+
     // reset the traversal number
     _traversalNumber = 0;
 
@@ -940,7 +944,7 @@ void CullVisitor::updateCalculatedNearFar(const osg::Vec3& pos)
 
 void CullVisitor::apply(Node& node)
 {
-    if (isCulled(node)) return;
+    if (isCulled(node) || isOccluded(node)) return;
 
     // push the culling mode.
     pushCurrentMask();
@@ -961,7 +965,7 @@ void CullVisitor::apply(Node& node)
 
 void CullVisitor::apply(Geode& node)
 {
-    if (isCulled(node)) return;
+    if (isCulled(node) || isOccluded(node)) return;
 
     // push the culling mode.
     pushCurrentMask();
@@ -1056,7 +1060,7 @@ void CullVisitor::apply(osg::Drawable& drawable)
 
 void CullVisitor::apply(Billboard& node)
 {
-    if (isCulled(node)) return;
+    if (isCulled(node) || isOccluded(node)) return;
 
     // push the node's state.
     StateSet* node_state = node.getStateSet();
@@ -1211,7 +1215,7 @@ void CullVisitor::apply(TexGenNode& node)
 
 void CullVisitor::apply(Group& node)
 {
-    if (isCulled(node)) return;
+    if (isCulled(node) || isOccluded(node)) return;
 
     // push the culling mode.
     pushCurrentMask();
@@ -1231,7 +1235,7 @@ void CullVisitor::apply(Group& node)
 
 void CullVisitor::apply(Transform& node)
 {
-    if (isCulled(node)) return;
+    if (isCulled(node) || isOccluded(node)) return;
 
     // push the culling mode.
     pushCurrentMask();
@@ -1319,7 +1323,7 @@ void CullVisitor::apply(Switch& node)
 
 void CullVisitor::apply(LOD& node)
 {
-    if (isCulled(node)) return;
+    if (isCulled(node) || isOccluded(node)) return;
 
     // push the culling mode.
     pushCurrentMask();
@@ -1462,6 +1466,9 @@ class RenderStageCache : public osg::Object, public osg::Observer
 
 void CullVisitor::apply(osg::Camera& camera)
 {
+    // the software occlusion depth buffer is only valid for the top level camera's view.
+    ++_numberOfEncloseDisabledSoftwareOcclusion;
+
     // push the node's state.
     StateSet* node_state = camera.getStateSet();
     if (node_state) pushStateSet(node_state);
@@ -1706,6 +1713,7 @@ void CullVisitor::apply(osg::Camera& camera)
     // pop the node's state off the render graph stack.
     if (node_state) popStateSet();
 
+    --_numberOfEncloseDisabledSoftwareOcclusion;
 }
 
 void CullVisitor::apply(osg::OccluderNode& node)
@@ -1728,10 +1736,13 @@ void CullVisitor::apply(osg::OccluderNode& node)
     StateSet* node_state = node.getStateSet();
     if (node_state) pushStateSet(node_state);
 
-
+    // the occluder mesh stands in for the children, so don't let it occlude them.
+    ++_numberOfEncloseDisabledSoftwareOcclusion;
 
     handle_cull_callbacks_and_traverse(node);
 
+    --_numberOfEncloseDisabledSoftwareOcclusion;
+
     // pop the node's state off the render graph stack.
     if (node_state) popStateSet();
 
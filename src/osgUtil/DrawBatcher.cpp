@@ -0,0 +1,465 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+#include <osgUtil/DrawBatcher>
+#include <osgUtil/RenderLeaf>
+
+#include <osg/GLExtensions>
+#include <osg/Notify>
+
+#include <string.h>
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+    #define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+using namespace osgUtil;
+
+// layout of the batch key
+static const unsigned int BATCH_KEY_VALID     = 0x80000000;
+static const unsigned int BATCH_KEY_NORMALS   = 0x1;
+static const unsigned int BATCH_KEY_COLORS    = 0x2;
+static const unsigned int BATCH_KEY_TEXCOORDS = 0x4;
+static const unsigned int BATCH_KEY_MODE_SHIFT = 8;
+
+// number of unsigned ints in a DrawElementsIndirectCommand
+static const unsigned int NUM_COMMAND_VALUES = 5;
+
+DrawBatcher::Arena::Arena(unsigned int key):
+    numUnusedVertices(0)
+{
+    osg::VertexBufferObject* vbo = new osg::VertexBufferObject;
+
+    vertices = new osg::Vec3Array;
+    vertices->setBufferObject(vbo);
+
+    if (key & BATCH_KEY_NORMALS)
+    {
+        normals = new osg::Vec3Array(osg::Array::BIND_PER_VERTEX);
+        normals->setBufferObject(vbo);
+    }
+
+    if (key & BATCH_KEY_COLORS)
+    {
+        colors = new osg::Vec4Array(osg::Array::BIND_PER_VERTEX);
+        colors->setBufferObject(vbo);
+    }
+
+    if (key & BATCH_KEY_TEXCOORDS)
+    {
+        texCoords = new osg::Vec2Array(osg::Array::BIND_PER_VERTEX);
+        texCoords->setBufferObject(vbo);
+    }
+
+    indices = new osg::DrawElementsUInt((key>>BATCH_KEY_MODE_SHIFT) & 0xff);
+    indices->setElementBufferObject(new osg::ElementBufferObject);
+}
+
+void DrawBatcher::Arena::clear()
+{
+    vertices->clear();
+    vertices->dirty();
+
+    if (normals.valid()) { normals->clear(); normals->dirty(); }
+    if (colors.valid()) { colors->clear(); colors->dirty(); }
+    if (texCoords.valid()) { texCoords->clear(); texCoords->dirty(); }
+
+    indices->clear();
+    indices->dirty();
+
+    numUnusedVertices = 0;
+}
+
+DrawBatcher::PerContext::PerContext():
+    clearCount(0),
+    numBatches(0),
+    numBatchedDrawables(0),
+    numDrawCallsSaved(0)
+{
+    osg::VertexBufferObject* commandBuffer = new osg::VertexBufferObject;
+    commandBuffer->setTarget(GL_DRAW_INDIRECT_BUFFER);
+    commandBuffer->setUsage(GL_STREAM_DRAW_ARB);
+
+    commands = new osg::UIntArray;
+    commands->setBufferObject(commandBuffer);
+
+    osg::ShaderStorageBufferObject* matrixBuffer = new osg::ShaderStorageBufferObject;
+    matrixBuffer->setUsage(GL_STREAM_DRAW_ARB);
+
+    matrices = new osg::MatrixfArray;
+    matrices->setBufferObject(matrixBuffer);
+
+    drawIndices = new osg::UIntArray;
+    drawIndices->setBufferObject(new osg::VertexBufferObject);
+}
+
+DrawBatcher* DrawBatcher::instance()
+{
+    static osg::ref_ptr<DrawBatcher> s_drawBatcher = new DrawBatcher;
+    return s_drawBatcher.get();
+}
+
+DrawBatcher::DrawBatcher():
+    _minimumBatchSize(4),
+    _matrixBufferBinding(0),
+    _drawIndexAttribLocation(15)
+{
+}
+
+DrawBatcher::~DrawBatcher()
+{
+}
+
+bool DrawBatcher::isSupported(osg::State& state) const
+{
+    const osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+    return extensions &&
+           extensions->glMultiDrawElementsIndirect &&
+           extensions->glBindBufferBase &&
+           extensions->glVertexAttribDivisor &&
+           state.isVertexBufferObjectSupported();
+}
+
+unsigned int DrawBatcher::getBatchKey(const RenderLeaf* leaf) const
+{
+    const osg::Drawable* drawable = leaf->getDrawable();
+    if (leaf->_dynamic || !drawable || drawable->getDrawCallback()) return 0;
+
+    // subclasses of Geometry may override drawImplementation() so only batch osg::Geometry itself.
+    const osg::Geometry* geometry = drawable->asGeometry();
+    if (!geometry || strcmp(geometry->className(),"Geometry")!=0 || strcmp(geometry->libraryName(),"osg")!=0) return 0;
+    if (geometry->containsDeprecatedData()) return 0;
+
+    const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(geometry->getVertexArray());
+    if (!vertices || vertices->empty()) return 0;
+
+    if (geometry->getSecondaryColorArray() ||
+        geometry->getFogCoordArray() ||
+        geometry->getNumVertexAttribArrays()>0 ||
+        geometry->getNumTexCoordArrays()>1) return 0;
+
+    unsigned int key = BATCH_KEY_VALID;
+
+    if (geometry->getNormalArray())
+    {
+        const osg::Array* normals = geometry->getNormalArray();
+        if (normals->getType()!=osg::Array::Vec3ArrayType || normals->getBinding()!=osg::Array::BIND_PER_VERTEX || normals->getNumElements()!=vertices->size()) return 0;
+        key |= BATCH_KEY_NORMALS;
+    }
+
+    if (geometry->getColorArray())
+    {
+        const osg::Array* colors = geometry->getColorArray();
+        if (colors->getType()!=osg::Array::Vec4ArrayType || colors->getBinding()!=osg::Array::BIND_PER_VERTEX || colors->getNumElements()!=vertices->size()) return 0;
+        key |= BATCH_KEY_COLORS;
+    }
+
+    if (geometry->getNumTexCoordArrays()==1 && geometry->getTexCoordArray(0))
+    {
+        const osg::Array* texCoords = geometry->getTexCoordArray(0);
+        if (texCoords->getType()!=osg::Array::Vec2ArrayType || texCoords->getNumElements()!=vertices->size()) return 0;
+        key |= BATCH_KEY_TEXCOORDS;
+    }
+
+    const osg::Geometry::PrimitiveSetList& primitives = geometry->getPrimitiveSetList();
+    if (primitives.empty()) return 0;
+
+    GLenum mode = primitives.front()->getMode();
+    if (mode==GL_QUADS || mode==GL_QUAD_STRIP || mode==GL_POLYGON) return 0;
+
+    for(osg::Geometry::PrimitiveSetList::const_iterator itr = primitives.begin();
+        itr != primitives.end();
+        ++itr)
+    {
+        const osg::PrimitiveSet* primitiveSet = itr->get();
+        if (primitiveSet->getMode()!=mode || primitiveSet->getNumInstances()!=0) return 0;
+
+        switch(primitiveSet->getType())
+        {
+            case(osg::PrimitiveSet::DrawArraysPrimitiveType):
+            case(osg::PrimitiveSet::DrawElementsUBytePrimitiveType):
+            case(osg::PrimitiveSet::DrawElementsUShortPrimitiveType):
+            case(osg::PrimitiveSet::DrawElementsUIntPrimitiveType):
+                break;
+            default:
+                return 0;
+        }
+    }
+
+    return key | (mode<<BATCH_KEY_MODE_SHIFT);
+}
+
+void DrawBatcher::trimArena(PerContext& pc, unsigned int key)
+{
+    Arenas::iterator aitr = pc.arenas.find(key);
+    if (aitr==pc.arenas.end()) return;
+
+    Arena& arena = *(aitr->second);
+
+    // account for the data of geometries that have since been deleted.
+    for(Entries::iterator itr = pc.entries.begin();
+        itr != pc.entries.end();)
+    {
+        if (itr->second.key==key && !itr->second.geometry.valid())
+        {
+            arena.numUnusedVertices += itr->second.numVertices;
+            pc.entries.erase(itr++);
+        }
+        else ++itr;
+    }
+
+    // once over half the arena is unused start again, the geometries still in use are copied back on demand.
+    if (arena.numUnusedVertices>65536 && arena.numUnusedVertices*2>arena.vertices->size())
+    {
+        OSG_INFO<<"DrawBatcher::trimArena() clearing arena with "<<arena.numUnusedVertices<<" of "<<arena.vertices->size()<<" vertices unused"<<std::endl;
+
+        for(Entries::iterator itr = pc.entries.begin();
+            itr != pc.entries.end();)
+        {
+            if (itr->second.key==key) pc.entries.erase(itr++);
+            else ++itr;
+        }
+
+        arena.clear();
+    }
+}
+
+const DrawBatcher::Entry* DrawBatcher::getOrCreateEntry(PerContext& pc, const osg::Geometry* geometry, unsigned int key)
+{
+    const osg::Vec3Array* vertices = static_cast<const osg::Vec3Array*>(geometry->getVertexArray());
+    const osg::Vec3Array* normals = (key & BATCH_KEY_NORMALS) ? static_cast<const osg::Vec3Array*>(geometry->getNormalArray()) : 0;
+    const osg::Vec4Array* colors = (key & BATCH_KEY_COLORS) ? static_cast<const osg::Vec4Array*>(geometry->getColorArray()) : 0;
+    const osg::Vec2Array* texCoords = (key & BATCH_KEY_TEXCOORDS) ? static_cast<const osg::Vec2Array*>(geometry->getTexCoordArray(0)) : 0;
+    const osg::Geometry::PrimitiveSetList& primitives = geometry->getPrimitiveSetList();
+
+    unsigned int modifiedCount = vertices->getModifiedCount();
+    if (normals) modifiedCount += normals->getModifiedCount();
+    if (colors) modifiedCount += colors->getModifiedCount();
+    if (texCoords) modifiedCount += texCoords->getModifiedCount();
+    for(osg::Geometry::PrimitiveSetList::const_iterator itr = primitives.begin();
+        itr != primitives.end();
+        ++itr)
+    {
+        modifiedCount += (*itr)->getModifiedCount();
+    }
+
+    osg::ref_ptr<Arena>& arena = pc.arenas[key];
+    if (!arena) arena = new Arena(key);
+
+    Entry& entry = pc.entries[geometry];
+    if (entry.geometry.get()==geometry && entry.key==key && entry.modifiedCount==modifiedCount && entry.numVertices==vertices->size())
+    {
+        return &entry;
+    }
+
+    // the geometry is new, has been modified or the address is being reused so copy its data into the arena again.
+    if (entry.numVertices>0 && entry.key==key) arena->numUnusedVertices += entry.numVertices;
+
+    entry.geometry = const_cast<osg::Geometry*>(geometry);
+    entry.key = key;
+    entry.modifiedCount = modifiedCount;
+    entry.numVertices = vertices->size();
+    entry.commands.clear();
+
+    GLint baseVertex = static_cast<GLint>(arena->vertices->size());
+
+    arena->vertices->insert(arena->vertices->end(), vertices->begin(), vertices->end());
+    arena->vertices->dirty();
+
+    if (normals)
+    {
+        arena->normals->insert(arena->normals->end(), normals->begin(), normals->end());
+        arena->normals->dirty();
+    }
+
+    if (colors)
+    {
+        arena->colors->insert(arena->colors->end(), colors->begin(), colors->end());
+        arena->colors->dirty();
+    }
+
+    if (texCoords)
+    {
+        arena->texCoords->insert(arena->texCoords->end(), texCoords->begin(), texCoords->end());
+        arena->texCoords->dirty();
+    }
+
+    osg::DrawElementsUInt& indices = *(arena->indices);
+    for(osg::Geometry::PrimitiveSetList::const_iterator itr = primitives.begin();
+        itr != primitives.end();
+        ++itr)
+    {
+        const osg::PrimitiveSet* primitiveSet = itr->get();
+        GLuint firstIndex = indices.size();
+
+        if (primitiveSet->getType()==osg::PrimitiveSet::DrawArraysPrimitiveType)
+        {
+            const osg::DrawArrays* drawArrays = static_cast<const osg::DrawArrays*>(primitiveSet);
+            GLint last = drawArrays->getFirst()+drawArrays->getCount();
+            for(GLint i=drawArrays->getFirst(); i<last; ++i)
+            {
+                indices.push_back(i);
+            }
+        }
+        else
+        {
+            for(unsigned int i=0; i<primitiveSet->getNumIndices(); ++i)
+            {
+                indices.push_back(primitiveSet->index(i));
+            }
+        }
+
+        GLuint count = indices.size()-firstIndex;
+        if (count>0) entry.commands.push_back(DrawCommand(count, firstIndex, baseVertex));
+    }
+    indices.dirty();
+
+    return &entry;
+}
+
+void DrawBatcher::draw(osg::RenderInfo& renderInfo, StateGraph::LeafList::iterator first, StateGraph::LeafList::iterator last, RenderLeaf*& previous)
+{
+    osg::State& state = *renderInfo.getState();
+    unsigned int contextID = state.getContextID();
+    osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+
+    RenderLeaf* firstLeaf = first->get();
+    unsigned int key = getBatchKey(firstLeaf);
+    GLenum mode = (key>>BATCH_KEY_MODE_SHIFT) & 0xff;
+
+    // the leaves share the StateGraph and projection so applying the first leaf's state covers them all.
+    firstLeaf->applyState(renderInfo, previous);
+
+    PerContext& pc = _perContext[contextID];
+
+    // release the arenas if clear() has been called since this context last drew a batch.
+    unsigned int clearCount = _clearCount;
+    if (pc.clearCount!=clearCount)
+    {
+        pc.clearCount = clearCount;
+        pc.arenas.clear();
+        pc.entries.clear();
+    }
+
+    trimArena(pc, key);
+    osg::UIntArray& commands = *(pc.commands);
+    osg::MatrixfArray& matrices = *(pc.matrices);
+    commands.clear();
+    matrices.clear();
+
+    unsigned int numCommands = 0;
+    for(StateGraph::LeafList::iterator itr = first; itr != last; ++itr)
+    {
+        RenderLeaf* leaf = itr->get();
+        const Entry* entry = getOrCreateEntry(pc, leaf->getDrawable()->asGeometry(), key);
+
+        GLuint drawIndex = matrices.size();
+        matrices.push_back(leaf->_modelview.valid() ? osg::Matrixf(*(leaf->_modelview)) : osg::Matrixf());
+
+        for(std::vector<DrawCommand>::const_iterator citr = entry->commands.begin();
+            citr != entry->commands.end();
+            ++citr)
+        {
+            commands.push_back(citr->count);
+            commands.push_back(1);
+            commands.push_back(citr->firstIndex);
+            commands.push_back(static_cast<GLuint>(citr->baseVertex));
+            commands.push_back(drawIndex);
+        }
+        numCommands += entry->commands.size();
+
+        previous = leaf;
+    }
+
+    commands.dirty();
+    matrices.dirty();
+
+    if (pc.drawIndices->size()<matrices.size())
+    {
+        for(GLuint i=pc.drawIndices->size(); i<matrices.size(); ++i)
+        {
+            pc.drawIndices->push_back(i);
+        }
+        pc.drawIndices->dirty();
+    }
+
+    Arena& arena = *pc.arenas[key];
+
+    state.lazyDisablingOfVertexAttributes();
+    state.setVertexPointer(arena.vertices.get());
+    if (arena.normals.valid()) state.setNormalPointer(arena.normals.get());
+    if (arena.colors.valid()) state.setColorPointer(arena.colors.get());
+    if (arena.texCoords.valid()) state.setTexCoordPointer(0, arena.texCoords.get());
+    state.setVertexAttribIPointer(_drawIndexAttribLocation, pc.drawIndices.get());
+    state.applyDisablingOfVertexAttributes();
+
+    extensions->glVertexAttribDivisor(_drawIndexAttribLocation, 1);
+
+    state.bindElementBufferObject(arena.indices->getOrCreateGLBufferObject(contextID));
+
+    osg::GLBufferObject* matrixBuffer = matrices.getOrCreateGLBufferObject(contextID);
+    matrixBuffer->compileBuffer();
+    extensions->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, _matrixBufferBinding, matrixBuffer->getGLObjectID());
+
+    // compiling leaves the command buffer bound to GL_DRAW_INDIRECT_BUFFER.
+    osg::GLBufferObject* commandBuffer = commands.getOrCreateGLBufferObject(contextID);
+    commandBuffer->compileBuffer();
+
+    extensions->glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, 0, numCommands, NUM_COMMAND_VALUES*sizeof(GLuint));
+
+    extensions->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    extensions->glVertexAttribDivisor(_drawIndexAttribLocation, 0);
+
+    state.unbindVertexBufferObject();
+    state.unbindElementBufferObject();
+
+    ++pc.numBatches;
+    pc.numBatchedDrawables += matrices.size();
+    if (numCommands>1) pc.numDrawCallsSaved += numCommands-1;
+}
+
+void DrawBatcher::clear()
+{
+    ++_clearCount;
+}
+
+unsigned int DrawBatcher::getNumBatches() const
+{
+    unsigned int numBatches = 0;
+    for(unsigned int i=0; i<_perContext.size(); ++i) numBatches += _perContext[i].numBatches;
+    return numBatches;
+}
+
+unsigned int DrawBatcher::getNumBatchedDrawables() const
+{
+    unsigned int numBatchedDrawables = 0;
+    for(unsigned int i=0; i<_perContext.size(); ++i) numBatchedDrawables += _perContext[i].numBatchedDrawables;
+    return numBatchedDrawables;
+}
+
+unsigned int DrawBatcher::getNumDrawCallsSaved() const
+{
+    unsigned int numDrawCallsSaved = 0;
+    for(unsigned int i=0; i<_perContext.size(); ++i) numDrawCallsSaved += _perContext[i].numDrawCallsSaved;
+    return numDrawCallsSaved;
+}
+
+void DrawBatcher::resetStats()
+{
+    for(unsigned int i=0; i<_perContext.size(); ++i)
+    {
+        PerContext& pc = _perContext[i];
+        pc.numBatches = 0;
+        pc.numBatchedDrawables = 0;
+        pc.numDrawCallsSaved = 0;
+    }
+}
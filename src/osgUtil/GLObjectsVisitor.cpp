@@ -40,8 +40,12 @@ void GLObjectsVisitor::apply(osg::Node& node)
         apply(*(node.getStateSet()));
     }
 
+    bool pushedPermutationState = pushPermutationState(node.getStateSet());
+
     traverse(node);
 
+    if (pushedPermutationState) popPermutationState();
+
     bool programSetAfter = _renderInfo.getState()!=0 && _renderInfo.getState()->getLastAppliedProgramObject()!=0;
     if (programSetBefore && !programSetAfter)
     {
@@ -62,8 +66,12 @@ void GLObjectsVisitor::apply(osg::Geode& node)
         apply(*(node.getStateSet()));
     }
 
+    bool pushedPermutationState = pushPermutationState(node.getStateSet());
+
     traverse(node);
 
+    if (pushedPermutationState) popPermutationState();
+
     bool programSetAfter = _lastCompiledProgram.valid();
     if (!programSetBefore && programSetAfter)
     {
@@ -77,6 +85,11 @@ void GLObjectsVisitor::apply(osg::Geode& node)
 
 void GLObjectsVisitor::apply(osg::Drawable& drawable)
 {
+    // the same drawable can be drawn with different defines inherited from each of its parents, so record its permutation on every visit.
+    bool pushedPermutationState = pushPermutationState(drawable.getStateSet());
+    addProgramPermutation();
+    if (pushedPermutationState) popPermutationState();
+
     if (_drawablesAppliedSet.count(&drawable)!=0) return;
 
     _drawablesAppliedSet.insert(&drawable);
@@ -175,6 +188,79 @@ void GLObjectsVisitor::apply(osg::StateSet& stateset)
     }
 }
 
+bool GLObjectsVisitor::pushPermutationState(const osg::StateSet* stateset)
+{
+    if ((_mode & COMPILE_DEFINE_PERMUTATIONS)==0 || !stateset) return false;
+
+    const osg::StateAttribute* program = stateset->getAttribute(osg::StateAttribute::PROGRAM);
+    if (!program && stateset->getDefineList().empty()) return false;
+
+    PermutationState ps = _permutationStateStack.empty() ? PermutationState() : _permutationStateStack.back();
+
+    // follow the same override rules as osg::State applies to the attribute and define stacks.
+    if (program)
+    {
+        osg::StateAttribute::OverrideValue value = stateset->getAttributePair(osg::StateAttribute::PROGRAM)->second;
+        if (!(ps.programOverride & osg::StateAttribute::OVERRIDE) || (value & osg::StateAttribute::PROTECTED))
+        {
+            ps.program = dynamic_cast<const osg::Program*>(program);
+            ps.programOverride = value;
+        }
+    }
+
+    const osg::StateSet::DefineList& defineList = stateset->getDefineList();
+    for(osg::StateSet::DefineList::const_iterator itr = defineList.begin();
+        itr != defineList.end();
+        ++itr)
+    {
+        osg::StateSet::DefineList::iterator ditr = ps.defines.find(itr->first);
+        if (ditr == ps.defines.end()) ps.defines.insert(*itr);
+        else if (!(ditr->second.second & osg::StateAttribute::OVERRIDE) || (itr->second.second & osg::StateAttribute::PROTECTED)) ditr->second = itr->second;
+    }
+
+    _permutationStateStack.push_back(ps);
+    return true;
+}
+
+void GLObjectsVisitor::addProgramPermutation()
+{
+    if ((_mode & COMPILE_DEFINE_PERMUTATIONS)==0 || _permutationStateStack.empty()) return;
+
+    const PermutationState& ps = _permutationStateStack.back();
+    if (!ps.program || ps.program->isFixedFunction()) return;
+
+    // only the defines that are switched on are passed on to shaders.
+    ProgramPermutation permutation;
+    permutation.first = const_cast<osg::Program*>(ps.program);
+    for(osg::StateSet::DefineList::const_iterator itr = ps.defines.begin();
+        itr != ps.defines.end();
+        ++itr)
+    {
+        if (itr->second.second & osg::StateAttribute::ON) permutation.second.insert(*itr);
+    }
+
+    if (!_programPermutations.insert(permutation).second) return;
+
+    if ((_mode & COMPILE_STATE_ATTRIBUTES) && _renderInfo.getState())
+    {
+        compileProgramPermutation(*_renderInfo.getState(), permutation);
+    }
+}
+
+void GLObjectsVisitor::compileProgramPermutation(osg::State& state, const ProgramPermutation& permutation)
+{
+    osg::State::DefineMap& defineMap = state.getDefineMap();
+    bool previousChanged = defineMap.changed;
+
+    osg::StateSet::DefineList defines(permutation.second);
+    defineMap.swapCurrentDefines(defines);
+
+    permutation.first->compileGLObjects(state);
+
+    defineMap.swapCurrentDefines(defines);
+    defineMap.changed = previousChanged;
+}
+
 /////////////////////////////////////////////////////////////////
 //
 // GLObjectsOperation
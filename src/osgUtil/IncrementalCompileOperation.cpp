@@ -19,6 +19,8 @@
 #include <osg/Depth>
 #include <osg/ColorMask>
 #include <osg/ApplicationUsage>
+#include <osg/GLExtensions>
+#include <osg/GraphicsThread>
 
 #include <OpenThreads/ScopedLock>
 
@@ -48,6 +50,7 @@ namespace osgUtil
 static osg::ApplicationUsageProxy ICO_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_MINIMUM_COMPILE_TIME_PER_FRAME <float>","minimum compile time alloted to compiling OpenGL objects per frame in database pager.");
 static osg::ApplicationUsageProxy UCO_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_MAXIMUM_OBJECTS_TO_COMPILE_PER_FRAME <int>","maximum number of OpenGL objects to compile per frame in database pager.");
 static osg::ApplicationUsageProxy UCO_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FORCE_TEXTURE_DOWNLOAD <ON/OFF>","should the texture compiles be forced to download using a dummy Geometry.");
+static osg::ApplicationUsageProxy UCO_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_COMPILE_THREAD <ON/OFF>","compile OpenGL objects for the database pager on a dedicated thread with a shared compile context.");
 
 /////////////////////////////////////////////////////////////////
 //
@@ -245,6 +248,11 @@ bool IncrementalCompileOperation::CompileDrawableOp::compile(CompileInfo& compil
     return true;
 }
 
+unsigned int IncrementalCompileOperation::CompileDrawableOp::dataSizeForCompile() const
+{
+    return _drawable->getGLObjectSizeHint();
+}
+
 IncrementalCompileOperation::CompileTextureOp::CompileTextureOp(osg::Texture* texture):
     _texture(texture)
 {
@@ -282,6 +290,17 @@ bool IncrementalCompileOperation::CompileTextureOp::compile(CompileInfo& compile
     return true;
 }
 
+unsigned int IncrementalCompileOperation::CompileTextureOp::dataSizeForCompile() const
+{
+    unsigned int size = 0;
+    for(unsigned int i=0; i<_texture->getNumImages(); ++i)
+    {
+        const osg::Image* image = _texture->getImage(i);
+        if (image) size += image->getTotalSizeInBytesIncludingMipmaps();
+    }
+    return size;
+}
+
 IncrementalCompileOperation::CompileProgramOp::CompileProgramOp(osg::Program* program):
     _program(program)
 {
@@ -304,7 +323,9 @@ bool IncrementalCompileOperation::CompileProgramOp::compile(CompileInfo& compile
 IncrementalCompileOperation::CompileInfo::CompileInfo(osg::GraphicsContext* context, IncrementalCompileOperation* ico):
     compileAll(false),
     maxNumObjectsToCompile(0),
-    allocatedTime(0)
+    allocatedTime(0),
+    numObjectsCompiled(0),
+    numBytesCompiled(0)
 {
     setState(context->getState());
     incrementalCompileOperation = ico;
@@ -362,6 +383,9 @@ bool IncrementalCompileOperation::CompileList::compile(CompileInfo& compileInfo)
         ++itr;
         if ((*saved_itr)->compile(compileInfo))
         {
+            ++compileInfo.numObjectsCompiled;
+            compileInfo.numBytesCompiled += (*saved_itr)->dataSizeForCompile();
+
             _compileOps.erase(saved_itr);
         }
 
@@ -450,7 +474,8 @@ IncrementalCompileOperation::IncrementalCompileOperation():
     _flushTimeRatio(0.5),
     _conservativeTimeRatio(0.5),
     _currentFrameNumber(0),
-    _compileAllTillFrameNumber(0)
+    _compileAllTillFrameNumber(0),
+    _useCompileThreads(false)
 {
     _markerObject = new osg::DummyObject;
     _markerObject->setName("HasBeenProcessedByStateToCompile");
@@ -483,6 +508,14 @@ IncrementalCompileOperation::IncrementalCompileOperation():
         assignForceTextureDownloadGeometry();
     }
 
+    if( (ptr = getenv("OSG_COMPILE_THREAD")) != 0)
+    {
+        _useCompileThreads = strcmp(ptr,"yes")==0 || strcmp(ptr,"YES")==0 ||
+                             strcmp(ptr,"on")==0 || strcmp(ptr,"ON")==0;
+
+        OSG_NOTICE<<"OSG_COMPILE_THREAD set to "<<_useCompileThreads<<std::endl;
+    }
+
 }
 
 IncrementalCompileOperation::~IncrementalCompileOperation()
@@ -546,6 +579,9 @@ void IncrementalCompileOperation::addGraphicsContext(osg::GraphicsContext* gc)
         gc->add(this);
         _contexts.insert(gc);
     }
+
+    // contexts are often added before they are realized, so also try again when they are assigned once realized.
+    if (_useCompileThreads) setUpCompileThread(gc);
 }
 
 void IncrementalCompileOperation::removeGraphicsContext(osg::GraphicsContext* gc)
@@ -555,6 +591,243 @@ void IncrementalCompileOperation::removeGraphicsContext(osg::GraphicsContext* gc
         gc->remove(this);
         _contexts.erase(gc);
     }
+
+    removeCompileThreads(gc);
+}
+
+/////////////////////////////////////////////////////////////////
+//
+// Compile threads
+//
+struct IncrementalCompileOperation::CompileThreadOperation : public osg::GraphicsOperation
+{
+    CompileThreadOperation(IncrementalCompileOperation* ico, CompileThread* compileThread):
+        osg::Referenced(true),
+        osg::GraphicsOperation("IncrementalCompileOperation::CompileThreadOperation",false),
+        _incrementalCompileOperation(ico),
+        _compileThread(compileThread) {}
+
+    virtual void operator () (osg::GraphicsContext* /*context*/)
+    {
+        osg::ref_ptr<IncrementalCompileOperation> ico;
+        if (_incrementalCompileOperation.lock(ico)) ico->compileOnCompileThread(_compileThread.get());
+    }
+
+    osg::observer_ptr<IncrementalCompileOperation>  _incrementalCompileOperation;
+    osg::ref_ptr<CompileThread>                     _compileThread;
+};
+
+void IncrementalCompileOperation::setUseCompileThreads(bool flag)
+{
+    if (_useCompileThreads==flag) return;
+
+    _useCompileThreads = flag;
+
+    if (_useCompileThreads)
+    {
+        for(ContextSet::iterator itr = _contexts.begin();
+            itr != _contexts.end();
+            ++itr)
+        {
+            setUpCompileThread(*itr);
+        }
+    }
+    else
+    {
+        removeCompileThreads(0);
+    }
+}
+
+void IncrementalCompileOperation::removeCompileThreads(osg::GraphicsContext* gc)
+{
+    CompileThreads removed;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileThreadsMutex);
+        if (gc)
+        {
+            CompileThreads::iterator itr = _compileThreads.find(gc);
+            if (itr == _compileThreads.end()) return;
+
+            removed.insert(*itr);
+            _compileThreads.erase(itr);
+        }
+        else
+        {
+            removed.swap(_compileThreads);
+        }
+    }
+
+    // wait for the compile threads to finish the CompileSet they are compiling, the rendering threads compile the rest.
+    for(CompileThreads::iterator itr = removed.begin();
+        itr != removed.end();
+        ++itr)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(itr->second->compileMutex);
+    }
+}
+
+bool IncrementalCompileOperation::hasCompileThread(osg::GraphicsContext* gc) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileThreadsMutex);
+    return _compileThreads.count(gc)!=0;
+}
+
+void IncrementalCompileOperation::setUpCompileThread(osg::GraphicsContext* gc)
+{
+    if (!gc->valid() || !gc->isRealized() || !gc->getState()) return;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileThreadsMutex);
+        if (_compileThreads.count(gc)!=0) return;
+    }
+
+    osg::GraphicsContext* compileContext = osg::GraphicsContext::getOrCreateCompileContext(gc->getState()->getContextID());
+    if (!compileContext)
+    {
+        OSG_NOTICE<<"IncrementalCompileOperation unable to create a compile context, compiling incrementally on the rendering thread."<<std::endl;
+        return;
+    }
+
+    if (!compileContext->getGraphicsThread()) compileContext->createGraphicsThread();
+    if (!compileContext->getGraphicsThread()->isRunning()) compileContext->getGraphicsThread()->startThread();
+
+    osg::ref_ptr<CompileThread> compileThread = new CompileThread;
+    compileThread->renderContext = gc;
+    compileThread->compileContext = compileContext;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileThreadsMutex);
+    _compileThreads[gc] = compileThread;
+}
+
+bool IncrementalCompileOperation::activateCompileThread(osg::GraphicsContext* gc)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileThreadsMutex);
+
+    CompileThreads::iterator itr = _compileThreads.find(gc);
+    if (itr == _compileThreads.end()) return false;
+
+    CompileThread* compileThread = itr->second.get();
+    if (!compileThread->active)
+    {
+        compileThread->active = true;
+        scheduleCompileThread(compileThread);
+    }
+    return true;
+}
+
+void IncrementalCompileOperation::scheduleCompileThread(CompileThread* compileThread)
+{
+    // called with _compileThreadsMutex held.
+    if (compileThread->active && !compileThread->scheduled)
+    {
+        compileThread->scheduled = true;
+        compileThread->compileContext->getGraphicsThread()->add(new CompileThreadOperation(this, compileThread));
+    }
+}
+
+void IncrementalCompileOperation::scheduleCompileThreads()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileThreadsMutex);
+    for(CompileThreads::iterator itr = _compileThreads.begin();
+        itr != _compileThreads.end();
+        ++itr)
+    {
+        scheduleCompileThread(itr->second.get());
+    }
+}
+
+void IncrementalCompileOperation::compileOnCompileThread(CompileThread* compileThread)
+{
+    {
+        // CompileSets added from now on schedule another run.
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileThreadsMutex);
+        compileThread->scheduled = false;
+    }
+
+    osg::State* state = compileThread->compileContext->getState();
+
+    // vertex array objects aren't shared between contexts, leave the rendering context to record them.
+    state->setUseVertexArrayObjects(false);
+
+    osg::GLExtensions* extensions = state->get<osg::GLExtensions>();
+    bool useFences = extensions && extensions->glFenceSync && extensions->glClientWaitSync && extensions->glDeleteSync;
+
+    CompileSets toCompileCopy;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex>  toCompile_lock(_toCompileMutex);
+        std::copy(_toCompile.begin(),_toCompile.end(),std::back_inserter<CompileSets>(toCompileCopy));
+    }
+
+    for(CompileSets::iterator itr = toCompileCopy.begin();
+        itr != toCompileCopy.end();
+        ++itr)
+    {
+        CompileSet* cs = itr->get();
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> compile_lock(compileThread->compileMutex);
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileThreadsMutex);
+            CompileThreads::iterator ct_itr = _compileThreads.find(compileThread->renderContext);
+            if (ct_itr==_compileThreads.end() || ct_itr->second!=compileThread || !compileThread->active) return;
+        }
+
+        // while the compile thread is registered the CompileList of the rendering context is only compiled by it.
+        CompileSet::CompileMap::iterator cl_itr = cs->_compileMap.find(compileThread->renderContext);
+        if (cl_itr==cs->_compileMap.end() || cl_itr->second.empty()) continue;
+
+        CompileInfo compileInfo(compileThread->compileContext.get(), this);
+        compileInfo.compileAll = true;
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        cl_itr->second.compile(compileInfo);
+
+        // the compiled objects may only be used by the rendering context once the uploads have completed.
+        if (useFences)
+        {
+            GLsync fence = extensions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            GLenum result;
+            do
+            {
+                result = extensions->glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            } while(result==GL_TIMEOUT_EXPIRED);
+            extensions->glDeleteSync(fence);
+        }
+        else
+        {
+            glFinish();
+        }
+
+        double uploadTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+        accumulateStatistics(compileInfo, uploadTime);
+
+        OSG_INFO<<"IncrementalCompileOperation compile thread uploaded "<<compileInfo.numBytesCompiled<<" bytes in "<<uploadTime*1000.0<<"ms"<<std::endl;
+
+        if (--cs->_numberCompileListsToCompile==0)
+        {
+            compileSetCompleted(cs);
+        }
+    }
+}
+
+IncrementalCompileOperation::Statistics IncrementalCompileOperation::getStatistics() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statisticsMutex);
+    return _statistics;
+}
+
+void IncrementalCompileOperation::resetStatistics()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statisticsMutex);
+    _statistics = Statistics();
+}
+
+void IncrementalCompileOperation::accumulateStatistics(const CompileInfo& compileInfo, double uploadTime)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statisticsMutex);
+    _statistics.numObjectsCompiled += compileInfo.numObjectsCompiled;
+    _statistics.numBytesUploaded += compileInfo.numBytesCompiled;
+    _statistics.uploadTime += uploadTime;
 }
 
 bool IncrementalCompileOperation::requiresCompile(StateToCompile& stateToCompile)
@@ -590,8 +863,12 @@ void IncrementalCompileOperation::add(CompileSet* compileSet, bool callBuildComp
 
     OSG_INFO<<"IncrementalCompileOperation::add(CompileSet = "<<compileSet<<", "<<", "<<callBuildCompileMap<<")"<<std::endl;
 
-    OpenThreads::ScopedLock<OpenThreads::Mutex>  lock(_toCompileMutex);
-    _toCompile.push_back(compileSet);
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex>  lock(_toCompileMutex);
+        _toCompile.push_back(compileSet);
+    }
+
+    if (_useCompileThreads) scheduleCompileThreads();
 }
 
 void IncrementalCompileOperation::remove(CompileSet* compileSet)
@@ -691,6 +968,13 @@ void IncrementalCompileOperation::operator () (osg::GraphicsContext* context)
 
     //level = osg::NOTICE;
 
+    if (activateCompileThread(context))
+    {
+        // the compile thread does all the compiling, so the whole of the available time can go on flushing.
+        osg::flushDeletedGLObjects(context->getState()->getContextID(), currentTime, availableTime);
+        return;
+    }
+
     CompileInfo compileInfo(context, this);
     compileInfo.maxNumObjectsToCompile = _maximumNumOfObjectsToCompilePerFrame;
     compileInfo.allocatedTime = compileTime;
@@ -707,6 +991,8 @@ void IncrementalCompileOperation::operator () (osg::GraphicsContext* context)
         compileSets(toCompileCopy, compileInfo);
     }
 
+    double compileSetsTime = compileInfo.timer.elapsedTime();
+
     osg::flushDeletedGLObjects(context->getState()->getContextID(), currentTime, flushTime);
 
     if (!toCompileCopy.empty() && compileInfo.maxNumObjectsToCompile>0)
@@ -717,18 +1003,22 @@ void IncrementalCompileOperation::operator () (osg::GraphicsContext* context)
         if (compileInfo.okToCompile())
         {
             OSG_NOTIFY(level)<<"    Passing on "<<flushTime<<" to second round of compileSets(..)"<<std::endl;
+
+            osg::ElapsedTime secondPassTimer;
             compileSets(toCompileCopy, compileInfo);
+            compileSetsTime += secondPassTimer.elapsedTime();
         }
     }
 
+    // on the rendering thread the uploads may still be in flight, so the bandwidth is only that of issuing them.
+    if (compileInfo.numObjectsCompiled>0) accumulateStatistics(compileInfo, compileSetsTime);
+
     //glFush();
     //glFinish();
 }
 
 void IncrementalCompileOperation::compileSets(CompileSets& toCompile, CompileInfo& compileInfo)
 {
-    osg::NotifySeverity level = osg::INFO;
-
     for(CompileSets::iterator itr = toCompile.begin();
         itr != toCompile.end() && compileInfo.okToCompile();
         )
@@ -736,28 +1026,7 @@ void IncrementalCompileOperation::compileSets(CompileSets& toCompile, CompileInf
         CompileSet* cs = itr->get();
         if (cs->compile(compileInfo))
         {
-            {
-                OpenThreads::ScopedLock<OpenThreads::Mutex>  toCompile_lock(_toCompileMutex);
-
-                CompileSets::iterator cs_itr = std::find(_toCompile.begin(), _toCompile.end(), *itr);
-                if (cs_itr != _toCompile.end())
-                {
-                    OSG_NOTIFY(level)<<"    Erasing from list"<<std::endl;
-
-                    // remove from the _toCompile list, note cs won't be deleted here as the tempoary
-                    // toCompile_Copy list will retain a reference.
-                    _toCompile.erase(cs_itr);
-                }
-            }
-            if (cs->_compileCompletedCallback.valid() && cs->_compileCompletedCallback->compileCompleted(cs))
-            {
-                // callback will handle merging of subgraph so no need to place CompileSet in merge.
-            }
-            else
-            {
-                OpenThreads::ScopedLock<OpenThreads::Mutex>  compilded_lock(_compiledMutex);
-                _compiled.push_back(cs);
-            }
+            compileSetCompleted(cs);
 
             // remove entry from list.
             itr = toCompile.erase(itr);
@@ -770,6 +1039,41 @@ void IncrementalCompileOperation::compileSets(CompileSets& toCompile, CompileInf
 
 }
 
+void IncrementalCompileOperation::compileSetCompleted(CompileSet* cs)
+{
+    osg::NotifySeverity level = osg::INFO;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex>  toCompile_lock(_toCompileMutex);
+
+        // the last context to finish compiling the set, or a compile thread and a rendering thread finishing together,
+        // can both see it completed, so only the one that removes it from the _toCompile list passes it on.
+        CompileSets::iterator cs_itr = std::find(_toCompile.begin(), _toCompile.end(), cs);
+        if (cs_itr == _toCompile.end()) return;
+
+        OSG_NOTIFY(level)<<"    Erasing from list"<<std::endl;
+
+        // remove from the _toCompile list, note cs won't be deleted here as the caller's
+        // copy of the list will retain a reference.
+        _toCompile.erase(cs_itr);
+    }
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statisticsMutex);
+        ++_statistics.numCompileSets;
+    }
+
+    if (cs->_compileCompletedCallback.valid() && cs->_compileCompletedCallback->compileCompleted(cs))
+    {
+        // callback will handle merging of subgraph so no need to place CompileSet in merge.
+    }
+    else
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex>  compilded_lock(_compiledMutex);
+        _compiled.push_back(cs);
+    }
+}
+
 
 void IncrementalCompileOperation::compileAllForNextFrame(unsigned int numFramesToDoCompileAll)
 {
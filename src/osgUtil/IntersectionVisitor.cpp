@@ -21,6 +21,7 @@
 #include <osg/Camera>
 #include <osg/Geode>
 #include <osg/Billboard>
+#include <osg/SpatialIndexGroup>
 #include <osg/Geometry>
 #include <osg/Notify>
 #include <osg/io_utils>
@@ -101,6 +102,20 @@ void IntersectorGroup::leave()
     }
 }
 
+bool IntersectorGroup::intersects(const osg::BoundingSphere& bs)
+{
+    if (disabled()) return false;
+
+    for(Intersectors::iterator itr = _intersectors.begin();
+        itr != _intersectors.end();
+        ++itr)
+    {
+        if (!(*itr)->disabled() && (*itr)->intersects(bs)) return true;
+    }
+
+    return false;
+}
+
 void IntersectorGroup::intersect(osgUtil::IntersectionVisitor& iv, osg::Drawable* drawable)
 {
     if (disabled()) return;
@@ -221,6 +236,41 @@ void IntersectionVisitor::apply(osg::Group& group)
     leave();
 }
 
+namespace
+{
+
+/** Skips the cells of a SpatialIndexGroup that the intersector can't intersect.*/
+class IntersectorCellCallback : public osg::SpatialIndexGroup::CellCallback
+{
+    public:
+
+        IntersectorCellCallback(Intersector* intersector):
+            _intersector(intersector) {}
+
+        virtual bool enter(const osg::BoundingBox& bb)
+        {
+            return !bb.valid() || _intersector->intersects(osg::BoundingSphere(bb));
+        }
+
+    protected:
+
+        Intersector* _intersector;
+};
+
+}
+
+void IntersectionVisitor::apply(osg::SpatialIndexGroup& group)
+{
+    if (!enter(group)) return;
+
+    // the cells are in the group's coordinate frame, which the current intersector remains in
+    // as the intersectors pushed for Transforms below the group are popped on leaving them.
+    IntersectorCellCallback callback(_intersectorStack.back().get());
+    group.traverse(*this, callback);
+
+    leave();
+}
+
 void IntersectionVisitor::apply(osg::Drawable& drawable)
 {
     intersect( &drawable );
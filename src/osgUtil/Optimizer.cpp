@@ -23,9 +23,11 @@
 #include <osg/Billboard>
 #include <osg/CameraView>
 #include <osg/Geometry>
+#include <osg/InstancedGeometry>
 #include <osg/Notify>
 #include <osg/OccluderNode>
 #include <osg/Sequence>
+#include <osg/SpatialIndexGroup>
 #include <osg/Switch>
 #include <osg/Texture>
 #include <osg/PagedLOD>
@@ -40,6 +42,7 @@
 #include <osgUtil/Tessellator>
 #include <osgUtil/Statistics>
 #include <osgUtil/MeshOptimizers>
+#include <osgUtil/ShaderGen>
 
 #include <typeinfo>
 #include <algorithm>
@@ -56,7 +59,7 @@ void Optimizer::reset()
 {
 }
 
-static osg::ApplicationUsageProxy Optimizer_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_OPTIMIZER \"<type> [<type>]\"","OFF | DEFAULT | FLATTEN_STATIC_TRANSFORMS | FLATTEN_STATIC_TRANSFORMS_DUPLICATING_SHARED_SUBGRAPHS | REMOVE_REDUNDANT_NODES | COMBINE_ADJACENT_LODS | SHARE_DUPLICATE_STATE | MERGE_GEOMETRY | MERGE_GEODES | SPATIALIZE_GROUPS  | COPY_SHARED_NODES  | TRISTRIP_GEOMETRY | OPTIMIZE_TEXTURE_SETTINGS | REMOVE_LOADED_PROXY_NODES | TESSELLATE_GEOMETRY | CHECK_GEOMETRY |  FLATTEN_BILLBOARDS | TEXTURE_ATLAS_BUILDER | STATIC_OBJECT_DETECTION | INDEX_MESH | VERTEX_POSTTRANSFORM | VERTEX_PRETRANSFORM | BUFFER_OBJECT_SETTINGS");
+static osg::ApplicationUsageProxy Optimizer_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_OPTIMIZER \"<type> [<type>]\"","OFF | DEFAULT | FLATTEN_STATIC_TRANSFORMS | FLATTEN_STATIC_TRANSFORMS_DUPLICATING_SHARED_SUBGRAPHS | REMOVE_REDUNDANT_NODES | COMBINE_ADJACENT_LODS | SHARE_DUPLICATE_STATE | MERGE_GEOMETRY | MERGE_GEODES | SPATIALIZE_GROUPS  | COPY_SHARED_NODES  | TRISTRIP_GEOMETRY | OPTIMIZE_TEXTURE_SETTINGS | REMOVE_LOADED_PROXY_NODES | TESSELLATE_GEOMETRY | CHECK_GEOMETRY |  FLATTEN_BILLBOARDS | TEXTURE_ATLAS_BUILDER | STATIC_OBJECT_DETECTION | INDEX_MESH | VERTEX_POSTTRANSFORM | VERTEX_PRETRANSFORM | BUFFER_OBJECT_SETTINGS | SPATIAL_INDEX_GROUPS | INSTANCE_GEOMETRY");
 
 void Optimizer::optimize(osg::Node* node)
 {
@@ -138,6 +141,12 @@ void Optimizer::optimize(osg::Node* node)
 
         if(str.find("~BUFFER_OBJECT_SETTINGS")!=std::string::npos) options ^= BUFFER_OBJECT_SETTINGS;
         else if(str.find("BUFFER_OBJECT_SETTINGS")!=std::string::npos) options |= BUFFER_OBJECT_SETTINGS;
+
+        if(str.find("~SPATIAL_INDEX_GROUPS")!=std::string::npos) options ^= SPATIAL_INDEX_GROUPS;
+        else if(str.find("SPATIAL_INDEX_GROUPS")!=std::string::npos) options |= SPATIAL_INDEX_GROUPS;
+
+        if(str.find("~INSTANCE_GEOMETRY")!=std::string::npos) options ^= INSTANCE_GEOMETRY;
+        else if(str.find("INSTANCE_GEOMETRY")!=std::string::npos) options |= INSTANCE_GEOMETRY;
     }
     else
     {
@@ -351,6 +360,15 @@ void Optimizer::optimize(osg::Node* node, unsigned int options)
         fbv.process();
     }
 
+    if (options & INSTANCE_GEOMETRY)
+    {
+        OSG_INFO<<"Optimizer::optimize() doing INSTANCE_GEOMETRY"<<std::endl;
+
+        InstanceGeometryVisitor igv(this);
+        node->accept(igv);
+        igv.instance();
+    }
+
     if (options & SPATIALIZE_GROUPS)
     {
         OSG_INFO<<"Optimizer::optimize() doing SPATIALIZE_GROUPS"<<std::endl;
@@ -360,6 +378,15 @@ void Optimizer::optimize(osg::Node* node, unsigned int options)
         sv.divide();
     }
 
+    if (options & SPATIAL_INDEX_GROUPS)
+    {
+        OSG_INFO<<"Optimizer::optimize() doing SPATIAL_INDEX_GROUPS"<<std::endl;
+
+        SpatialIndexGroupsVisitor sigv(this);
+        node->accept(sigv);
+        sigv.convert();
+    }
+
     if (options & INDEX_MESH)
     {
         OSG_INFO<<"Optimizer::optimize() doing INDEX_MESH"<<std::endl;
@@ -4799,3 +4826,449 @@ void Optimizer::BufferObjectVisitor::apply(osg::Geometry& geometry)
         geometry.setUseDisplayList(_valueDisplayList);
     }
 }
+
+////////////////////////////////////////////////////////////////////////////
+// SpatialIndexGroupsVisitor
+////////////////////////////////////////////////////////////////////////////
+
+void Optimizer::SpatialIndexGroupsVisitor::apply(osg::Group& group)
+{
+    if (typeid(group)==typeid(osg::Group) &&
+        group.getNumChildren()>=_minimumNumChildren &&
+        isOperationPermissibleForObject(&group))
+    {
+        _groupsToConvertList.insert(&group);
+    }
+    traverse(group);
+}
+
+bool Optimizer::SpatialIndexGroupsVisitor::convert()
+{
+    bool converted = false;
+    for(GroupsToConvertList::iterator itr=_groupsToConvertList.begin();
+        itr!=_groupsToConvertList.end();
+        ++itr)
+    {
+        osg::ref_ptr<osg::Group> group = *itr;
+        if (group->getNumParents()==0) continue;
+
+        osg::ref_ptr<osg::SpatialIndexGroup> indexGroup = new osg::SpatialIndexGroup(*group);
+
+        // take a copy of the parent list as replacing the child removes the group from it.
+        osg::Node::ParentList parents = group->getParents();
+        for(osg::Node::ParentList::iterator pitr=parents.begin();
+            pitr!=parents.end();
+            ++pitr)
+        {
+            (*pitr)->replaceChild(group.get(), indexGroup.get());
+        }
+
+        converted = true;
+    }
+    _groupsToConvertList.clear();
+    return converted;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// InstanceGeometryVisitor
+////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+bool isSameArray(const osg::Array* lhs, const osg::Array* rhs)
+{
+    if (lhs==rhs) return true;
+    if (!lhs || !rhs) return false;
+
+    if (lhs->getType()!=rhs->getType() ||
+        lhs->getBinding()!=rhs->getBinding() ||
+        lhs->getNormalize()!=rhs->getNormalize() ||
+        lhs->getTotalDataSize()!=rhs->getTotalDataSize()) return false;
+
+    return lhs->getTotalDataSize()==0 || memcmp(lhs->getDataPointer(), rhs->getDataPointer(), lhs->getTotalDataSize())==0;
+}
+
+bool isSameArrayList(const osg::Geometry::ArrayList& lhs, const osg::Geometry::ArrayList& rhs)
+{
+    if (lhs.size()!=rhs.size()) return false;
+
+    for(unsigned int i=0; i<lhs.size(); ++i)
+    {
+        if (!isSameArray(lhs[i].get(), rhs[i].get())) return false;
+    }
+    return true;
+}
+
+bool isSamePrimitiveSet(const osg::PrimitiveSet* lhs, const osg::PrimitiveSet* rhs)
+{
+    if (lhs==rhs) return true;
+
+    if (lhs->getType()!=rhs->getType() ||
+        lhs->getMode()!=rhs->getMode() ||
+        lhs->getNumInstances()!=rhs->getNumInstances() ||
+        lhs->getTotalDataSize()!=rhs->getTotalDataSize()) return false;
+
+    if (lhs->getType()==osg::PrimitiveSet::DrawArraysPrimitiveType)
+    {
+        const osg::DrawArrays* lda = static_cast<const osg::DrawArrays*>(lhs);
+        const osg::DrawArrays* rda = static_cast<const osg::DrawArrays*>(rhs);
+        return lda->getFirst()==rda->getFirst() && lda->getCount()==rda->getCount();
+    }
+
+    if (lhs->getType()==osg::PrimitiveSet::DrawArrayLengthsPrimitiveType &&
+        static_cast<const osg::DrawArrayLengths*>(lhs)->getFirst()!=static_cast<const osg::DrawArrayLengths*>(rhs)->getFirst()) return false;
+
+    return lhs->getTotalDataSize()==0 || memcmp(lhs->getDataPointer(), rhs->getDataPointer(), lhs->getTotalDataSize())==0;
+}
+
+/** Hash of the vertices and primitives of a geometry, so that only geometries with the same hash need comparing.*/
+unsigned int computeGeometryHash(const osg::Geometry& geometry)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+
+    const osg::Array* vertices = geometry.getVertexArray();
+    const unsigned char* ptr = static_cast<const unsigned char*>(vertices->getDataPointer());
+    for(unsigned int i=0; i<vertices->getTotalDataSize(); ++i)
+    {
+        hash = (hash ^ ptr[i]) * 16777619u;
+    }
+
+    hash = (hash ^ geometry.getNumPrimitiveSets()) * 16777619u;
+    for(unsigned int i=0; i<geometry.getNumPrimitiveSets(); ++i)
+    {
+        hash = (hash ^ geometry.getPrimitiveSet(i)->getNumIndices()) * 16777619u;
+    }
+    return hash;
+}
+
+/** Interleave the bits of the cell coordinates to give the position of the cell along a Morton curve.*/
+unsigned int computeMortonCode(unsigned int x, unsigned int y, unsigned int z)
+{
+    unsigned int code = 0;
+    for(unsigned int bit=0; bit<10; ++bit)
+    {
+        code |= ((x>>bit)&1) << (bit*3);
+        code |= ((y>>bit)&1) << (bit*3+1);
+        code |= ((z>>bit)&1) << (bit*3+2);
+    }
+    return code;
+}
+
+}
+
+Optimizer::InstanceGeometryVisitor::InstanceGeometryVisitor(Optimizer* optimizer, unsigned int minimumNumInstances):
+    BaseOptimizerVisitor(optimizer, INSTANCE_GEOMETRY),
+    _minimumNumInstances(minimumNumInstances),
+    _numPrograms(0)
+{
+    _rootStateSet = new osg::StateSet;
+    _rootStateSet->setMode(GL_LIGHTING, osg::StateAttribute::ON);
+}
+
+void Optimizer::InstanceGeometryVisitor::reset()
+{
+    _stateSetStack.clear();
+    _numPrograms = 0;
+    _groupsCollected.clear();
+    _instanceSets.clear();
+}
+
+void Optimizer::InstanceGeometryVisitor::pushStateSet(osg::StateSet* stateSet)
+{
+    if (!stateSet) return;
+
+    _stateSetStack.push_back(stateSet);
+    if (stateSet->getAttribute(osg::StateAttribute::PROGRAM)) ++_numPrograms;
+}
+
+void Optimizer::InstanceGeometryVisitor::popStateSet(osg::StateSet* stateSet)
+{
+    if (!stateSet) return;
+
+    _stateSetStack.pop_back();
+    if (stateSet->getAttribute(osg::StateAttribute::PROGRAM)) --_numPrograms;
+}
+
+void Optimizer::InstanceGeometryVisitor::apply(osg::Node& node)
+{
+    pushStateSet(node.getStateSet());
+    traverse(node);
+    popStateSet(node.getStateSet());
+}
+
+void Optimizer::InstanceGeometryVisitor::apply(osg::Group& group)
+{
+    pushStateSet(group.getStateSet());
+
+    // only plain groups and transforms, as the children of the other groups have a meaning of their own.
+    bool plainGroup = typeid(group)==typeid(osg::Group) || typeid(group)==typeid(osg::SpatialIndexGroup) || group.asTransform();
+    if (plainGroup &&
+        _numPrograms==0 &&
+        group.getNumChildren()>=_minimumNumInstances &&
+        isOperationPermissibleForObject(&group) &&
+        _groupsCollected.insert(&group).second)
+    {
+        collectInstances(group);
+    }
+
+    traverse(group);
+
+    popStateSet(group.getStateSet());
+}
+
+bool Optimizer::InstanceGeometryVisitor::computeInstance(osg::Node* child, Instance& instance)
+{
+    osg::Transform* transform = child->asTransform();
+    if (!transform || transform->getReferenceFrame()!=osg::Transform::RELATIVE_RF) return false;
+
+    // other transforms, such as AutoTransforms, depend on the view.
+    if (typeid(*transform)!=typeid(osg::MatrixTransform) && typeid(*transform)!=typeid(osg::PositionAttitudeTransform)) return false;
+
+    if (transform->getNumParents()!=1 || transform->getNumChildren()!=1 ||
+        transform->getStateSet() ||
+        transform->getUpdateCallback() || transform->getEventCallback() || transform->getCullCallback() ||
+        transform->getDataVariance()==osg::Object::DYNAMIC) return false;
+
+    osg::Node* node = transform->getChild(0);
+    osg::Geode* geode = node->asGeode();
+    osg::Geometry* geometry = 0;
+    if (geode)
+    {
+        if (geode->getNumDrawables()!=1 ||
+            geode->getUpdateCallback() || geode->getEventCallback() || geode->getCullCallback()) return false;
+
+        geometry = geode->getDrawable(0)->asGeometry();
+    }
+    else
+    {
+        geometry = node->asGeometry();
+    }
+
+    if (!geometry || typeid(*geometry)!=typeid(osg::Geometry)) return false;
+
+    if (geometry->getUpdateCallback() || geometry->getEventCallback() || geometry->getCullCallback() ||
+        geometry->getDrawCallback() || geometry->getComputeBoundingBoxCallback() ||
+        geometry->getDataVariance()==osg::Object::DYNAMIC ||
+        geometry->containsDeprecatedData() ||
+        !geometry->getVertexArray() || geometry->getVertexArray()->getNumElements()==0) return false;
+
+    // the instance matrix takes up four attribute locations, which the geometry can't be using.
+    for(unsigned int i=0; i<4; ++i)
+    {
+        if (geometry->getVertexAttribArray(osg::InstancedGeometry::DEFAULT_INSTANCE_MATRIX_LOCATION+i)) return false;
+    }
+
+    for(unsigned int i=0; i<geometry->getNumPrimitiveSets(); ++i)
+    {
+        const osg::PrimitiveSet* primitiveSet = geometry->getPrimitiveSet(i);
+        if (primitiveSet->getNumInstances()!=0) return false;
+        if (primitiveSet->getType()!=osg::PrimitiveSet::DrawArraysPrimitiveType &&
+            primitiveSet->getType()!=osg::PrimitiveSet::DrawArrayLengthsPrimitiveType &&
+            !primitiveSet->getDrawElements()) return false;
+    }
+
+    instance.transform = transform;
+    instance.geode = geode;
+    instance.geometry = geometry;
+    instance.matrix.makeIdentity();
+    transform->computeLocalToWorldMatrix(instance.matrix, 0);
+    return true;
+}
+
+bool Optimizer::InstanceGeometryVisitor::isSameGeometry(const osg::Geometry& lhs, const osg::Geometry& rhs)
+{
+    if (&lhs==&rhs) return true;
+
+    if (lhs.getStateSet()!=rhs.getStateSet()) return false;
+
+    if (!isSameArray(lhs.getVertexArray(), rhs.getVertexArray()) ||
+        !isSameArray(lhs.getNormalArray(), rhs.getNormalArray()) ||
+        !isSameArray(lhs.getColorArray(), rhs.getColorArray()) ||
+        !isSameArray(lhs.getSecondaryColorArray(), rhs.getSecondaryColorArray()) ||
+        !isSameArray(lhs.getFogCoordArray(), rhs.getFogCoordArray()) ||
+        !isSameArrayList(lhs.getTexCoordArrayList(), rhs.getTexCoordArrayList()) ||
+        !isSameArrayList(lhs.getVertexAttribArrayList(), rhs.getVertexAttribArrayList())) return false;
+
+    if (lhs.getNumPrimitiveSets()!=rhs.getNumPrimitiveSets()) return false;
+
+    for(unsigned int i=0; i<lhs.getNumPrimitiveSets(); ++i)
+    {
+        if (!isSamePrimitiveSet(lhs.getPrimitiveSet(i), rhs.getPrimitiveSet(i))) return false;
+    }
+    return true;
+}
+
+void Optimizer::InstanceGeometryVisitor::sortInstances(Instances& instances)
+{
+    osg::BoundingBox bb;
+    for(Instances::const_iterator itr = instances.begin(); itr != instances.end(); ++itr)
+    {
+        bb.expandBy(itr->matrix.getTrans());
+    }
+
+    osg::Vec3 size = bb._max - bb._min;
+    float scale = 1023.0f/std::max(std::max(size.x(), size.y()), std::max(size.z(), 1e-6f));
+
+    typedef std::vector< std::pair<unsigned int, unsigned int> > Codes;
+    Codes codes;
+    codes.reserve(instances.size());
+    for(unsigned int i=0; i<instances.size(); ++i)
+    {
+        osg::Vec3 cell = (osg::Vec3(instances[i].matrix.getTrans()) - bb._min)*scale;
+        codes.push_back(Codes::value_type(computeMortonCode(static_cast<unsigned int>(cell.x()),
+                                                            static_cast<unsigned int>(cell.y()),
+                                                            static_cast<unsigned int>(cell.z())), i));
+    }
+
+    std::sort(codes.begin(), codes.end());
+
+    Instances sorted;
+    sorted.reserve(instances.size());
+    for(Codes::const_iterator itr = codes.begin(); itr != codes.end(); ++itr)
+    {
+        sorted.push_back(instances[itr->second]);
+    }
+    instances.swap(sorted);
+}
+
+void Optimizer::InstanceGeometryVisitor::collectInstances(osg::Group& group)
+{
+    // instances can only be drawn together when they share the geometry, its state and node masks.
+    typedef std::multimap<unsigned int, unsigned int> HashMap;
+    typedef std::map<osg::Geometry*, unsigned int> GeometryHashMap;
+
+    HashMap hashMap;
+    GeometryHashMap geometryHashMap;
+    std::vector<Instances> candidateSets;
+
+    for(unsigned int i=0; i<group.getNumChildren(); ++i)
+    {
+        Instance instance;
+        if (!computeInstance(group.getChild(i), instance) ||
+            !isOperationPermissibleForObject(instance.transform) ||
+            !isOperationPermissibleForObject(instance.geometry)) continue;
+
+        osg::StateSet* geodeStateSet = instance.geode ? instance.geode->getStateSet() : 0;
+        osg::StateSet* geometryStateSet = instance.geometry->getStateSet();
+        if ((geodeStateSet && geodeStateSet->getAttribute(osg::StateAttribute::PROGRAM)) ||
+            (geometryStateSet && geometryStateSet->getAttribute(osg::StateAttribute::PROGRAM))) continue;
+
+        GeometryHashMap::iterator gitr = geometryHashMap.find(instance.geometry);
+        if (gitr==geometryHashMap.end())
+        {
+            gitr = geometryHashMap.insert(GeometryHashMap::value_type(instance.geometry, computeGeometryHash(*instance.geometry))).first;
+        }
+
+        unsigned int nodeMask = instance.transform->getNodeMask() & (instance.geode ? instance.geode->getNodeMask() : ~0u);
+
+        bool added = false;
+        std::pair<HashMap::iterator, HashMap::iterator> range = hashMap.equal_range(gitr->second);
+        for(HashMap::iterator hitr = range.first; hitr != range.second && !added; ++hitr)
+        {
+            Instances& candidates = candidateSets[hitr->second];
+            const Instance& first = candidates.front();
+            if ((first.geode ? first.geode->getStateSet() : 0)==geodeStateSet &&
+                (first.transform->getNodeMask() & (first.geode ? first.geode->getNodeMask() : ~0u))==nodeMask &&
+                isSameGeometry(*first.geometry, *instance.geometry))
+            {
+                candidates.push_back(instance);
+                added = true;
+            }
+        }
+
+        if (!added)
+        {
+            hashMap.insert(HashMap::value_type(gitr->second, static_cast<unsigned int>(candidateSets.size())));
+            candidateSets.push_back(Instances(1, instance));
+        }
+    }
+
+    osg::ref_ptr<osg::StateSet> accumulatedStateSet;
+    for(std::vector<Instances>::iterator itr = candidateSets.begin(); itr != candidateSets.end(); ++itr)
+    {
+        if (itr->size()<_minimumNumInstances) continue;
+
+        // the state the instances inherit, from which the shaders are generated.
+        if (!accumulatedStateSet)
+        {
+            accumulatedStateSet = _rootStateSet.valid() ? new osg::StateSet(*_rootStateSet) : new osg::StateSet;
+            for(StateSetStack::const_iterator sitr = _stateSetStack.begin(); sitr != _stateSetStack.end(); ++sitr)
+            {
+                accumulatedStateSet->merge(**sitr);
+            }
+        }
+
+        _instanceSets.push_back(InstanceSet());
+        InstanceSet& instanceSet = _instanceSets.back();
+        instanceSet.group = &group;
+        instanceSet.stateSet = accumulatedStateSet;
+        instanceSet.instances.swap(*itr);
+    }
+}
+
+bool Optimizer::InstanceGeometryVisitor::instance()
+{
+    bool instanced = false;
+    for(InstanceSets::iterator itr = _instanceSets.begin(); itr != _instanceSets.end(); ++itr)
+    {
+        osg::Group* group = itr->group.get();
+        Instances& instances = itr->instances;
+
+        sortInstances(instances);
+
+        const Instance& first = instances.front();
+
+        osg::ref_ptr<osg::InstancedGeometry> geometry = new osg::InstancedGeometry(*first.geometry);
+
+        // the shaders are set on the geometry's own StateSet, so leave the StateSet of the original geometries alone.
+        geometry->setStateSet(first.geometry->getStateSet() ? new osg::StateSet(*first.geometry->getStateSet()) : new osg::StateSet);
+        geometry->setUseVertexBufferObjects(true);
+
+        osg::ref_ptr<osg::MatrixfArray> matrices = new osg::MatrixfArray;
+        matrices->reserve(instances.size());
+        for(Instances::const_iterator iitr = instances.begin(); iitr != instances.end(); ++iitr)
+        {
+            matrices->push_back(osg::Matrixf(iitr->matrix));
+        }
+        geometry->setInstanceMatrices(matrices.get());
+
+        osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+        geode->setStateSet(first.geode ? first.geode->getStateSet() : 0);
+        geode->setNodeMask(first.transform->getNodeMask() & (first.geode ? first.geode->getNodeMask() : ~0u));
+        geode->addDrawable(geometry.get());
+
+        ShaderGenVisitor shaderGen;
+        shaderGen.setRootStateSet(itr->stateSet.get());
+        geode->accept(shaderGen);
+
+        // rebuild the child list in one pass rather than removing the transforms one at a time.
+        std::set<osg::Node*> transforms;
+        for(Instances::const_iterator iitr = instances.begin(); iitr != instances.end(); ++iitr)
+        {
+            transforms.insert(iitr->transform);
+        }
+
+        std::vector< osg::ref_ptr<osg::Node> > children;
+        children.reserve(group->getNumChildren()-instances.size()+1);
+        for(unsigned int i=0; i<group->getNumChildren(); ++i)
+        {
+            if (transforms.count(group->getChild(i))==0) children.push_back(group->getChild(i));
+        }
+        children.push_back(geode.get());
+
+        group->removeChildren(0, group->getNumChildren());
+        for(std::vector< osg::ref_ptr<osg::Node> >::iterator citr = children.begin(); citr != children.end(); ++citr)
+        {
+            group->addChild(citr->get());
+        }
+
+        OSG_INFO<<"Optimizer::InstanceGeometryVisitor::instance() replaced "<<instances.size()<<" transformed geometries"<<std::endl;
+
+        instanced = true;
+    }
+    _instanceSets.clear();
+    _groupsCollected.clear();
+    return instanced;
+}
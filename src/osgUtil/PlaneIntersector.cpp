@@ -645,6 +645,11 @@ bool PlaneIntersector::enter(const osg::Node& node)
 }
 
 
+bool PlaneIntersector::intersects(const osg::BoundingSphere& bs)
+{
+    return _plane.intersect(bs)==0 && _polytope.contains(bs);
+}
+
 void PlaneIntersector::leave()
 {
     // do nothing.
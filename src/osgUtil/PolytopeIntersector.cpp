@@ -556,6 +556,11 @@ bool PolytopeIntersector::enter(const osg::Node& node)
 }
 
 
+bool PolytopeIntersector::intersects(const osg::BoundingSphere& bs)
+{
+    return _polytope.contains(bs);
+}
+
 void PolytopeIntersector::leave()
 {
     // do nothing.
@@ -16,6 +16,7 @@
 #include <osgUtil/RenderBin>
 #include <osgUtil/RenderStage>
 #include <osgUtil/Statistics>
+#include <osgUtil/DrawBatcher>
 
 #include <osg/Notify>
 #include <osg/ApplicationUsage>
@@ -142,6 +143,32 @@ RenderBin::SortMode RenderBin::getDefaultRenderBinSortMode()
     return s_defaultBinSortMode;
 }
 
+static bool s_defaultDrawBatchingInitialized = false;
+static bool s_defaultDrawBatching = false;
+static osg::ApplicationUsageProxy RenderBin_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_RENDERBIN_DRAW_BATCHING <mode>","ON | OFF - batch compatible drawables into multi draw indirect calls, requires shaders that read the DrawBatcher matrices.");
+
+void RenderBin::setDefaultDrawBatching(bool flag)
+{
+    s_defaultDrawBatchingInitialized = true;
+    s_defaultDrawBatching = flag;
+}
+
+bool RenderBin::getDefaultDrawBatching()
+{
+    if (!s_defaultDrawBatchingInitialized)
+    {
+        s_defaultDrawBatchingInitialized = true;
+
+        const char* str = getenv("OSG_RENDERBIN_DRAW_BATCHING");
+        if (str)
+        {
+            s_defaultDrawBatching = (strcmp(str,"ON")==0 || strcmp(str,"on")==0 || strcmp(str,"On")==0);
+        }
+    }
+
+    return s_defaultDrawBatching;
+}
+
 RenderBin::RenderBin()
 {
     _binNum = 0;
@@ -149,6 +176,7 @@ RenderBin::RenderBin()
     _stage = NULL;
     _sorted = false;
     _sortMode = getDefaultRenderBinSortMode();
+    _drawBatching = getDefaultDrawBatching();
 }
 
 RenderBin::RenderBin(SortMode mode)
@@ -158,6 +186,7 @@ RenderBin::RenderBin(SortMode mode)
     _stage = NULL;
     _sorted = false;
     _sortMode = mode;
+    _drawBatching = getDefaultDrawBatching();
 
 #if 1
     if (_sortMode==SORT_BACK_TO_FRONT)
@@ -188,6 +217,7 @@ RenderBin::RenderBin(const RenderBin& rhs,const CopyOp& copyop):
         _sorted(rhs._sorted),
         _sortMode(rhs._sortMode),
         _sortCallback(rhs._sortCallback),
+        _drawBatching(rhs._drawBatching),
         _drawCallback(rhs._drawCallback),
         _stateset(rhs._stateset)
 {
@@ -471,8 +501,58 @@ void RenderBin::drawImplementation(osg::RenderInfo& renderInfo,RenderLeaf*& prev
 
     bool draw_forward = true; //(_sortMode!=SORT_BY_STATE) || (state.getFrameStamp()->getFrameNumber() % 2)==0;
 
+    DrawBatcher* drawBatcher = (_drawBatching && DrawBatcher::instance()->isSupported(state)) ? DrawBatcher::instance() : 0;
+
     // draw coarse grained ordering.
-    if (draw_forward)
+    if (drawBatcher)
+    {
+        unsigned int minimumBatchSize = osg::maximum(drawBatcher->getMinimumBatchSize(), 2u);
+
+        for(StateGraphList::iterator oitr=_stateGraphList.begin();
+            oitr!=_stateGraphList.end();
+            ++oitr)
+        {
+            StateGraph::LeafList& leaves = (*oitr)->_leaves;
+            StateGraph::LeafList::iterator dw_itr = leaves.begin();
+            while(dw_itr != leaves.end())
+            {
+                // find the run of leaves that share the batch key and projection of the current leaf.
+                RenderLeaf* rl = dw_itr->get();
+                unsigned int key = drawBatcher->getBatchKey(rl);
+
+                StateGraph::LeafList::iterator end_itr = dw_itr;
+                ++end_itr;
+                unsigned int runLength = 1;
+                if (key!=0)
+                {
+                    while(end_itr != leaves.end() &&
+                          drawBatcher->getBatchKey(end_itr->get())==key &&
+                          ((*end_itr)->_projection==rl->_projection ||
+                           ((*end_itr)->_projection.valid() && rl->_projection.valid() && *((*end_itr)->_projection)==*(rl->_projection))))
+                    {
+                        ++end_itr;
+                        ++runLength;
+                    }
+                }
+
+                if (runLength>=minimumBatchSize)
+                {
+                    if (!state.getAbortRendering()) drawBatcher->draw(renderInfo, dw_itr, end_itr, previous);
+                    dw_itr = end_itr;
+                }
+                else
+                {
+                    for(; dw_itr != end_itr; ++dw_itr)
+                    {
+                        rl = dw_itr->get();
+                        rl->render(renderInfo,previous);
+                        previous = rl;
+                    }
+                }
+            }
+        }
+    }
+    else if (draw_forward)
     {
         for(StateGraphList::iterator oitr=_stateGraphList.begin();
             oitr!=_stateGraphList.end();
@@ -17,24 +17,16 @@
 using namespace osg;
 using namespace osgUtil;
 
-void RenderLeaf::render(osg::RenderInfo& renderInfo,RenderLeaf* previous)
+void RenderLeaf::applyState(osg::RenderInfo& renderInfo,RenderLeaf* previous)
 {
     osg::State& state = *renderInfo.getState();
 
-    // don't draw this leaf if the abort rendering flag has been set.
-    if (state.getAbortRendering())
-    {
-        //cout << "early abort"<<endl;
-        return;
-    }
+    // apply matrices if required.
+    state.applyProjectionMatrix(_projection.get());
+    state.applyModelViewMatrix(_modelview.get());
 
     if (previous)
     {
-
-        // apply matrices if required.
-        state.applyProjectionMatrix(_projection.get());
-        state.applyModelViewMatrix(_modelview.get());
-
         // apply state if required.
         StateGraph* prev_rg = previous->_parent;
         StateGraph* prev_rg_parent = prev_rg->_parent;
@@ -54,33 +46,36 @@ void RenderLeaf::render(osg::RenderInfo& renderInfo,RenderLeaf* previous)
             state.apply(rg->getStateSet());
 
         }
-
-        // if we are using osg::Program which requires OSG's generated uniforms to track
-        // modelview and projection matrices then apply them now.
-        if (state.getUseModelViewAndProjectionUniforms()) state.applyModelViewAndProjectionUniformsIfRequired();
-
-        // draw the drawable
-        _drawable->draw(renderInfo);
     }
     else
     {
-        // apply matrices if required.
-        state.applyProjectionMatrix(_projection.get());
-        state.applyModelViewMatrix(_modelview.get());
-
         // apply state if required.
         StateGraph::moveStateGraph(state,NULL,_parent->_parent);
 
         state.apply(_parent->getStateSet());
+    }
 
-        // if we are using osg::Program which requires OSG's generated uniforms to track
-        // modelview and projection matrices then apply them now.
-        if (state.getUseModelViewAndProjectionUniforms()) state.applyModelViewAndProjectionUniformsIfRequired();
+    // if we are using osg::Program which requires OSG's generated uniforms to track
+    // modelview and projection matrices then apply them now.
+    if (state.getUseModelViewAndProjectionUniforms()) state.applyModelViewAndProjectionUniformsIfRequired();
+}
+
+void RenderLeaf::render(osg::RenderInfo& renderInfo,RenderLeaf* previous)
+{
+    osg::State& state = *renderInfo.getState();
 
-        // draw the drawable
-        _drawable->draw(renderInfo);
+    // don't draw this leaf if the abort rendering flag has been set.
+    if (state.getAbortRendering())
+    {
+        //cout << "early abort"<<endl;
+        return;
     }
 
+    applyState(renderInfo, previous);
+
+    // draw the drawable
+    _drawable->draw(renderInfo);
+
     if (_dynamic)
     {
         state.decrementDynamicObjectCount();
@@ -236,7 +236,8 @@ void SceneView::setDefaults(unsigned int options)
     {
         GLObjectsVisitor::Mode  dlvMode = GLObjectsVisitor::COMPILE_DISPLAY_LISTS |
                                           GLObjectsVisitor::COMPILE_STATE_ATTRIBUTES |
-                                          GLObjectsVisitor::CHECK_BLACK_LISTED_MODES;
+                                          GLObjectsVisitor::CHECK_BLACK_LISTED_MODES |
+                                          GLObjectsVisitor::COMPILE_DEFINE_PERMUTATIONS;
 
     #ifdef __sgi
         dlvMode = GLObjectsVisitor::COMPILE_STATE_ATTRIBUTES;
@@ -822,6 +823,23 @@ bool SceneView::cullStage(const osg::Matrixd& projection,const osg::Matrixd& mod
         std::copy(_collectOccludersVisitor->getCollectedOccluderSet().begin(),_collectOccludersVisitor->getCollectedOccluderSet().end(), std::back_insert_iterator<CullStack::OccluderList>(cullVisitor->getOccluderList()));
     }
 
+    // rasterize the occluder meshes in view for the CullVisitor to test against.
+    if ((getCullingMode() & osg::CullSettings::SOFTWARE_OCCLUSION_CULLING)!=0 && _camera->containsOccluderNodes())
+    {
+        if (!cullVisitor->getSoftwareOcclusionCuller()) cullVisitor->setSoftwareOcclusionCuller(new SoftwareOcclusionCuller);
+
+        SoftwareOcclusionCuller* softwareOcclusionCuller = cullVisitor->getSoftwareOcclusionCuller();
+        softwareOcclusionCuller->clear();
+        for(unsigned int i=0; i<_camera->getNumChildren(); ++i)
+        {
+            softwareOcclusionCuller->collectOccluders(*_camera->getChild(i), *mv, *proj);
+        }
+    }
+    else if (cullVisitor->getSoftwareOcclusionCuller())
+    {
+        cullVisitor->getSoftwareOcclusionCuller()->clear();
+    }
+
 
 
     cullVisitor->reset();
@@ -19,6 +19,7 @@
 #include <osgUtil/ShaderGen>
 #include <osg/Geode>
 #include <osg/Geometry> // for ShaderGenVisitor::update
+#include <osg/InstancedGeometry>
 #include <osg/Fog>
 #include <sstream>
 
@@ -156,10 +157,34 @@ osg::StateSet *ShaderGenCache::createStateSet(int stateMask) const
         vert << "attribute vec3 tangent;\n";
     }
 
+    // instances transform the vertex attributes by their matrix ahead of the modelview matrix.
+    std::string vertex("gl_Vertex");
+    std::string normal("gl_Normal");
+    std::string tangent("tangent");
+    if (stateMask & INSTANCED)
+    {
+        program->addBindAttribLocation("osg_InstanceMatrix", osg::InstancedGeometry::DEFAULT_INSTANCE_MATRIX_LOCATION);
+        vert << "attribute mat4 osg_InstanceMatrix;\n";
+        vertex = "vertex";
+        normal = "normal";
+        tangent = "(osg_InstanceMatrix * vec4(tangent, 0.0)).xyz";
+    }
+
     vert << "\n"\
         "void main()\n"\
-        "{\n"\
-        "  gl_Position = ftransform();\n";
+        "{\n";
+
+    if (stateMask & INSTANCED)
+    {
+        vert <<
+            "  vec4 vertex = osg_InstanceMatrix * gl_Vertex;\n"\
+            "  vec3 normal = (osg_InstanceMatrix * vec4(gl_Normal, 0.0)).xyz;\n"\
+            "  gl_Position = gl_ModelViewProjectionMatrix * vertex;\n";
+    }
+    else
+    {
+        vert << "  gl_Position = ftransform();\n";
+    }
 
     if (stateMask & (DIFFUSE_MAP | NORMAL_MAP))
     {
@@ -169,10 +194,10 @@ osg::StateSet *ShaderGenCache::createStateSet(int stateMask) const
     if (stateMask & NORMAL_MAP)
     {
         vert <<
-            "  vec3 n = gl_NormalMatrix * gl_Normal;\n"\
-            "  vec3 t = gl_NormalMatrix * tangent;\n"\
+            "  vec3 n = gl_NormalMatrix * " << normal << ";\n"\
+            "  vec3 t = gl_NormalMatrix * " << tangent << ";\n"\
             "  vec3 b = cross(n, t);\n"\
-            "  vec3 dir = -vec3(gl_ModelViewMatrix * gl_Vertex);\n"\
+            "  vec3 dir = -vec3(gl_ModelViewMatrix * " << vertex << ");\n"\
             "  viewDir.x = dot(dir, t);\n"\
             "  viewDir.y = dot(dir, b);\n"\
             "  viewDir.z = dot(dir, n);\n"\
@@ -188,8 +213,8 @@ osg::StateSet *ShaderGenCache::createStateSet(int stateMask) const
     else if (stateMask & LIGHTING)
     {
         vert <<
-            "  normalDir = gl_NormalMatrix * gl_Normal;\n"\
-            "  vec3 dir = -vec3(gl_ModelViewMatrix * gl_Vertex);\n"\
+            "  normalDir = gl_NormalMatrix * " << normal << ";\n"\
+            "  vec3 dir = -vec3(gl_ModelViewMatrix * " << vertex << ");\n"\
             "  viewDir = dir;\n"\
             "  vec4 lpos = gl_LightSource[0].position;\n"\
             "  if (lpos.w == 0.0)\n"\
@@ -200,7 +225,7 @@ osg::StateSet *ShaderGenCache::createStateSet(int stateMask) const
     else if (stateMask & FOG)
     {
         vert <<
-            "  viewDir = -vec3(gl_ModelViewMatrix * gl_Vertex);\n"\
+            "  viewDir = -vec3(gl_ModelViewMatrix * " << vertex << ");\n"\
             "  gl_FrontColor = gl_Color;\n";
     }
     else
@@ -377,6 +402,9 @@ void ShaderGenVisitor::update(osg::Drawable *drawable)
         geometry->getVertexAttribArray(6)) //tangent
         stateMask |= ShaderGenCache::NORMAL_MAP;
 
+    if (dynamic_cast<osg::InstancedGeometry*>(drawable))
+        stateMask |= ShaderGenCache::INSTANCED;
+
     // Get program and uniforms for accumulated state.
     osg::StateSet *progss = _stateCache->getOrCreateStateSet(stateMask);
     // Set program and uniforms to the last state set.
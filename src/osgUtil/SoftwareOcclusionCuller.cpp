@@ -0,0 +1,412 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgUtil/SoftwareOcclusionCuller>
+#include <osgUtil/Simplifier>
+
+#include <osg/NodeVisitor>
+#include <osg/OccluderNode>
+#include <osg/Transform>
+#include <osg/Camera>
+#include <osg/Geode>
+#include <osg/TriangleFunctor>
+#include <osg/TriangleIndexFunctor>
+
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace osgUtil;
+
+namespace
+{
+
+// vertices with a clip space w below this are treated as being on or behind the eye
+const double s_minimumW = 1e-6;
+
+// snap window coordinates to a 1/16th sub pixel grid so that the edge functions are computed exactly,
+// and pixels on the edge shared by two triangles are covered by both rather than falling between them.
+inline double snap(double v) { return floor(v*16.0+0.5)/16.0; }
+
+struct RasterizeIndexedTriangle
+{
+    RasterizeIndexedTriangle(): _culler(0), _vertices(0) {}
+
+    void set(SoftwareOcclusionCuller* culler, const std::vector<osg::Vec4d>* vertices) { _culler = culler; _vertices = vertices; }
+
+    void operator() (unsigned int p1, unsigned int p2, unsigned int p3);
+
+    SoftwareOcclusionCuller*            _culler;
+    const std::vector<osg::Vec4d>*      _vertices;
+};
+
+struct CollectTriangles
+{
+    CollectTriangles(): _vertices(0), _matrix(0) {}
+
+    void operator() (const osg::Vec3& v1, const osg::Vec3& v2, const osg::Vec3& v3, bool)
+    {
+        _vertices->push_back(v1 * (*_matrix));
+        _vertices->push_back(v2 * (*_matrix));
+        _vertices->push_back(v3 * (*_matrix));
+    }
+
+    osg::Vec3Array*     _vertices;
+    const osg::Matrix*  _matrix;
+};
+
+class CollectOccluderMeshesVisitor : public osg::NodeVisitor
+{
+    public:
+
+        CollectOccluderMeshesVisitor(SoftwareOcclusionCuller* culler, const osg::Matrix& modelView, const osg::Matrix& projection):
+            osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ACTIVE_CHILDREN),
+            _culler(culler),
+            _projection(projection)
+        {
+            _modelViewStack.push_back(modelView);
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            if (node.getNumChildrenWithOccluderNodes()>0) traverse(node);
+        }
+
+        virtual void apply(osg::Camera&)
+        {
+            // nested cameras have their own view and projection, so their occluders don't apply to this view.
+        }
+
+        virtual void apply(osg::Transform& transform)
+        {
+            if (transform.getNumChildrenWithOccluderNodes()==0) return;
+
+            osg::Matrix matrix = _modelViewStack.back();
+            transform.computeLocalToWorldMatrix(matrix, this);
+
+            _modelViewStack.push_back(matrix);
+            traverse(transform);
+            _modelViewStack.pop_back();
+        }
+
+        virtual void apply(osg::OccluderNode& node)
+        {
+            osg::Matrix modelViewProjection = _modelViewStack.back() * _projection;
+
+            if (node.getOccluderMesh())
+            {
+                _culler->rasterizeOccluder(*node.getOccluderMesh(), modelViewProjection);
+            }
+
+            // convex planar occluders with holes would occlude through their holes, so only those without holes are used.
+            const osg::ConvexPlanarOccluder* occluder = node.getOccluder();
+            if (occluder && occluder->getHoleList().empty())
+            {
+                const osg::ConvexPlanarPolygon::VertexList& vertices = occluder->getOccluder().getVertexList();
+                for(unsigned int i=2; i<vertices.size(); ++i)
+                {
+                    _culler->rasterizeTriangle(vertices[0], vertices[i-1], vertices[i], modelViewProjection);
+                }
+            }
+
+            if (node.getNumChildrenWithOccluderNodes()>0) traverse(node);
+        }
+
+    protected:
+
+        typedef std::vector<osg::Matrix> MatrixStack;
+
+        SoftwareOcclusionCuller*    _culler;
+        osg::Matrix                 _projection;
+        MatrixStack                 _modelViewStack;
+};
+
+class MergeTrianglesVisitor : public osg::NodeVisitor
+{
+    public:
+
+        MergeTrianglesVisitor():
+            osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+            _vertices(new osg::Vec3Array)
+        {
+            _matrixStack.push_back(osg::Matrix::identity());
+        }
+
+        virtual void apply(osg::Transform& transform)
+        {
+            osg::Matrix matrix = _matrixStack.back();
+            transform.computeLocalToWorldMatrix(matrix, this);
+
+            _matrixStack.push_back(matrix);
+            traverse(transform);
+            _matrixStack.pop_back();
+        }
+
+        virtual void apply(osg::Geometry& geometry)
+        {
+            osg::TriangleFunctor<CollectTriangles> tf;
+            tf._vertices = _vertices.get();
+            tf._matrix = &_matrixStack.back();
+            geometry.accept(tf);
+        }
+
+        typedef std::vector<osg::Matrix> MatrixStack;
+
+        MatrixStack                     _matrixStack;
+        osg::ref_ptr<osg::Vec3Array>    _vertices;
+};
+
+}
+
+void RasterizeIndexedTriangle::operator() (unsigned int p1, unsigned int p2, unsigned int p3)
+{
+    if (p1>=_vertices->size() || p2>=_vertices->size() || p3>=_vertices->size()) return;
+
+    _culler->rasterizeClipSpaceTriangle((*_vertices)[p1], (*_vertices)[p2], (*_vertices)[p3]);
+}
+
+SoftwareOcclusionCuller::SoftwareOcclusionCuller(unsigned int width, unsigned int height):
+    _width(0),
+    _height(0),
+    _numTilesX(0),
+    _numTilesY(0),
+    _numOccluderTriangles(0),
+    _numTests(0),
+    _numOccluded(0)
+{
+    setResolution(width, height);
+}
+
+void SoftwareOcclusionCuller::setResolution(unsigned int width, unsigned int height)
+{
+    _numTilesX = std::max(1u, (width+TILE_SIZE-1)/TILE_SIZE);
+    _numTilesY = std::max(1u, (height+TILE_SIZE-1)/TILE_SIZE);
+    _width = _numTilesX*TILE_SIZE;
+    _height = _numTilesY*TILE_SIZE;
+
+    _depth.resize(_width*_height);
+    _tileMaxDepth.resize(_numTilesX*_numTilesY);
+
+    clear();
+}
+
+void SoftwareOcclusionCuller::clear()
+{
+    std::fill(_depth.begin(), _depth.end(), FLT_MAX);
+    std::fill(_tileMaxDepth.begin(), _tileMaxDepth.end(), FLT_MAX);
+
+    _numOccluderTriangles = 0;
+    _numTests = 0;
+    _numOccluded = 0;
+}
+
+void SoftwareOcclusionCuller::collectOccluders(osg::Node& node, const osg::Matrix& modelView, const osg::Matrix& projection)
+{
+    CollectOccluderMeshesVisitor cov(this, modelView, projection);
+    node.accept(cov);
+
+    updateTiles();
+}
+
+void SoftwareOcclusionCuller::rasterizeOccluder(const osg::Geometry& mesh, const osg::Matrix& modelViewProjection)
+{
+    const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(mesh.getVertexArray());
+    if (!vertices || vertices->empty())
+    {
+        OSG_INFO<<"SoftwareOcclusionCuller::rasterizeOccluder() occluder mesh requires an osg::Vec3Array vertex array."<<std::endl;
+        return;
+    }
+
+    // transform each vertex once, then rasterize the triangles by index.
+    std::vector<osg::Vec4d> clipVertices;
+    clipVertices.reserve(vertices->size());
+    for(osg::Vec3Array::const_iterator itr = vertices->begin(); itr != vertices->end(); ++itr)
+    {
+        clipVertices.push_back(osg::Vec4d(osg::Vec3d(*itr), 1.0) * modelViewProjection);
+    }
+
+    osg::TriangleIndexFunctor<RasterizeIndexedTriangle> tif;
+    tif.set(this, &clipVertices);
+    mesh.accept(tif);
+}
+
+void SoftwareOcclusionCuller::rasterizeTriangle(const osg::Vec3& v1, const osg::Vec3& v2, const osg::Vec3& v3, const osg::Matrix& modelViewProjection)
+{
+    rasterizeClipSpaceTriangle(osg::Vec4d(osg::Vec3d(v1), 1.0) * modelViewProjection,
+                               osg::Vec4d(osg::Vec3d(v2), 1.0) * modelViewProjection,
+                               osg::Vec4d(osg::Vec3d(v3), 1.0) * modelViewProjection);
+}
+
+void SoftwareOcclusionCuller::rasterizeClipSpaceTriangle(const osg::Vec4d& c0, const osg::Vec4d& c1, const osg::Vec4d& c2)
+{
+    // triangles crossing the near plane are skipped rather than clipped, leaving out part of an occluder only
+    // reduces what is occluded so the results remain conservative.
+    if (c0.w()<s_minimumW || c1.w()<s_minimumW || c2.w()<s_minimumW) return;
+    if (c0.z()<-c0.w() || c1.z()<-c1.w() || c2.z()<-c2.w()) return;
+
+    // project to window coordinates of the depth buffer
+    double x0 = snap((c0.x()/c0.w()*0.5+0.5)*double(_width)),  y0 = snap((c0.y()/c0.w()*0.5+0.5)*double(_height)), z0 = c0.z()/c0.w();
+    double x1 = snap((c1.x()/c1.w()*0.5+0.5)*double(_width)),  y1 = snap((c1.y()/c1.w()*0.5+0.5)*double(_height)), z1 = c1.z()/c1.w();
+    double x2 = snap((c2.x()/c2.w()*0.5+0.5)*double(_width)),  y2 = snap((c2.y()/c2.w()*0.5+0.5)*double(_height)), z2 = c2.z()/c2.w();
+
+    // occluders are rasterized regardless of facing, so reorder clockwise triangles to be counter clockwise.
+    double area = (x1-x0)*(y2-y0) - (x2-x0)*(y1-y0);
+    if (area==0.0) return;
+    if (area<0.0)
+    {
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+        std::swap(z1, z2);
+        area = -area;
+    }
+
+    int minX = std::max(0, int(floor(std::min(x0, std::min(x1, x2)))));
+    int maxX = std::min(int(_width)-1, int(ceil(std::max(x0, std::max(x1, x2)))));
+    int minY = std::max(0, int(floor(std::min(y0, std::min(y1, y2)))));
+    int maxY = std::min(int(_height)-1, int(ceil(std::max(y0, std::max(y1, y2)))));
+    if (minX>maxX || minY>maxY) return;
+
+    ++_numOccluderTriangles;
+
+    // edge functions evaluated at the pixel centres, stepped incrementally across each row.
+    double dx0 = y1-y2, dy0 = x2-x1;
+    double dx1 = y2-y0, dy1 = x0-x2;
+    double dx2 = y0-y1, dy2 = x1-x0;
+
+    double px = double(minX)+0.5;
+    double py = double(minY)+0.5;
+    double rowE0 = (x2-x1)*(py-y1) - (y2-y1)*(px-x1);
+    double rowE1 = (x0-x2)*(py-y2) - (y0-y2)*(px-x2);
+    double rowE2 = (x1-x0)*(py-y0) - (y1-y0)*(px-x0);
+
+    double invArea = 1.0/area;
+
+    for(int y=minY; y<=maxY; ++y)
+    {
+        double e0 = rowE0, e1 = rowE1, e2 = rowE2;
+        for(int x=minX; x<=maxX; ++x)
+        {
+            if (e0>=0.0 && e1>=0.0 && e2>=0.0)
+            {
+                // depth in normalized device coordinates is linear in window space.
+                float z = float((e0*z0 + e1*z1 + e2*z2)*invArea);
+                float& depth = _depth[index(x,y)];
+                if (z<depth) depth = z;
+            }
+            e0 += dx0;
+            e1 += dx1;
+            e2 += dx2;
+        }
+        rowE0 += dy0;
+        rowE1 += dy1;
+        rowE2 += dy2;
+    }
+}
+
+void SoftwareOcclusionCuller::updateTiles()
+{
+    const unsigned int pixelsPerTile = TILE_SIZE*TILE_SIZE;
+    for(unsigned int t=0; t<_tileMaxDepth.size(); ++t)
+    {
+        std::vector<float>::const_iterator begin = _depth.begin()+t*pixelsPerTile;
+        _tileMaxDepth[t] = *std::max_element(begin, begin+pixelsPerTile);
+    }
+}
+
+bool SoftwareOcclusionCuller::isOccluded(const osg::BoundingBox& bb, const osg::Matrix& modelViewProjection) const
+{
+    ++_numTests;
+
+    if (!bb.valid() || empty()) return false;
+
+    double minX = DBL_MAX, maxX = -DBL_MAX;
+    double minY = DBL_MAX, maxY = -DBL_MAX;
+    double minZ = DBL_MAX;
+    for(unsigned int i=0; i<8; ++i)
+    {
+        osg::Vec4d c = osg::Vec4d(osg::Vec3d(bb.corner(i)), 1.0) * modelViewProjection;
+
+        // boxes reaching the eye or the near plane are never occluded.
+        if (c.w()<s_minimumW || c.z()<-c.w()) return false;
+
+        double x = c.x()/c.w(), y = c.y()/c.w(), z = c.z()/c.w();
+        minX = std::min(minX, x); maxX = std::max(maxX, x);
+        minY = std::min(minY, y); maxY = std::max(maxY, y);
+        minZ = std::min(minZ, z);
+    }
+
+    // boxes outside the view are left for view frustum culling.
+    if (maxX<-1.0 || minX>1.0 || maxY<-1.0 || minY>1.0) return false;
+
+    int px0 = std::max(0, int(floor((minX*0.5+0.5)*double(_width))));
+    int px1 = std::min(int(_width)-1, int(floor((maxX*0.5+0.5)*double(_width))));
+    int py0 = std::max(0, int(floor((minY*0.5+0.5)*double(_height))));
+    int py1 = std::min(int(_height)-1, int(floor((maxY*0.5+0.5)*double(_height))));
+
+    float nearestDepth = float(minZ);
+
+    for(int ty=py0/TILE_SIZE; ty<=py1/int(TILE_SIZE); ++ty)
+    {
+        for(int tx=px0/TILE_SIZE; tx<=px1/int(TILE_SIZE); ++tx)
+        {
+            // every pixel in the tile is in front of the box
+            if (_tileMaxDepth[ty*_numTilesX+tx]<nearestDepth) continue;
+
+            int x0 = std::max(px0, tx*int(TILE_SIZE)), x1 = std::min(px1, (tx+1)*int(TILE_SIZE)-1);
+            int y0 = std::max(py0, ty*int(TILE_SIZE)), y1 = std::min(py1, (ty+1)*int(TILE_SIZE)-1);
+            for(int y=y0; y<=y1; ++y)
+            {
+                for(int x=x0; x<=x1; ++x)
+                {
+                    if (_depth[index(x,y)]>=nearestDepth) return false;
+                }
+            }
+        }
+    }
+
+    ++_numOccluded;
+    return true;
+}
+
+bool SoftwareOcclusionCuller::isOccluded(const osg::BoundingSphere& bs, const osg::Matrix& modelViewProjection) const
+{
+    if (!bs.valid())
+    {
+        ++_numTests;
+        return false;
+    }
+
+    osg::BoundingBox bb;
+    bb.expandBy(bs);
+    return isOccluded(bb, modelViewProjection);
+}
+
+osg::Geometry* SoftwareOcclusionCuller::createOccluderMesh(osg::Node& node, float sampleRatio)
+{
+    MergeTrianglesVisitor mtv;
+    node.accept(mtv);
+
+    if (mtv._vertices->empty()) return 0;
+
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(mtv._vertices.get());
+    geometry->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLES, 0, mtv._vertices->size()));
+
+    if (sampleRatio<1.0f)
+    {
+        osgUtil::Simplifier simplifier(sampleRatio);
+        simplifier.simplify(*geometry);
+    }
+
+    return geometry.release();
+}
@@ -12,11 +12,98 @@
 */
 #include <osgUtil/UpdateVisitor>
 
+#include <osg/BoundUpdateQueue>
+#include <osg/ValueObject>
+#include <osg/ApplicationUsage>
+
+#include <stdlib.h>
+#include <algorithm>
+
 using namespace osg;
 using namespace osgUtil;
 
+static osg::ApplicationUsageProxy UpdateVisitor_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_UPDATE_THREADS <value>","Number of threads used to update independent subgraphs concurrently during the update traversal.");
+
+static const char* s_independentSubgraphName = "osgUtil::UpdateVisitor::IndependentSubgraph";
+
+static unsigned int getDefaultNumUpdateThreads()
+{
+    static int s_numUpdateThreads = -1;
+    if (s_numUpdateThreads<0)
+    {
+        const char* str = getenv("OSG_UPDATE_THREADS");
+        s_numUpdateThreads = str ? std::max(0, atoi(str)) : 0;
+    }
+    return static_cast<unsigned int>(s_numUpdateThreads);
+}
+
+namespace osgUtil
+{
+
+/** Updates a range of independent subgraphs on one of the UpdateVisitor's threads.*/
+class UpdateSubgraphsOperation : public osg::Operation
+{
+    public:
+
+        UpdateSubgraphsOperation(const UpdateVisitor& parent, osg::Node* const* begin, osg::Node* const* end, osg::RefBlockCount* block):
+            osg::Operation("UpdateSubgraphsOperation", false),
+            _updateVisitor(new UpdateVisitor),
+            _begin(begin),
+            _end(end),
+            _block(block),
+            _boundUpdateQueue(osg::BoundUpdateQueue::getCurrent()),
+            _updateCountQueue(parent._updateCountQueue)
+        {
+            _updateVisitor->_withinUpdateThread = true;
+            _updateVisitor->setTraversalMode(parent.getTraversalMode());
+            _updateVisitor->setTraversalMask(parent.getTraversalMask());
+            _updateVisitor->setNodeMaskOverride(parent.getNodeMaskOverride());
+            _updateVisitor->setTraversalNumber(parent.getTraversalNumber());
+            _updateVisitor->setFrameStamp(const_cast<osg::FrameStamp*>(parent.getFrameStamp()));
+            _updateVisitor->setDatabaseRequestHandler(const_cast<osg::NodeVisitor::DatabaseRequestHandler*>(parent.getDatabaseRequestHandler()));
+            _updateVisitor->setImageRequestHandler(const_cast<osg::NodeVisitor::ImageRequestHandler*>(parent.getImageRequestHandler()));
+
+            // the subgraphs see the same parental node path as they would in a serial traversal
+            const osg::NodePath& nodePath = parent.getNodePath();
+            for(osg::NodePath::const_iterator itr = nodePath.begin(); itr != nodePath.end(); ++itr)
+            {
+                _updateVisitor->pushOntoNodePath(*itr);
+            }
+        }
+
+        virtual void operator () (osg::Object*)
+        {
+            // bounds dirtied by the subgraphs are batched with those of the thread that launched the update.
+            if (_boundUpdateQueue.valid()) _boundUpdateQueue->addThread(OpenThreads::Thread::CurrentThread());
+            _updateCountQueue->addThread(OpenThreads::Thread::CurrentThread());
+
+            for(osg::Node* const* itr = _begin; itr != _end; ++itr)
+            {
+                (*itr)->accept(*_updateVisitor);
+            }
+
+            if (_boundUpdateQueue.valid()) _boundUpdateQueue->removeThread(OpenThreads::Thread::CurrentThread());
+            _updateCountQueue->removeThread(OpenThreads::Thread::CurrentThread());
+
+            _block->completed();
+        }
+
+    protected:
+
+        osg::ref_ptr<UpdateVisitor>         _updateVisitor;
+        osg::Node* const*                   _begin;
+        osg::Node* const*                   _end;
+        osg::ref_ptr<osg::RefBlockCount>    _block;
+        osg::ref_ptr<osg::BoundUpdateQueue> _boundUpdateQueue;
+        osg::ref_ptr<osg::UpdateCountQueue> _updateCountQueue;
+};
+
+}
+
 UpdateVisitor::UpdateVisitor():
-    osg::NodeVisitor(osg::NodeVisitor::UPDATE_VISITOR, osg::NodeVisitor::TRAVERSE_ALL_CHILDREN)
+    osg::NodeVisitor(osg::NodeVisitor::UPDATE_VISITOR, osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+    _numUpdateThreads(getDefaultNumUpdateThreads()),
+    _withinUpdateThread(false)
 {
 }
 
@@ -29,3 +116,98 @@ UpdateVisitor::~UpdateVisitor()
 void UpdateVisitor::reset()
 {
 }
+
+void UpdateVisitor::setNumUpdateThreads(unsigned int numThreads)
+{
+    if (_numUpdateThreads==numThreads) return;
+
+    _numUpdateThreads = numThreads;
+
+    // threads are recreated on demand at the new count.
+    _operationThreads.clear();
+    _operationQueue = 0;
+}
+
+void UpdateVisitor::setIndependentSubgraph(osg::Node* node, bool independent)
+{
+    if (!node) return;
+
+    if (independent) node->setUserValue(s_independentSubgraphName, true);
+    else if (node->getUserDataContainer())
+    {
+        unsigned int index = node->getUserDataContainer()->getUserObjectIndex(s_independentSubgraphName);
+        if (index<node->getUserDataContainer()->getNumUserObjects()) node->getUserDataContainer()->removeUserObject(index);
+    }
+}
+
+bool UpdateVisitor::isIndependentSubgraph(const osg::Node& node)
+{
+    bool independent = false;
+    return node.getUserDataContainer()!=0 && node.getUserValue(s_independentSubgraphName, independent) && independent;
+}
+
+void UpdateVisitor::traverseIndependentSubgraphs(osg::Group& group)
+{
+    // update the dependent children in order on this thread, collecting the independent ones.
+    std::vector<osg::Node*> independentSubgraphs;
+    for(unsigned int i=0; i<group.getNumChildren(); ++i)
+    {
+        osg::Node* child = group.getChild(i);
+        if (isIndependentSubgraph(*child)) independentSubgraphs.push_back(child);
+        else child->accept(*this);
+    }
+
+    // the changes the subgraphs make to their parents are deferred until they are joined, if another
+    // traversal is already deferring them the subgraphs are updated on this thread instead.
+    if (!_updateCountQueue) _updateCountQueue = new osg::UpdateCountQueue;
+
+    if (independentSubgraphs.size()<2 || !_updateCountQueue->begin())
+    {
+        for(std::vector<osg::Node*>::iterator itr = independentSubgraphs.begin(); itr != independentSubgraphs.end(); ++itr)
+        {
+            (*itr)->accept(*this);
+        }
+    }
+    else
+    {
+        if (!_operationQueue)
+        {
+            _operationQueue = new osg::OperationQueue;
+            for(unsigned int i=1; i<_numUpdateThreads; ++i)
+            {
+                osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+                thread->setOperationQueue(_operationQueue.get());
+                thread->startThread();
+                _operationThreads.push_back(thread);
+            }
+        }
+
+        // split the subgraphs into contiguous ranges, one per thread, the first range being updated on this thread.
+        unsigned int numRanges = std::min(_numUpdateThreads, static_cast<unsigned int>(independentSubgraphs.size()));
+        unsigned int rangeSize = (static_cast<unsigned int>(independentSubgraphs.size())+numRanges-1)/numRanges;
+        numRanges = (static_cast<unsigned int>(independentSubgraphs.size())+rangeSize-1)/rangeSize;
+
+        osg::Node* const* first = &independentSubgraphs.front();
+        osg::Node* const* last = first + independentSubgraphs.size();
+
+        osg::ref_ptr<osg::RefBlockCount> block = new osg::RefBlockCount(numRanges-1);
+        block->reset();
+        for(unsigned int r=1; r<numRanges; ++r)
+        {
+            osg::Node* const* begin = first + r*rangeSize;
+            osg::Node* const* end = std::min(begin + rangeSize, last);
+            _operationQueue->add(new UpdateSubgraphsOperation(*this, begin, end, block.get()));
+        }
+
+        _withinUpdateThread = true;
+        for(osg::Node* const* itr = first; itr != first + rangeSize; ++itr)
+        {
+            (*itr)->accept(*this);
+        }
+        _withinUpdateThread = false;
+
+        // join all the ranges before the traversal continues, then pass on the changes to the parents.
+        block->block();
+        _updateCountQueue->end();
+    }
+}
@@ -1293,6 +1293,9 @@ void CompositeViewer::updateTraversal()
     _updateVisitor->setFrameStamp(getFrameStamp());
     _updateVisitor->setTraversalNumber(getFrameStamp()->getFrameNumber());
 
+    // collect the bounds dirtied during the update traversal so they are recomputed once, before cull.
+    if (_boundUpdateQueue.valid()) _boundUpdateQueue->begin();
+
     Scenes scenes;
     getScenes(scenes);
     for(Scenes::iterator sitr = scenes.begin();
@@ -1374,6 +1377,8 @@ void CompositeViewer::updateTraversal()
 
     }
 
+    if (_boundUpdateQueue.valid()) _boundUpdateQueue->end();
+
     if (getViewerStats() && getViewerStats()->collectStats("update"))
     {
         double endUpdateTraversal = osg::Timer::instance()->delta_s(_startTick, osg::Timer::instance()->tick());
@@ -1382,6 +1387,14 @@ void CompositeViewer::updateTraversal()
         getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Update traversal begin time", beginUpdateTraversal);
         getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Update traversal end time", endUpdateTraversal);
         getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Update traversal time taken", endUpdateTraversal-beginUpdateTraversal);
+
+        if (_boundUpdateQueue.valid())
+        {
+            const osg::BoundUpdateQueue::Statistics& boundStats = _boundUpdateQueue->getStatistics();
+            getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Bound updates", boundStats.numDirtyBoundCalls);
+            getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Bounds computed", boundStats.numBoundsComputed);
+            getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Bound update time taken", boundStats.updateTime);
+        }
     }
 
 }
@@ -604,6 +604,14 @@ static void collectSceneViewStats(unsigned int frameNumber, osgUtil::SceneView*
     stats->setAttribute(frameNumber, "Visible number of impostors", static_cast<double>(sceneStats.nimpostor));
     stats->setAttribute(frameNumber, "Number of ordered leaves", static_cast<double>(sceneStats.numOrderedLeaves));
 
+    const osgUtil::SoftwareOcclusionCuller* softwareOcclusionCuller = sceneView->getCullVisitor() ? sceneView->getCullVisitor()->getSoftwareOcclusionCuller() : 0;
+    if (softwareOcclusionCuller)
+    {
+        stats->setAttribute(frameNumber, "Number of occluder triangles", static_cast<double>(softwareOcclusionCuller->getNumOccluderTriangles()));
+        stats->setAttribute(frameNumber, "Number of occlusion tests", static_cast<double>(softwareOcclusionCuller->getNumTests()));
+        stats->setAttribute(frameNumber, "Number of occluded nodes", static_cast<double>(softwareOcclusionCuller->getNumOccluded()));
+    }
+
     unsigned int totalNumPrimitiveSets = 0;
     const osgUtil::Statistics::PrimitiveValueMap& pvm = sceneStats.getPrimitiveValueMap();
     for(osgUtil::Statistics::PrimitiveValueMap::const_iterator pvm_itr = pvm.begin();
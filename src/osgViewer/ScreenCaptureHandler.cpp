@@ -16,6 +16,8 @@
 #include <osgViewer/Viewer>
 #include <osgViewer/ViewerEventHandlers>
 
+#include <OpenThreads/ScopedLock>
+
 #include <string.h>
 
 namespace osgViewer
@@ -535,8 +537,14 @@ ScreenCaptureHandler::WriteToFile::WriteToFile(const std::string& filename,
 
 void ScreenCaptureHandler::WriteToFile::operator () (const osg::Image& image, const unsigned int context_id)
 {
+    std::stringstream filename;
+    filename << _filename << "_" << context_id;
+
     if (_savePolicy == SEQUENTIAL_NUMBER)
     {
+        // take the sequence number under the mutex so that images can be written from several threads.
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
         if (_contextSaveCounter.size() <= context_id)
         {
             unsigned int oldSize = _contextSaveCounter.size();
@@ -545,26 +553,231 @@ void ScreenCaptureHandler::WriteToFile::operator () (const osg::Image& image, co
             for (unsigned int i = oldSize; i <= context_id; i++)
                 _contextSaveCounter[i] = 0;
         }
-    }
-
-    std::stringstream filename;
-    filename << _filename << "_" << context_id;
 
-    if (_savePolicy == SEQUENTIAL_NUMBER)
         filename << "_" << _contextSaveCounter[context_id];
+        _contextSaveCounter[context_id]++;
+    }
 
     filename << "." << _extension;
 
     osgDB::writeImageFile(image, filename.str());
 
     OSG_INFO<<"ScreenCaptureHandler: Taking a screenshot, saved as '"<<filename.str()<<"'"<<std::endl;
+}
 
-    if (_savePolicy == SEQUENTIAL_NUMBER)
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ScreenCaptureHandler::WriteToRawStream
+//
+ScreenCaptureHandler::WriteToRawStream::WriteToRawStream(const std::string& filename)
+    : _fout(filename.c_str(), std::ios::out | std::ios::binary),
+      _numFramesWritten(0)
+{
+    if (!_fout)
     {
-        _contextSaveCounter[context_id]++;
+        OSG_WARN<<"ScreenCaptureHandler: Could not open raw stream '"<<filename<<"' for writing."<<std::endl;
+    }
+}
+
+void ScreenCaptureHandler::WriteToRawStream::operator () (const osg::Image& image, const unsigned int context_id)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    if (!_fout) return;
+
+    unsigned int header[7];
+    header[0] = context_id;
+    header[1] = _numFramesWritten;
+    header[2] = image.s();
+    header[3] = image.t();
+    header[4] = image.getPixelFormat();
+    header[5] = image.getDataType();
+    header[6] = image.getTotalSizeInBytes();
+
+    _fout.write(reinterpret_cast<const char*>(header), sizeof(header));
+    _fout.write(reinterpret_cast<const char*>(image.data()), image.getTotalSizeInBytes());
+
+    ++_numFramesWritten;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ScreenCaptureHandler::AsyncCaptureOperation
+//
+ScreenCaptureHandler::AsyncCaptureOperation::AsyncCaptureOperation(CaptureOperation* operation,
+                                                                   unsigned int maximumQueueSize,
+                                                                   QueueFullPolicy policy,
+                                                                   unsigned int numThreads)
+    : _operation(operation),
+      _maximumQueueSize(maximumQueueSize>0 ? maximumQueueSize : 1),
+      _policy(policy),
+      _numThreads(numThreads>0 ? numThreads : 1),
+      _numFramesReserved(0),
+      _numFramesActive(0),
+      _done(false),
+      _numFramesCaptured(0),
+      _numFramesDropped(0),
+      _numFramesProcessed(0),
+      _totalLatency(0.0),
+      _maximumLatency(0.0),
+      _totalOperationTime(0.0)
+{
+}
+
+ScreenCaptureHandler::AsyncCaptureOperation::~AsyncCaptureOperation()
+{
+    flush();
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _done = true;
+        _frameQueued.broadcast();
+    }
+
+    for(CaptureThreads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
     }
 }
 
+void ScreenCaptureHandler::AsyncCaptureOperation::operator () (const osg::Image& image, const unsigned int context_id)
+{
+    if (!_operation) return;
+
+    osg::Timer_t captureTick = osg::Timer::instance()->tick();
+
+    osg::ref_ptr<osg::Image> copy;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+        while (_threads.size()<_numThreads)
+        {
+            _threads.push_back(new CaptureThread(this));
+            _threads.back()->startThread();
+        }
+
+        while (_frames.size()+_numFramesReserved>=_maximumQueueSize)
+        {
+            if (_policy==DROP_FRAMES)
+            {
+                ++_numFramesDropped;
+                return;
+            }
+            _frameProcessed.wait(&_mutex);
+        }
+
+        ++_numFramesReserved;
+
+        if (!_freeImages.empty())
+        {
+            copy = _freeImages.back();
+            _freeImages.pop_back();
+        }
+    }
+
+    // copy outside of the lock so the capture threads aren't held up.
+    if (!copy) copy = new osg::Image;
+    copy->allocateImage(image.s(), image.t(), image.r(), image.getPixelFormat(), image.getDataType(), image.getPacking());
+    copy->setInternalTextureFormat(image.getInternalTextureFormat());
+    memcpy(copy->data(), image.data(), image.getTotalSizeInBytes());
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    Frame frame;
+    frame.image = copy;
+    frame.contextID = context_id;
+    frame.captureTick = captureTick;
+    _frames.push_back(frame);
+
+    --_numFramesReserved;
+    ++_numFramesCaptured;
+
+    _frameQueued.signal();
+}
+
+void ScreenCaptureHandler::AsyncCaptureOperation::processFrames()
+{
+    while (true)
+    {
+        Frame frame;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+            while (_frames.empty() && !_done)
+            {
+                _frameQueued.wait(&_mutex);
+            }
+
+            if (_frames.empty()) return;
+
+            frame = _frames.front();
+            _frames.pop_front();
+            ++_numFramesActive;
+        }
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        (*_operation)(*frame.image, frame.contextID);
+
+        osg::Timer_t endTick = osg::Timer::instance()->tick();
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+        double latency = osg::Timer::instance()->delta_s(frame.captureTick, endTick);
+        ++_numFramesProcessed;
+        _totalLatency += latency;
+        _maximumLatency = osg::maximum(_maximumLatency, latency);
+        _totalOperationTime += osg::Timer::instance()->delta_s(startTick, endTick);
+
+        if (_freeImages.size()<_maximumQueueSize) _freeImages.push_back(frame.image);
+
+        --_numFramesActive;
+        _frameProcessed.broadcast();
+    }
+}
+
+unsigned int ScreenCaptureHandler::AsyncCaptureOperation::getQueueSize() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return static_cast<unsigned int>(_frames.size());
+}
+
+void ScreenCaptureHandler::AsyncCaptureOperation::flush()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    while ((!_frames.empty() || _numFramesActive>0 || _numFramesReserved>0) && !_threads.empty())
+    {
+        _frameProcessed.wait(&_mutex);
+    }
+}
+
+double ScreenCaptureHandler::AsyncCaptureOperation::getAverageLatency() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _numFramesProcessed>0 ? _totalLatency/double(_numFramesProcessed) : 0.0;
+}
+
+double ScreenCaptureHandler::AsyncCaptureOperation::getAverageOperationTime() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _numFramesProcessed>0 ? _totalOperationTime/double(_numFramesProcessed) : 0.0;
+}
+
+void ScreenCaptureHandler::AsyncCaptureOperation::resetStats()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _numFramesCaptured = 0;
+    _numFramesDropped = 0;
+    _numFramesProcessed = 0;
+    _totalLatency = 0.0;
+    _maximumLatency = 0.0;
+    _totalOperationTime = 0.0;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
@@ -586,7 +799,7 @@ ScreenCaptureHandler::ScreenCaptureHandler(CaptureOperation* defaultOperation,
     if (defaultOperation)
         setCaptureOperation(defaultOperation);
     else
-        setCaptureOperation(new WriteToFile("screen_shot", "jpg"));
+        setCaptureOperation(new AsyncCaptureOperation(new WriteToFile("screen_shot", "jpg")));
 }
 
 void ScreenCaptureHandler::setCaptureOperation(CaptureOperation* operation)
@@ -66,6 +66,7 @@ Viewer::Viewer(osg::ArgumentParser& arguments)
     arguments.getApplicationUsage()->addCommandLineOption("--run-continuous","Set the run methods frame rate management to rendering frames continuously.");
     arguments.getApplicationUsage()->addCommandLineOption("--run-max-frame-rate","Set the run methods maximum permissible frame rate, 0.0 is default and switching off frame rate capping.");
     arguments.getApplicationUsage()->addCommandLineOption("--enable-object-cache","Enable caching of objects, images, etc.");
+    arguments.getApplicationUsage()->addCommandLineOption("--ico-thread","Compile paged databases on a dedicated thread with a shared compile context.");
 
     // FIXME: Uncomment these lines when the options have been documented properly
     //arguments.getApplicationUsage()->addCommandLineOption("--3d-sd","");
@@ -79,6 +80,13 @@ Viewer::Viewer(osg::ArgumentParser& arguments)
         setIncrementalCompileOperation(new osgUtil::IncrementalCompileOperation());
     }
 
+    if (arguments.read("--ico-thread"))
+    {
+        osgUtil::IncrementalCompileOperation* ico = new osgUtil::IncrementalCompileOperation();
+        ico->setUseCompileThreads(true);
+        setIncrementalCompileOperation(ico);
+    }
+
     std::string filename;
     bool readConfig = false;
     while (arguments.read("-c",filename))
@@ -1145,6 +1153,9 @@ void Viewer::updateTraversal()
     _updateVisitor->setFrameStamp(getFrameStamp());
     _updateVisitor->setTraversalNumber(getFrameStamp()->getFrameNumber());
 
+    // collect the bounds dirtied during the update traversal so they are recomputed once, before cull.
+    if (_boundUpdateQueue.valid()) _boundUpdateQueue->begin();
+
     _scene->updateSceneGraph(*_updateVisitor);
 
     // if we have a shared state manager prune any unused entries
@@ -1211,6 +1222,8 @@ void Viewer::updateTraversal()
 
     updateSlaves();
 
+    if (_boundUpdateQueue.valid()) _boundUpdateQueue->end();
+
     if (getViewerStats() && getViewerStats()->collectStats("update"))
     {
         double endUpdateTraversal = osg::Timer::instance()->delta_s(_startTick, osg::Timer::instance()->tick());
@@ -1219,6 +1232,14 @@ void Viewer::updateTraversal()
         getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Update traversal begin time", beginUpdateTraversal);
         getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Update traversal end time", endUpdateTraversal);
         getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Update traversal time taken", endUpdateTraversal-beginUpdateTraversal);
+
+        if (_boundUpdateQueue.valid())
+        {
+            const osg::BoundUpdateQueue::Statistics& boundStats = _boundUpdateQueue->getStatistics();
+            getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Bound updates", boundStats.numDirtyBoundCalls);
+            getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Bounds computed", boundStats.numBoundsComputed);
+            getViewerStats()->setAttribute(_frameStamp->getFrameNumber(), "Bound update time taken", boundStats.updateTime);
+        }
     }
 }
 
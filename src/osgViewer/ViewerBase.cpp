@@ -37,6 +37,7 @@ static osg::ApplicationUsageProxy ViewerBase_e2(osg::ApplicationUsage::ENVIRONME
 static osg::ApplicationUsageProxy ViewerBase_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_WINDOW x y width height","Set the default window dimensions that windows should open up on.");
 static osg::ApplicationUsageProxy ViewerBase_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_RUN_FRAME_SCHEME","Frame rate manage scheme that viewer run should use,  ON_DEMAND or CONTINUOUS (default).");
 static osg::ApplicationUsageProxy ViewerBase_e5(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_RUN_MAX_FRAME_RATE","Set the maximum number of frame as second that viewer run. 0.0 is default and disables an frame rate capping.");
+static osg::ApplicationUsageProxy ViewerBase_e6(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_BATCH_BOUND_UPDATES <mode>","ON | OFF - Batch the bound updates of the update traversal, recomputing them once before cull.");
 
 using namespace osgViewer;
 
@@ -79,6 +80,12 @@ void ViewerBase::viewerBaseInit()
     {
         _runMaxFrameRate = osg::asciiToDouble(str);
     }
+
+    str = getenv("OSG_BATCH_BOUND_UPDATES");
+    if (str && strcmp(str, "ON")==0)
+    {
+        _boundUpdateQueue = new osg::BoundUpdateQueue;
+    }
 }
 
 void ViewerBase::setThreadingModel(ThreadingModel threadingModel)
@@ -0,0 +1,49 @@
+#include <osg/InstancedGeometry>
+#include <osgDB/ObjectWrapper>
+#include <osgDB/InputStream>
+#include <osgDB/OutputStream>
+
+static bool checkInstanceMatrices( const osg::InstancedGeometry& geom )
+{
+    return geom.getNumInstances()>0;
+}
+
+static bool readInstanceMatrices( osgDB::InputStream& is, osg::InstancedGeometry& geom )
+{
+    unsigned int size = is.readSize();
+    osg::ref_ptr<osg::MatrixfArray> matrices = new osg::MatrixfArray;
+    matrices->reserve(size);
+    is >> is.BEGIN_BRACKET;
+    for ( unsigned int i=0; i<size; ++i )
+    {
+        osg::Matrixf matrix; is >> matrix;
+        matrices->push_back( matrix );
+    }
+    is >> is.END_BRACKET;
+    geom.setInstanceMatrices( matrices.get() );
+    return true;
+}
+
+static bool writeInstanceMatrices( osgDB::OutputStream& os, const osg::InstancedGeometry& geom )
+{
+    const osg::MatrixfArray* matrices = geom.getInstanceMatrices();
+    os.writeSize(matrices->size());
+    os << os.BEGIN_BRACKET << std::endl;
+    for ( osg::MatrixfArray::const_iterator itr=matrices->begin();
+          itr!=matrices->end(); ++itr )
+    {
+        os << *itr << std::endl;
+    }
+    os << os.END_BRACKET << std::endl;
+    return true;
+}
+
+REGISTER_OBJECT_WRAPPER( InstancedGeometry,
+                         new osg::InstancedGeometry,
+                         osg::InstancedGeometry,
+                         "osg::Object osg::Drawable osg::Geometry osg::InstancedGeometry" )
+{
+    ADD_USER_SERIALIZER( InstanceMatrices );  // _instanceMatrices
+    ADD_UINT_SERIALIZER( InstanceMatrixLocation, osg::InstancedGeometry::DEFAULT_INSTANCE_MATRIX_LOCATION );  // _instanceMatrixLocation
+    ADD_BOOL_SERIALIZER( InstanceCulling, true );  // _instanceCulling
+}
@@ -9,4 +9,9 @@ REGISTER_OBJECT_WRAPPER( OccluderNode,
                          "osg::Object osg::Node osg::Group osg::OccluderNode" )
 {
     ADD_OBJECT_SERIALIZER( Occluder, osg::ConvexPlanarOccluder, NULL );  // _occluder
+
+    {
+        UPDATE_TO_VERSION_SCOPED( 146 )
+        ADD_OBJECT_SERIALIZER( OccluderMesh, osg::Geometry, NULL );  // _occluderMesh
+    }
 }
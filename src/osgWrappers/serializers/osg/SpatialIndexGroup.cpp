@@ -0,0 +1,13 @@
+#include <osg/SpatialIndexGroup>
+#include <osgDB/ObjectWrapper>
+#include <osgDB/InputStream>
+#include <osgDB/OutputStream>
+
+REGISTER_OBJECT_WRAPPER( SpatialIndexGroup,
+                         new osg::SpatialIndexGroup,
+                         osg::SpatialIndexGroup,
+                         "osg::Object osg::Node osg::Group osg::SpatialIndexGroup" )
+{
+    ADD_UINT_SERIALIZER( MaximumChildrenPerCell, 8 );  // _maximumChildrenPerCell
+    ADD_FLOAT_SERIALIZER( RebuildRatio, 2.0f );  // _rebuildRatio
+}